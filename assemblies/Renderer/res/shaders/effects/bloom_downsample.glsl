@@ -11,6 +11,12 @@ layout (binding = 0) uniform sampler2D source;
 layout (rgba16f, binding = 0) uniform image2D result;
 
 uniform int uMip = 0;
+uniform vec2 uViewportScale = vec2(1.0);   // Share of the textures in use, from their origin
+
+vec3 Tap(vec2 uv, float level, vec2 texelSize) {
+    // Texels out of the viewport hold previous frames
+    return textureLod(source, min(uv, uViewportScale - 0.5 * texelSize), level).rgb;
+}
 
 void main() {
     uvec2 id = gl_GlobalInvocationID.xy;
@@ -28,22 +34,22 @@ void main() {
     uv.y += 0.5 * y;
 
     // Downsample Filter from https://learnopengl.com/Guest-Articles/2022/Phys.-Based-Bloom
-    vec3 a = textureLod(source, vec2(uv.x - 2*x, uv.y + 2*y), level).rgb;
-    vec3 b = textureLod(source, vec2(uv.x,       uv.y + 2*y), level).rgb;
-    vec3 c = textureLod(source, vec2(uv.x + 2*x, uv.y + 2*y), level).rgb;
-
-    vec3 d = textureLod(source, vec2(uv.x - 2*x, uv.y), level).rgb;
-    vec3 e = textureLod(source, vec2(uv.x,       uv.y), level).rgb;
-    vec3 f = textureLod(source, vec2(uv.x + 2*x, uv.y), level).rgb;
-
-    vec3 g = textureLod(source, vec2(uv.x - 2*x, uv.y - 2*y), level).rgb;
-    vec3 h = textureLod(source, vec2(uv.x,       uv.y - 2*y), level).rgb;
-    vec3 i = textureLod(source, vec2(uv.x + 2*x, uv.y - 2*y), level).rgb;
-
-    vec3 j = textureLod(source, vec2(uv.x - x, uv.y + y), level).rgb;
-    vec3 k = textureLod(source, vec2(uv.x + x, uv.y + y), level).rgb;
-    vec3 l = textureLod(source, vec2(uv.x - x, uv.y - y), level).rgb;
-    vec3 m = textureLod(source, vec2(uv.x + x, uv.y - y), level).rgb;
+    vec3 a = Tap(vec2(uv.x - 2*x, uv.y + 2*y), level, sourceTexelSize);
+    vec3 b = Tap(vec2(uv.x,       uv.y + 2*y), level, sourceTexelSize);
+    vec3 c = Tap(vec2(uv.x + 2*x, uv.y + 2*y), level, sourceTexelSize);
+
+    vec3 d = Tap(vec2(uv.x - 2*x, uv.y), level, sourceTexelSize);
+    vec3 e = Tap(vec2(uv.x,       uv.y), level, sourceTexelSize);
+    vec3 f = Tap(vec2(uv.x + 2*x, uv.y), level, sourceTexelSize);
+
+    vec3 g = Tap(vec2(uv.x - 2*x, uv.y - 2*y), level, sourceTexelSize);
+    vec3 h = Tap(vec2(uv.x,       uv.y - 2*y), level, sourceTexelSize);
+    vec3 i = Tap(vec2(uv.x + 2*x, uv.y - 2*y), level, sourceTexelSize);
+
+    vec3 j = Tap(vec2(uv.x - x, uv.y + y), level, sourceTexelSize);
+    vec3 k = Tap(vec2(uv.x + x, uv.y + y), level, sourceTexelSize);
+    vec3 l = Tap(vec2(uv.x - x, uv.y - y), level, sourceTexelSize);
+    vec3 m = Tap(vec2(uv.x + x, uv.y - y), level, sourceTexelSize);
 
     vec3 downsample = e*0.125;
     downsample += (a+c+g+i)*0.03125;
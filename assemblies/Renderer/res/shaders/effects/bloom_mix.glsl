@@ -14,6 +14,8 @@ layout (rgba16f, binding = 0) uniform image2D self;
 layout (rgba16f, binding = 1) uniform image2D result;
 
 uniform float uBloomAmount = 0.5;
+uniform ivec2 uViewport = ivec2(65536);    // Size of the result region in use
+uniform vec2 uViewportScale = vec2(1.0);   // Share of the textures in use, from their origin
 
 void main() {
     uvec2 id = gl_GlobalInvocationID.xy;
@@ -22,10 +24,11 @@ void main() {
     vec2 uv = vec2(id) / sz;
 
     if (id.x >= szr.x || id.y >= szr.y ) return;
+    if (any(greaterThanEqual(ivec2(id), uViewport))) return;
 
     vec2 sourceTexelSize = 1.0 / textureSize(source, 0);
     uv += 0.5 * sourceTexelSize;
-
+    uv = min(uv, uViewportScale - 0.5 * sourceTexelSize);
 
     vec3 bloom = textureLod(source, uv, 0).rgb / textureQueryLevels(source);
 
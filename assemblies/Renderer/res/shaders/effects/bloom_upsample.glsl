@@ -12,6 +12,12 @@ layout (rgba16f, binding = 0) uniform image2D self;
 layout (rgba16f, binding = 1) uniform image2D result;
 
 uniform int uMip = 0;
+uniform vec2 uViewportScale = vec2(1.0);   // Share of the textures in use, from their origin
+
+vec3 Tap(vec2 uv, float level, vec2 texelSize) {
+    // Texels out of the viewport hold previous frames
+    return textureLod(source, min(uv, uViewportScale - 0.5 * texelSize), level).rgb;
+}
 uniform float uFilterRadius = 0.08;
 
 void main() {
@@ -35,17 +41,17 @@ void main() {
     uv.y += 0.5 * y;
 
     // Upsample gaussian blur filter from: https://learnopengl.com/Guest-Articles/2022/Phys.-Based-Bloom
-    vec3 a = textureLod(source, vec2(uv.x - x, uv.y + y), level).rgb;
-    vec3 b = textureLod(source, vec2(uv.x,     uv.y + y), level).rgb;
-    vec3 c = textureLod(source, vec2(uv.x + x, uv.y + y), level).rgb;
+    vec3 a = Tap(vec2(uv.x - x, uv.y + y), level, sourceTexelSize);
+    vec3 b = Tap(vec2(uv.x,     uv.y + y), level, sourceTexelSize);
+    vec3 c = Tap(vec2(uv.x + x, uv.y + y), level, sourceTexelSize);
 
-    vec3 d = textureLod(source, vec2(uv.x - x, uv.y), level).rgb;
-    vec3 e = textureLod(source, vec2(uv.x,     uv.y), level).rgb;
-    vec3 f = textureLod(source, vec2(uv.x + x, uv.y), level).rgb;
+    vec3 d = Tap(vec2(uv.x - x, uv.y), level, sourceTexelSize);
+    vec3 e = Tap(vec2(uv.x,     uv.y), level, sourceTexelSize);
+    vec3 f = Tap(vec2(uv.x + x, uv.y), level, sourceTexelSize);
 
-    vec3 g = textureLod(source, vec2(uv.x - x, uv.y - y), level).rgb;
-    vec3 h = textureLod(source, vec2(uv.x,     uv.y - y), level).rgb;
-    vec3 i = textureLod(source, vec2(uv.x + x, uv.y - y), level).rgb;
+    vec3 g = Tap(vec2(uv.x - x, uv.y - y), level, sourceTexelSize);
+    vec3 h = Tap(vec2(uv.x,     uv.y - y), level, sourceTexelSize);
+    vec3 i = Tap(vec2(uv.x + x, uv.y - y), level, sourceTexelSize);
 
     vec3 upsample = e*4.0;
     upsample += (b+d+f+h)*2.0;
@@ -7,21 +7,65 @@
 
 #version 460 core
 
-#define MAX_SHADOW_CASTERS 4
+#define MAX_CASCADES 4
+
+// Stereo variants draw both eyes at once, each vertex is transformed by the view of its multiview or instance pair.
+// Foveated variants also draw every object once per region, into the viewport of the region.
+#if defined(FOVEATED)
+#define REGION_COUNT 2
+#else
+#define REGION_COUNT 1
+#endif
+#if defined(STEREO_INSTANCED) || defined(FOVEATED)
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+#if defined(STEREO_MULTIVIEW)
+#extension GL_OVR_multiview2 : require
+#define VIEW_INDEX gl_ViewID_OVR
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#elif defined(STEREO_INSTANCED)
+#define VIEW_INDEX uint((gl_InstanceID / REGION_COUNT) & 1)
+#define INSTANCE_INDEX (gl_InstanceID / (2 * REGION_COUNT))
+#else
+#define VIEW_INDEX 0u
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#endif
+#define REGION_INDEX uint(gl_InstanceID % REGION_COUNT)
 
 layout (std140, binding = 0) uniform Scene {
+    mat4 ViewTransforms[2];
+    mat4 ProjectionTransforms[2];
+    vec4 EyePositions[2];
+    vec4 Regions[2]; // Clip space scale and offset of the foveation regions
+    uint ViewCount;
+} uScene;
+
+struct Object {
     mat4 ModelTransform;
     mat4 NormalTransform;
-    mat4 ViewTransform;
-    mat4 ProjectionTransform;
-    vec3 EyePosition;
-} uScene;
+};
+
+// Objects of the frame renderables, each instance reads its own from the draw base instance
+layout (std430, binding = 4) readonly buffer Objects {
+    Object gObjects[];
+};
+
+#define uObject gObjects[gl_BaseInstance + INSTANCE_INDEX]
+
+#ifdef MATERIAL_INDEXED
+// Material ID of each object, in objects order, the indexed variant fetches its material by ID
+layout (std430, binding = 9) readonly buffer ObjectMaterials {
+    uint gObjectMaterials[];
+};
+#endif
 
 struct DirectionalLight {
     vec3 direction;
     vec3 color;
     float power;
-    mat4 matrix;
+    mat4 matrices[MAX_CASCADES];
+    vec4 splits; // View depth where each cascade ends
+    uint cascadeCount;
 };
 
 struct PointLight {
@@ -39,6 +83,17 @@ layout (std430, binding = 1) buffer PointLighting {
     PointLight[] gPointLights;
 };
 
+// Shadow atlas tile of a directional cascade or of a point light cube face
+struct ShadowTile {
+    mat4 viewProjection;
+    vec4 rect; // Atlas UV offset, UV size and texel size, an empty tile has no shadow
+};
+
+// Cascades of each directional light, then the 6 faces of each point light
+layout (std430, binding = 8) readonly buffer ShadowTiles {
+    ShadowTile gShadowTiles[];
+};
+
 #stage vertex
 // === VERTEX SHADER ===============================================================================
 layout (location = 0) in vec3 aPosition;
@@ -46,41 +101,84 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec4 aTangent;
 layout (location = 3) in vec2 aTexCoord;
 
+#ifdef STEREO_MULTIVIEW
+layout (num_views = 2) in;
+#endif
+
 out vec3 vPosition;
 out vec3 vNormal;
 out vec3 vTangent;
 out vec3 vBitangent;
 out vec2 vUV;
-out vec3 vLightPosition[MAX_SHADOW_CASTERS];
+flat out uint vView;
+#ifdef MATERIAL_INDEXED
+flat out uint vMaterial;
+#endif
+
+// Must match the depth pre-pass exactly
+invariant gl_Position;
 
 void main() {
-    vPosition = vec3(uScene.ModelTransform * vec4(aPosition, 1.0));
-    vNormal = mat3(uScene.NormalTransform) * aNormal;
-    vTangent = mat3(uScene.NormalTransform) * aTangent.xyz;
-    vBitangent = mat3(uScene.NormalTransform) * aTangent.w * cross(aNormal, aTangent.xyz);
+    vPosition = vec3(uObject.ModelTransform * vec4(aPosition, 1.0));
+    vNormal = mat3(uObject.NormalTransform) * aNormal;
+    vTangent = mat3(uObject.NormalTransform) * aTangent.xyz;
+    vBitangent = mat3(uObject.NormalTransform) * aTangent.w * cross(aNormal, aTangent.xyz);
     vUV = aTexCoord;
-
-    for (uint i = 0; i < gDirectionalLights.length() && i < MAX_SHADOW_CASTERS; ++i) {
-        vec4 lightCoords = gDirectionalLights[i].matrix * vec4(vPosition, 1.0);
-        vLightPosition[i] = lightCoords.xyz / lightCoords.w;
-    }
+    vView = VIEW_INDEX;
+#ifdef MATERIAL_INDEXED
+    vMaterial = gObjectMaterials[gl_BaseInstance + INSTANCE_INDEX];
+#endif
     
-    gl_Position = uScene.ProjectionTransform * uScene.ViewTransform * vec4(vPosition, 1.0);
+    gl_Position = uScene.ProjectionTransforms[VIEW_INDEX] * uScene.ViewTransforms[VIEW_INDEX] * vec4(vPosition, 1.0);
+#ifdef STEREO_INSTANCED
+    gl_Layer = int(VIEW_INDEX);
+#endif
+#ifdef FOVEATED
+    gl_Position.xy = gl_Position.xy * uScene.Regions[REGION_INDEX].xy + uScene.Regions[REGION_INDEX].zw * gl_Position.w;
+    gl_ViewportIndex = int(REGION_INDEX);
+#endif
 }
 
 #stage fragment
 // === FRAGMENT SHADER =============================================================================
 #define PI 3.141592653589793
+#define CLUSTER_MAX_LIGHTS 128u
+#define LIGHT_THRESHOLD 0.01
 
 in vec3 vPosition;
 in vec3 vNormal;
 in vec3 vTangent;
 in vec3 vBitangent;
 in vec2 vUV;
-in vec3 vLightPosition[MAX_SHADOW_CASTERS];
+flat in uint vView;
 
 out vec4 fColor;
 
+#ifdef MATERIAL_INDEXED
+flat in uint vMaterial;
+
+// Parameters of the material block, then the map of each texture slot packed as (array << 16) | layer.
+// Maps follow the slot order: albedo, metal roughness, occlusion, emissive, normal.
+struct PBRMaterial {
+    bool AlbedoMap;
+    bool MetalRoughnessMap;
+    bool NormalMap;
+    bool OcclusionMap;
+    bool EmissiveMap;
+    float MetallicFactor;
+    float RoughnessFactor;
+    vec3 AlbedoFactor;
+    vec3 EmissiveFactor;
+    float AlphaCutoff;
+    uint Maps[5];
+};
+
+layout (std430, binding = 10) readonly buffer Materials {
+    PBRMaterial gMaterials[];
+};
+
+#define uMaterial gMaterials[vMaterial]
+#else
 layout (std140, binding = 2) uniform PBRMaterial {
     bool AlbedoMap;
     bool MetalRoughnessMap;
@@ -91,29 +189,58 @@ layout (std140, binding = 2) uniform PBRMaterial {
     float RoughnessFactor;
     vec3 AlbedoFactor;
     vec3 EmissiveFactor;
-    float AlphaMasking;
+    float AlphaCutoff;
 } uMaterial;
+#endif
+
+// -- Light clusters --
+layout (std140, binding = 3) uniform Clusters {
+    mat4 InverseProjections[2];
+    uvec4 GridSize; // Clusters of each view in w
+    vec4 DepthParams; // near, far, slice scale, slice bias
+    vec2 ScreenSize;
+    uint DebugView;
+} uClusters;
+
+layout (std430, binding = 2) readonly buffer ClusterCounts {
+    uint[] gClusterCounts;
+};
+
+layout (std430, binding = 3) readonly buffer ClusterLights {
+    uint[] gClusterLights;
+};
 
 // -- Texture samplers --
 layout (binding = 0) uniform samplerCube sEnvironment;
-layout (binding = 1) uniform sampler2DArray sShadowMaps;
-layout (binding = 2) uniform samplerCubeArray sShadowCubeMaps;
+layout (binding = 1) uniform sampler2D sShadowAtlas;
 layout (binding = 3) uniform sampler2D sBRDF_LUT;
+#ifdef MATERIAL_INDEXED
+layout (binding = 9) uniform sampler2DArray sMaterialArrays[8];
+
+// Samples the map of a texture slot. Instances of a draw share their material, the array index is dynamically uniform.
+vec4 SampleMap(uint slot, vec2 uv) {
+    const uint map = uMaterial.Maps[slot];
+    return texture(sMaterialArrays[map >> 16], vec3(uv, float(map & 0xFFFFu)));
+}
+
+#define ALBEDO_MAP(uv) SampleMap(0, uv)
+#define METAL_ROUGHNESS_MAP(uv) SampleMap(1, uv)
+#define OCCLUSION_MAP(uv) SampleMap(2, uv)
+#define EMISSIVE_MAP(uv) SampleMap(3, uv)
+#define NORMAL_MAP(uv) SampleMap(4, uv)
+#else
 layout (binding = 4) uniform sampler2D sAlbedoMap;
 layout (binding = 5) uniform sampler2D sMetalRoughnessMap;
 layout (binding = 6) uniform sampler2D sOcclusionMap;
 layout (binding = 7) uniform sampler2D sEmissiveMap;
 layout (binding = 8) uniform sampler2D sNormalMap;
 
-// Shadow maps offset for Cube Map PCF
-const vec3 sampleOffsetDirections[20] = vec3[]
-(
-   vec3( 1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1,  1,  1), 
-   vec3( 1,  1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1,  1, -1),
-   vec3( 1,  1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1,  1,  0),
-   vec3( 1,  0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1,  0, -1),
-   vec3( 0,  1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0,  1, -1)
-);   
+#define ALBEDO_MAP(uv) texture(sAlbedoMap, uv)
+#define METAL_ROUGHNESS_MAP(uv) texture(sMetalRoughnessMap, uv)
+#define OCCLUSION_MAP(uv) texture(sOcclusionMap, uv)
+#define EMISSIVE_MAP(uv) texture(sEmissiveMap, uv)
+#define NORMAL_MAP(uv) texture(sNormalMap, uv)
+#endif
 
 // Computes the irradiance map level corresponding to roughness.
 float MipFromRoughness(float roughness) {
@@ -161,54 +288,97 @@ vec3 FresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
 }
 
-float ComputeShadow(in DirectionalLight light, in vec3 lightCoords, in uint mapLayer, in float cosThetaL) {
-    const int shadowMapLayers = textureSize(sShadowMaps, 0).z;
-    const vec2 shadowTexelSize = 1.0 / textureSize(sShadowMaps, 0).xy;
-    const float actualLayer = max(0, min(shadowMapLayers - 1, floor(mapLayer + 0.5)));
-    
-    float shadow = 0.0;
+// Finds the view space froxel the fragment belongs to, the clusters of each view follow each other.
+// Tiles are found from the view projection rather than the window position, foveation regions have their own viewports.
+uint ComputeCluster() {
+    const uvec3 grid = uClusters.GridSize.xyz;
+    const vec4 viewPosition = uScene.ViewTransforms[vView] * vec4(vPosition, 1.0);
+    const vec4 clipPosition = uScene.ProjectionTransforms[vView] * viewPosition;
+    const float depth = -viewPosition.z;
+    const float slice = floor(log(max(depth, 1e-4)) * uClusters.DepthParams.z + uClusters.DepthParams.w);
+    const vec2 screen = clamp(clipPosition.xy / clipPosition.w * 0.5 + 0.5, 0.0, 1.0);
+    const uvec2 tile = min(uvec2(screen * vec2(grid.xy)), grid.xy - 1);
+
+    return vView * uClusters.GridSize.w + tile.x + grid.x * (tile.y + grid.y * uint(clamp(slice, 0.0, float(grid.z - 1))));
+}
 
-    // Check if fragment is inside light clip space.
-    if (lightCoords.z <= 1.0) {
-        // Remap light coordinates to texture coordinates.
-        const vec3 lightUVs = (lightCoords + 1.0) * 0.5;
-
-        // Compute a bias depending on light angle to avoid shadow acnee.
-        const float bias = max(2e-4 * (1.0 - cosThetaL), 1e-4);    
-        
-        // PCF: Filter shadow map using a moving uniform averaging kernel.
-        const int KERNEL_SZ = 2;
-        for (int x = -KERNEL_SZ; x <= KERNEL_SZ; ++x) {
-            for (int y = -KERNEL_SZ; y <= KERNEL_SZ; ++y) {
-                float closestDepth = texture(sShadowMaps, vec3(lightUVs.xy + vec2(x, y) * shadowTexelSize.xy, actualLayer)).r;
-                shadow += lightUVs.z - bias > closestDepth ? 1.0 : 0.0;
-            }
+// Maps a light count to a blue-green-red heat color.
+vec3 HeatColor(float t) {
+    return clamp(vec3(2.0 * t - 1.0, 1.0 - abs(2.0 * t - 1.0), 1.0 - 2.0 * t), 0.0, 1.0);
+}
+
+// Filters the depth comparisons of a tile around a position, the kernel is clamped to the tile.
+float SampleShadowTile(in ShadowTile tile, in vec2 uv, in float depth, in float depthScale, in int kernelSize) {
+    const vec2 minUV = tile.rect.xy + 0.5 * tile.rect.w;
+    const vec2 maxUV = tile.rect.xy + tile.rect.z - 0.5 * tile.rect.w;
+    const vec2 center = tile.rect.xy + uv * tile.rect.z;
+
+    float shadow = 0.0;
+    for (int x = -kernelSize; x <= kernelSize; ++x) {
+        for (int y = -kernelSize; y <= kernelSize; ++y) {
+            float closestDepth = texture(sShadowAtlas, clamp(center + vec2(x, y) * tile.rect.w, minUV, maxUV)).r * depthScale;
+            shadow += depth > closestDepth ? 1.0 : 0.0;
         }
-        shadow /= ((KERNEL_SZ * 2) + 1) * ((KERNEL_SZ * 2) + 1);
     }
 
-    return shadow;
+    return shadow / float((kernelSize * 2 + 1) * (kernelSize * 2 + 1));
 }
 
-float ComputeCubeShadow(in PointLight light, in vec3 Lvec, in uint mapLayer, in float cosThetaL) {
-    const int shadowMapLayers = textureSize(sShadowCubeMaps, 0).z;
-    const float actualLayer = max(0, min(shadowMapLayers - 1, floor(mapLayer + 0.5)));
+float ComputeShadow(in DirectionalLight light, in uint lightIndex, in float cosThetaL) {
+    // Select the first cascade reaching the fragment, there are no shadows past the last one
+    const float viewDepth = -(uScene.ViewTransforms[vView] * vec4(vPosition, 1.0)).z;
+    uint cascade = 0;
+    while (cascade < light.cascadeCount && viewDepth > light.splits[cascade])
+        ++cascade;
 
-    float shadow = 0.0;
-    float currentDepth = length(Lvec);
+    if (cascade >= light.cascadeCount)
+        return 0.0;
+
+    const ShadowTile tile = gShadowTiles[lightIndex * MAX_CASCADES + cascade];
+    if (tile.rect.z == 0.0)
+        return 0.0;
+
+    const vec4 lightPosition = tile.viewProjection * vec4(vPosition, 1.0);
+    const vec3 lightCoords = lightPosition.xyz / lightPosition.w;
+
+    // Check if fragment is inside light clip space.
+    if (lightCoords.z > 1.0)
+        return 0.0;
 
+    // Remap light coordinates to texture coordinates.
+    const vec3 lightUVs = (lightCoords + 1.0) * 0.5;
 
     // Compute a bias depending on light angle to avoid shadow acnee.
-    const float bias = max(4e-2 * (1.0 - cosThetaL), 3e-2);  
+    const float bias = max(2e-4 * (1.0 - cosThetaL), 1e-4);
+
+    // PCF: Filter shadow map using a moving uniform averaging kernel.
+    return SampleShadowTile(tile, lightUVs.xy, lightUVs.z - bias, 1.0, 2);
+}
 
-    // PCF
-    for (int i = 0; i < 20; ++i) {
-        float closestDepth = texture(sShadowCubeMaps, vec4(-Lvec + sampleOffsetDirections[i] * light.radius, actualLayer)).r * 100.0;
-        shadow += currentDepth - bias > closestDepth ? 1.0 : 0.0;
-    } 
-    shadow /= 20.0;
+float ComputeCubeShadow(in vec3 Lvec, in uint lightIndex, in float cosThetaL) {
+    // Select the cube face the fragment is seen from, faces are ordered +X, -X, +Y, -Y, +Z, -Z
+    const vec3 direction = -Lvec;
+    const vec3 axis = abs(direction);
+    uint face;
+    if (axis.x >= axis.y && axis.x >= axis.z)
+        face = direction.x > 0.0 ? 0 : 1;
+    else if (axis.y >= axis.z)
+        face = direction.y > 0.0 ? 2 : 3;
+    else
+        face = direction.z > 0.0 ? 4 : 5;
+
+    const ShadowTile tile = gShadowTiles[gDirectionalLights.length() * MAX_CASCADES + lightIndex * 6 + face];
+    if (tile.rect.z == 0.0)
+        return 0.0;
+
+    const vec4 lightPosition = tile.viewProjection * vec4(vPosition, 1.0);
+    const vec2 lightUVs = (lightPosition.xy / lightPosition.w + 1.0) * 0.5;
 
-    return shadow;
+    // Compute a bias depending on light angle to avoid shadow acnee.
+    const float bias = max(4e-2 * (1.0 - cosThetaL), 3e-2);
+
+    // PCF on the linear depth, stored as a fraction of the cube far plane
+    return SampleShadowTile(tile, lightUVs, length(Lvec) - bias, 100.0, 1);
 }
 
 void main() {
@@ -216,8 +386,8 @@ void main() {
     vec3 albedo = vec3(1.0);
     float alpha = 1.0;
     if (uMaterial.AlbedoMap) {
-        vec4 albedo_alpha= texture(sAlbedoMap, vUV).rgba;
-        if (albedo_alpha.a < uMaterial.AlphaMasking) discard;
+        vec4 albedo_alpha= ALBEDO_MAP(vUV).rgba;
+        if (albedo_alpha.a < uMaterial.AlphaCutoff) discard;
         albedo = albedo_alpha.rgb;
         alpha = albedo_alpha.a;
     }
@@ -227,7 +397,7 @@ void main() {
     float metallic = 1.0;
     float roughness = 1.0;
     if (uMaterial.MetalRoughnessMap) {
-        vec3 sampl = texture(sMetalRoughnessMap, vUV).rgb;
+        vec3 sampl = METAL_ROUGHNESS_MAP(vUV).rgb;
         metallic = sampl.b;
         roughness = sampl.g;
     }
@@ -236,19 +406,19 @@ void main() {
 
     float ao = 1.0;
     if (uMaterial.OcclusionMap) {
-        ao = texture(sOcclusionMap, vUV).r;
+        ao = OCCLUSION_MAP(vUV).r;
     }
 
     vec3 emissive = vec3(1.0);
     if (uMaterial.EmissiveMap) {
-        emissive = texture(sEmissiveMap, vUV).rgb;
+        emissive = EMISSIVE_MAP(vUV).rgb;
     }
     emissive *= uMaterial.EmissiveFactor;
 
     // Compute normal vector
     vec3 N = normalize(vNormal);
     if (uMaterial.NormalMap) {
-        vec3 normal = texture(sNormalMap, vUV).rgb * 2.0 - 1.0;
+        vec3 normal = NORMAL_MAP(vUV).rgb * 2.0 - 1.0;
         N = normalize(normal.x * vTangent + normal.y * vBitangent + normal.z * vNormal);
         //N = normalize(normal);
     }
@@ -258,7 +428,7 @@ void main() {
     }
 
     // Precompute view and reflected vectors
-    vec3 V = normalize(uScene.EyePosition - vPosition);
+    vec3 V = normalize(uScene.EyePositions[vView].xyz - vPosition);
     vec3 R = reflect(-V, N);
     float cosThetaO = max(dot(N, V), 0.0);
 
@@ -286,7 +456,7 @@ void main() {
         float cosThetaH = max(dot(N, H), 0.0);
        
         // Compute shadow
-        float shadow = (i < MAX_SHADOW_CASTERS) ? ComputeShadow(light, vLightPosition[i], i, cosThetaL) : 0.0;
+        float shadow = ComputeShadow(light, i, cosThetaL);
 
         // Direct specular component (Cook-Torrance)
         vec3 numCT = DistributionGGX(cosThetaH, roughness) * F * GeometrySmith(cosThetaO, cosThetaL, roughness);
@@ -296,8 +466,11 @@ void main() {
         Ld += (1.0 - shadow) * (diffuseDirect + specular) * light.color * light.power * cosThetaL;
     }
 
-    // Point Lights
-    for (uint i = 0; i < gPointLights.length(); ++i) {
+    // Point Lights, only those influencing the fragment cluster
+    const uint cluster = ComputeCluster();
+    const uint clusterLightCount = gClusterCounts[cluster];
+    for (uint c = 0; c < clusterLightCount; ++c) {
+        const uint i = gClusterLights[cluster * CLUSTER_MAX_LIGHTS + c];
         PointLight light = gPointLights[i];
 
         vec3 Lvec = light.position - vPosition;
@@ -309,10 +482,13 @@ void main() {
         float cosThetaH = max(dot(N, H), 0.0);
 
         // Compute shadow
-        float shadow = (i < MAX_SHADOW_CASTERS) ? ComputeCubeShadow(light, Lvec, i, cosThetaL) : 0.0;
+        float shadow = ComputeCubeShadow(Lvec, i, cosThetaL);
 
-        // Attenuation
-        float attenuation = 1.0 / dot(Lvec, Lvec);
+        // Attenuation, windowed to reach zero at the influence radius used for clustering
+        const float distance2 = dot(Lvec, Lvec);
+        const float influence2 = light.power * max(light.color.r, max(light.color.g, light.color.b)) / LIGHT_THRESHOLD;
+        float window = clamp(1.0 - (distance2 * distance2) / (influence2 * influence2), 0.0, 1.0);
+        float attenuation = window * window / distance2;
 
         // Direct specular component (Cook-Torrance)
         vec3 numCT = DistributionGGX(cosThetaH, roughness) * F * GeometrySmith(cosThetaO, cosThetaL, roughness);
@@ -339,5 +515,10 @@ void main() {
     // Apply ambiant occlusion and self-emitted light.
     vec3 color = (Ld + Li) * ao + emissive;
 
-    fColor = vec4(color, alpha);   
+    fColor = vec4(color, alpha);
+
+    // Debug view: number of lights in the fragment cluster
+    if (uClusters.DebugView != 0) {
+        fColor = vec4(HeatColor(float(clusterLightCount) / 32.0), 1.0);
+    }
 }
@@ -1,23 +1,57 @@
 #version 460 core
 
+// Stereo variants draw both eyes at once, the skybox is drawn with one instance per view.
+// Foveated variants also draw every object once per region, into the viewport of the region.
+#if defined(FOVEATED)
+#define REGION_COUNT 2
+#else
+#define REGION_COUNT 1
+#endif
+#if defined(STEREO_INSTANCED) || defined(FOVEATED)
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+#if defined(STEREO_MULTIVIEW)
+#extension GL_OVR_multiview2 : require
+#define VIEW_INDEX gl_ViewID_OVR
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#elif defined(STEREO_INSTANCED)
+#define VIEW_INDEX uint((gl_InstanceID / REGION_COUNT) & 1)
+#define INSTANCE_INDEX (gl_InstanceID / (2 * REGION_COUNT))
+#else
+#define VIEW_INDEX 0u
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#endif
+#define REGION_INDEX uint(gl_InstanceID % REGION_COUNT)
+
 #stage vertex
 // === VERTEX SHADER ===============================================================================
 
+#ifdef STEREO_MULTIVIEW
+layout (num_views = 2) in;
+#endif
+
 layout (location = 0) in vec3 aPos;
 
-layout (std140, binding = 0) uniform Matrices {
-    mat4 modelTransform;
-    mat4 normalTransform;
-    mat4 viewTransform;
-    mat4 projectionTransform;
-    vec4 eyePosition;
+layout (std140, binding = 0) uniform Scene {
+    mat4 viewTransforms[2];
+    mat4 projectionTransforms[2];
+    vec4 eyePositions[2];
+    vec4 regions[2]; // Clip space scale and offset of the foveation regions
+    uint viewCount;
 };
 
 out vec3 position;
 
 void main() {
     position = aPos;
-    gl_Position = (projectionTransform * vec4(mat3(viewTransform) * vec3(aPos), 1.0)).xyww;
+    gl_Position = (projectionTransforms[VIEW_INDEX] * vec4(mat3(viewTransforms[VIEW_INDEX]) * vec3(aPos), 1.0)).xyww;
+#ifdef STEREO_INSTANCED
+    gl_Layer = int(VIEW_INDEX);
+#endif
+#ifdef FOVEATED
+    gl_Position.xy = gl_Position.xy * regions[REGION_INDEX].xy + regions[REGION_INDEX].zw * gl_Position.w;
+    gl_ViewportIndex = int(REGION_INDEX);
+#endif
 }
 
 #stage fragment
@@ -4,22 +4,55 @@
 
 #version 460 core
 
-layout (std140, binding = 0) uniform Matrices {
-    mat4 modelTransform;
-    mat4 normalTransform;
-    mat4 viewTransform;
-    mat4 projectionTransform;
-    vec3 eyePosition;
+// Stereo variants draw both eyes at once, each vertex is transformed by the view of its multiview or instance pair.
+// Foveated variants also draw every object once per region, into the viewport of the region.
+#if defined(FOVEATED)
+#define REGION_COUNT 2
+#else
+#define REGION_COUNT 1
+#endif
+#if defined(STEREO_INSTANCED) || defined(FOVEATED)
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+#if defined(STEREO_MULTIVIEW)
+#extension GL_OVR_multiview2 : require
+#define VIEW_INDEX gl_ViewID_OVR
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#elif defined(STEREO_INSTANCED)
+#define VIEW_INDEX uint((gl_InstanceID / REGION_COUNT) & 1)
+#define INSTANCE_INDEX (gl_InstanceID / (2 * REGION_COUNT))
+#else
+#define VIEW_INDEX 0u
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#endif
+#define REGION_INDEX uint(gl_InstanceID % REGION_COUNT)
+
+layout (std140, binding = 0) uniform Scene {
+    mat4 viewTransforms[2];
+    mat4 projectionTransforms[2];
+    vec4 eyePositions[2];
+    vec4 regions[2]; // Clip space scale and offset of the foveation regions
+    uint viewCount;
 };
 
 #stage vertex
 // ==== VERTEX SHADER ==============================================================================
+#ifdef STEREO_MULTIVIEW
+layout (num_views = 2) in;
+#endif
 
 layout (location = 0) in vec2 aPosition;
 
 void main() {
     vec3 position = vec3(aPosition, 0.0);
-    gl_Position = projectionTransform * viewTransform * vec4(position, 1.0);
+    gl_Position = projectionTransforms[VIEW_INDEX] * viewTransforms[VIEW_INDEX] * vec4(position, 1.0);
+#ifdef STEREO_INSTANCED
+    gl_Layer = int(VIEW_INDEX);
+#endif
+#ifdef FOVEATED
+    gl_Position.xy = gl_Position.xy * regions[REGION_INDEX].xy + regions[REGION_INDEX].zw * gl_Position.w;
+    gl_ViewportIndex = int(REGION_INDEX);
+#endif
 }
 
 #stage fragment
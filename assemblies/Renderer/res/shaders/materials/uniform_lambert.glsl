@@ -4,20 +4,59 @@
 
 #version 460 core
 
-layout (std140, binding = 0) uniform Matrices {
-    mat4 modelTransform;
-    mat4 normalTransform;
-    mat4 viewTransform;
-    mat4 projectionTransform;
-    vec3 eyePosition;
+// Stereo variants draw both eyes at once, each vertex is transformed by the view of its multiview or instance pair.
+// Foveated variants also draw every object once per region, into the viewport of the region.
+#if defined(FOVEATED)
+#define REGION_COUNT 2
+#else
+#define REGION_COUNT 1
+#endif
+#if defined(STEREO_INSTANCED) || defined(FOVEATED)
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+#if defined(STEREO_MULTIVIEW)
+#extension GL_OVR_multiview2 : require
+#define VIEW_INDEX gl_ViewID_OVR
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#elif defined(STEREO_INSTANCED)
+#define VIEW_INDEX uint((gl_InstanceID / REGION_COUNT) & 1)
+#define INSTANCE_INDEX (gl_InstanceID / (2 * REGION_COUNT))
+#else
+#define VIEW_INDEX 0u
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#endif
+#define REGION_INDEX uint(gl_InstanceID % REGION_COUNT)
+
+layout (std140, binding = 0) uniform Scene {
+    mat4 viewTransforms[2];
+    mat4 projectionTransforms[2];
+    vec4 eyePositions[2];
+    vec4 regions[2]; // Clip space scale and offset of the foveation regions
+    uint viewCount;
+};
+
+// Objects of the frame renderables, each instance reads its own from the draw base instance
+struct Object {
+    mat4 ModelTransform;
+    mat4 NormalTransform;
 };
 
+layout (std430, binding = 4) readonly buffer Objects {
+    Object gObjects[];
+};
+
+#define modelTransform gObjects[gl_BaseInstance + INSTANCE_INDEX].ModelTransform
+#define normalTransform gObjects[gl_BaseInstance + INSTANCE_INDEX].NormalTransform
+
 layout (std140, binding = 2) uniform Material {
     vec3 diffuse;
 };
 
 #stage vertex
 // ==== VERTEX SHADER ==============================================================================
+#ifdef STEREO_MULTIVIEW
+layout (num_views = 2) in;
+#endif
 
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aNormal;
@@ -27,7 +66,14 @@ out vec3 Normal;
 void main() {
     vec3 position = vec3(modelTransform * vec4(aPosition, 1.0));
     Normal = vec3(normalTransform * vec4(aNormal, 0.0));
-    gl_Position = projectionTransform * viewTransform * vec4(position, 1.0);
+    gl_Position = projectionTransforms[VIEW_INDEX] * viewTransforms[VIEW_INDEX] * vec4(position, 1.0);
+#ifdef STEREO_INSTANCED
+    gl_Layer = int(VIEW_INDEX);
+#endif
+#ifdef FOVEATED
+    gl_Position.xy = gl_Position.xy * regions[REGION_INDEX].xy + regions[REGION_INDEX].zw * gl_Position.w;
+    gl_ViewportIndex = int(REGION_INDEX);
+#endif
 }
 
 #stage fragment
@@ -0,0 +1,77 @@
+// Depth Pre-Pass Shader
+// Rodolphe VALICON
+// 2025
+
+// Position only, for opaque geometry. The position must be computed exactly as in the material
+// shaders, so that the main pass can test depth with GL_EQUAL.
+
+#version 460 core
+
+// Stereo variants draw both eyes at once, each vertex is transformed by the view of its multiview or instance pair.
+// Foveated variants also draw every object once per region, into the viewport of the region.
+#if defined(FOVEATED)
+#define REGION_COUNT 2
+#else
+#define REGION_COUNT 1
+#endif
+#if defined(STEREO_INSTANCED) || defined(FOVEATED)
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+#if defined(STEREO_MULTIVIEW)
+#extension GL_OVR_multiview2 : require
+#define VIEW_INDEX gl_ViewID_OVR
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#elif defined(STEREO_INSTANCED)
+#define VIEW_INDEX uint((gl_InstanceID / REGION_COUNT) & 1)
+#define INSTANCE_INDEX (gl_InstanceID / (2 * REGION_COUNT))
+#else
+#define VIEW_INDEX 0u
+#define INSTANCE_INDEX (gl_InstanceID / REGION_COUNT)
+#endif
+#define REGION_INDEX uint(gl_InstanceID % REGION_COUNT)
+
+#stage vertex
+// === VERTEX SHADER ===============================================================================
+layout (std140, binding = 0) uniform Scene {
+    mat4 ViewTransforms[2];
+    mat4 ProjectionTransforms[2];
+    vec4 EyePositions[2];
+    vec4 Regions[2]; // Clip space scale and offset of the foveation regions
+    uint ViewCount;
+} uScene;
+
+struct Object {
+    mat4 ModelTransform;
+    mat4 NormalTransform;
+};
+
+// Objects of the frame renderables, each instance reads its own from the draw base instance
+layout (std430, binding = 4) readonly buffer Objects {
+    Object gObjects[];
+};
+
+#define uObject gObjects[gl_BaseInstance + INSTANCE_INDEX]
+
+#ifdef STEREO_MULTIVIEW
+layout (num_views = 2) in;
+#endif
+
+layout (location = 0) in vec3 aPosition;
+
+invariant gl_Position;
+
+void main() {
+    vec3 position = vec3(uObject.ModelTransform * vec4(aPosition, 1.0));
+    gl_Position = uScene.ProjectionTransforms[VIEW_INDEX] * uScene.ViewTransforms[VIEW_INDEX] * vec4(position, 1.0);
+#ifdef STEREO_INSTANCED
+    gl_Layer = int(VIEW_INDEX);
+#endif
+#ifdef FOVEATED
+    gl_Position.xy = gl_Position.xy * uScene.Regions[REGION_INDEX].xy + uScene.Regions[REGION_INDEX].zw * gl_Position.w;
+    gl_ViewportIndex = int(REGION_INDEX);
+#endif
+}
+
+#stage fragment
+// === FRAGMENT SHADER =============================================================================
+void main() {}
@@ -0,0 +1,58 @@
+// Depth Pyramid Shader
+// Rodolphe VALICON
+// 2025
+
+// Builds one level of a farthest depth pyramid. The first level reduces the scene depth buffer, taking every sample
+// of multisampled targets, the following ones halve the previous level. Depths are kept conservative: a texel holds
+// the farthest depth of everything it covers.
+
+#version 460 core
+#stage compute
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0) uniform sampler2DMS uDepthMultisample;
+layout (binding = 1) uniform sampler2D uDepth;
+
+layout (binding = 0, r32f) writeonly uniform image2D uDestination;
+layout (binding = 1, r32f) readonly uniform image2D uSource;
+
+uniform int uLevel;
+uniform int uSampleCount; // 0 for single sampled targets
+uniform ivec2 uDepthSize;
+
+float FetchDepth(ivec2 pixel) {
+    if (uSampleCount == 0)
+        return texelFetch(uDepth, pixel, 0).r;
+
+    float depth = 0.0;
+    for (int s = 0; s < uSampleCount; ++s)
+        depth = max(depth, texelFetch(uDepthMultisample, pixel, s).r);
+    return depth;
+}
+
+void main() {
+    const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 size = imageSize(uDestination);
+    if (any(greaterThanEqual(texel, size)))
+        return;
+
+    float depth = 0.0;
+    if (uLevel == 0) {
+        // A texel covers up to 3 pixels per axis of the depth viewport, at least one when the viewport is scaled down
+        const ivec2 pixelMin = min(texel * uDepthSize / size, uDepthSize - 1);
+        const ivec2 pixelMax = max(min(((texel + 1) * uDepthSize + size - 1) / size, uDepthSize), pixelMin + 1);
+        for (int y = pixelMin.y; y < pixelMax.y; ++y) {
+            for (int x = pixelMin.x; x < pixelMax.x; ++x)
+                depth = max(depth, FetchDepth(ivec2(x, y)));
+        }
+    } else {
+        const ivec2 sourceMax = imageSize(uSource) - 1;
+        for (int y = 0; y < 2; ++y) {
+            for (int x = 0; x < 2; ++x)
+                depth = max(depth, imageLoad(uSource, min(texel * 2 + ivec2(x, y), sourceMax)).r);
+        }
+    }
+
+    imageStore(uDestination, texel, vec4(depth));
+}
@@ -0,0 +1,54 @@
+// Foveated Resolve Shader
+// Rodolphe VALICON
+// 2025
+
+// Upscales the low resolution periphery of a view and composites the full resolution center over it.
+// The center edge is blended with the periphery, so that the resolution change doesn't show as a line.
+
+#version 460 core
+#stage compute
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+#ifdef LAYERED
+layout (binding = 0) uniform sampler2DArray sRegions;
+#else
+layout (binding = 0) uniform sampler2D sRegions;
+#endif
+
+layout (rgba16f, binding = 1) uniform writeonly image2D uResult;
+
+uniform int uLayer = 0;
+uniform ivec4 uDestination;     // Offset and size of the view in the result
+uniform vec4 uCenterRect;       // UV offset and size of the full resolution center in the regions texture
+uniform vec4 uPeripheryRect;    // UV offset and size of the low resolution periphery
+uniform vec2 uTexelSize;        // Texel size of the regions texture
+uniform float uCenterSize;      // Half extent of the center, in NDC
+uniform float uBlendWidth;      // Share of the center blended with the periphery
+
+vec3 SampleRegion(in vec4 rect, in vec2 uv) {
+    // Bilinear taps stay inside the region
+    const vec2 regionUV = clamp(rect.xy + uv * rect.zw, rect.xy + 0.5 * uTexelSize, rect.xy + rect.zw - 0.5 * uTexelSize);
+#ifdef LAYERED
+    return textureLod(sRegions, vec3(regionUV, float(uLayer)), 0.0).rgb;
+#else
+    return textureLod(sRegions, regionUV, 0.0).rgb;
+#endif
+}
+
+void main() {
+    const ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, uDestination.zw))) return;
+
+    const vec2 uv = (vec2(pixel) + 0.5) / vec2(uDestination.zw);
+    const vec2 ndc = uv * 2.0 - 1.0;
+    vec3 color = SampleRegion(uPeripheryRect, uv);
+
+    const float edge = max(abs(ndc.x), abs(ndc.y)) / uCenterSize;
+    if (edge < 1.0) {
+        const vec3 center = SampleRegion(uCenterRect, ndc / uCenterSize * 0.5 + 0.5);
+        color = mix(center, color, smoothstep(1.0 - uBlendWidth, 1.0, edge));
+    }
+
+    imageStore(uResult, uDestination.xy + pixel, vec4(color, 1.0));
+}
@@ -0,0 +1,130 @@
+// GPU Culling Shader
+// Rodolphe VALICON
+// 2025
+
+// Tests the world bounds of every renderable against the view frustum, then against the depth pyramid of the
+// previous frame. Visible renderables are appended to the indirect draw commands of their batch.
+// Only relies on OpenGL 4.6 core features, so that it also runs on software implementations.
+
+#version 460 core
+#stage compute
+
+layout (local_size_x = 64) in;
+
+struct Instance {
+    uint primitive;
+    uint object;
+    uint elementCount;
+    uint firstIndex;
+    int baseVertex;
+    uint batch;
+    uint batchFirst;
+    uint slot;
+};
+
+// World bounds of the flattened primitives, min then max
+layout (std430, binding = 5) readonly buffer Bounds {
+    float gBounds[];
+};
+
+layout (std430, binding = 6) readonly buffer Instances {
+    Instance gInstances[];
+};
+
+// Draw count of each batch, followed by the draw commands
+layout (std430, binding = 7) buffer Draws {
+    uint gDraws[];
+};
+
+layout (binding = 0) uniform sampler2D uPyramid;
+
+uniform vec4 uFrustumPlanes[6];
+uniform mat4 uPyramidViewProjection;
+uniform ivec2 uPyramidSize;
+uniform int uPyramidLevels;
+uniform bool uOcclusion;
+uniform bool uCompact;
+uniform uint uInstanceViews = 1u; // Instances per visible renderable, one per view with instanced stereo
+uniform uint uInstanceCount;
+uniform uint uCommandBase;
+
+bool IsInFrustum(vec3 boxMin, vec3 boxMax) {
+    for (int i = 0; i < 6; ++i) {
+        const vec4 plane = uFrustumPlanes[i];
+        const vec3 positive = mix(boxMin, boxMax, greaterThanEqual(plane.xyz, vec3(0.0)));
+        if (dot(plane.xyz, positive) + plane.w < 0.0)
+            return false;
+    }
+    return true;
+}
+
+bool IsOccluded(vec3 boxMin, vec3 boxMax) {
+    // Screen rectangle and nearest depth of the box, as seen when the pyramid was rendered
+    vec2 ndcMin = vec2(1.0);
+    vec2 ndcMax = vec2(-1.0);
+    float nearestDepth = 1.0;
+    for (int corner = 0; corner < 8; ++corner) {
+        const vec3 position = vec3((corner & 1) == 0 ? boxMin.x : boxMax.x, (corner & 2) == 0 ? boxMin.y : boxMax.y, (corner & 4) == 0 ? boxMin.z : boxMax.z);
+        const vec4 clip = uPyramidViewProjection * vec4(position, 1.0);
+
+        // Boxes crossing the near plane are kept
+        if (clip.w <= 1e-5)
+            return false;
+
+        const vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc.xy);
+        ndcMax = max(ndcMax, ndc.xy);
+        nearestDepth = min(nearestDepth, ndc.z * 0.5 + 0.5);
+    }
+
+    const vec2 rectMin = clamp(ndcMin * 0.5 + 0.5, 0.0, 1.0) * vec2(uPyramidSize);
+    const vec2 rectMax = clamp(ndcMax * 0.5 + 0.5, 0.0, 1.0) * vec2(uPyramidSize);
+
+    // Level where the rectangle spans at most 2x2 texels
+    const float extent = max(max(rectMax.x - rectMin.x, rectMax.y - rectMin.y), 1.0);
+    const int level = clamp(int(ceil(log2(extent))), 0, uPyramidLevels - 1);
+    const ivec2 levelSize = max(uPyramidSize >> level, ivec2(1));
+    const ivec2 texelMin = clamp(ivec2(rectMin) >> level, ivec2(0), levelSize - 1);
+    const ivec2 texelMax = clamp(ivec2(rectMax) >> level, ivec2(0), levelSize - 1);
+
+    float farthestDepth = 0.0;
+    for (int y = texelMin.y; y <= texelMax.y; ++y) {
+        for (int x = texelMin.x; x <= texelMax.x; ++x)
+            farthestDepth = max(farthestDepth, texelFetch(uPyramid, ivec2(x, y), level).r);
+    }
+
+    return nearestDepth > farthestDepth;
+}
+
+void main() {
+    const uint id = gl_GlobalInvocationID.x;
+    if (id >= uInstanceCount)
+        return;
+
+    const Instance instance = gInstances[id];
+    const uint b = instance.primitive * 6;
+    const vec3 boxMin = vec3(gBounds[b + 0], gBounds[b + 1], gBounds[b + 2]);
+    const vec3 boxMax = vec3(gBounds[b + 3], gBounds[b + 4], gBounds[b + 5]);
+
+    bool visible = IsInFrustum(boxMin, boxMax);
+    if (visible && uOcclusion)
+        visible = !IsOccluded(boxMin, boxMax);
+
+    // Compacted commands are appended to their batch, otherwise each renderable owns a command
+    uint slot = instance.slot;
+    if (visible) {
+        const uint index = atomicAdd(gDraws[instance.batch], 1u);
+        if (uCompact)
+            slot = instance.batchFirst + index;
+    } else if (uCompact) {
+        return;
+    }
+
+    // The base instance holds the object index read by the instanced shader variants
+    const uint command = uCommandBase + slot * 5;
+    gDraws[command + 0] = instance.elementCount;
+    gDraws[command + 1] = visible ? uInstanceViews : 0u;
+    gDraws[command + 2] = instance.firstIndex;
+    gDraws[command + 3] = uint(instance.baseVertex);
+    gDraws[command + 4] = instance.object;
+}
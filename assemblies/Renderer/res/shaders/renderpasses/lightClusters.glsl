@@ -0,0 +1,121 @@
+// Light Clustering Shader
+// Rodolphe VALICON
+// 2025
+
+// Bins the point lights into view space froxels, using their influence radius.
+// Each invocation builds the light list of one cluster, lights are streamed through shared memory.
+// Stereo frames have a grid per eye, the work group Y coordinate selects the view.
+
+#version 460 core
+#stage compute
+
+#define CLUSTER_MAX_LIGHTS 128u
+#define LIGHT_THRESHOLD 0.01
+#define BATCH_SIZE 128
+
+layout (local_size_x = BATCH_SIZE) in;
+
+layout (std140, binding = 0) uniform Scene {
+    mat4 ViewTransforms[2];
+    mat4 ProjectionTransforms[2];
+    vec4 EyePositions[2];
+    uint ViewCount;
+} uScene;
+
+layout (std140, binding = 3) uniform Clusters {
+    mat4 InverseProjections[2];
+    uvec4 GridSize; // Clusters of each view in w
+    vec4 DepthParams; // near, far, slice scale, slice bias
+    vec2 ScreenSize;
+    uint DebugView;
+} uClusters;
+
+struct PointLight {
+    vec3 position;
+    vec3 color;
+    float power;
+    float radius;
+};
+
+layout (std430, binding = 1) readonly buffer PointLighting {
+    PointLight[] gPointLights;
+};
+
+layout (std430, binding = 2) writeonly buffer ClusterCounts {
+    uint[] gClusterCounts;
+};
+
+layout (std430, binding = 3) writeonly buffer ClusterLights {
+    uint[] gClusterLights;
+};
+
+// View space position and influence radius of the current batch of lights
+shared vec4 sLights[BATCH_SIZE];
+
+// View space point on the eye ray through a NDC position, at a given distance along -Z.
+vec3 PointAtDepth(uint view, vec2 ndc, float depth) {
+    vec4 nearPoint = uClusters.InverseProjections[view] * vec4(ndc, -1.0, 1.0);
+    vec3 direction = nearPoint.xyz / nearPoint.w;
+    return direction * (depth / -direction.z);
+}
+
+float SquaredDistanceToBox(vec3 point, vec3 boxMin, vec3 boxMax) {
+    vec3 d = max(max(boxMin - point, point - boxMax), 0.0);
+    return dot(d, d);
+}
+
+void main() {
+    const uvec3 grid = uClusters.GridSize.xyz;
+    const uint clusterCount = grid.x * grid.y * grid.z;
+    const uint view = gl_WorkGroupID.y;
+    const uint cluster = gl_GlobalInvocationID.x;
+    const bool inGrid = cluster < clusterCount;
+
+    // Cluster bounds, in view space
+    const uvec3 coords = uvec3(cluster % grid.x, (cluster / grid.x) % grid.y, cluster / (grid.x * grid.y));
+    const vec2 ndcMin = vec2(coords.xy) / vec2(grid.xy) * 2.0 - 1.0;
+    const vec2 ndcMax = vec2(coords.xy + 1) / vec2(grid.xy) * 2.0 - 1.0;
+
+    const float near = uClusters.DepthParams.x;
+    const float far = uClusters.DepthParams.y;
+    const float sliceNear = near * pow(far / near, float(coords.z) / float(grid.z));
+    const float sliceFar = near * pow(far / near, float(coords.z + 1) / float(grid.z));
+
+    vec3 boxMin = vec3(1e30);
+    vec3 boxMax = vec3(-1e30);
+    for (uint corner = 0; corner < 4; ++corner) {
+        const vec2 ndc = vec2((corner & 1) == 0 ? ndcMin.x : ndcMax.x, (corner & 2) == 0 ? ndcMin.y : ndcMax.y);
+        const vec3 nearCorner = PointAtDepth(view, ndc, sliceNear);
+        const vec3 farCorner = PointAtDepth(view, ndc, sliceFar);
+        boxMin = min(boxMin, min(nearCorner, farCorner));
+        boxMax = max(boxMax, max(nearCorner, farCorner));
+    }
+
+    // Test every light against the cluster, one shared memory batch at a time
+    const uint lightCount = gPointLights.length();
+    uint count = 0;
+    for (uint base = 0; base < lightCount; base += uint(BATCH_SIZE)) {
+        const uint i = base + gl_LocalInvocationIndex;
+        if (i < lightCount) {
+            PointLight light = gPointLights[i];
+            const float intensity = light.power * max(light.color.r, max(light.color.g, light.color.b));
+            const float influence = sqrt(max(intensity, 0.0) / LIGHT_THRESHOLD);
+            sLights[gl_LocalInvocationIndex] = vec4((uScene.ViewTransforms[view] * vec4(light.position, 1.0)).xyz, influence);
+        }
+        barrier();
+
+        const uint batchSize = min(uint(BATCH_SIZE), lightCount - base);
+        for (uint j = 0; inGrid && j < batchSize; ++j) {
+            const vec4 light = sLights[j];
+            if (light.w > 0.0 && SquaredDistanceToBox(light.xyz, boxMin, boxMax) <= light.w * light.w) {
+                if (count < CLUSTER_MAX_LIGHTS)
+                    gClusterLights[(view * clusterCount + cluster) * CLUSTER_MAX_LIGHTS + count] = base + j;
+                ++count;
+            }
+        }
+        barrier();
+    }
+
+    if (inGrid)
+        gClusterCounts[view * clusterCount + cluster] = min(count, CLUSTER_MAX_LIGHTS);
+}
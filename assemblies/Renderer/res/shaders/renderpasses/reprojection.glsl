@@ -0,0 +1,71 @@
+// Reprojection Shader
+// Rodolphe VALICON
+// 2025
+
+// Warps the last completed frame of a view with a newer pose. A grid covering the frame is moved by the depth it was
+// drawn at, or rotated only when the depth is unknown. Triangles folding over each other are sorted by the depth test.
+
+#version 460 core
+
+#ifdef LAYERED
+layout (binding = 0) uniform sampler2DArray sColor;
+layout (binding = 1) uniform sampler2DArray sDepth;
+#else
+layout (binding = 0) uniform sampler2D sColor;
+layout (binding = 1) uniform sampler2D sDepth;
+#endif
+
+uniform int uLayer = 0;
+uniform vec2 uFrameScale = vec2(1.0);  // Share of the kept frame textures drawn, from their origin
+
+#stage vertex
+// === Vertex Shader ===============================================================================
+
+layout(location = 0) in vec2 aPosition;     // UV of the vertex in the kept frame
+
+out vec2 vUV;
+
+uniform mat4 uInverseProjection;    // Projection the frame was drawn with
+uniform mat4 uReprojection;         // View space of the frame to the clip space of the newest pose
+uniform bool uPositional = false;
+
+float FrameDepth(in vec2 uv) {
+    // Nearest of the texels around the vertex, so that foreground edges cover the gaps they open
+#ifdef LAYERED
+    const vec4 depths = textureGather(sDepth, vec3(uv * uFrameScale, float(uLayer)));
+#else
+    const vec4 depths = textureGather(sDepth, uv * uFrameScale);
+#endif
+    return min(min(depths.x, depths.y), min(depths.z, depths.w));
+}
+
+void main() {
+    const float depth = uPositional ? FrameDepth(aPosition) : 1.0;
+    vec4 viewPosition = uInverseProjection * vec4(aPosition * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    viewPosition /= viewPosition.w;
+
+    // The sky and rotation only reprojection move directions, which stay on the far plane
+    if (uPositional && depth < 1.0) {
+        gl_Position = uReprojection * vec4(viewPosition.xyz, 1.0);
+    } else {
+        gl_Position = uReprojection * vec4(viewPosition.xyz, 0.0);
+        gl_Position.z = gl_Position.w;
+    }
+
+    vUV = aPosition;
+}
+
+#stage fragment
+// === Fragment Shader =============================================================================
+
+in vec2 vUV;
+
+out vec4 FragColor;
+
+void main() {
+#ifdef LAYERED
+    FragColor = vec4(texture(sColor, vec3(vUV * uFrameScale, float(uLayer))).rgb, 1.0);
+#else
+    FragColor = vec4(texture(sColor, vUV * uFrameScale).rgb, 1.0);
+#endif
+}
@@ -38,6 +38,7 @@ uniform float uChromaticAbberation = 0.0;
 uniform int uTonemapper = 0;
 uniform float uSaturation = 1.0;
 uniform float uLuminosity = 1.0;
+uniform vec2 uViewportScale = vec2(1.0);   // Share of the screen texture drawn this frame, from its origin
 
 
 // --- Modified from: https://64.github.io/tonemapping/
@@ -105,10 +106,16 @@ vec3 hsv2rgb(vec3 c)
 // ----------------------------------------------
 
 
+// Samples the drawn viewport, bilinear taps don't reach the texels out of it
+vec4 viewportSample(vec2 UV) {
+    const vec2 halfTexel = 0.5 / vec2(textureSize(screenTexture, 0));
+    return texture(screenTexture, clamp(UV * uViewportScale, halfTexel, uViewportScale - halfTexel));
+}
+
 vec3 chromaticAbberatedSample(vec2 UV) {
-    float r = texture(screenTexture, UV + uChromaticAbberation * 0.01 * vec2(cos(1 * 2 * 3.14/3), sin(1 * 2 * 3.14/3))).r;
-    float g = texture(screenTexture, UV + uChromaticAbberation * 0.01 * vec2(cos(2 * 2 * 3.14/3), sin(2 * 2 * 3.14/3))).g;
-    float b = texture(screenTexture, UV + uChromaticAbberation * 0.01 * vec2(cos(3 * 2 * 3.14/3), sin(3 * 3.14/3))).b;
+    float r = viewportSample(UV + uChromaticAbberation * 0.01 * vec2(cos(1 * 2 * 3.14/3), sin(1 * 2 * 3.14/3))).r;
+    float g = viewportSample(UV + uChromaticAbberation * 0.01 * vec2(cos(2 * 2 * 3.14/3), sin(2 * 2 * 3.14/3))).g;
+    float b = viewportSample(UV + uChromaticAbberation * 0.01 * vec2(cos(3 * 2 * 3.14/3), sin(3 * 3.14/3))).b;
 
     return vec3(r, g, b);
 }
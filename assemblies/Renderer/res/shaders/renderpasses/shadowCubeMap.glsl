@@ -6,13 +6,17 @@
 
 #stage vertex
 // === VERTEX SHADER ===============================================================================
-layout (std140, binding = 0) uniform Scene {
+struct Object {
     mat4 ModelTransform;
     mat4 NormalTransform;
-    mat4 ViewTransform;
-    mat4 ProjectionTransform;
-    vec3 EyePosition;
-} uScene;
+};
+
+// Objects of the frame renderables, each instance reads its own from the draw base instance
+layout (std430, binding = 4) readonly buffer Objects {
+    Object gObjects[];
+};
+
+#define uObject gObjects[gl_BaseInstance + gl_InstanceID]
 
 struct PointLight {
     vec3 position;
@@ -34,7 +38,7 @@ out vec3 vPosition;
 out vec3 lightPosition;
 
 void main() {
-    vec4 position = uScene.ModelTransform * vec4(aPosition, 1.0);
+    vec4 position = uObject.ModelTransform * vec4(aPosition, 1.0);
     vPosition = position.xyz;
     lightPosition = gPointLights[uLightIndex].position;
 
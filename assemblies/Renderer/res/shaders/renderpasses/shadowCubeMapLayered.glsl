@@ -0,0 +1,69 @@
+// Shadow Cube Mapping Shader - Single pass layered variant
+// Rodolphe VALICON
+// 2025
+
+// Each instance renders the primitive into one of the cube faces it overlaps,
+// selecting the viewport of the face atlas tile from the vertex shader.
+
+#version 460 core
+#extension GL_ARB_shader_viewport_layer_array : require
+
+#stage vertex
+// === VERTEX SHADER ===============================================================================
+struct Object {
+    mat4 ModelTransform;
+    mat4 NormalTransform;
+};
+
+// Objects of the frame renderables, instances broadcast the draw object to several faces
+layout (std430, binding = 4) readonly buffer Objects {
+    Object gObjects[];
+};
+
+#define uObject gObjects[gl_BaseInstance]
+
+struct PointLight {
+    vec3 position;
+    vec3 color;
+    float power;
+    float radius;
+};
+
+layout (std430, binding = 1) buffer PointLights {
+    PointLight[] gPointLights;
+};
+
+uniform uint uLightIndex = 0;
+uniform mat4 uLightViewProj[6];
+uniform uint uFaces[6];
+
+layout (location = 0) in vec3 aPosition;
+
+out vec3 vPosition;
+out vec3 lightPosition;
+
+void main() {
+    uint face = uFaces[gl_InstanceID];
+
+    vec4 position = uObject.ModelTransform * vec4(aPosition, 1.0);
+    vPosition = position.xyz;
+    lightPosition = gPointLights[uLightIndex].position;
+
+    gl_Position = uLightViewProj[face] * position;
+    gl_ViewportIndex = int(face);
+}
+
+#stage fragment
+// === FRAGMENT SHADER =============================================================================
+in vec3 vPosition;
+in vec3 lightPosition;
+
+void main() {
+    if (!gl_FrontFacing) discard;
+
+    // Linear depth
+    float d = length(vPosition - lightPosition);
+
+    // Map to [0.0, 1.0] range
+    gl_FragDepth = d / 100.0;
+}
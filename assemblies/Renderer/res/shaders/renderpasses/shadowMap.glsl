@@ -6,31 +6,25 @@
 
 #stage vertex
 // === VERTEX SHADER ===============================================================================
-layout (std140, binding = 0) uniform Scene {
+struct Object {
     mat4 ModelTransform;
     mat4 NormalTransform;
-    mat4 ViewTransform;
-    mat4 ProjectionTransform;
-    vec3 EyePosition;
-} uScene;
-
-struct DirectionalLight {
-    vec3 direction;
-    vec3 color;
-    float power;
-    mat4 matrix;
 };
 
-uniform uint uLightIndex = 0;
-
-layout (std430, binding = 0) buffer DirectionalLights {
-    DirectionalLight[] gDirectionalLights;
+// Objects of the frame renderables, each instance reads its own from the draw base instance
+layout (std430, binding = 4) readonly buffer Objects {
+    Object gObjects[];
 };
 
+#define uObject gObjects[gl_BaseInstance + gl_InstanceID]
+
+// Projection of the rendered cascade
+uniform mat4 uLightViewProj;
+
 layout (location = 0) in vec3 aPosition;
 
 void main() {
-    gl_Position = gDirectionalLights[uLightIndex].matrix * uScene.ModelTransform * vec4(aPosition, 1.0);
+    gl_Position = uLightViewProj * uObject.ModelTransform * vec4(aPosition, 1.0);
 }
 
 #stage fragment
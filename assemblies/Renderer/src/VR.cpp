@@ -3,14 +3,81 @@
 // 2025
 
 #include "VR.h"
+#include "gpu/StateCache.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <iostream>
+#include <optional>
+#include <random>
+#include <utility>
 
 #include <imgui.h>
 #include <GLFW/glfw3.h>
 
 using namespace vr;
 
+// Renderer state shown by the UI, copied by the render thread after each frame
+struct RenderReport {
+	Renderer::Stats stats;
+	StereoMode stereoMode = StereoMode::Mono;
+	bool foveated = false;
+	float shadedRatio = 1.0f;
+	Reprojection::Stats reprojection;
+	DynamicResolution::Stats dynamicResolution;
+	glm::ivec2 viewport{ 0 };
+	uint32_t renderables = 0;
+	GpuCuller::Stats gpuCulling;
+	size_t gpuBatches = 0;
+	bool gpuCompacting = false;
+	RenderGraph::Stats renderGraph;
+	ShadowScheduler::Stats shadows;
+	uint32_t atlasSize = 0;
+	uint32_t atlasTiles = 0;
+	size_t atlasMemory = 0;
+	uint32_t bvhObjects = 0;
+	uint32_t bvhNodes = 0;
+	float bvhDegradation = 1.0f;
+	SceneBVH::Stats bvh;
+	uint32_t updatedTransforms = 0;
+};
+
+// Adjustable uniforms of the screen shader
+struct ScreenUniforms {
+	gpu::UniformHandle<float> gamma;
+	gpu::UniformHandle<float> exposure;
+	gpu::UniformHandle<float> chromaticAbberation;
+	gpu::UniformHandle<float> saturation;
+	gpu::UniformHandle<float> luminosity;
+	gpu::UniformHandle<int32_t> tonemapper;
+};
+
+// Frame handed over to the render thread, it leaves its results in it for the update thread
+struct GameSnapshot final : FrameSnapshot {
+	SceneSnapshot scene;
+	Camera camera;
+	Renderer::Settings rendererSettings;
+	bool stereo = false;
+	float eyeSeparation = 0.0f;
+	bool headMotion = false;
+	bool bloomEnable = true;
+	std::optional<Ray> pickRay;
+	bool reloadSponza = false;
+	bool staticBatching = true;
+
+	// Results of the render thread
+	RenderReport report;
+	bool picked = false;				// Whether the pick ray was cast against the entities of the frame
+	uint32_t pickedEntity = EntityStore::s_NO_ENTITY;
+	std::shared_ptr<Mesh> loadedSponza;	// Loaded with the context, swapped into the scene by the update thread
+
+	void release() override {
+		FrameSnapshot::release();
+		scene.release();
+	}
+};
+
 class GameApp final : public Application {
 public:
 	GameApp() : Application(1920, 1080, "VR Renderer") {
@@ -37,7 +104,7 @@ public:
 		auto cube = utils::loadGLTFMesh("res/models/cube-emissive/Cube.gltf", 0);
 		cube->transform.scale = glm::vec3(0.05f);
 		cube->transform.translation = glm::vec3(0.5f, 0.1f, 0.0f);
-		m_scene.meshes.push_back(cube);
+		m_scene.entities.add(*cube);
 
 		m_scene.pointLights.push_back(PointLight{
 			.position = cube->transform.translation,
@@ -49,29 +116,41 @@ public:
 		cube = utils::loadGLTFMesh("res/models/cube-emissive/Cube.gltf", 0);
 		cube->transform.scale = glm::vec3(0.05f);
 		cube->transform.translation = glm::vec3(-0.5f, 0.1f, 0.0f);
-		m_scene.meshes.push_back(cube);
+		m_scene.entities.add(*cube);
 
 		m_scene.pointLights.push_back(PointLight{
 			.position = cube->transform.translation,
 			.color = glm::vec3(0.0f, 1.0f, 0.0f),
 			.power = 0.0f,
 			});
+		m_scenePointLightCount = m_scene.pointLights.size();
 
 		// Sponza scene
-		auto sponza = utils::loadGLTFMesh("res/models/sponza/Sponza.gltf", 0);
-		sponza->transform.scale = glm::vec3(0.002f); // Scene is huuuuuge.
-		m_scene.meshes.push_back(sponza);
+		m_sponzaEntity = m_scene.entities.add(*loadSponza(m_staticBatching));
 
 		// Damaged Helmet
 		auto helmet = utils::loadGLTFMesh("res/models/helmet/DamagedHelmet.gltf", 0);
 		helmet->transform.scale = glm::vec3(0.1f);
 		helmet->transform.rotation = glm::angleAxis(glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_scene.meshes.push_back(helmet);
+		m_scene.entities.add(*helmet);
+		m_sceneEntityCount = m_scene.entities.getCount();
+
+		// Placed by the stress test, loaded while the context is still current on this thread
+		m_stressCube = utils::loadGLTFMesh("res/models/cube-emissive/Cube.gltf", 0);
+		m_stressCube->transform.scale = glm::vec3(0.005f);
+		m_stressCube->isStatic = true;
 
 		// Initialize renderer and effects
-		m_renderTarget = std::make_shared<RenderTarget>(1920, 1080, 4);
-		m_renderer = std::make_unique<Renderer>(m_renderTarget);
+		createRenderer(1920, 1080, m_stereo, m_targetScale);
 		m_screenShader = std::make_unique<gpu::ShaderProgram>("res/shaders/renderpasses/screen.glsl");
+		m_screenUniforms = {
+			.gamma = m_screenShader->getUniform<float>("uGamma"),
+			.exposure = m_screenShader->getUniform<float>("uExposure"),
+			.chromaticAbberation = m_screenShader->getUniform<float>("uChromaticAbberation"),
+			.saturation = m_screenShader->getUniform<float>("uSaturation"),
+			.luminosity = m_screenShader->getUniform<float>("uLuminosity"),
+			.tonemapper = m_screenShader->getUniform<int32_t>("uTonemapper"),
+		};
 		
 		// Implemented lens dirt, but i find the effect rather bad. Maybe it's the fault of the dirt texture.
 		std::shared_ptr<Image> lensImage = utils::loadImage("res/textures/lens_dirt.jpg", GL_UNSIGNED_BYTE);
@@ -82,14 +161,32 @@ public:
 		m_bloom = std::make_unique<Bloom>(lensDirtTexture);
 
 		// MSAA for main render pass.
-		glEnable(GL_MULTISAMPLE);
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.enable(GL_MULTISAMPLE);
 		
 		// Alpha Blending.
-		glEnable(GL_BLEND);
+		state.enable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	}
 
 protected:
+	static std::shared_ptr<Mesh> loadSponza(bool staticBatching) {
+		Transform transform;
+		transform.scale = glm::vec3(0.002f); // Scene is huuuuuge.
+
+		if (!staticBatching) {
+			auto sponza = utils::loadGLTFMesh("res/models/sponza/Sponza.gltf", 0);
+			sponza->transform = transform;
+			sponza->isStatic = true;
+			return sponza;
+		}
+
+		// Merge the primitives sharing a material, with the transform baked into the vertices
+		utils::StaticBatcher batcher;
+		utils::batchGLTFMesh("res/models/sponza/Sponza.gltf", 0, transform.getModelMatrix(), batcher);
+		return batcher.build();
+	}
+
 	~GameApp() {
 		logger::debug("Bye!");
 	}
@@ -99,8 +196,7 @@ protected:
 
 		// On resize we need to resize the render target, and thus recreate the renderer
 		dispatcher.dispatch<events::WindowResizeEvent>([this](const events::WindowResizeEvent& e) {
-			m_renderTarget = std::make_shared<RenderTarget>(e.width, e.height, 4);
-			m_renderer = std::make_unique<Renderer>(m_renderTarget);
+			enqueueRenderCommand([this, width = e.width, height = e.height, stereo = m_stereo, scale = m_targetScale]() { createRenderer(width, height, stereo, scale); });
 			return false;
 		});
 
@@ -110,9 +206,11 @@ protected:
 				stop();
 			} else if (e.pressed && e.key == GLFW_KEY_R) {
 				// Reload every shaders
-				MaterialRegistry::reloadMaterials();
-				m_screenShader->reload();
-				m_bloom->reload();
+				enqueueRenderCommand([this]() {
+					MaterialRegistry::reloadMaterials();
+					m_screenShader->reload();
+					m_bloom->reload();
+				});
 			}
 			return false;
 		});
@@ -123,22 +221,17 @@ protected:
 		m_cameraController.handle_input();
 		m_cameraController.update(m_camera, deltaTime);
 
-		// Update meshes & materials
+		// Update entities & materials
+		EntityStore& entities = m_scene.entities;
 		for (uint32_t i = 0; i < 2; ++i) {
 			PointLight& light = m_scene.pointLights[i];
 
 			// Sync cube and point light
-			auto& cube = m_scene.meshes[i];
-			cube->transform.translation = light.position;
-			auto& cubeMat = cube->primitives[0].material;
+			entities.getTransform(i).translation = light.position;
+			auto& cubeMat = entities.getPrimitive(entities.getFirstRenderable(i)).material;
 			cubeMat->set("EmissiveFactor", light.color * light.power);
 		}
 		
-		// Update lights
-		// Makes the directional light frustum follow the main camera
-		for (DirectionalLight& light : m_scene.directionalLights)
-			light.computeMatrix(m_camera, m_directionalFrustumSize);
-
 
 		// Model rotation with mouse
 		static glm::vec2 modelRot(0.0f);
@@ -148,10 +241,23 @@ protected:
 			modelRot += glm::vec2(x, y) * 0.0002f;
 		}
 
+		// Entity picking with the middle mouse button, the render thread casts the ray against the entities it drew
+		if (input::isButtonDown(MouseButton::Middle) && !input::wasButtonDown(MouseButton::Middle) && !ImGui::GetIO().WantCaptureMouse) {
+			float x, y;
+			input::getMousePosition(x, y);
+			const glm::vec2 ndc(2.0f * x / getWindow().getWidth() - 1.0f, 1.0f - 2.0f * y / getWindow().getHeight());
+			const glm::mat4 inverseViewProj = glm::inverse(m_camera.getProjectionMatrix() * m_camera.getViewMatrix());
+			const glm::vec4 nearPoint = inverseViewProj * glm::vec4(ndc, -1.0f, 1.0f);
+			const glm::vec4 farPoint = inverseViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+
+			m_pickRay = Ray{ glm::vec3(nearPoint) / nearPoint.w, glm::vec3(farPoint) / farPoint.w - glm::vec3(nearPoint) / nearPoint.w };
+		}
+
 		glm::vec3 right = glm::normalize(glm::cross(m_camera.forward, m_camera.up));
-		if (auto mesh = m_selectedMesh.lock()) {
-			mesh->transform.rotation = glm::normalize(glm::angleAxis(modelRot.x, glm::vec3(0.0f, 1.0f, 0.0f)) * mesh->transform.rotation);
-			mesh->transform.rotation = glm::normalize(glm::angleAxis(modelRot.y, right) * mesh->transform.rotation);
+		if (m_selectedEntity < entities.getCount()) {
+			Transform& transform = entities.getTransform(m_selectedEntity);
+			transform.rotation = glm::normalize(glm::angleAxis(modelRot.x, glm::vec3(0.0f, 1.0f, 0.0f)) * transform.rotation);
+			transform.rotation = glm::normalize(glm::angleAxis(modelRot.y, right) * transform.rotation);
 		}
 		modelRot /= 1.1f;
 	}
@@ -160,13 +266,84 @@ protected:
 		// TODO: Add physics here
 	}
 
-	virtual void onRender() override {
-		m_renderer->beginScene(m_camera);
-		m_renderer->submit(m_scene);
-		m_renderer->endScene();
-		if (m_bloomEnable)
-			m_renderer->postprocess(*m_bloom);
+	virtual std::unique_ptr<FrameSnapshot> createSnapshot() override {
+		return std::make_unique<GameSnapshot>();
+	}
+
+	virtual void onSnapshot(FrameSnapshot& frame) override {
+		GameSnapshot& snapshot = static_cast<GameSnapshot&>(frame);
+		snapshot.scene.capture(m_scene);
+		snapshot.camera = m_camera;
+		snapshot.rendererSettings = m_rendererSettings;
+		snapshot.stereo = m_stereo;
+		snapshot.eyeSeparation = m_eyeSeparation;
+		snapshot.headMotion = m_headMotion;
+		snapshot.bloomEnable = m_bloomEnable;
+		snapshot.pickRay = m_pickRay;
+		snapshot.reloadSponza = std::exchange(m_reloadSponza, false);
+		snapshot.staticBatching = m_staticBatching;
+	}
+
+	virtual void onFrameRendered(FrameSnapshot& frame) override {
+		GameSnapshot& snapshot = static_cast<GameSnapshot&>(frame);
+		m_report = snapshot.report;
+
+		if (snapshot.picked) {
+			if (snapshot.pickedEntity != EntityStore::s_NO_ENTITY)
+				m_selectedEntity = snapshot.pickedEntity;
+			m_pickRay.reset();
+			snapshot.picked = false;
+			snapshot.pickedEntity = EntityStore::s_NO_ENTITY;
+		}
+
+		// The previous Sponza holds GL objects, it is released by the render thread
+		if (snapshot.loadedSponza) {
+			std::vector<Primitive> previous = m_scene.entities.setPrimitives(m_sponzaEntity, snapshot.loadedSponza->primitives);
+			retire(std::make_shared<std::vector<Primitive>>(std::move(previous)));
+			snapshot.loadedSponza.reset();
+		}
+	}
+
+	virtual void onRender(FrameSnapshot& frame) override {
+		GameSnapshot& snapshot = static_cast<GameSnapshot&>(frame);
+		snapshot.scene.applyMaterialDeltas();
+		if (snapshot.reloadSponza)
+			snapshot.loadedSponza = loadSponza(snapshot.staticBatching);
+
+		m_renderer->getSettings() = snapshot.rendererSettings;
+		if (m_renderer->beginFrame()) {
+			const Camera head = sampleHeadPose(snapshot);
+			if (snapshot.stereo) {
+				const auto [leftEye, rightEye] = eyeCameras(head, snapshot.eyeSeparation);
+				m_renderer->beginScene(leftEye, rightEye);
+			} else {
+				m_renderer->beginScene(head);
+			}
+			m_renderer->submit(snapshot.scene);
+			m_renderer->endScene();
+			if (snapshot.bloomEnable)
+				m_renderer->postprocess(*m_bloom);
+
+			// The BVH matches the entities of the snapshot once they are submitted
+			if (snapshot.pickRay) {
+				SceneBVH::Item item;
+				if (m_renderer->getSceneBVH().raycast(*snapshot.pickRay, 1.0f, item))
+					snapshot.pickedEntity = item.entity;
+				snapshot.picked = true;
+			}
+		}
+
+		// Newest pose, sampled right before the frame is presented
+		const Camera head = sampleHeadPose(snapshot);
+		if (snapshot.stereo) {
+			const auto [leftEye, rightEye] = eyeCameras(head, snapshot.eyeSeparation);
+			m_renderer->reproject(leftEye, rightEye);
+		} else {
+			m_renderer->reproject(head);
+		}
 		m_renderer->display(*m_screenShader);
+
+		reportStats(snapshot.report);
 	}
 
 	virtual void onUI() override {
@@ -182,6 +359,85 @@ protected:
 				}
 				ImGui::EndCombo();
 			}
+			ImGui::Checkbox("Light clusters debug view", &m_rendererSettings.clusterDebugView);
+			ImGui::Checkbox("Depth pre-pass", &m_rendererSettings.depthPrepass);
+			ImGui::Checkbox("Occlusion culling", &m_rendererSettings.occlusionCulling);
+			ImGui::Checkbox("GPU culling", &m_rendererSettings.gpuCulling);
+			ImGui::Checkbox("Instancing", &m_rendererSettings.instancing);
+			ImGui::Checkbox("Parallel recording", &m_rendererSettings.parallelRecording);
+			ImGui::Checkbox("Indexed materials", &m_rendererSettings.indexedMaterials);
+			if (ImGui::Checkbox("Stereo", &m_stereo)) {
+				enqueueRenderCommand([this, width = getWindow().getWidth(), height = getWindow().getHeight(), stereo = m_stereo, scale = m_targetScale]() {
+					createRenderer(width, height, stereo, scale);
+				});
+			}
+			if (m_stereo) {
+				static const char* stereoModes[] = { "left eye only", "multiview", "instanced" };
+				ImGui::SliderFloat("Eye separation", &m_eyeSeparation, 0.0f, 0.2f, "%.3f m");
+				ImGui::Checkbox("Multiview", &m_rendererSettings.multiview);
+				ImGui::Text("Stereo path: %s", stereoModes[static_cast<size_t>(m_report.stereoMode)]);
+			}
+
+			Foveation::Settings& foveation = m_rendererSettings.foveation;
+			ImGui::Checkbox("Foveated rendering", &foveation.enabled);
+			if (foveation.enabled) {
+				ImGui::SliderFloat("Foveation center", &foveation.centerSize, 0.1f, 1.0f);
+				ImGui::SliderFloat("Periphery scale", &foveation.peripheryScale, 0.1f, 1.0f);
+				ImGui::SliderFloat("Foveation blend", &foveation.blendWidth, 0.0f, 0.5f);
+				if (m_report.foveated)
+					ImGui::Text("Shaded pixels: %.0f%% of full resolution", 100.0f * m_report.shadedRatio);
+				else
+					ImGui::Text("Foveated rendering is not supported");
+			}
+
+			Reprojection::Settings& reprojection = m_rendererSettings.reprojection;
+			ImGui::Checkbox("Reprojection", &reprojection.enabled);
+			ImGui::Checkbox("Simulated head motion", &m_headMotion);
+			if (reprojection.enabled) {
+				int32_t mode = static_cast<int32_t>(reprojection.mode);
+				if (ImGui::Combo("Reprojection mode", &mode, "Rotation\0Positional\0"))
+					reprojection.mode = static_cast<Reprojection::Mode>(mode);
+				ImGui::SliderFloat("Display rate", &reprojection.targetRate, 30.0f, 144.0f, "%.0f Hz");
+
+				// Forcing an interval simulates a scene dropping frames
+				static const uint32_t minInterval = 0, maxInterval = Reprojection::s_MAX_INTERVAL;
+				ImGui::SliderScalar("Scene interval (0 adapts)", ImGuiDataType_U32, &reprojection.sceneInterval, &minInterval, &maxInterval);
+
+				const Reprojection::Stats& reprojectionStats = m_report.reprojection;
+				ImGui::Text("Scene: %.0f us GPU, 1 frame every %u displayed, %u reprojected frames",
+					reprojectionStats.sceneGpuTime, reprojectionStats.interval, reprojectionStats.reprojectedFrames);
+			}
+
+			const Renderer::Stats& stats = m_report.stats;
+			ImGui::Text("Fragment invocations: %llu pre-pass, %llu shading",
+				static_cast<unsigned long long>(stats.prepassFragments), static_cast<unsigned long long>(stats.shadingFragments));
+			ImGui::Text("Culled primitives: %u (%u occluders, %u triangles, %.0f us)",
+				stats.culledPrimitives, stats.occluders, stats.occluderTriangles, stats.occlusionTime);
+			ImGui::Text("Submit: %.0f us for %u renderables, %u draw calls of %u instances", stats.submitTime, m_report.renderables, stats.drawCalls, stats.instances);
+			ImGui::Text("Recording: %.0f us for %u passes, %.1f KB of commands", stats.recordTime, stats.recordedPasses, stats.recordedSize / 1024.0f);
+			ImGui::Text("State calls: %u issued, %u skipped", stats.stateCalls, stats.skippedStateCalls);
+			if (m_rendererSettings.indexedMaterials)
+				ImGui::Text("Indexed materials: %u", stats.indexedMaterials);
+			if (m_rendererSettings.gpuCulling) {
+				const GpuCuller::Stats& gpuStats = m_report.gpuCulling;
+				ImGui::Text("GPU culling: %u / %u visible, %zu batches, %.1f MB merged geometry%s", gpuStats.visible, gpuStats.instances,
+					m_report.gpuBatches, gpuStats.geometryMemory / (1024.0f * 1024.0f), m_report.gpuCompacting ? "" : " (not compacted)");
+			}
+
+			if (ImGui::Checkbox("Static batching (reloads Sponza)", &m_staticBatching))
+				m_reloadSponza = true;
+
+			// Grid of small cubes appended to the scene, to measure the submission cost of many objects
+			if (ImGui::SliderInt("Stress cubes", &m_stressCubes, 0, 100000, "%d", ImGuiSliderFlags_Logarithmic)) {
+				m_scene.entities.truncate(m_sceneEntityCount);
+				const int32_t side = static_cast<int32_t>(std::ceil(std::cbrt(static_cast<float>(m_stressCubes))));
+				const float spacing = 0.04f;
+				for (int32_t c = 0; c < m_stressCubes; ++c) {
+					const uint32_t cube = m_scene.entities.add(*m_stressCube);
+					m_scene.entities.getTransform(cube).translation = glm::vec3(c % side, c / side % side, c / (side * side)) * spacing
+						- glm::vec3(0.5f * spacing * side, -0.1f, 0.5f * spacing * side);
+				}
+			}
 		}
 
 		if (ImGui::CollapsingHeader("Camera")) {
@@ -192,34 +448,92 @@ protected:
 			static float luminosity = 1.0f;
 
 			if (ImGui::SliderFloat("Gamma", &gamma, 0.0f, 3.0f))
-				glProgramUniform1f(*m_screenShader, glGetUniformLocation(*m_screenShader, "uGamma"), gamma);
+				setScreenUniform(m_screenUniforms.gamma, gamma);
 			if (ImGui::SliderFloat("Exposure", &exposure, 0.0f, 2.0f))
-				glProgramUniform1f(*m_screenShader, glGetUniformLocation(*m_screenShader, "uExposure"), exposure);
+				setScreenUniform(m_screenUniforms.exposure, exposure);
 			if (ImGui::SliderFloat("Chromatic aberration", &chromaticAbberation, 0.0f, 1.0f))
-				glProgramUniform1f(*m_screenShader, glGetUniformLocation(*m_screenShader, "uChromaticAbberation"), chromaticAbberation);
+				setScreenUniform(m_screenUniforms.chromaticAbberation, chromaticAbberation);
 			if (ImGui::SliderFloat("Saturation", &saturation, 0.0f, 2.0f))
-				glProgramUniform1f(*m_screenShader, glGetUniformLocation(*m_screenShader, "uSaturation"), saturation);
+				setScreenUniform(m_screenUniforms.saturation, saturation);
 			if (ImGui::SliderFloat("Luminosity", &luminosity, 0.0f, 2.0f))
-				glProgramUniform1f(*m_screenShader, glGetUniformLocation(*m_screenShader, "uLuminosity"), luminosity);
+				setScreenUniform(m_screenUniforms.luminosity, luminosity);
 
 			static int tonemapper = 0;
 			static const char* tonemappers = "ACES Fitted\0ACES Filmic\0Reinhard\0Simple Exposure\0Disabled\0";
-			if (ImGui::Combo("Tonemapper", &tonemapper, tonemappers))
-				glProgramUniform1i(*m_screenShader, glGetUniformLocation(*m_screenShader, "uTonemapper"), tonemapper);
+			if (ImGui::Combo("Tonemapper", &tonemapper, tonemappers)) {
+				enqueueRenderCommand([uniform = m_screenUniforms.tonemapper, tonemapper = tonemapper]() {
+					uniform.set(tonemapper);
+				});
+			}
 		}
 
 
+		if (ImGui::CollapsingHeader("Dynamic Resolution")) {
+			DynamicResolution::Settings& resolution = m_rendererSettings.dynamicResolution;
+			ImGui::Checkbox("Enable##DynamicResolution", &resolution.enabled);
+			ImGui::SliderFloat("Frame time target", &resolution.targetFrameTime, 2.0f, 33.3f, "%.1f ms");
+			ImGui::SliderFloat("Min scale", &resolution.minScale, 0.1f, 1.0f);
+			ImGui::SliderFloat("Max scale", &resolution.maxScale, 0.1f, DynamicResolution::s_MAX_SCALE);
+			ImGui::SliderFloat("Dead band", &resolution.deadBand, 0.0f, 0.3f);
+			ImGui::DragFloat3("PID gains", &resolution.proportional, 0.01f, 0.0f, 2.0f);
+
+			// Scales above 1 need a larger target, reallocated once the slider is released rather than at each step
+			const float targetScale = resolution.enabled ? std::clamp(resolution.maxScale, 1.0f, DynamicResolution::s_MAX_SCALE) : 1.0f;
+			if (targetScale != m_targetScale && !ImGui::IsAnyItemActive()) {
+				m_targetScale = targetScale;
+				enqueueRenderCommand([this, width = getWindow().getWidth(), height = getWindow().getHeight(), stereo = m_stereo, scale = m_targetScale]() {
+					createRenderer(width, height, stereo, scale);
+				});
+			}
+
+			const DynamicResolution::Stats& stats = m_report.dynamicResolution;
+			ImGui::Text("GPU frame: %.2f ms, scale %.2f, %d x %d", stats.gpuFrameTime, stats.scale, m_report.viewport.x, m_report.viewport.y);
+		}
+
 		if (ImGui::CollapsingHeader("Bloom")) {
 			static float bloomAmount = 0.5f;
 			ImGui::Checkbox("Enable", &m_bloomEnable);
 			if (ImGui::SliderFloat("Amount", &bloomAmount, 0.0f, 1.0f)) {
-				m_bloom->setAmount(bloomAmount);
+				enqueueRenderCommand([this, amount = bloomAmount]() { m_bloom->setAmount(amount); });
 			}
 		}
 
+		if (ImGui::CollapsingHeader("Render Graph")) {
+			const RenderGraph::Stats& stats = m_report.renderGraph;
+			const float transientMemory = stats.transientMemory / (1024.0f * 1024.0f);
+			const float pooledMemory = stats.pooledMemory / (1024.0f * 1024.0f);
+			ImGui::Text("Passes: %d, culled %d", stats.passes, stats.culledPasses);
+			ImGui::Text("Transient textures: %d in %d pooled", stats.transientTextures, stats.pooledTextures);
+			ImGui::Text("Memory: %.1f MB for %.1f MB requested, %.1f MB saved", pooledMemory, transientMemory, transientMemory - pooledMemory);
+		}
+
+
+		if (ImGui::CollapsingHeader("Shadows")) {
+			ImGui::DragScalar("Instance budget", ImGuiDataType_U32, &m_rendererSettings.shadows.instanceBudget, 10.0f);
+			ImGui::DragFloat("Time budget (us)", &m_rendererSettings.shadows.timeBudget, 10.0f, 0.0f, 10000.0f);
+			ImGui::DragScalar("Max interval", ImGuiDataType_U32, &m_rendererSettings.shadows.maxInterval, 0.1f);
+
+			const ShadowScheduler::Stats& stats = m_report.shadows;
+			ImGui::Text("Updates: %u / %u requested", stats.scheduled, stats.requested);
+			ImGui::Text("Instance budget: %u", stats.instanceBudget);
+			ImGui::Text("Draws: %u for %u instances", stats.draws, stats.instances);
+			ImGui::Text("GPU time: %.1f us", stats.gpuTime);
+
+			bool halfDepth = m_rendererSettings.shadowDepthBits == 16;
+			if (ImGui::Checkbox("16-bit depth", &halfDepth))
+				m_rendererSettings.shadowDepthBits = halfDepth ? 16 : 32;
+
+			static const uint32_t minAtlasSize = 1024, maxAtlasSize = 16384;
+			ImGui::SliderScalar("Max atlas size", ImGuiDataType_U32, &m_rendererSettings.shadowAtlasSize, &minAtlasSize, &maxAtlasSize);
+
+			ImGui::Text("Atlas: %u x %u, %u tiles, %.1f MB", m_report.atlasSize, m_report.atlasSize, m_report.atlasTiles, m_report.atlasMemory / (1024.0f * 1024.0f));
+		}
 
 		if (ImGui::CollapsingHeader("Directional Lights")) {
-			ImGui::SliderFloat("Frustum size", &m_directionalFrustumSize, 0.5f, 10.0f);
+			static const uint32_t minCascades = DirectionalLight::s_MIN_CASCADES, maxCascades = DirectionalLight::s_MAX_CASCADES;
+			ImGui::SliderScalar("Cascades", ImGuiDataType_U32, &m_rendererSettings.shadowCascades, &minCascades, &maxCascades);
+			ImGui::SliderFloat("Split lambda", &m_rendererSettings.cascadeSplitLambda, 0.0f, 1.0f);
+			ImGui::SliderFloat("Shadow distance", &m_rendererSettings.shadowDistance, 1.0f, 50.0f);
 			
 			int32_t i = 0;
 			for (DirectionalLight& light : m_scene.directionalLights) {
@@ -233,6 +547,21 @@ protected:
 		}
 
 		if (ImGui::CollapsingHeader("Point Lights")) {
+			// Small random lights spread in Sponza, to stress the clustered lighting
+			if (ImGui::SliderInt("Extra lights", &m_extraLights, 0, 2048)) {
+				std::mt19937 rng(42);
+				std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+				m_scene.pointLights.resize(m_scenePointLightCount);
+				for (int32_t l = 0; l < m_extraLights; ++l) {
+					m_scene.pointLights.push_back(PointLight{
+						.position = glm::vec3(unit(rng) * 5.0f - 2.5f, unit(rng) * 1.5f + 0.05f, unit(rng) * 2.0f - 1.0f),
+						.color = glm::vec3(unit(rng), unit(rng), unit(rng)),
+						.power = 0.002f,
+						.radius = 0.0f,
+					});
+				}
+			}
+
 			int32_t i = 0;
 			for (PointLight& light : m_scene.pointLights) {
 				if (ImGui::TreeNode(std::format("Point Light {}", i).c_str())) {
@@ -249,48 +578,151 @@ protected:
 		ImGui::End();
 
 		ImGui::Begin("Meshes");
-		int32_t i = 0;
-		for (auto& mesh : m_scene.meshes) {
+		ImGui::Text("BVH: %u primitives, %u nodes, cost x%.2f", m_report.bvhObjects, m_report.bvhNodes, m_report.bvhDegradation);
+		ImGui::Text("Refitted primitives: %u, builds: %u", m_report.bvh.refittedPrimitives, m_report.bvh.builds);
+		ImGui::Text("Updated transforms: %u", m_report.updatedTransforms);
+		ImGui::Text("Middle click a mesh to select it for rotation.");
+
+		EntityStore& entities = m_scene.entities;
+		for (uint32_t i = 0; i < entities.getCount(); ++i) {
 			if (ImGui::TreeNode(std::format("Mesh {}", i).c_str())) {
-				ImGui::DragFloat3("Translation", glm::value_ptr(mesh->transform.translation), 0.01f);
-				ImGui::DragFloat3("Scale", glm::value_ptr(mesh->transform.scale), 0.01f);
+				Transform& transform = entities.getTransform(i);
+				ImGui::DragFloat3("Translation", glm::value_ptr(transform.translation), 0.01f);
+				ImGui::DragFloat3("Scale", glm::value_ptr(transform.scale), 0.01f);
 
 				if (ImGui::Button("Select for rotation")) {
-					m_selectedMesh = mesh;
+					m_selectedEntity = i;
+				}
+
+				// Parent selection, the transform becomes relative to the parent mesh
+				const uint32_t parent = entities.getParent(i);
+				std::string parentName = parent != EntityStore::s_NO_ENTITY ? std::format("Mesh {}", parent) : "None";
+				if (ImGui::BeginCombo("Parent", parentName.c_str())) {
+					if (ImGui::Selectable("None"))
+						entities.setParent(i, EntityStore::s_NO_ENTITY);
+
+					for (uint32_t k = 0; k < entities.getCount(); ++k) {
+						if (k != i && ImGui::Selectable(std::format("Mesh {}", k).c_str()))
+							entities.setParent(i, k);
+					}
+					ImGui::EndCombo();
 				}
 
-				int32_t j = 0;
-				for (auto& primitive : mesh->primitives) {
+				for (uint32_t j = 0; j < entities.getRenderableCount(i); ++j) {
 					if (ImGui::TreeNode(std::format("Material {}", j).c_str())) {
-						primitive.material->immediateGUI();
+						entities.getPrimitive(entities.getFirstRenderable(i) + j).material->immediateGUI();
 						ImGui::TreePop();
 					}
-					++j;
 				}
 
 				ImGui::TreePop();
 			}
-			++i;
 		}
 		ImGui::End();
 	}
 
 private:
+	// No headset yet, the head is the camera swaying around its vertical axis and nodding when simulated
+	Camera sampleHeadPose(const GameSnapshot& snapshot) {
+		const Camera& camera = snapshot.camera;
+		Camera head = camera;
+		if (!snapshot.headMotion) return head;
+
+		const float time = getWindow().getTime();
+		const glm::vec3 right = glm::normalize(glm::cross(camera.forward, camera.up));
+		const glm::quat yaw = glm::angleAxis(glm::radians(15.0f) * std::sin(2.0f * time), glm::normalize(camera.up));
+		const glm::quat pitch = glm::angleAxis(glm::radians(5.0f) * std::sin(3.0f * time), right);
+		head.forward = yaw * pitch * camera.forward;
+		return head;
+	}
+
+	// The eyes are the head moved along its right axis
+	std::array<Camera, 2> eyeCameras(const Camera& head, float eyeSeparation) const {
+		const glm::vec3 right = glm::normalize(glm::cross(head.forward, head.up));
+		Camera leftEye = head;
+		Camera rightEye = head;
+		leftEye.aspect = rightEye.aspect = static_cast<float>(m_renderTarget->getNominalWidth()) / m_renderTarget->getNominalHeight();
+		leftEye.eyePos -= 0.5f * eyeSeparation * right;
+		rightEye.eyePos += 0.5f * eyeSeparation * right;
+		return { leftEye, rightEye };
+	}
+
+	// Stereo frames render each eye in a layer of half the window width, displayed side by side.
+	// The target is allocated for the largest dynamic resolution scale.
+	void createRenderer(int32_t width, int32_t height, bool stereo, float maxScale) {
+		if (stereo)
+			m_renderTarget = std::make_shared<RenderTarget>(std::max(width / 2, 1), height, 4, 2, maxScale);
+		else
+			m_renderTarget = std::make_shared<RenderTarget>(width, height, 4, 1, maxScale);
+
+		m_renderer = std::make_unique<Renderer>(m_renderTarget);
+	}
+
+	// Screen shader uniforms are set by the render thread, which owns the shader
+	void setScreenUniform(const gpu::UniformHandle<float>& uniform, float value) {
+		enqueueRenderCommand([uniform, value]() {
+			uniform.set(value);
+		});
+	}
+
+	// Copies the renderer state the UI shows, on the render thread
+	void reportStats(RenderReport& report) const {
+		report.stats = m_renderer->getStats();
+		report.stereoMode = m_renderer->getStereoMode();
+		report.foveated = m_renderer->isFoveated();
+		report.shadedRatio = m_renderer->getFoveation().getShadedRatio();
+		report.reprojection = m_renderer->getReprojection().getStats();
+		report.dynamicResolution = m_renderer->getDynamicResolution().getStats();
+		report.viewport = { m_renderTarget->getViewportWidth(), m_renderTarget->getViewportHeight() };
+		report.renderables = m_renderer->getRenderables().getCount();
+		report.gpuCulling = m_renderer->getGpuCuller().getStats();
+		report.gpuBatches = m_renderer->getGpuCuller().getBatches().size();
+		report.gpuCompacting = m_renderer->getGpuCuller().isCompacting();
+		report.renderGraph = m_renderer->getRenderGraph().getStats();
+		report.shadows = m_renderer->getShadowScheduler().getStats();
+		report.atlasSize = m_renderer->getShadowAtlas().getSize();
+		report.atlasTiles = m_renderer->getShadowAtlas().getTileCount();
+		report.atlasMemory = m_renderer->getShadowAtlas().getMemorySize();
+		report.bvhObjects = m_renderer->getSceneBVH().getTree().getObjectCount();
+		report.bvhNodes = m_renderer->getSceneBVH().getTree().getNodeCount();
+		report.bvhDegradation = m_renderer->getSceneBVH().getTree().getDegradation();
+		report.bvh = m_renderer->getSceneBVH().getStats();
+		report.updatedTransforms = m_renderer->getTransforms().getUpdatedCount();
+	}
+
+private:
+	// Update thread state, handed over in the snapshots
 	Camera m_camera;
 	CameraController m_cameraController;
 
 	Scene m_scene;
 	std::unordered_map<const char*, std::shared_ptr<Skybox>> m_skyboxes;
-	std::weak_ptr<Mesh> m_selectedMesh;
+	uint32_t m_selectedEntity = EntityStore::s_NO_ENTITY;
+	std::optional<Ray> m_pickRay;	// Pending until a rendered frame casts it
+	std::shared_ptr<Mesh> m_stressCube;
+	uint32_t m_sceneEntityCount = 0;
+	size_t m_scenePointLightCount = 0;	// Lights the scene was built with, the extra lights follow them
+	int32_t m_extraLights = 0;
+	int32_t m_stressCubes = 0;	// Grid of small cubes appended to the scene entities
+	uint32_t m_sponzaEntity = 0;
+	bool m_staticBatching = true;
+	bool m_reloadSponza = false;
+
+	bool m_stereo = false;
+	float m_targetScale = 1.0f;		// Resolution scale the render target is allocated for
+	float m_eyeSeparation = 0.064f;	// Distance between the eyes, in meters
+	bool m_headMotion = false;		// Simulated pose source, to see the reprojection of late frames
+	bool m_bloomEnable = true;
+
+	Renderer::Settings m_rendererSettings;
+	RenderReport m_report;	// Latest frame given back by the render thread
 
+	// Render thread state, only touched by onRender and render commands once the application runs
 	std::unique_ptr<gpu::ShaderProgram> m_screenShader;
+	ScreenUniforms m_screenUniforms;	// Resolved with the shader, kept across reloads
 	std::shared_ptr<RenderTarget> m_renderTarget;
 	std::unique_ptr<Renderer> m_renderer;
-
 	std::unique_ptr<Bloom> m_bloom;
-	bool m_bloomEnable = true;
-
-	float m_directionalFrustumSize = 5.0f;
 };
 
 vr::Application* vr::createApplication() {
@@ -11,6 +11,7 @@
 #include "renderer/Renderer.h"
 
 #include <stdexcept>
+#include <thread>
 
 namespace vr {
 	Application* Application::s_instance = nullptr;
@@ -31,7 +32,7 @@ namespace vr {
 			return false;
 		});
 		dispatcher.dispatch<events::WindowResizeEvent>([this](const events::WindowResizeEvent& e) {
-			Renderer::adapt(e.width, e.height);
+			enqueueRenderCommand([width = e.width, height = e.height]() { Renderer::adapt(width, height); });
 			return false;
 		});
 		m_imguiSubsystem->onEvent(event);
@@ -40,6 +41,18 @@ namespace vr {
 			onEvent(event);
 	}
 
+	void Application::enqueueRenderCommand(std::function<void()> command) {
+		if (m_snapshot)
+			m_snapshot->renderCommands.push_back(std::move(command));
+		else
+			command();
+	}
+
+	void Application::retire(std::shared_ptr<void> object) {
+		if (m_snapshot)
+			m_snapshot->retired.push_back(std::move(object));
+	}
+
 	Application::Application(int32_t width, int32_t height, const char* title) 
 		: m_isRunning(false)
 	{
@@ -73,9 +86,20 @@ namespace vr {
 
 		m_isRunning = true;
 
+		// The context moves to the render thread, frame N is updated while frame N-1 is submitted
+		for (uint32_t i = 0; i < s_SNAPSHOT_COUNT; ++i)
+			m_freeSnapshots.push(createSnapshot());
+		m_renderContext->release();
+		std::thread renderThread(&Application::renderLoop, this);
+
 		do {
 			float deltaTime = frameTimeCurrent - frameTimePrevious;
 
+			// Waits for the render thread when it is a frame behind
+			m_snapshot = m_freeSnapshots.pop();
+			onFrameRendered(*m_snapshot);
+			m_snapshot->deltaTime = deltaTime;
+
 			while (fixedTime < frameTimeCurrent) {
 				onFixedUpdate();
 				fixedTime += m_fixedDeltaTime;
@@ -83,20 +107,44 @@ namespace vr {
 
 			input::update();
 			m_window->pollEvents();
-			
-			
+
 			onUpdate(deltaTime);
-			onRender();
 
 			m_imguiSubsystem->beginFrame();
 			onUI();
-			m_imguiSubsystem->endFrame();
+			m_imguiSubsystem->endFrame(m_snapshot->ui);
 
-			m_window->swapBuffers();
+			onSnapshot(*m_snapshot);
+			m_renderSnapshots.push(std::move(m_snapshot));
 
 			frameTimePrevious = frameTimeCurrent;
 			frameTimeCurrent = m_window->getTime();
 		} while (m_isRunning);
+
+		// Snapshots hold GL objects, they are destroyed once the context is back
+		m_renderSnapshots.push(nullptr);
+		renderThread.join();
+		m_renderContext->makeCurrent();
+		for (uint32_t i = 0; i < s_SNAPSHOT_COUNT; ++i)
+			m_freeSnapshots.pop();
+	}
+
+	void Application::renderLoop() {
+		m_renderContext->makeCurrent();
+
+		while (std::unique_ptr<FrameSnapshot> snapshot = m_renderSnapshots.pop()) {
+			for (const std::function<void()>& command : snapshot->renderCommands)
+				command();
+
+			onRender(*snapshot);
+			m_imguiSubsystem->render(snapshot->ui);
+			m_window->swapBuffers();
+
+			snapshot->release();
+			m_freeSnapshots.push(std::move(snapshot));
+		}
+
+		m_renderContext->release();
 	}
 
 }
@@ -8,9 +8,12 @@
 #include "core/RenderContext.h"
 #include "core/Window.h"
 #include "core/ImGuiSubsystem.h"
+#include "core/FrameSnapshot.h"
+#include "core/SpscQueue.h"
 #include "event/Event.h"
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 // NOTE: Forward declaration of the program's entry point to be able to declare it as a friend of the Application class.
@@ -40,6 +43,16 @@ namespace vr {
 		/// @param event Event to broadcast.
 		void broadcastEvent(const Event& event);
 
+		/// @brief Requests GL work from the update thread, executed by the render thread before the current frame is rendered.
+		/// Executed immediately when the render thread isn't running.
+		/// @param command Command to execute, it must only capture values or objects owned by the render thread.
+		void enqueueRenderCommand(std::function<void()> command);
+
+		/// @brief Hands over a reference dropped by the update thread, so that it is released by the render thread.
+		/// Objects owning GL objects must be destroyed where the context is current.
+		/// @param object Reference to release.
+		void retire(std::shared_ptr<void> object);
+
 	protected:
 		/// @brief Constructs the application instance.
 		/// This constructor also initializes the Application's singleton instance pointer.
@@ -62,15 +75,29 @@ namespace vr {
 		/// @brief Callback for fixed delta time application logic.
 		virtual void onFixedUpdate() {}
 
-		/// @brief Callback for rendering.
-		/// This method may be executed on a separate thread in the future.
-		virtual void onRender() {}
+		/// @brief Callback for rendering, executed on the render thread.
+		/// It runs while the update thread produces the next frame, and must only read the snapshot and the objects
+		/// owned by the render thread.
+		/// @param snapshot Frame to render, as filled by onSnapshot.
+		virtual void onRender(FrameSnapshot& snapshot) {}
 
 		/// @brief Callback for ImGui.
 		virtual void onUI() {}
 
+		/// @brief Creates the snapshots exchanged with the render thread, applications return their own derived snapshot.
+		virtual std::unique_ptr<FrameSnapshot> createSnapshot() { return std::make_unique<FrameSnapshot>(); }
+
+		/// @brief Callback filling the snapshot of the frame with the state the render thread needs, after the updates and the UI.
+		/// @param snapshot Snapshot of the frame, released by the render thread since it was last filled.
+		virtual void onSnapshot(FrameSnapshot& snapshot) {}
+
+		/// @brief Callback taking the results the render thread left in a snapshot, when it is given back to the update thread.
+		/// @param snapshot Rendered snapshot, about to be filled again.
+		virtual void onFrameRendered(FrameSnapshot& snapshot) {}
+
 	private:
 		void run();
+		void renderLoop();
 
 	private:
 		static Application* s_instance;
@@ -82,6 +109,13 @@ namespace vr {
 
 		const float m_fixedDeltaTime = 0.5f;
 		bool m_isRunning;
+
+		// Two snapshots go around, the update thread fills one while the render thread renders the other.
+		// A null snapshot stops the render thread.
+		static constexpr uint32_t s_SNAPSHOT_COUNT = 2;
+		SpscQueue<std::unique_ptr<FrameSnapshot>, 4> m_renderSnapshots;	// Update to render thread
+		SpscQueue<std::unique_ptr<FrameSnapshot>, 4> m_freeSnapshots;	// Render to update thread
+		std::unique_ptr<FrameSnapshot> m_snapshot;	// Snapshot filled by the update thread
 	};
 
 	/// @brief Instanciate an Application from user Implementation.
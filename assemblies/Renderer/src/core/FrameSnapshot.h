@@ -0,0 +1,39 @@
+// VR Renderer - Frame Snapshot
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "core/ImGuiDrawSnapshot.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace vr {
+
+	/// @brief State of a frame, produced by the update thread and consumed by the render thread.
+	/// The update thread never touches a snapshot once it is handed over, until the render thread gives it back. This is
+	/// a base class that applications inherit from to add their own state, see Application::createSnapshot.
+	struct FrameSnapshot {
+		virtual ~FrameSnapshot() = default;
+
+		float deltaTime = 0.0f;
+		ImGuiDrawSnapshot ui;
+
+		// GL work requested by the update thread, executed by the render thread before the frame is rendered
+		std::vector<std::function<void()>> renderCommands;
+
+		// References dropped by the update thread, released by the render thread so that GL objects are deleted with its context
+		std::vector<std::shared_ptr<void>> retired;
+
+		/// @brief Releases what the render thread consumed, before the snapshot is given back to the update thread.
+		/// Overrides should call the base method. Results meant for the update thread should be kept.
+		virtual void release() {
+			ui.clear();
+			renderCommands.clear();
+			retired.clear();
+		}
+	};
+
+}
@@ -0,0 +1,34 @@
+// VR Renderer - ImGui Draw Snapshot
+// Rodolphe VALICON
+// 2025
+
+#include "ImGuiDrawSnapshot.h"
+
+namespace vr {
+
+	ImGuiDrawSnapshot::~ImGuiDrawSnapshot() {
+		clear();
+	}
+
+	void ImGuiDrawSnapshot::capture(const ImDrawData& drawData) {
+		clear();
+
+		// The list array keeps its storage. Draw lists point to the shared data of the context, only their output is cloned.
+		ImVector<ImDrawList*> lists;
+		lists.swap(m_drawData.CmdLists);
+		m_drawData = drawData;
+		m_drawData.CmdLists.swap(lists);
+		for (ImDrawList* list : drawData.CmdLists)
+			m_drawData.CmdLists.push_back(list->CloneOutput());
+	}
+
+	void ImGuiDrawSnapshot::clear() {
+		for (ImDrawList* list : m_drawData.CmdLists)
+			IM_DELETE(list);
+
+		m_drawData.CmdLists.resize(0);
+		m_drawData.CmdListsCount = 0;
+		m_drawData.Valid = false;
+	}
+
+}
@@ -0,0 +1,35 @@
+// VR Renderer - ImGui Draw Snapshot
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <imgui.h>
+
+namespace vr {
+
+	/// @brief Copy of the ImGui draw data of a frame.
+	/// The draw lists of ImGui are rebuilt by the next frame, the copy is rendered by the render thread meanwhile.
+	class ImGuiDrawSnapshot {
+	public:
+		ImGuiDrawSnapshot() = default;
+		~ImGuiDrawSnapshot();
+
+		// No copy semantic
+		ImGuiDrawSnapshot(const ImGuiDrawSnapshot&) = delete;
+		ImGuiDrawSnapshot& operator=(const ImGuiDrawSnapshot&) = delete;
+
+		/// @brief Copies draw data, the previous copy is released.
+		void capture(const ImDrawData& drawData);
+
+		/// @brief Releases the copied draw lists.
+		void clear();
+
+		/// @return The copied draw data, nullptr when there is none.
+		ImDrawData* getDrawData() { return m_drawData.Valid ? &m_drawData : nullptr; }
+
+	private:
+		ImDrawData m_drawData;
+	};
+
+}
@@ -7,6 +7,7 @@
 #include "core/Input.h"
 #include "event/EventDispatcher.h"
 #include "event/InputEvents.h"
+#include "gpu/StateCache.h"
 
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
@@ -23,6 +24,9 @@ namespace vr {
 		ImGui_ImplGlfw_InitForOpenGL(window.getGLFWHandle(), true);
 		ImGui_ImplOpenGL3_Init();
 
+		// Device objects and the font texture are created while the context is current on this thread, the render thread only draws
+		ImGui_ImplOpenGL3_NewFrame();
+
 		logger::info("ImGui subsystem initialized.");
 	}
 
@@ -34,16 +38,25 @@ namespace vr {
 
 	void ImGuiSubsystem::beginFrame() const {
 		ImGui_ImplGlfw_NewFrame();
-		ImGui_ImplOpenGL3_NewFrame();
 		ImGui::NewFrame();
 	}
 
-	void ImGuiSubsystem::endFrame() const {
-		glDisable(GL_DEBUG_OUTPUT);
+	void ImGuiSubsystem::endFrame(ImGuiDrawSnapshot& snapshot) const {
 		ImGui::EndFrame();
 		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		snapshot.capture(*ImGui::GetDrawData());
+	}
+
+	void ImGuiSubsystem::render(ImGuiDrawSnapshot& snapshot) const {
+		ImDrawData* drawData = snapshot.getDrawData();
+		if (!drawData) return;
+
+		glDisable(GL_DEBUG_OUTPUT);
+		ImGui_ImplOpenGL3_RenderDrawData(drawData);
 		glEnable(GL_DEBUG_OUTPUT);
+
+		// The backend restores the state it changes, but behind the state cache
+		gpu::StateCache::getInstance().invalidate();
 	}
 
 	void ImGuiSubsystem::onEvent(const Event& event) {
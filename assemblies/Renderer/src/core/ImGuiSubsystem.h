@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "core/ImGuiDrawSnapshot.h"
 #include "core/Window.h"
 #include "event/Event.h"
 
@@ -21,7 +22,12 @@ namespace vr {
 		
 
 		void beginFrame() const;
-		void endFrame() const;
+
+		/// @brief Ends the frame of the update thread, its draw data is copied to be rendered by the render thread.
+		void endFrame(ImGuiDrawSnapshot& snapshot) const;
+
+		/// @brief Renders the draw data of a frame, on the thread holding the render context.
+		void render(ImGuiDrawSnapshot& snapshot) const;
 
 		void onEvent(const Event& event);
 	};
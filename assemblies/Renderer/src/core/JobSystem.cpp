@@ -0,0 +1,76 @@
+// VR Renderer - Job System
+// Rodolphe VALICON
+// 2025
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace vr {
+
+	JobSystem::JobSystem(uint32_t threadCount) {
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		for (uint32_t i = 0; i < threadCount; ++i)
+			m_workers.emplace_back(&JobSystem::workerLoop, this);
+	}
+
+	JobSystem::~JobSystem() {
+		{
+			std::lock_guard lock(m_mutex);
+			m_stopping = true;
+		}
+		m_wakeCondition.notify_all();
+
+		for (std::thread& worker : m_workers)
+			worker.join();
+	}
+
+	void JobSystem::parallelFor(uint32_t count, const std::function<void(uint32_t)>& job) {
+		if (count == 0) return;
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_job = &job;
+			m_count = count;
+			m_next = 0;
+			m_busyWorkers = static_cast<uint32_t>(m_workers.size());
+			++m_generation;
+		}
+		m_wakeCondition.notify_all();
+
+		// The calling thread takes part in the work
+		runJobs();
+
+		std::unique_lock lock(m_mutex);
+		m_doneCondition.wait(lock, [this] { return m_busyWorkers == 0; });
+		m_job = nullptr;
+	}
+
+	void JobSystem::workerLoop() {
+		uint64_t generation = 0;
+		while (true) {
+			{
+				std::unique_lock lock(m_mutex);
+				m_wakeCondition.wait(lock, [&] { return m_stopping || m_generation != generation; });
+				if (m_stopping) return;
+				generation = m_generation;
+			}
+
+			runJobs();
+
+			{
+				std::lock_guard lock(m_mutex);
+				--m_busyWorkers;
+			}
+			m_doneCondition.notify_one();
+		}
+	}
+
+	void JobSystem::runJobs() {
+		for (uint32_t i = m_next++; i < m_count; i = m_next++)
+			(*m_job)(i);
+	}
+
+}
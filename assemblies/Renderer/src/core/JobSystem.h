@@ -0,0 +1,56 @@
+// VR Renderer - Job System
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vr {
+
+	/// @brief A fixed pool of worker threads, running data-parallel loops.
+	class JobSystem {
+	public:
+		/// @brief Starts the worker threads.
+		/// @param threadCount Number of worker threads, 0 to use all the hardware threads but the calling one.
+		JobSystem(uint32_t threadCount = 0);
+		~JobSystem();
+
+		// No copy semantic
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		/// @brief Runs a job for every index in [0, count), spread over the workers and the calling thread.
+		/// Blocks until every index has been processed. Must not be called concurrently.
+		/// @param count Number of indices to process.
+		/// @param job Function called with each index.
+		void parallelFor(uint32_t count, const std::function<void(uint32_t)>& job);
+
+		/// @brief Provides the number of threads running jobs, including the calling thread.
+		uint32_t getConcurrency() const { return static_cast<uint32_t>(m_workers.size()) + 1; }
+
+	private:
+		void workerLoop();
+		void runJobs();
+
+	private:
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex;
+		std::condition_variable m_wakeCondition;
+		std::condition_variable m_doneCondition;
+
+		const std::function<void(uint32_t)>* m_job = nullptr;
+		uint32_t m_count = 0;
+		uint64_t m_generation = 0;
+		uint32_t m_busyWorkers = 0;
+		std::atomic<uint32_t> m_next = 0;
+		bool m_stopping = false;
+	};
+
+}
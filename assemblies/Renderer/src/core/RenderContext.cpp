@@ -64,8 +64,10 @@ static void initializeOpenGLDebug() {
 #endif
 
 namespace vr {
-	RenderContext::RenderContext(Window& window) {
-		glfwMakeContextCurrent(window.getGLFWHandle());
+	RenderContext::RenderContext(Window& window)
+		: m_window(window)
+	{
+		makeCurrent();
 		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 			throw std::runtime_error("glad failed to load OpenGL");
 
@@ -77,6 +79,14 @@ namespace vr {
 	}
 
 	RenderContext::~RenderContext() {
+		release();
+	}
+
+	void RenderContext::makeCurrent() const {
+		glfwMakeContextCurrent(m_window.getGLFWHandle());
+	}
+
+	void RenderContext::release() const {
 		glfwMakeContextCurrent(nullptr);
 	}
 }
\ No newline at end of file
@@ -15,8 +15,18 @@ namespace vr {
 	public:
 		~RenderContext();
 
+		/// @brief Makes the context current on the calling thread.
+		/// A context is current on a single thread at a time, it must be released by the thread holding it first.
+		void makeCurrent() const;
+
+		/// @brief Releases the context from the calling thread.
+		void release() const;
+
 	private:
 		RenderContext(Window& window);
+
+	private:
+		Window& m_window;
 	};
 
 }
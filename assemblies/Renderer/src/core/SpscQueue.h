@@ -0,0 +1,70 @@
+// VR Renderer - Single Producer Single Consumer Queue
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace vr {
+
+	/// @brief Bounded lock-free queue between one producer thread and one consumer thread.
+	/// Each side only writes its own index, published with release semantics, so that an element is fully written
+	/// before the other side sees it. Waiting relies on atomic waits rather than on a mutex.
+	template<typename T, size_t Capacity>
+	class SpscQueue {
+		static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+	public:
+		/// @brief Pushes an element from the producer thread.
+		/// @return False when the queue is full, the element is left untouched.
+		bool tryPush(T&& value) {
+			const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_head.load(std::memory_order_acquire) == Capacity) return false;
+
+			m_slots[tail & (Capacity - 1)] = std::move(value);
+			m_tail.store(tail + 1, std::memory_order_release);
+			m_tail.notify_one();
+			return true;
+		}
+
+		/// @brief Pushes an element from the producer thread, waiting for the consumer to make room.
+		void push(T&& value) {
+			while (!tryPush(std::move(value)))
+				m_head.wait(m_tail.load(std::memory_order_relaxed) - Capacity, std::memory_order_acquire);
+		}
+
+		/// @brief Pops an element from the consumer thread.
+		/// @return The element, nothing when the queue is empty.
+		std::optional<T> tryPop() {
+			const uint64_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire)) return std::nullopt;
+
+			std::optional<T> value(std::move(m_slots[head & (Capacity - 1)]));
+			m_head.store(head + 1, std::memory_order_release);
+			m_head.notify_one();
+			return value;
+		}
+
+		/// @brief Pops an element from the consumer thread, waiting for the producer to push one.
+		T pop() {
+			std::optional<T> value;
+			while (!(value = tryPop()))
+				m_tail.wait(m_head.load(std::memory_order_relaxed), std::memory_order_acquire);
+
+			return std::move(*value);
+		}
+
+	private:
+		// Indices only grow, their difference is the element count. Separate cache lines keep both sides from sharing one.
+		alignas(64) std::atomic<uint64_t> m_head = 0;
+		alignas(64) std::atomic<uint64_t> m_tail = 0;
+		alignas(64) std::array<T, Capacity> m_slots{};
+	};
+
+}
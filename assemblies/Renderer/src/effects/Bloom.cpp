@@ -3,124 +3,164 @@
 // 2025
 
 #include "Bloom.h"
+#include "gpu/StateCache.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace vr {
 	
-	Bloom::Bloom(std::shared_ptr<gpu::Texture> lensDirt) : m_cTexture(GL_TEXTURE_2D), m_dTexture(GL_TEXTURE_2D), m_uTexture(GL_TEXTURE_2D) {
-		m_copyShader = std::make_unique<gpu::ShaderProgram>("res/shaders/effects/bloom_copy.glsl");
+	Bloom::Bloom(std::shared_ptr<gpu::Texture> lensDirt) {
 		m_downsampleShader = std::make_unique<gpu::ShaderProgram>("res/shaders/effects/bloom_downsample.glsl");
 		m_upsampleShader = std::make_unique<gpu::ShaderProgram>("res/shaders/effects/bloom_upsample.glsl");
 		m_mixShader = std::make_unique<gpu::ShaderProgram>("res/shaders/effects/bloom_mix.glsl");
 
+		m_downsampleMip = m_downsampleShader->getUniform<int32_t>("uMip");
+		m_downsampleViewportScale = m_downsampleShader->getUniform<glm::vec2>("uViewportScale");
+		m_upsampleMip = m_upsampleShader->getUniform<int32_t>("uMip");
+		m_upsampleViewportScale = m_upsampleShader->getUniform<glm::vec2>("uViewportScale");
+		m_mixViewportScale = m_mixShader->getUniform<glm::vec2>("uViewportScale");
+		m_mixViewport = m_mixShader->getUniform<glm::ivec2>("uViewport");
+		m_mixAmount = m_mixShader->getUniform<float>("uBloomAmount");
+
 		m_lensDirt = lensDirt;
 	}
 	
-	void Bloom::apply(RenderTarget& target) {
-		// Check if texture needs to be recreated
-		int32_t tWidth = target.getWidth();
-		int32_t tHeight = target.getHeight();
-
-		if (tWidth != m_width || tHeight != m_height) {
-			m_width = tWidth;
-			m_height = tWidth;
-			
-			// Compute max level
-			const int32_t reqLevels = 8;
-			
-			const float minDim = static_cast<float>(m_width < m_height ? m_width : m_height) / 2.0f;
-			const int32_t maxLevels = static_cast<int32_t>(std::floorf(std::log2(minDim))) + 1;
-			m_levels = maxLevels < reqLevels ? maxLevels : reqLevels;
-
-			// Allocate textures
-			m_cTexture = gpu::Texture(GL_TEXTURE_2D);
-			glTextureStorage2D(m_cTexture, 1, GL_RGBA16F, m_width, m_height);
-			glTextureParameteri(m_cTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTextureParameteri(m_cTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTextureParameteri(m_cTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTextureParameteri(m_cTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-			m_dTexture = gpu::Texture(GL_TEXTURE_2D);
-			glTextureStorage2D(m_dTexture, m_levels, GL_RGBA16F, m_width / 2, m_height / 2);
-			glTextureParameteri(m_dTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTextureParameteri(m_dTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTextureParameteri(m_dTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-			glTextureParameteri(m_dTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-			m_uTexture = gpu::Texture(GL_TEXTURE_2D);
-			glTextureStorage2D(m_uTexture, m_levels - 1, GL_RGBA16F, m_width / 2, m_height / 2);
-			glTextureParameteri(m_uTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTextureParameteri(m_uTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTextureParameteri(m_uTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-			glTextureParameteri(m_uTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		}
-		
-		int32_t uDMip = glGetUniformLocation(*m_downsampleShader, "uMip");
-		int32_t uUMip = glGetUniformLocation(*m_upsampleShader, "uMip");
-
-		// Copy pass
-		glUseProgram(*m_copyShader);
-		glBindTextureUnit(0, *target.getColorTexture());
-		glBindImageTexture(1, m_cTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-		glDispatchCompute(m_width / 8, m_height / 8, 1);
+	RenderGraph::Resource Bloom::addPasses(RenderGraph& graph, RenderGraph::Resource color, glm::ivec2 viewport) {
+		const RenderGraph::TextureDesc& colorDesc = graph.getDesc(color);
+
+		// Compute max level
+		const int32_t reqLevels = 8;
+
+		const float minDim = static_cast<float>(std::min(colorDesc.width, colorDesc.height)) / 2.0f;
+		const int32_t maxLevels = static_cast<int32_t>(std::floor(std::log2(minDim))) + 1;
+		const int32_t levels = std::max(std::min(maxLevels, reqLevels), 2);
+
+		// Chains are sized from the color texture rather than its viewport, so that a resolution change keeps them
+		RenderGraph::TextureDesc chainDesc{
+			.width = colorDesc.width / 2,
+			.height = colorDesc.height / 2,
+			.levels = levels,
+			.sampler{ GL_LINEAR, GL_LINEAR_MIPMAP_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE },
+		};
+
+		// Only the viewport is processed, every level keeps its share of the textures
+		const int32_t width = viewport.x;
+		const int32_t height = viewport.y;
+		const float scaleX = static_cast<float>(width) / colorDesc.width;
+		const float scaleY = static_cast<float>(height) / colorDesc.height;
+		m_downsampleViewportScale.set(glm::vec2(scaleX, scaleY));
+		m_upsampleViewportScale.set(glm::vec2(scaleX, scaleY));
+		m_mixViewportScale.set(glm::vec2(scaleX, scaleY));
+		m_mixViewport.set(glm::ivec2(width, height));
 
 		// Downsample passes
-		glUseProgram(*m_downsampleShader);
-		
-		int32_t dFactor = 2;
-		glBindTextureUnit(0, m_cTexture);
-		glBindImageTexture(0, m_dTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-		glUniform1i(uDMip, 0);
-		glDispatchCompute(m_width / dFactor / 8, m_height / dFactor / 8, 1);
-		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
-		for (int32_t mip = 1; mip < m_levels; ++mip) {
-			dFactor *= 2;
-
-			glBindTextureUnit(0, m_dTexture);
-			glBindImageTexture(0, m_dTexture, mip, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-			glUniform1i(uDMip, mip - 1);
-			glDispatchCompute(m_width / dFactor / 8 + 1, m_height / dFactor / 8 + 1, 1);
-			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-		}
+		struct DownsampleData {
+			RenderGraph::Resource color;
+			RenderGraph::Resource chain;
+		};
+
+		const DownsampleData& downsample = graph.addPass<DownsampleData>("Bloom downsample",
+			[&](RenderGraph::Builder& builder, DownsampleData& data) {
+				data.color = builder.read(color, RenderGraph::Access::Sampled);
+				data.chain = builder.write(builder.create("Bloom downsample chain", chainDesc), RenderGraph::Access::Image);
+			},
+			[this, width, height, levels](const DownsampleData& data, RenderGraph::Context& context) {
+				const gpu::Texture& dTexture = context.getTexture(data.chain);
+				gpu::StateCache& state = gpu::StateCache::getInstance();
+				state.useProgram(*m_downsampleShader);
+
+				int32_t dFactor = 2;
+				state.bindTextureUnit(0, context.getTexture(data.color));
+				glBindImageTexture(0, dTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+				m_downsampleMip.set(0);
+				glDispatchCompute(width / dFactor / 8 + 1, height / dFactor / 8 + 1, 1);
+				glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+				for (int32_t mip = 1; mip < levels; ++mip) {
+					dFactor *= 2;
+
+					state.bindTextureUnit(0, dTexture);
+					glBindImageTexture(0, dTexture, mip, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+					m_downsampleMip.set(mip - 1);
+					glDispatchCompute(width / dFactor / 8 + 1, height / dFactor / 8 + 1, 1);
+					glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+				}
+			}
+		);
 
 		// Upsample passes
-		dFactor /= 2;
-
-		glUseProgram(*m_upsampleShader);
-		glBindTextureUnit(0, m_dTexture);
-		glBindImageTexture(0, m_dTexture, m_levels - 2, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
-		glBindImageTexture(1, m_uTexture, m_levels - 2, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-
-		glUniform1i(uUMip, m_levels - 1);
-		glDispatchCompute(m_width / dFactor / 8 + 2, m_height / dFactor / 8 +2, 1);
-		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
-		for (int32_t mip = m_levels - 3; mip >= 0; --mip) {
-			dFactor /= 2;
-
-			glBindTextureUnit(0, m_uTexture);
-			glBindImageTexture(0, m_dTexture, mip, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
-			glBindImageTexture(1, m_uTexture, mip, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-
-			glUniform1i(uUMip, mip + 1);
-			glDispatchCompute(m_width / dFactor / 8 + 2, m_height / dFactor / 8 +2, 1);
-			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-		}
-
-		// Mix pass
-		glUseProgram(*m_mixShader);
-		glBindTextureUnit(0, m_uTexture);
-		glBindTextureUnit(1, *m_lensDirt);
-		glBindImageTexture(0, m_cTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
-		glBindImageTexture(1, *target.getColorTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-		glDispatchCompute(target.getWidth() / 8 + 1, target.getHeight() / 8 + 1, 1);
-		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
+		struct UpsampleData {
+			RenderGraph::Resource downsample;
+			RenderGraph::Resource chain;
+		};
+
+		chainDesc.levels = levels - 1;
+		const UpsampleData& upsample = graph.addPass<UpsampleData>("Bloom upsample",
+			[&](RenderGraph::Builder& builder, UpsampleData& data) {
+				data.downsample = builder.read(downsample.chain, RenderGraph::Access::Sampled);
+				builder.read(downsample.chain, RenderGraph::Access::Image);
+				data.chain = builder.write(builder.create("Bloom upsample chain", chainDesc), RenderGraph::Access::Image);
+			},
+			[this, width, height, levels](const UpsampleData& data, RenderGraph::Context& context) {
+				const gpu::Texture& dTexture = context.getTexture(data.downsample);
+				const gpu::Texture& uTexture = context.getTexture(data.chain);
+
+				int32_t dFactor = 1 << (levels - 1);
+
+				gpu::StateCache& state = gpu::StateCache::getInstance();
+				state.useProgram(*m_upsampleShader);
+				state.bindTextureUnit(0, dTexture);
+				glBindImageTexture(0, dTexture, levels - 2, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+				glBindImageTexture(1, uTexture, levels - 2, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+				m_upsampleMip.set(levels - 1);
+				glDispatchCompute(width / dFactor / 8 + 2, height / dFactor / 8 + 2, 1);
+				glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+				for (int32_t mip = levels - 3; mip >= 0; --mip) {
+					dFactor /= 2;
+
+					state.bindTextureUnit(0, uTexture);
+					glBindImageTexture(0, dTexture, mip, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+					glBindImageTexture(1, uTexture, mip, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+					m_upsampleMip.set(mip + 1);
+					glDispatchCompute(width / dFactor / 8 + 2, height / dFactor / 8 + 2, 1);
+					glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+				}
+			}
+		);
+
+		// Mix pass, in place: each invocation only reads the texel it writes
+		struct MixData {
+			RenderGraph::Resource upsample;
+			RenderGraph::Resource color;
+		};
+
+		const MixData& mix = graph.addPass<MixData>("Bloom mix",
+			[&](RenderGraph::Builder& builder, MixData& data) {
+				data.upsample = builder.read(upsample.chain, RenderGraph::Access::Sampled);
+				data.color = builder.write(builder.read(color, RenderGraph::Access::Image), RenderGraph::Access::Image);
+			},
+			[this, width, height](const MixData& data, RenderGraph::Context& context) {
+				const gpu::Texture& colorTexture = context.getTexture(data.color);
+
+				gpu::StateCache& state = gpu::StateCache::getInstance();
+				state.useProgram(*m_mixShader);
+				state.bindTextureUnit(0, context.getTexture(data.upsample));
+				state.bindTextureUnit(1, *m_lensDirt);
+				glBindImageTexture(0, colorTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+				glBindImageTexture(1, colorTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+				glDispatchCompute(width / 8 + 1, height / 8 + 1, 1);
+			}
+		);
+
+		return mix.color;
 	}
 
 	void Bloom::setAmount(float amount) {
-		int32_t location = glGetUniformLocation(*m_mixShader, "uBloomAmount");
-		glProgramUniform1f(*m_mixShader, location, amount);
+		m_mixAmount.set(amount);
 	}
 
-}
\ No newline at end of file
+}
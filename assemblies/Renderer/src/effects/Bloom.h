@@ -12,38 +12,36 @@
 
 namespace vr {
 
+	/// @brief Physically based bloom. The frame is downsampled along a mip chain, upsampled back and mixed in place.
+	/// Both chains are transient textures of the frame graph.
 	class Bloom : public Effect {
 	public:
 		Bloom(std::shared_ptr<gpu::Texture> lensDirt);
 
-		virtual void apply(RenderTarget& target) override;
+		virtual RenderGraph::Resource addPasses(RenderGraph& graph, RenderGraph::Resource color, glm::ivec2 viewport) override;
 
-		gpu::Texture& getDTexture() { return m_dTexture; }
-		gpu::Texture& getUTexture() { return m_uTexture; }
-		gpu::Texture& getCTexture() { return m_cTexture; }
 		void reload() {
 			m_upsampleShader->reload();
 			m_downsampleShader->reload();
-			m_copyShader->reload();
 			m_mixShader->reload();
 		}
 
 		void setAmount(float amount);
 
 	private:
-		int32_t m_width = 1, m_height = 1;
-		int32_t m_levels = 0;
-
-		gpu::Texture m_cTexture;
-		gpu::Texture m_dTexture;
-		gpu::Texture m_uTexture;
-
-		std::unique_ptr<gpu::ShaderProgram> m_copyShader;
 		std::unique_ptr<gpu::ShaderProgram> m_downsampleShader;
 		std::unique_ptr<gpu::ShaderProgram> m_upsampleShader;
 		std::unique_ptr<gpu::ShaderProgram> m_mixShader;
 
+		gpu::UniformHandle<int32_t> m_downsampleMip;
+		gpu::UniformHandle<glm::vec2> m_downsampleViewportScale;
+		gpu::UniformHandle<int32_t> m_upsampleMip;
+		gpu::UniformHandle<glm::vec2> m_upsampleViewportScale;
+		gpu::UniformHandle<glm::vec2> m_mixViewportScale;
+		gpu::UniformHandle<glm::ivec2> m_mixViewport;
+		gpu::UniformHandle<float> m_mixAmount;
+
 		std::shared_ptr<gpu::Texture> m_lensDirt;
 	};
 
-}
\ No newline at end of file
+}
@@ -4,13 +4,19 @@
 
 #pragma once
 
-#include "renderer/RenderTarget.h"
+#include "renderer/RenderGraph.h"
+
+#include <glm/glm.hpp>
 
 namespace vr {
 
 	class Effect {
 	public:
-		virtual void apply(RenderTarget& target) = 0;
+		/// @brief Records the passes of the effect in the frame graph.
+		/// @param color Single sample color of the frame.
+		/// @param viewport Part of the color drawn, from its origin.
+		/// @return The color with the effect applied.
+		virtual RenderGraph::Resource addPasses(RenderGraph& graph, RenderGraph::Resource color, glm::ivec2 viewport) = 0;
 	};
 
-}
\ No newline at end of file
+}
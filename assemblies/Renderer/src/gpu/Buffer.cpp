@@ -3,6 +3,7 @@
 // 2025
 
 #include "Buffer.h"
+#include "gpu/StateCache.h"
 
 #include <utility>
 
@@ -24,6 +25,7 @@ namespace vr {
 
 		Buffer& Buffer::operator=(Buffer&& other) noexcept {
 			if (m_handle == other.m_handle) return *this;
+			StateCache::getInstance().forgetBuffer(m_handle);
 			glDeleteBuffers(1, &m_handle);
 
 			m_handle = std::exchange(other.m_handle, 0);
@@ -32,6 +34,7 @@ namespace vr {
 		}
 
 		Buffer::~Buffer() {
+			StateCache::getInstance().forgetBuffer(m_handle);
 			glDeleteBuffers(1, &m_handle);
 		}
 
@@ -0,0 +1,190 @@
+// VR Renderer - GPU Command Buffer
+// Rodolphe VALICON
+// 2025
+
+#include "CommandBuffer.h"
+#include "gpu/StateCache.h"
+
+#include <cstring>
+
+namespace vr {
+	namespace gpu {
+
+		void CommandBuffer::reset() {
+			m_words.clear();
+			m_vertexArray = 0;
+		}
+
+		void CommandBuffer::useProgram(GLuint program) {
+			push(Opcode::UseProgram, program);
+		}
+
+		void CommandBuffer::bindVertexArray(GLuint vertexArray) {
+			if (vertexArray == m_vertexArray) return;
+
+			push(Opcode::BindVertexArray, vertexArray);
+			m_vertexArray = vertexArray;
+		}
+
+		void CommandBuffer::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+			push(Opcode::BindBufferBase, target, index, buffer);
+		}
+
+		void CommandBuffer::bindTextureUnit(GLuint unit, GLuint texture) {
+			push(Opcode::BindTextureUnit, unit, texture);
+		}
+
+		void CommandBuffer::bindTextures(GLuint first, GLsizei count, const GLuint* textures) {
+			push(Opcode::BindTextures, first, count);
+			pushArray(textures, count);
+		}
+
+		void CommandBuffer::enable(GLenum capability) {
+			push(Opcode::Enable, capability);
+		}
+
+		void CommandBuffer::disable(GLenum capability) {
+			push(Opcode::Disable, capability);
+		}
+
+		void CommandBuffer::depthFunc(GLenum function) {
+			push(Opcode::DepthFunc, function);
+		}
+
+		void CommandBuffer::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+			push(Opcode::Viewport, x, y, width, height);
+		}
+
+		void CommandBuffer::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+			push(Opcode::Scissor, x, y, width, height);
+		}
+
+		void CommandBuffer::viewportIndexed(GLuint index, GLfloat x, GLfloat y, GLfloat width, GLfloat height) {
+			push(Opcode::ViewportIndexed, index, x, y, width, height);
+		}
+
+		void CommandBuffer::scissorIndexed(GLuint index, GLint x, GLint y, GLsizei width, GLsizei height) {
+			push(Opcode::ScissorIndexed, index, x, y, width, height);
+		}
+
+		void CommandBuffer::uniform1f(GLint location, GLfloat value) {
+			push(Opcode::Uniform1f, location, value);
+		}
+
+		void CommandBuffer::uniform1ui(GLint location, GLuint value) {
+			push(Opcode::Uniform1ui, location, value);
+		}
+
+		void CommandBuffer::uniform1uiv(GLint location, GLsizei count, const GLuint* values) {
+			push(Opcode::Uniform1uiv, location, count);
+			pushArray(values, count);
+		}
+
+		void CommandBuffer::uniformMatrix4fv(GLint location, GLsizei count, const GLfloat* values) {
+			push(Opcode::UniformMatrix4fv, location, count);
+			pushArray(values, 16 * static_cast<size_t>(count));
+		}
+
+		void CommandBuffer::drawElementsInstancedBaseInstance(GLenum mode, GLsizei count, GLsizei instanceCount, GLuint baseInstance) {
+			push(Opcode::DrawElementsInstancedBaseInstance, mode, count, instanceCount, baseInstance);
+		}
+
+		void CommandBuffer::memoryBarrier(GLbitfield barriers) {
+			push(Opcode::MemoryBarrier, barriers);
+		}
+
+		void CommandBuffer::pushArray(const void* values, size_t wordCount) {
+			const size_t offset = m_words.size();
+			m_words.resize(offset + wordCount);
+			std::memcpy(m_words.data() + offset, values, wordCount * sizeof(uint32_t));
+		}
+
+		void CommandBuffer::execute() const {
+			// Arguments are read in place, each command advances past its own words
+			const uint32_t* word = m_words.data();
+			const uint32_t* end = word + m_words.size();
+			auto asInt = [](uint32_t value) { return std::bit_cast<GLint>(value); };
+			auto asFloat = [](uint32_t value) { return std::bit_cast<GLfloat>(value); };
+			StateCache& state = StateCache::getInstance();
+
+			while (word < end) {
+				const Opcode opcode = static_cast<Opcode>(*word++);
+				switch (opcode) {
+				case Opcode::UseProgram:
+					state.useProgram(word[0]);
+					word += 1;
+					break;
+				case Opcode::BindVertexArray:
+					state.bindVertexArray(word[0]);
+					word += 1;
+					break;
+				case Opcode::BindBufferBase:
+					state.bindBufferBase(word[0], word[1], word[2]);
+					word += 3;
+					break;
+				case Opcode::BindTextureUnit:
+					state.bindTextureUnit(word[0], word[1]);
+					word += 2;
+					break;
+				case Opcode::BindTextures:
+					state.bindTextures(word[0], asInt(word[1]), word + 2);
+					word += 2 + word[1];
+					break;
+				case Opcode::Enable:
+					state.enable(word[0]);
+					word += 1;
+					break;
+				case Opcode::Disable:
+					state.disable(word[0]);
+					word += 1;
+					break;
+				case Opcode::DepthFunc:
+					state.depthFunc(word[0]);
+					word += 1;
+					break;
+				case Opcode::Viewport:
+					glViewport(asInt(word[0]), asInt(word[1]), asInt(word[2]), asInt(word[3]));
+					word += 4;
+					break;
+				case Opcode::Scissor:
+					glScissor(asInt(word[0]), asInt(word[1]), asInt(word[2]), asInt(word[3]));
+					word += 4;
+					break;
+				case Opcode::ViewportIndexed:
+					glViewportIndexedf(word[0], asFloat(word[1]), asFloat(word[2]), asFloat(word[3]), asFloat(word[4]));
+					word += 5;
+					break;
+				case Opcode::ScissorIndexed:
+					glScissorIndexed(word[0], asInt(word[1]), asInt(word[2]), asInt(word[3]), asInt(word[4]));
+					word += 5;
+					break;
+				case Opcode::Uniform1f:
+					glUniform1f(asInt(word[0]), asFloat(word[1]));
+					word += 2;
+					break;
+				case Opcode::Uniform1ui:
+					glUniform1ui(asInt(word[0]), word[1]);
+					word += 2;
+					break;
+				case Opcode::Uniform1uiv:
+					glUniform1uiv(asInt(word[0]), asInt(word[1]), word + 2);
+					word += 2 + word[1];
+					break;
+				case Opcode::UniformMatrix4fv:
+					glUniformMatrix4fv(asInt(word[0]), asInt(word[1]), GL_FALSE, reinterpret_cast<const GLfloat*>(word + 2));
+					word += 2 + 16 * word[1];
+					break;
+				case Opcode::DrawElementsInstancedBaseInstance:
+					glDrawElementsInstancedBaseInstance(word[0], asInt(word[1]), GL_UNSIGNED_INT, nullptr, asInt(word[2]), word[3]);
+					word += 4;
+					break;
+				case Opcode::MemoryBarrier:
+					glMemoryBarrier(word[0]);
+					word += 1;
+					break;
+				}
+			}
+		}
+
+	}
+}
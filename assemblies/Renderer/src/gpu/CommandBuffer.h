@@ -0,0 +1,99 @@
+// VR Renderer - GPU Command Buffer
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <glad/glad.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vr {
+	namespace gpu {
+
+		/// @brief A list of GL commands, recorded on any thread and executed by the thread holding the context.
+		/// Commands are packed as 32-bit words in a linear buffer, which keeps its storage when reset, so that a
+		/// buffer recorded every frame stops allocating. Recording never touches GL. A buffer must only be recorded by
+		/// one thread at a time, and executed once its recording is done.
+		class CommandBuffer {
+		public:
+			CommandBuffer() = default;
+
+			/// @brief Drops the recorded commands, the storage is kept.
+			void reset();
+
+			// State
+			void useProgram(GLuint program);
+			void bindVertexArray(GLuint vertexArray);
+			void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+			void bindTextureUnit(GLuint unit, GLuint texture);
+			void bindTextures(GLuint first, GLsizei count, const GLuint* textures);
+			void enable(GLenum capability);
+			void disable(GLenum capability);
+			void depthFunc(GLenum function);
+			void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+			void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+			void viewportIndexed(GLuint index, GLfloat x, GLfloat y, GLfloat width, GLfloat height);
+			void scissorIndexed(GLuint index, GLint x, GLint y, GLsizei width, GLsizei height);
+
+			// Uniforms of the program in use, arrays are copied in the buffer
+			void uniform1f(GLint location, GLfloat value);
+			void uniform1ui(GLint location, GLuint value);
+			void uniform1uiv(GLint location, GLsizei count, const GLuint* values);
+			void uniformMatrix4fv(GLint location, GLsizei count, const GLfloat* values);
+
+			// Draws and synchronization
+			void drawElementsInstancedBaseInstance(GLenum mode, GLsizei count, GLsizei instanceCount, GLuint baseInstance);
+			void memoryBarrier(GLbitfield barriers);
+
+			/// @brief Issues the recorded commands, in order. Must be called by the thread holding the context.
+			/// State changes go through the StateCache, the ones setting the current state are skipped.
+			void execute() const;
+
+			bool isEmpty() const { return m_words.empty(); }
+
+			/// @brief Provides the recorded size, in bytes.
+			size_t getSize() const { return m_words.size() * sizeof(uint32_t); }
+
+		private:
+			enum class Opcode : uint32_t {
+				UseProgram,
+				BindVertexArray,
+				BindBufferBase,
+				BindTextureUnit,
+				BindTextures,
+				Enable,
+				Disable,
+				DepthFunc,
+				Viewport,
+				Scissor,
+				ViewportIndexed,
+				ScissorIndexed,
+				Uniform1f,
+				Uniform1ui,
+				Uniform1uiv,
+				UniformMatrix4fv,
+				DrawElementsInstancedBaseInstance,
+				MemoryBarrier,
+			};
+
+			// Every argument is a 32-bit GL scalar, stored as a word
+			template<typename... Args>
+			void push(Opcode opcode, Args... args) {
+				static_assert(((sizeof(Args) == sizeof(uint32_t)) && ...), "Command arguments must be 32-bit words.");
+				m_words.push_back(static_cast<uint32_t>(opcode));
+				(m_words.push_back(std::bit_cast<uint32_t>(args)), ...);
+			}
+
+			void pushArray(const void* values, size_t wordCount);
+
+		private:
+			std::vector<uint32_t> m_words;
+			GLuint m_vertexArray = 0;	// Last recorded binding, consecutive draws of a geometry only bind it once
+		};
+
+	}
+}
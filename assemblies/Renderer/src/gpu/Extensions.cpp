@@ -0,0 +1,58 @@
+// VR Renderer - OpenGL Extensions
+// Rodolphe VALICON
+// 2025
+
+#include "Extensions.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <unordered_set>
+
+namespace vr {
+	namespace gpu {
+
+		// OVR_multiview entry point, glad only loads the core profile.
+		typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint baseViewIndex, GLsizei numViews);
+		static PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC s_framebufferTextureMultiviewOVR = nullptr;
+
+		bool isExtensionSupported(std::string_view name) {
+			static const std::unordered_set<std::string> extensions = []() {
+				std::unordered_set<std::string> result;
+
+				GLint count = 0;
+				glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+				for (GLint i = 0; i < count; ++i)
+					result.emplace(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+
+				return result;
+			}();
+
+			return extensions.find(std::string(name)) != extensions.end();
+		}
+
+	
+		bool isMultiviewSupported() {
+			static const bool supported = []() {
+				if (!isExtensionSupported("GL_OVR_multiview") || !isExtensionSupported("GL_OVR_multiview2"))
+					return false;
+
+				s_framebufferTextureMultiviewOVR = reinterpret_cast<PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC>(glfwGetProcAddress("glFramebufferTextureMultiviewOVR"));
+				return s_framebufferTextureMultiviewOVR != nullptr;
+			}();
+
+			return supported;
+		}
+
+		void framebufferTextureMultiview(GLuint framebuffer, GLenum attachment, GLuint texture, GLint baseView, GLsizei viewCount) {
+			// The extension has no direct state access entry point
+			GLint previous = 0;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+			s_framebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, attachment, texture, 0, baseView, viewCount);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+		}
+
+	}
+}
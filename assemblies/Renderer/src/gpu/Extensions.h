@@ -0,0 +1,33 @@
+// VR Renderer - OpenGL Extensions
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string_view>
+
+namespace vr {
+	namespace gpu {
+
+		/// @brief Checks whether the current OpenGL context exposes an extension.
+		/// The extension list is queried once, on the first call.
+		/// @param name Extension name, e.g. "GL_ARB_shader_viewport_layer_array".
+		/// @return true if the extension is supported, false otherwise.
+		bool isExtensionSupported(std::string_view name);
+
+		/// @brief Checks whether OVR_multiview is usable, its entry point is loaded on the first call.
+		bool isMultiviewSupported();
+
+		/// @brief Attaches consecutive layers of an array texture as the views of a multiview framebuffer.
+		/// isMultiviewSupported() must be true.
+		/// @param framebuffer Framebuffer to attach to, its draw binding is restored afterwards.
+		/// @param attachment Attachment point, e.g. GL_COLOR_ATTACHMENT0.
+		/// @param texture 2D array or 2D multisample array texture.
+		/// @param baseView Layer of the first view.
+		/// @param viewCount Number of views, up to GL_MAX_VIEWS_OVR.
+		void framebufferTextureMultiview(GLuint framebuffer, GLenum attachment, GLuint texture, GLint baseView, GLsizei viewCount);
+
+	}
+}
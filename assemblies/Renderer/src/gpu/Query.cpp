@@ -0,0 +1,66 @@
+// VR Renderer - Query
+// Rodolphe VALICON
+// 2025
+
+#include "Query.h"
+
+#include <utility>
+
+namespace vr {
+	namespace gpu {
+
+		Query::Query(GLenum target) : m_target(target) {
+			glCreateQueries(target, 1, &m_handle);
+		}
+
+		Query::~Query() {
+			glDeleteQueries(1, &m_handle);
+		}
+
+		Query::Query(Query&& other) noexcept
+			: m_handle(std::exchange(other.m_handle, 0)),
+			m_target(other.m_target),
+			m_issued(std::exchange(other.m_issued, false))
+		{}
+
+		Query& Query::operator=(Query&& other) noexcept {
+			if (m_handle == other.m_handle) return *this;
+			glDeleteQueries(1, &m_handle);
+
+			m_handle = std::exchange(other.m_handle, 0);
+			m_target = other.m_target;
+			m_issued = std::exchange(other.m_issued, false);
+
+			return *this;
+		}
+
+		void Query::begin() {
+			glBeginQuery(m_target, m_handle);
+		}
+
+		void Query::end() {
+			glEndQuery(m_target);
+			m_issued = true;
+		}
+
+		void Query::timestamp() {
+			glQueryCounter(m_handle, GL_TIMESTAMP);
+			m_issued = true;
+		}
+
+		bool Query::isAvailable() const {
+			if (!m_issued) return false;
+
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(m_handle, GL_QUERY_RESULT_AVAILABLE, &available);
+			return available == GL_TRUE;
+		}
+
+		uint64_t Query::getResult() const {
+			GLuint64 result = 0;
+			glGetQueryObjectui64v(m_handle, GL_QUERY_RESULT, &result);
+			return result;
+		}
+
+	}
+}
@@ -0,0 +1,61 @@
+// VR Renderer - Query
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+namespace vr {
+	namespace gpu {
+
+		/// @brief An asynchronous GPU query (timer, samples passed, pipeline statistics...).
+		/// Results become available a few frames later, poll isAvailable() to avoid stalling.
+		class Query {
+		public:
+			/// @brief Creates a decoy invalid query.
+			Query() = default;
+
+			/// @brief Creates a query object.
+			/// @param target Query target, e.g. GL_TIME_ELAPSED.
+			Query(GLenum target);
+			~Query();
+
+			// No copy semantic
+			Query(const Query&) = delete;
+			Query& operator=(const Query&) = delete;
+
+			// Move semantic
+			Query(Query&& other) noexcept;
+			Query& operator=(Query&& other) noexcept;
+
+			/// @brief Starts measuring. Only one query of a target may be active at a time.
+			void begin();
+
+			/// @brief Stops measuring.
+			void end();
+
+			/// @brief Records the GPU time once the previous commands are done, for GL_TIMESTAMP queries.
+			void timestamp();
+
+			/// @brief Checks whether the query was issued and its result is ready.
+			bool isAvailable() const;
+
+			/// @brief Reads the query result, waiting for it if needed.
+			uint64_t getResult() const;
+
+			/// @brief Checks whether the query was issued at least once.
+			bool isIssued() const { return m_issued; }
+
+			inline operator GLuint() const { return m_handle; }
+
+		private:
+			GLuint m_handle = 0;
+			GLenum m_target = 0;
+			bool m_issued = false;
+		};
+
+	}
+}
@@ -0,0 +1,152 @@
+// VR Renderer - GPU Ring Buffer
+// Rodolphe VALICON
+// 2025
+
+#include "RingBuffer.h"
+
+#include "core/Logger.h"
+#include "gpu/StateCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace vr {
+	namespace gpu {
+
+		RingBuffer::RingBuffer(size_t regionSize, uint32_t regionCount) {
+			// Every allocation may be bound either as a uniform or a shader storage buffer range.
+			GLint uniformAlignment, storageAlignment;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+			m_alignment = static_cast<size_t>(std::max(uniformAlignment, storageAlignment));
+
+			m_fences.resize(regionCount, nullptr);
+			allocateStorage(alignedSize(regionSize));
+		}
+
+		RingBuffer::RingBuffer(RingBuffer&& other) noexcept
+			: m_handle(std::exchange(other.m_handle, 0)),
+			m_mapped(std::exchange(other.m_mapped, nullptr)),
+			m_regionSize(std::exchange(other.m_regionSize, 0)),
+			m_alignment(other.m_alignment),
+			m_region(std::exchange(other.m_region, 0)),
+			m_head(std::exchange(other.m_head, 0)),
+			m_fences(std::move(other.m_fences))
+		{}
+
+		RingBuffer& RingBuffer::operator=(RingBuffer&& other) noexcept {
+			if (m_handle == other.m_handle) return *this;
+			release();
+
+			m_handle = std::exchange(other.m_handle, 0);
+			m_mapped = std::exchange(other.m_mapped, nullptr);
+			m_regionSize = std::exchange(other.m_regionSize, 0);
+			m_alignment = other.m_alignment;
+			m_region = std::exchange(other.m_region, 0);
+			m_head = std::exchange(other.m_head, 0);
+			m_fences = std::move(other.m_fences);
+
+			return *this;
+		}
+
+		RingBuffer::~RingBuffer() {
+			release();
+		}
+
+		void RingBuffer::beginFrame(size_t requiredSize) {
+			m_region = (m_region + 1) % m_fences.size();
+			m_head = 0;
+
+			if (requiredSize > m_regionSize) {
+				// Every region may still be in use, wait for all of them before reallocating.
+				for (GLsync& fence : m_fences)
+					waitFence(fence);
+
+				size_t regionSize = m_regionSize;
+				while (regionSize < requiredSize) regionSize *= 2;
+
+				logger::debug("Growing ring buffer regions from {} to {} bytes.", m_regionSize, regionSize);
+				glUnmapNamedBuffer(m_handle);
+				StateCache::getInstance().forgetBuffer(m_handle);
+				glDeleteBuffers(1, &m_handle);
+				allocateStorage(regionSize);
+				return;
+			}
+
+			waitFence(m_fences[m_region]);
+		}
+
+		void RingBuffer::endFrame() {
+			if (m_fences[m_region])
+				glDeleteSync(m_fences[m_region]);
+
+			m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		GLintptr RingBuffer::allocate(size_t size, uint8_t** data) {
+			size_t paddedSize = alignedSize(size);
+			if (m_head + paddedSize > m_regionSize) {
+				// Neither wrapping nor spilling is safe: the start of the region is already bound by this frame, and the
+				// next region may still be read by the GPU. The frame under-estimated its size in beginFrame.
+				throw std::logic_error(std::format("Ring buffer region overflow ({} bytes requested, {} left).", paddedSize, m_regionSize - m_head));
+			}
+
+			GLintptr offset = static_cast<GLintptr>(m_region * m_regionSize + m_head);
+			m_head += paddedSize;
+
+			*data = m_mapped + offset;
+			return offset;
+		}
+
+		GLintptr RingBuffer::write(const void* data, size_t size) {
+			uint8_t* destination;
+			GLintptr offset = allocate(size, &destination);
+			std::memcpy(destination, data, size);
+			return offset;
+		}
+
+		void RingBuffer::allocateStorage(size_t regionSize) {
+			m_regionSize = regionSize;
+			m_head = 0;
+
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glCreateBuffers(1, &m_handle);
+			glNamedBufferStorage(m_handle, m_regionSize * m_fences.size(), nullptr, flags);
+			m_mapped = static_cast<uint8_t*>(glMapNamedBufferRange(m_handle, 0, m_regionSize * m_fences.size(), flags));
+		}
+
+		void RingBuffer::release() {
+			for (GLsync& fence : m_fences) {
+				if (fence) glDeleteSync(fence);
+				fence = nullptr;
+			}
+
+			if (m_handle) {
+				glUnmapNamedBuffer(m_handle);
+				StateCache::getInstance().forgetBuffer(m_handle);
+				glDeleteBuffers(1, &m_handle);
+			}
+			m_mapped = nullptr;
+		}
+
+		void RingBuffer::waitFence(GLsync& fence) {
+			if (!fence) return;
+
+			// Flush on the first wait only, so that the fence is guaranteed to be signaled eventually.
+			GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+			while (true) {
+				GLenum result = glClientWaitSync(fence, waitFlags, 1'000'000'000);
+				if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+					break;
+				waitFlags = 0;
+			}
+
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+	}
+}
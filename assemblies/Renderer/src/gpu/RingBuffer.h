@@ -0,0 +1,87 @@
+// VR Renderer - GPU Ring Buffer
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace vr {
+	namespace gpu {
+
+		/// @brief A persistently mapped buffer, split into fence-guarded frame regions.
+		/// Each frame writes into its own region, which is only reused once the GPU is done reading it.
+		/// Data is written once and bound by offset, without any synchronous buffer update.
+		class RingBuffer {
+		public:
+			/// @brief Creates a decoy invalid ring buffer.
+			RingBuffer() = default;
+
+			/// @brief Allocates a persistently mapped ring buffer.
+			/// @param regionSize Initial size of a frame region, in bytes.
+			/// @param regionCount Number of frame regions in flight.
+			RingBuffer(size_t regionSize, uint32_t regionCount = 3);
+
+			// No copy semantics
+			RingBuffer(const RingBuffer&) = delete;
+			RingBuffer& operator=(const RingBuffer&) = delete;
+
+			// Move semantics
+			RingBuffer(RingBuffer&& other) noexcept;
+			RingBuffer& operator=(RingBuffer&& other) noexcept;
+
+			~RingBuffer();
+
+			/// @brief Starts writing into the next frame region, waiting for the GPU to release it if needed.
+			/// The buffer is reallocated if the region is smaller than the required size.
+			/// @param requiredSize Upper bound of the bytes that will be written during the frame.
+			void beginFrame(size_t requiredSize = 0);
+
+			/// @brief Fences the current frame region. Must be called after the last command reading it.
+			void endFrame();
+
+			/// @brief Reserves aligned memory in the current frame region.
+			/// @param size Size to reserve, in bytes.
+			/// @param data Receives the mapped pointer to the reserved memory.
+			/// @return The offset of the reserved memory in the buffer, to be used with glBindBufferRange.
+			/// @throws std::logic_error is thrown if the region is full, the size given to beginFrame was too small.
+			GLintptr allocate(size_t size, uint8_t** data);
+
+			/// @brief Copies data in the current frame region.
+			/// @param data Pointer to the data to copy.
+			/// @param size Size of the data, in bytes.
+			/// @return The offset of the data in the buffer, to be used with glBindBufferRange.
+			/// @throws std::logic_error is thrown if the region is full, the size given to beginFrame was too small.
+			GLintptr write(const void* data, size_t size);
+
+			template<typename T>
+			GLintptr write(const T& value) { return write(&value, sizeof(T)); }
+
+			/// @brief Provides the size of an allocation once padded to the binding alignment.
+			size_t alignedSize(size_t size) const { return (size + m_alignment - 1) / m_alignment * m_alignment; }
+
+			/// @brief Transparently casts the ring buffer object into its GL handle.
+			inline operator GLuint() const { return m_handle; }
+
+		private:
+			void allocateStorage(size_t regionSize);
+			void release();
+			static void waitFence(GLsync& fence);
+
+		private:
+			GLuint m_handle = 0;
+			uint8_t* m_mapped = nullptr;
+
+			size_t m_regionSize = 0;
+			size_t m_alignment = 256;
+			uint32_t m_region = 0;
+			size_t m_head = 0;
+
+			std::vector<GLsync> m_fences;
+		};
+
+	}
+}
@@ -16,6 +16,8 @@ namespace vr {
 			GLint wrapS = GL_REPEAT;
 			GLint wrapT = GL_REPEAT;
 			GLint wrapR = GL_REPEAT;
+
+			bool operator==(const Sampler& other) const = default;
 		};
 
 	}
@@ -5,7 +5,9 @@
 #include "ShaderProgram.h"
 
 #include "core/Logger.h"
+#include "gpu/StateCache.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -40,34 +42,106 @@ namespace vr {
 		ShaderProgram::ShaderProgram(const char* path) : m_handle(0) {
 			m_path = path;
 			logger::info("Loading shader '{}'...", path);
-			m_handle = loadProgram(path);
+			load();
+		}
+
+		ShaderProgram::ShaderProgram(const char* path, const std::vector<std::string>& defines) : m_handle(0) {
+			m_path = path;
+			m_defines = defines;
+			std::string variant = defines.empty() ? "default" : defines.front();
+			for (size_t i = 1; i < defines.size(); ++i)
+				variant += ", " + defines[i];
+
+			logger::info("Loading shader '{}' ({})...", path, variant);
+			load();
 		}
 
 		ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept
-			: m_handle(std::exchange(other.m_handle, 0)) {}
+			: m_handle(std::exchange(other.m_handle, 0)), m_path(std::move(other.m_path)), m_defines(std::move(other.m_defines)),
+			m_reflection(std::move(other.m_reflection)), m_slots(std::move(other.m_slots)) {}
 
 		ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept {
 			if (m_handle == other.m_handle) return *this;
 
+			StateCache::getInstance().forgetProgram(m_handle);
 			glDeleteProgram(m_handle);
 			m_handle = std::exchange(other.m_handle, 0);
+			m_path = std::move(other.m_path);
+			m_defines = std::move(other.m_defines);
+			m_reflection = std::move(other.m_reflection);
+			m_slots = std::move(other.m_slots);
 			return *this;
 		}
 
 		ShaderProgram::~ShaderProgram() {
+			StateCache::getInstance().forgetProgram(m_handle);
 			glDeleteProgram(m_handle);
 		}
 
 		void ShaderProgram::reload() {
 			logger::info("Reloading shader '{}'...", m_path);
+			StateCache::getInstance().forgetProgram(m_handle);
 			glDeleteProgram(m_handle);
-			m_handle = loadProgram(m_path.c_str());
+			load();
+		}
+
+		void ShaderProgram::load() {
+			m_handle = loadProgram(m_path.c_str(), m_defines);
+			m_reflection = reflectProgram(m_handle);
+			for (UniformSlot& slot : m_slots)
+				resolveSlot(slot);
+		}
+
+		const UniformSlot* ShaderProgram::findSlot(const std::string& name, ShaderType type) const {
+			auto slot = std::find_if(m_slots.begin(), m_slots.end(), [&](const UniformSlot& slot) {
+				return slot.name == name && slot.type == type;
+			});
+			if (slot != m_slots.end())
+				return &*slot;
+
+			UniformSlot& added = m_slots.emplace_back(UniformSlot{ .name = name, .type = type });
+			resolveSlot(added);
+			return &added;
+		}
+
+		void ShaderProgram::resolveSlot(UniformSlot& slot) const {
+			slot.program = m_handle;
+			slot.location = -1;
+
+			// Variants may not use every uniform, their handles do nothing
+			const Reflection::Variable* uniform = m_reflection.findUniform(slot.name);
+			if (!uniform || uniform->location < 0)
+				return;
+
+			// Opaque types have no shader type, they are set as integers
+			const ShaderType type = ShaderType::fromGLType(uniform->type);
+			if (type != ShaderType::Unknown && (type & slot.type) == 0) {
+				logger::warn("Uniform '{}' of shader '{}' is of type {}, not {}.", slot.name, m_path, type.name(), slot.type.name());
+				return;
+			}
+
+			slot.location = uniform->location;
+		}
+
+		const ShaderProgram::Reflection::Variable* ShaderProgram::Reflection::findUniform(std::string_view name) const {
+			auto uniform = std::find_if(uniforms.begin(), uniforms.end(), [name](const Variable& uniform) { return uniform.name == name; });
+			return uniform != uniforms.end() ? &*uniform : nullptr;
 		}
 
-		GLuint ShaderProgram::loadProgram(const char* path) {
+		GLint ShaderProgram::Reflection::findUniformBlock(GLint binding) const {
+			auto block = std::find_if(uniformBlocks.begin(), uniformBlocks.end(), [binding](const Block& block) { return block.binding == binding; });
+			return block != uniformBlocks.end() ? static_cast<GLint>(block - uniformBlocks.begin()) : -1;
+		}
+
+		GLint ShaderProgram::Reflection::findStorageBlock(GLint binding) const {
+			auto block = std::find_if(storageBlocks.begin(), storageBlocks.end(), [binding](const Block& block) { return block.binding == binding; });
+			return block != storageBlocks.end() ? static_cast<GLint>(block - storageBlocks.begin()) : -1;
+		}
+
+		GLuint ShaderProgram::loadProgram(const char* path, const std::vector<std::string>& defines) {
 			try {
 				std::string source = readSource(path);
-				SourceMap sources = preprocessSource(source);
+				SourceMap sources = preprocessSource(source, defines);
 				ShaderMap shaders = compileProgram(sources);
 				return linkProgram(std::move(shaders));
 			} catch (const std::runtime_error& error) {
@@ -88,7 +162,7 @@ namespace vr {
 			return code;
 		}
 
-		ShaderProgram::SourceMap ShaderProgram::preprocessSource(const std::string& code) {
+		ShaderProgram::SourceMap ShaderProgram::preprocessSource(const std::string& code, const std::vector<std::string>& defines) {
 			SourceMap sources;
 			std::stringstream codeStream(code);
 			std::string commonCode = "";
@@ -105,6 +179,14 @@ namespace vr {
 				if (line.back() == '\r')
 					line.pop_back();
 
+				// Variant definitions must follow the version directive
+				if (!defines.empty() && line.substr(0, 8) == "#version") {
+					line += "\n";
+					for (const std::string& define : defines)
+						line += std::format("#define {}\n", define);
+					line += std::format("#line {}", l + 1);
+				}
+
 				// Detect stage directive
 				if (line.substr(0, 6) == "#stage") {
 					// Extract stage name and verify stage existence.
@@ -218,5 +300,109 @@ namespace vr {
 			return program;
 		}
 
+		ShaderProgram::Reflection ShaderProgram::reflectProgram(GLuint program) {
+			Reflection reflection;
+			if (program == 0)
+				return reflection;
+
+			auto readName = [program](GLenum programInterface, GLuint index) {
+				GLint maxLength = 0;
+				glGetProgramInterfaceiv(program, programInterface, GL_MAX_NAME_LENGTH, &maxLength);
+
+				std::string name;
+				name.resize(maxLength);
+				GLsizei length = 0;
+				glGetProgramResourceName(program, programInterface, index, maxLength, &length, name.data());
+				name.resize(length);
+
+				// Arrays are named after their first element
+				if (name.ends_with("[0]"))
+					name.resize(name.size() - 3);
+				return name;
+			};
+
+			auto reflectBlocks = [&](GLenum programInterface, std::vector<Reflection::Block>& blocks) {
+				GLint count = 0;
+				glGetProgramInterfaceiv(program, programInterface, GL_ACTIVE_RESOURCES, &count);
+				blocks.reserve(count);
+
+				static const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+				for (GLint i = 0; i < count; ++i) {
+					GLint values[2]{};
+					glGetProgramResourceiv(program, programInterface, i, 2, properties, 2, nullptr, values);
+					blocks.push_back({ readName(programInterface, i), values[0], values[1] });
+				}
+			};
+
+			// Uniforms of the default block and members of the uniform blocks
+			GLint count = 0;
+			glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+			reflection.uniforms.reserve(count);
+			static const GLenum uniformProperties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET };
+			for (GLint i = 0; i < count; ++i) {
+				GLint values[5]{};
+				glGetProgramResourceiv(program, GL_UNIFORM, i, 5, uniformProperties, 5, nullptr, values);
+				reflection.uniforms.push_back({ readName(GL_UNIFORM, i), static_cast<GLenum>(values[0]), values[1], values[2], values[3], values[4], 0 });
+			}
+			reflectBlocks(GL_UNIFORM_BLOCK, reflection.uniformBlocks);
+
+			// Members of the storage blocks
+			glGetProgramInterfaceiv(program, GL_BUFFER_VARIABLE, GL_ACTIVE_RESOURCES, &count);
+			reflection.bufferVariables.reserve(count);
+			static const GLenum variableProperties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX, GL_OFFSET, GL_TOP_LEVEL_ARRAY_STRIDE };
+			for (GLint i = 0; i < count; ++i) {
+				GLint values[5]{};
+				glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, i, 5, variableProperties, 5, nullptr, values);
+				reflection.bufferVariables.push_back({ readName(GL_BUFFER_VARIABLE, i), static_cast<GLenum>(values[0]), values[1], -1, values[2], values[3], values[4] });
+			}
+			reflectBlocks(GL_SHADER_STORAGE_BLOCK, reflection.storageBlocks);
+
+			return reflection;
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const float* values) {
+			glProgramUniform1fv(program, location, count, values);
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const int32_t* values) {
+			glProgramUniform1iv(program, location, count, values);
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const uint32_t* values) {
+			glProgramUniform1uiv(program, location, count, values);
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::vec2* values) {
+			glProgramUniform2fv(program, location, count, reinterpret_cast<const GLfloat*>(values));
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::vec3* values) {
+			glProgramUniform3fv(program, location, count, reinterpret_cast<const GLfloat*>(values));
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::vec4* values) {
+			glProgramUniform4fv(program, location, count, reinterpret_cast<const GLfloat*>(values));
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::ivec2* values) {
+			glProgramUniform2iv(program, location, count, reinterpret_cast<const GLint*>(values));
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::ivec3* values) {
+			glProgramUniform3iv(program, location, count, reinterpret_cast<const GLint*>(values));
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::ivec4* values) {
+			glProgramUniform4iv(program, location, count, reinterpret_cast<const GLint*>(values));
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::mat3* values) {
+			glProgramUniformMatrix3fv(program, location, count, GL_FALSE, reinterpret_cast<const GLfloat*>(values));
+		}
+
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::mat4* values) {
+			glProgramUniformMatrix4fv(program, location, count, GL_FALSE, reinterpret_cast<const GLfloat*>(values));
+		}
+
 	}
 }
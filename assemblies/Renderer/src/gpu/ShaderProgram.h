@@ -4,27 +4,112 @@
 
 #pragma once
 
+#include "gpu/ShaderType.h"
+
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
+#include <deque>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace vr {
 	namespace gpu {
 
+		/// @brief Location of a uniform shared by its handles, resolved again when the program is reloaded.
+		struct UniformSlot {
+			std::string name;
+			ShaderType type;	// Type requested by the handles
+			GLuint program = 0;
+			GLint location = -1;
+		};
+
+		// Typed glProgramUniform calls
+		void programUniform(GLuint program, GLint location, GLsizei count, const float* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const int32_t* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const uint32_t* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::vec2* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::vec3* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::vec4* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::ivec2* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::ivec3* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::ivec4* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::mat3* values);
+		void programUniform(GLuint program, GLint location, GLsizei count, const glm::mat4* values);
+
+		/// @brief Typed handle to a uniform of the default block of a program. Stays valid across reload(), and
+		/// does nothing when the uniform is not active. Must not outlive its program.
+		template<typename T>
+		class UniformHandle {
+		public:
+			UniformHandle() = default;
+			explicit UniformHandle(const UniformSlot* slot) : m_slot(slot) {}
+
+			/// @brief Sets the uniform, the program doesn't need to be bound.
+			void set(const T& value) const { set(&value, 1); }
+			void set(const T* values, GLsizei count) const {
+				if (m_slot && m_slot->location >= 0)
+					programUniform(m_slot->program, m_slot->location, count, values);
+			}
+
+			/// @brief Location of the uniform, -1 if it is not active. Changes when the program is reloaded.
+			GLint getLocation() const { return m_slot ? m_slot->location : -1; }
+
+		private:
+			const UniformSlot* m_slot = nullptr;
+		};
+
 		class ShaderProgram {
 			using SourceMap = std::unordered_map<GLenum, std::string>;
 			using ShaderMap = std::unordered_map<GLenum, GLuint>;
 
+		public:
+			/// @brief Active resources of the linked program, reflected through the program interface queries.
+			struct Reflection {
+				struct Variable {
+					std::string name;	// Arrays without their [0] suffix, block members prefixed as GL names them
+					GLenum type;
+					GLint arraySize;
+					GLint location;		// -1 for block members
+					GLint blockIndex;	// -1 for the default block
+					GLint offset;		// Bytes from the start of the block
+					GLint arrayStride;	// Storage block members only: stride of their top level array, 0 outside of one
+				};
+
+				struct Block {
+					std::string name;
+					GLint binding;
+					GLint dataSize;
+				};
+
+				std::vector<Variable> uniforms;
+				std::vector<Block> uniformBlocks;		// Indexed by the block index of their members
+				std::vector<Variable> bufferVariables;	// Members of the storage blocks
+				std::vector<Block> storageBlocks;
+
+				const Variable* findUniform(std::string_view name) const;
+
+				/// @brief Provides the index of the block at a binding, -1 if none.
+				GLint findUniformBlock(GLint binding) const;
+				GLint findStorageBlock(GLint binding) const;
+			};
+
 		public:
 			ShaderProgram() : m_handle(0) {}
 			ShaderProgram(const char* path);
 
+			/// @brief Loads a variant of a shader program, compiled with extra preprocessor definitions.
+			/// @param path Path of the shader source file.
+			/// @param defines Macro names defined right after the version directive of every stage.
+			ShaderProgram(const char* path, const std::vector<std::string>& defines);
+
 			// No copy semantic
 			ShaderProgram(const ShaderProgram&) = delete;
 			ShaderProgram& operator=(const ShaderProgram&) = delete;
 
-			// Move semantic
+			// Move semantic, handles follow the program they were given by
 			ShaderProgram(ShaderProgram&& other) noexcept;
 			ShaderProgram& operator=(ShaderProgram&& other) noexcept;
 
@@ -32,18 +117,36 @@ namespace vr {
 
 			void reload();
 
+			const Reflection& getReflection() const { return m_reflection; }
+
+			/// @brief Provides a handle to a uniform of the default block, resolved at link time. Handles to the
+			/// same uniform share their location, the handles of a reloaded program are resolved again.
+			template<typename T>
+			UniformHandle<T> getUniform(const std::string& name) const {
+				return UniformHandle<T>(findSlot(name, ShaderType::associated_type<T>()));
+			}
+
 			inline operator GLuint() const { return m_handle; }
 
 		private:
-			static GLuint loadProgram(const char* path);
+			void load();
+			const UniformSlot* findSlot(const std::string& name, ShaderType type) const;
+			void resolveSlot(UniformSlot& slot) const;
+
+			static GLuint loadProgram(const char* path, const std::vector<std::string>& defines);
 			static std::string readSource(const char* path);
-			static SourceMap preprocessSource(const std::string& code);
+			static SourceMap preprocessSource(const std::string& code, const std::vector<std::string>& defines);
 			static ShaderMap compileProgram(const SourceMap& sources);
 			static GLuint linkProgram(ShaderMap&& shaders);
+			static Reflection reflectProgram(GLuint program);
 
 		private:
 			GLuint m_handle;
 			std::string m_path;
+			std::vector<std::string> m_defines;
+
+			Reflection m_reflection;
+			mutable std::deque<UniformSlot> m_slots;	// Handles point into it, its elements never move
 		};
 
 	}
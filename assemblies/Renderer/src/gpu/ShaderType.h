@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include <cstdint>
+#include <string_view>
 
 
 namespace vr {
@@ -16,6 +18,7 @@ namespace vr {
 		public:
 			enum Type : uint32_t {
 				Bool = (1 << 0),
+				UInt = (1 << 1),
 				Int = (1 << 2),
 				Float = (1 << 3),
 				Vec2 = (1 << 4),
@@ -41,9 +44,11 @@ namespace vr {
 			explicit operator bool() const = delete;
 
 			uint32_t size() const {
-				switch (m_type) {
+				switch (static_cast<uint32_t>(m_type)) {
 				case Bool | Int:
+				case Bool | UInt:
 				case Bool:
+				case UInt:
 				case Int:	return 4;
 				case Float: return 4;
 				case Vec2:	return 2 * 4;
@@ -64,9 +69,11 @@ namespace vr {
 			}
 
 			uint32_t alignment() const {
-				switch (m_type) {
+				switch (static_cast<uint32_t>(m_type)) {
 				case Bool | Int:
+				case Bool | UInt:
 				case Bool:
+				case UInt:
 				case Int:	return 4;
 				case Float: return 4;
 				case Vec2:	return 2 * 4;
@@ -87,10 +94,12 @@ namespace vr {
 			}
 
 			const char* name() const {
-				switch (m_type) {
+				switch (static_cast<uint32_t>(m_type)) {
 				case Bool:			return "Bool";
 				case Int:			return "Int";
 				case Int | Bool:	return "Int/Bool";
+				case UInt:			return "UInt";
+				case UInt | Bool:	return "UInt/Bool";
 				case Float:			return "Float";
 				case Vec2:			return "Vec2";
 				case Vec3:			return "Vec3";
@@ -112,6 +121,7 @@ namespace vr {
 			static ShaderType fromName(std::string_view name) {
 				if (name == "Bool") return ShaderType(ShaderType::Bool);
 				if (name == "Int") return ShaderType(ShaderType::Int);
+				if (name == "UInt") return ShaderType(ShaderType::UInt);
 				if (name == "Float") return ShaderType(ShaderType::Float);
 				if (name == "Vec2") return ShaderType(ShaderType::Vec2);
 				if (name == "Color3") return ShaderType(ShaderType::Color3);
@@ -128,11 +138,32 @@ namespace vr {
 				return ShaderType(ShaderType::Unknown);
 			}
 
+			/// @brief Type of a reflected GL type, Unknown for the opaque types.
+			static ShaderType fromGLType(GLenum type) {
+				switch (type) {
+				case GL_BOOL:				return ShaderType(ShaderType::Bool);
+				case GL_INT:				return ShaderType(ShaderType::Int);
+				case GL_UNSIGNED_INT:		return ShaderType(ShaderType::UInt);
+				case GL_FLOAT:				return ShaderType(ShaderType::Float);
+				case GL_FLOAT_VEC2:			return ShaderType(ShaderType::Vec2);
+				case GL_FLOAT_VEC3:			return ShaderType((Type)(Vec3 | Color3));
+				case GL_FLOAT_VEC4:			return ShaderType((Type)(Vec4 | Color4));
+				case GL_INT_VEC2:			return ShaderType(ShaderType::IVec2);
+				case GL_INT_VEC3:			return ShaderType(ShaderType::IVec3);
+				case GL_INT_VEC4:			return ShaderType(ShaderType::IVec4);
+				case GL_FLOAT_MAT2:			return ShaderType(ShaderType::Mat2);
+				case GL_FLOAT_MAT3:			return ShaderType(ShaderType::Mat3);
+				case GL_FLOAT_MAT4:			return ShaderType(ShaderType::Mat4);
+				default:					return ShaderType(ShaderType::Unknown);
+				}
+			}
+
 			template<class T>
 			static ShaderType associated_type() { return Type::Unknown; }
 
 #define ASSOCIATE(type, shader_type) template<> static ShaderType associated_type<type>() { return shader_type; }
 			ASSOCIATE(int32_t, (Type)(Int | Bool))
+			ASSOCIATE(uint32_t, (Type)(UInt | Bool))
 			ASSOCIATE(float, Float)
 			ASSOCIATE(glm::vec2, Vec2)
 			ASSOCIATE(glm::vec3, (Type)(Vec3 | Color3))
@@ -0,0 +1,209 @@
+// VR Renderer - GPU State Cache
+// Rodolphe VALICON
+// 2025
+
+#include "StateCache.h"
+
+#include <algorithm>
+
+namespace vr {
+	namespace gpu {
+
+		StateCache& StateCache::getInstance() {
+			// Trivially destructible, objects released at exit can still forget their bindings
+			static StateCache s_cache;
+			return s_cache;
+		}
+
+		StateCache::StateCache() {
+			invalidate();
+		}
+
+		void StateCache::useProgram(GLuint program) {
+			if (!track(m_program == program)) return;
+
+			glUseProgram(program);
+			m_program = program;
+		}
+
+		void StateCache::bindVertexArray(GLuint vertexArray) {
+			if (!track(m_vertexArray == vertexArray)) return;
+
+			glBindVertexArray(vertexArray);
+			m_vertexArray = vertexArray;
+		}
+
+		void StateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+			bindBufferRange(target, index, buffer, 0, -1);
+		}
+
+		void StateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+			std::array<BufferBinding, s_MAX_BUFFER_BINDINGS>* bindings = nullptr;
+			if (target == GL_UNIFORM_BUFFER) bindings = &m_uniformBuffers;
+			else if (target == GL_SHADER_STORAGE_BUFFER) bindings = &m_storageBuffers;
+
+			// Other targets and bindings are not tracked
+			BufferBinding* binding = bindings && index < s_MAX_BUFFER_BINDINGS ? &(*bindings)[index] : nullptr;
+			if (binding && !track(binding->buffer == buffer && binding->offset == offset && binding->size == size)) return;
+			if (!binding) ++m_counters.issued;
+
+			if (size < 0)
+				glBindBufferBase(target, index, buffer);
+			else
+				glBindBufferRange(target, index, buffer, offset, size);
+
+			if (binding)
+				*binding = BufferBinding{ buffer, offset, size };
+		}
+
+		void StateCache::bindTextureUnit(GLuint unit, GLuint texture) {
+			if (unit >= s_MAX_TEXTURE_UNITS) {
+				++m_counters.issued;
+				glBindTextureUnit(unit, texture);
+				return;
+			}
+
+			if (!track(m_textures[unit] == texture)) return;
+
+			glBindTextureUnit(unit, texture);
+			m_textures[unit] = texture;
+		}
+
+		void StateCache::bindSampler(GLuint unit, GLuint sampler) {
+			if (unit >= s_MAX_TEXTURE_UNITS) {
+				++m_counters.issued;
+				glBindSampler(unit, sampler);
+				return;
+			}
+
+			if (!track(m_samplers[unit] == sampler)) return;
+
+			glBindSampler(unit, sampler);
+			m_samplers[unit] = sampler;
+		}
+
+		void StateCache::bindTextures(GLuint first, GLsizei count, const GLuint* textures) {
+			if (count <= 0) return;
+
+			if (first + count > s_MAX_TEXTURE_UNITS) {
+				++m_counters.issued;
+				glBindTextures(first, count, textures);
+
+				// Units of the range that are tracked still have to reflect the bind
+				for (GLuint unit = first; unit < s_MAX_TEXTURE_UNITS; ++unit)
+					m_textures[unit] = textures ? textures[unit - first] : 0;
+				return;
+			}
+
+			// Only the span between the first and the last changed unit is bound
+			GLsizei low = 0;
+			while (low < count && m_textures[first + low] == textures[low]) ++low;
+			if (!track(low == count)) return;
+
+			GLsizei high = count - 1;
+			while (m_textures[first + high] == textures[high]) --high;
+
+			glBindTextures(first + low, high - low + 1, textures + low);
+			std::copy(textures + low, textures + high + 1, m_textures.begin() + first + low);
+		}
+
+		void StateCache::enable(GLenum capability) {
+			setCapability(capability, true);
+		}
+
+		void StateCache::disable(GLenum capability) {
+			setCapability(capability, false);
+		}
+
+		void StateCache::depthFunc(GLenum function) {
+			if (!track(m_depthFunc == function)) return;
+
+			glDepthFunc(function);
+			m_depthFunc = function;
+		}
+
+		void StateCache::depthMask(GLboolean mask) {
+			if (!track(m_depthMask == mask)) return;
+
+			glDepthMask(mask);
+			m_depthMask = mask;
+		}
+
+		void StateCache::cullFace(GLenum face) {
+			if (!track(m_cullFace == face)) return;
+
+			glCullFace(face);
+			m_cullFace = face;
+		}
+
+		void StateCache::forgetProgram(GLuint program) {
+			if (m_program == program) m_program = s_UNKNOWN;
+		}
+
+		void StateCache::forgetBuffer(GLuint buffer) {
+			for (BufferBinding& binding : m_uniformBuffers)
+				if (binding.buffer == buffer) binding.buffer = s_UNKNOWN;
+			for (BufferBinding& binding : m_storageBuffers)
+				if (binding.buffer == buffer) binding.buffer = s_UNKNOWN;
+		}
+
+		void StateCache::forgetTexture(GLuint texture) {
+			std::replace(m_textures.begin(), m_textures.end(), texture, s_UNKNOWN);
+		}
+
+		void StateCache::forgetVertexArray(GLuint vertexArray) {
+			if (m_vertexArray == vertexArray) m_vertexArray = s_UNKNOWN;
+		}
+
+		void StateCache::invalidate() {
+			m_program = s_UNKNOWN;
+			m_vertexArray = s_UNKNOWN;
+			m_uniformBuffers.fill(BufferBinding{});
+			m_storageBuffers.fill(BufferBinding{});
+			m_textures.fill(s_UNKNOWN);
+			m_samplers.fill(s_UNKNOWN);
+			for (uint32_t i = 0; i < m_capabilityCount; ++i)
+				m_capabilities[i].enabled = -1;
+
+			m_depthFunc = s_UNKNOWN;
+			m_cullFace = s_UNKNOWN;
+			m_depthMask = -1;
+		}
+
+		StateCache::Counters StateCache::takeCounters() {
+			const Counters counters = m_counters;
+			m_counters = Counters{};
+			return counters;
+		}
+
+		void StateCache::setCapability(GLenum capability, bool enabled) {
+			// Capabilities get a slot on first use, past the last slot they are no longer tracked
+			Capability* slot = nullptr;
+			for (uint32_t i = 0; i < m_capabilityCount && !slot; ++i) {
+				if (m_capabilities[i].capability == capability)
+					slot = &m_capabilities[i];
+			}
+			if (!slot && m_capabilityCount < s_MAX_CAPABILITIES) {
+				slot = &m_capabilities[m_capabilityCount++];
+				*slot = Capability{ capability, -1 };
+			}
+
+			if (slot && !track(slot->enabled == static_cast<int8_t>(enabled))) return;
+			if (!slot) ++m_counters.issued;
+
+			if (enabled)
+				glEnable(capability);
+			else
+				glDisable(capability);
+
+			if (slot)
+				slot->enabled = static_cast<int8_t>(enabled);
+		}
+
+		bool StateCache::track(bool unchanged) {
+			++(unchanged ? m_counters.skipped : m_counters.issued);
+			return !unchanged;
+		}
+
+	}
+}
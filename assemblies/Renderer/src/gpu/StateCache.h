@@ -0,0 +1,102 @@
+// VR Renderer - GPU State Cache
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+
+namespace vr {
+	namespace gpu {
+
+		/// @brief Shadows the bindings and fixed function state of the context, so that calls setting the state
+		/// it already holds are skipped. The state is only known once set through the cache: code setting it
+		/// directly must invalidate it. Must only be used by the thread holding the context.
+		class StateCache {
+		public:
+			struct Counters {
+				uint32_t issued = 0;	// GL calls forwarded to the driver
+				uint32_t skipped = 0;	// Calls whose state was already set
+			};
+
+		public:
+			/// @brief Provides the cache of the context.
+			static StateCache& getInstance();
+
+			// Bindings
+			void useProgram(GLuint program);
+			void bindVertexArray(GLuint vertexArray);
+			void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+			void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+			void bindTextureUnit(GLuint unit, GLuint texture);
+			void bindSampler(GLuint unit, GLuint sampler);
+
+			/// @brief Binds consecutive texture units with a single glBindTextures, over the span of units that changed.
+			/// @param first First unit to bind.
+			/// @param count Number of units.
+			/// @param textures Texture of each unit, 0 unbinds it.
+			void bindTextures(GLuint first, GLsizei count, const GLuint* textures);
+
+			// Fixed function state
+			void enable(GLenum capability);
+			void disable(GLenum capability);
+			void depthFunc(GLenum function);
+			void depthMask(GLboolean mask);
+			void cullFace(GLenum face);
+
+			/// @brief Forgets the bindings of a deleted object, so that a new object reusing its name is bound again.
+			void forgetProgram(GLuint program);
+			void forgetBuffer(GLuint buffer);
+			void forgetTexture(GLuint texture);
+			void forgetVertexArray(GLuint vertexArray);
+
+			/// @brief Forgets the whole state, the next call of each kind is issued.
+			void invalidate();
+
+			/// @brief Provides the counters since the last call, and resets them.
+			Counters takeCounters();
+
+		private:
+			StateCache();
+
+			void setCapability(GLenum capability, bool enabled);
+			bool track(bool unchanged);
+
+		private:
+			static constexpr GLuint s_UNKNOWN = ~0u;
+			static constexpr uint32_t s_MAX_TEXTURE_UNITS = 32;
+			static constexpr uint32_t s_MAX_BUFFER_BINDINGS = 16;
+			static constexpr uint32_t s_MAX_CAPABILITIES = 16;
+
+			struct BufferBinding {
+				GLuint buffer = s_UNKNOWN;
+				GLintptr offset = 0;
+				GLsizeiptr size = 0;	// -1 for the whole buffer
+			};
+
+			struct Capability {
+				GLenum capability = 0;
+				int8_t enabled = -1;	// -1 if unknown
+			};
+
+			GLuint m_program = s_UNKNOWN;
+			GLuint m_vertexArray = s_UNKNOWN;
+			std::array<BufferBinding, s_MAX_BUFFER_BINDINGS> m_uniformBuffers;
+			std::array<BufferBinding, s_MAX_BUFFER_BINDINGS> m_storageBuffers;
+			std::array<GLuint, s_MAX_TEXTURE_UNITS> m_textures;
+			std::array<GLuint, s_MAX_TEXTURE_UNITS> m_samplers;
+
+			std::array<Capability, s_MAX_CAPABILITIES> m_capabilities;
+			uint32_t m_capabilityCount = 0;
+			GLenum m_depthFunc = s_UNKNOWN;
+			GLenum m_cullFace = s_UNKNOWN;
+			GLint m_depthMask = -1;
+
+			Counters m_counters;
+		};
+
+	}
+}
@@ -3,6 +3,7 @@
 // 2025
 
 #include "Texture.h"
+#include "gpu/StateCache.h"
 
 #include <utility>
 
@@ -24,7 +25,20 @@ namespace vr {
 			glTextureParameteri(m_handle, GL_TEXTURE_WRAP_R, sampler.wrapR);
 		}
 
+		Texture::Texture(const Texture& source, GLenum type, GLenum format, GLuint firstLevel, GLuint levelCount, GLuint firstLayer, GLuint layerCount, const Sampler& sampler) {
+			// Views need a name that was never bound, created textures already have a type
+			glGenTextures(1, &m_handle);
+			glTextureView(m_handle, type, source, format, firstLevel, levelCount, firstLayer, layerCount);
+
+			glTextureParameteri(m_handle, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+			glTextureParameteri(m_handle, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+			glTextureParameteri(m_handle, GL_TEXTURE_WRAP_S, sampler.wrapS);
+			glTextureParameteri(m_handle, GL_TEXTURE_WRAP_T, sampler.wrapT);
+			glTextureParameteri(m_handle, GL_TEXTURE_WRAP_R, sampler.wrapR);
+		}
+
 		Texture::~Texture() {
+			StateCache::getInstance().forgetTexture(m_handle);
 			glDeleteTextures(1, &m_handle);
 		}
 
@@ -33,6 +47,7 @@ namespace vr {
 
 		Texture& Texture::operator=(Texture&& other) noexcept {
 			if (m_handle == other.m_handle) return *this;
+			StateCache::getInstance().forgetTexture(m_handle);
 			glDeleteTextures(1, &m_handle);
 
 			m_handle = std::exchange(other.m_handle, 0);
@@ -15,6 +15,12 @@ namespace vr {
 		public:
 			Texture(GLenum type);
 			Texture(GLenum type, const Sampler& sampler);
+
+			/// @brief Creates a view of levels and layers of another texture, sharing its storage.
+			/// @param source Texture with immutable storage.
+			/// @param type Type of the view, GL_TEXTURE_2D for a single layer of an array.
+			/// @param format Internal format of the view, compatible with the source format.
+			Texture(const Texture& source, GLenum type, GLenum format, GLuint firstLevel, GLuint levelCount, GLuint firstLayer, GLuint layerCount, const Sampler& sampler);
 			~Texture();
 
 			// No copy semantic
@@ -3,6 +3,7 @@
 // 2025
 
 #include "VertexArray.h"
+#include "gpu/StateCache.h"
 
 namespace vr {
 	namespace gpu {
@@ -12,35 +13,57 @@ namespace vr {
 			setLayout(geometry.layout);
 			m_vertexBuffer = Buffer(geometry.vertex_data.size(), GL_STATIC_DRAW, geometry.vertex_data.data());
 			m_elementBuffer = Buffer(geometry.indices.size() * sizeof(uint32_t), GL_STATIC_DRAW, reinterpret_cast<const uint8_t*>(geometry.indices.data()));
+			m_layout = geometry.layout;
 			m_elementCount = static_cast<uint32_t>(geometry.indices.size());
+			m_vertexCount = geometry.layout.getStride() > 0 ? static_cast<uint32_t>(geometry.vertex_data.size() / geometry.layout.getStride()) : 0;
 			m_topology = geometry.topology;
 
 			glVertexArrayVertexBuffer(m_handle, 0, m_vertexBuffer, 0, geometry.layout.getStride());
 			glVertexArrayElementBuffer(m_handle, m_elementBuffer);
 		}
 
+		VertexArray::VertexArray(const VertexLayout& layout, GLenum topology, uint32_t vertexCount, uint32_t elementCount) {
+			glCreateVertexArrays(1, &m_handle);
+			setLayout(layout);
+			m_vertexBuffer = Buffer(static_cast<size_t>(vertexCount) * layout.getStride(), GL_STATIC_DRAW);
+			m_elementBuffer = Buffer(static_cast<size_t>(elementCount) * sizeof(uint32_t), GL_STATIC_DRAW);
+			m_layout = layout;
+			m_elementCount = elementCount;
+			m_vertexCount = vertexCount;
+			m_topology = topology;
+
+			glVertexArrayVertexBuffer(m_handle, 0, m_vertexBuffer, 0, layout.getStride());
+			glVertexArrayElementBuffer(m_handle, m_elementBuffer);
+		}
+
 		VertexArray::VertexArray(VertexArray&& other) noexcept :
 			m_handle(std::exchange(other.m_handle, 0)),
 			m_vertexBuffer(std::move(other.m_vertexBuffer)),
 			m_elementBuffer(std::move(other.m_elementBuffer)),
+			m_layout(std::move(other.m_layout)),
+			m_topology(std::exchange(other.m_topology, 0)),
 			m_elementCount(std::exchange(other.m_elementCount, 0)),
-			m_topology(std::exchange(other.m_topology, 0))
+			m_vertexCount(std::exchange(other.m_vertexCount, 0))
 		{}
 
 		VertexArray& VertexArray::operator=(VertexArray&& other) noexcept {
 			if (m_handle == other.m_handle) return *this;
+			StateCache::getInstance().forgetVertexArray(m_handle);
 			glDeleteVertexArrays(1, &m_handle);
 
 			m_handle = std::exchange(other.m_handle, 0);
 			m_vertexBuffer = std::move(other.m_vertexBuffer);
 			m_elementBuffer = std::move(other.m_elementBuffer);
+			m_layout = std::move(other.m_layout);
 			m_elementCount = std::exchange(other.m_elementCount, 0);
+			m_vertexCount = std::exchange(other.m_vertexCount, 0);
 			m_topology = std::exchange(other.m_topology, 0);
 
 			return *this;
 		}
 
 		VertexArray::~VertexArray() {
+			StateCache::getInstance().forgetVertexArray(m_handle);
 			glDeleteVertexArrays(1, &m_handle);
 		}
 
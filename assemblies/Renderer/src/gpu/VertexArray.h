@@ -22,6 +22,13 @@ namespace vr {
 			VertexArray() = default;
 			VertexArray(const GeometryData& geometry);
 
+			/// @brief Allocates an uninitialized vertex array, to be filled with buffer copies.
+			/// @param layout Layout of the vertices.
+			/// @param topology Primitive topology.
+			/// @param vertexCount Number of vertices to allocate.
+			/// @param elementCount Number of indices to allocate.
+			VertexArray(const VertexLayout& layout, GLenum topology, uint32_t vertexCount, uint32_t elementCount);
+
 			// No copy semantic
 			VertexArray(const VertexArray&) = delete;
 			VertexArray& operator=(const VertexArray&) = delete;
@@ -35,7 +42,12 @@ namespace vr {
 			operator GLuint() { return m_handle; }
 
 			uint32_t getElementCount() const { return m_elementCount; }
+			uint32_t getVertexCount() const { return m_vertexCount; }
 			GLenum getTopology() const { return m_topology; }
+			const VertexLayout& getLayout() const { return m_layout; }
+
+			const Buffer& getVertexBuffer() const { return m_vertexBuffer; }
+			const Buffer& getElementBuffer() const { return m_elementBuffer; }
 
 		private:
 			void setLayout(const VertexLayout& layout) const;
@@ -45,9 +57,11 @@ namespace vr {
 
 			Buffer m_vertexBuffer;
 			Buffer m_elementBuffer;
+			VertexLayout m_layout;
 
 			GLenum m_topology;
 			uint32_t m_elementCount;
+			uint32_t m_vertexCount;
 		};
 
 	}
@@ -32,6 +32,22 @@ namespace vr {
 			}
 		}
 
+		bool VertexLayout::operator==(const VertexLayout& other) const {
+			if (m_stride != other.m_stride || m_attributes.size() != other.m_attributes.size())
+				return false;
+
+			for (const auto& [name, attribute] : m_attributes) {
+				auto it = other.m_attributes.find(name);
+				if (it == other.m_attributes.end()) return false;
+
+				const VertexAttribute& otherAttribute = it->second;
+				if (attribute.type != otherAttribute.type || attribute.components != otherAttribute.components || attribute.offset != otherAttribute.offset)
+					return false;
+			}
+
+			return true;
+		}
+
 		void VertexLayout::addAttribute(VertexAttribute attribute) {
 			attribute.offset = m_stride;
 			m_attributes[attribute.attribute] = attribute;
@@ -76,6 +76,9 @@ namespace vr {
 
 			size_t size() const { return m_attributes.size(); }
 
+			/// @brief Tests whether two layouts describe the same vertex format, so that their vertices can share a buffer.
+			bool operator==(const VertexLayout& other) const;
+
 			Attributes::iterator begin() { return m_attributes.begin(); }
 			Attributes::iterator end() { return m_attributes.end(); }
 			Attributes::const_iterator begin() const { return m_attributes.begin(); }
@@ -0,0 +1,285 @@
+// VR Renderer - Bounding Volume Hierarchy
+// Rodolphe VALICON
+// 2025
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace vr {
+
+	// Distance along the ray to the box, clamped to the ray segment.
+	static bool IntersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) {
+		const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+		const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+		const glm::vec3 entries = glm::min(t0, t1);
+		const glm::vec3 exits = glm::max(t0, t1);
+
+		const float entry = glm::max(glm::max(entries.x, entries.y), glm::max(entries.z, 0.0f));
+		const float exit = glm::min(glm::min(exits.x, exits.y), glm::min(exits.z, maxDistance));
+		distance = entry;
+		return entry <= exit;
+	}
+
+	void BoundingVolumeHierarchy::build(const std::vector<AABB>& bounds) {
+		m_bounds = bounds;
+		rebuild();
+	}
+
+	void BoundingVolumeHierarchy::update(uint32_t object, const AABB& bounds) {
+		m_bounds[object] = bounds;
+
+		// Flag the path to the root, stopping at the first node already flagged
+		for (uint32_t node = m_leaves[object]; !m_dirty[node]; node = m_parents[node]) {
+			m_dirty[node] = true;
+			if (node == 0) break;
+		}
+	}
+
+	bool BoundingVolumeHierarchy::refit() {
+		if (m_nodes.empty() || !m_dirty[0]) return false;
+
+		refitNode(0);
+		if (getDegradation() <= rebuildThreshold) return false;
+
+		rebuild();
+		return true;
+	}
+
+	float BoundingVolumeHierarchy::getDegradation() const {
+		if (m_nodes.empty()) return 1.0f;
+
+		const float rootArea = m_nodes[0].bounds.getSurfaceArea();
+		if (rootArea <= 0.0f || m_builtCost <= 0.0f) return 1.0f;
+
+		return m_areaSum / rootArea / m_builtCost;
+	}
+
+	void BoundingVolumeHierarchy::rebuild() {
+		const uint32_t objectCount = static_cast<uint32_t>(m_bounds.size());
+		m_nodes.clear();
+		m_objects.resize(objectCount);
+		m_leaves.resize(objectCount);
+		std::iota(m_objects.begin(), m_objects.end(), 0);
+		if (objectCount == 0) return;
+
+		std::vector<glm::vec3> centroids(objectCount);
+		for (uint32_t i = 0; i < objectCount; ++i)
+			centroids[i] = m_bounds[i].getCenter();
+
+		// A binary tree with one object per leaf has 2n - 1 nodes, so references stay valid while building
+		m_nodes.reserve(2 * objectCount - 1);
+		m_nodes.push_back(Node{ AABB{}, 0, objectCount, 0 });
+		subdivide(0, 0, centroids);
+
+		m_parents.assign(m_nodes.size(), 0);
+		m_dirty.assign(m_nodes.size(), false);
+		m_areaSum = 0.0f;
+		for (uint32_t i = 0; i < m_nodes.size(); ++i) {
+			const Node& node = m_nodes[i];
+			m_areaSum += node.bounds.getSurfaceArea();
+
+			if (node.left != 0) {
+				m_parents[node.left] = i;
+				m_parents[node.left + 1] = i;
+			} else {
+				for (uint32_t o = node.first; o < node.first + node.count; ++o)
+					m_leaves[m_objects[o]] = i;
+			}
+		}
+
+		const float rootArea = m_nodes[0].bounds.getSurfaceArea();
+		m_builtCost = rootArea > 0.0f ? m_areaSum / rootArea : 0.0f;
+	}
+
+	void BoundingVolumeHierarchy::subdivide(uint32_t index, uint32_t depth, const std::vector<glm::vec3>& centroids) {
+		Node& node = m_nodes[index];
+		const uint32_t begin = node.first;
+		const uint32_t end = node.first + node.count;
+
+		AABB centroidBounds;
+		for (uint32_t o = begin; o < end; ++o) {
+			node.bounds.expand(m_bounds[m_objects[o]]);
+			centroidBounds.expand(centroids[m_objects[o]]);
+		}
+
+		if (node.count <= s_MAX_LEAF_SIZE || depth + 1 >= s_MAX_DEPTH) return;
+
+		// Binned surface area heuristic, over the three axes
+		struct Bin {
+			AABB bounds;
+			uint32_t count = 0;
+		};
+
+		const glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+		float bestCost = std::numeric_limits<float>::max();
+		uint32_t bestAxis = 0;
+		uint32_t bestSplit = 0;
+
+		for (uint32_t axis = 0; axis < 3; ++axis) {
+			if (extent[axis] <= 0.0f) continue;
+
+			const float scale = s_BIN_COUNT / extent[axis];
+			std::array<Bin, s_BIN_COUNT> bins;
+			for (uint32_t o = begin; o < end; ++o) {
+				const uint32_t object = m_objects[o];
+				const uint32_t bin = std::min(s_BIN_COUNT - 1, static_cast<uint32_t>((centroids[object][axis] - centroidBounds.min[axis]) * scale));
+				bins[bin].bounds.expand(m_bounds[object]);
+				++bins[bin].count;
+			}
+
+			// Sweep from the right to gather the right side areas, then from the left to evaluate every split
+			std::array<float, s_BIN_COUNT> rightAreas;
+			AABB right;
+			for (uint32_t bin = s_BIN_COUNT - 1; bin > 0; --bin) {
+				right.expand(bins[bin].bounds);
+				rightAreas[bin] = right.isValid() ? right.getSurfaceArea() : 0.0f;
+			}
+
+			AABB left;
+			uint32_t leftCount = 0;
+			for (uint32_t split = 1; split < s_BIN_COUNT; ++split) {
+				left.expand(bins[split - 1].bounds);
+				leftCount += bins[split - 1].count;
+				if (leftCount == 0 || leftCount == node.count) continue;
+
+				const float cost = left.getSurfaceArea() * leftCount + rightAreas[split] * (node.count - leftCount);
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		// Keep small leaves when splitting them isn't worth the extra traversal step
+		const float area = node.bounds.getSurfaceArea();
+		const float leafCost = static_cast<float>(node.count);
+		const float splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+		if (bestSplit != 0 && splitCost >= leafCost && node.count <= 4 * s_MAX_LEAF_SIZE) return;
+
+		uint32_t middle = begin + node.count / 2;
+		if (bestSplit != 0) {
+			const float scale = s_BIN_COUNT / extent[bestAxis];
+			auto firstRight = std::partition(m_objects.begin() + begin, m_objects.begin() + end, [&](uint32_t object) {
+				return std::min(s_BIN_COUNT - 1, static_cast<uint32_t>((centroids[object][bestAxis] - centroidBounds.min[bestAxis]) * scale)) < bestSplit;
+			});
+			middle = static_cast<uint32_t>(firstRight - m_objects.begin());
+		}
+
+		// Objects sharing the same centroid are split in two halves, whatever their order
+		const uint32_t left = static_cast<uint32_t>(m_nodes.size());
+		node.left = left;
+		m_nodes.push_back(Node{ AABB{}, begin, middle - begin, 0 });
+		m_nodes.push_back(Node{ AABB{}, middle, end - middle, 0 });
+
+		subdivide(left, depth + 1, centroids);
+		subdivide(left + 1, depth + 1, centroids);
+	}
+
+	void BoundingVolumeHierarchy::refitNode(uint32_t index) {
+		Node& node = m_nodes[index];
+		const float previousArea = node.bounds.getSurfaceArea();
+
+		if (node.left == 0) {
+			node.bounds = AABB{};
+			for (uint32_t o = node.first; o < node.first + node.count; ++o)
+				node.bounds.expand(m_bounds[m_objects[o]]);
+		} else {
+			if (m_dirty[node.left]) refitNode(node.left);
+			if (m_dirty[node.left + 1]) refitNode(node.left + 1);
+
+			node.bounds = m_nodes[node.left].bounds;
+			node.bounds.expand(m_nodes[node.left + 1].bounds);
+		}
+
+		m_areaSum += node.bounds.getSurfaceArea() - previousArea;
+		m_dirty[index] = false;
+	}
+
+	template<typename Test>
+	void BoundingVolumeHierarchy::queryVolume(const Test& test, std::vector<uint32_t>& objects) const {
+		if (m_nodes.empty()) return;
+
+		// Subdivision stops before s_MAX_DEPTH, which bounds the pending siblings
+		std::array<uint32_t, s_MAX_DEPTH> stack;
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0) {
+			const Node& node = m_nodes[stack[--stackSize]];
+			const int32_t result = test(node.bounds);
+			if (result == 0) continue;
+
+			if (result == 2) {
+				// Every object below is inside
+				objects.insert(objects.end(), m_objects.begin() + node.first, m_objects.begin() + node.first + node.count);
+			} else if (node.left == 0) {
+				for (uint32_t o = node.first; o < node.first + node.count; ++o) {
+					if (node.count == 1 || test(m_bounds[m_objects[o]]) != 0)
+						objects.push_back(m_objects[o]);
+				}
+			} else {
+				stack[stackSize++] = node.left;
+				stack[stackSize++] = node.left + 1;
+			}
+		}
+	}
+
+	void BoundingVolumeHierarchy::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects) const {
+		queryVolume([&](const AABB& box) {
+			if (!frustum.intersects(box)) return 0;
+			return frustum.contains(box) ? 2 : 1;
+		}, objects);
+	}
+
+	void BoundingVolumeHierarchy::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const {
+		const float squaredRadius = radius * radius;
+		queryVolume([&](const AABB& box) {
+			const glm::vec3 nearest = glm::max(glm::max(box.min - center, center - box.max), 0.0f);
+			if (glm::dot(nearest, nearest) > squaredRadius) return 0;
+
+			const glm::vec3 farthest = glm::max(glm::abs(box.min - center), glm::abs(box.max - center));
+			return glm::dot(farthest, farthest) <= squaredRadius ? 2 : 1;
+		}, objects);
+	}
+
+	void BoundingVolumeHierarchy::queryBox(const AABB& box, std::vector<uint32_t>& objects) const {
+		queryVolume([&](const AABB& other) {
+			if (!box.overlaps(other)) return 0;
+			return box.contains(other) ? 2 : 1;
+		}, objects);
+	}
+
+	void BoundingVolumeHierarchy::queryRay(const Ray& ray, float maxDistance, std::vector<RayHit>& hits) const {
+		if (m_nodes.empty()) return;
+
+		const size_t firstHit = hits.size();
+		const glm::vec3 inverseDirection = 1.0f / ray.direction;
+
+		std::array<uint32_t, s_MAX_DEPTH> stack;
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0) {
+			const Node& node = m_nodes[stack[--stackSize]];
+			float distance;
+			if (!IntersectRay(node.bounds, ray.origin, inverseDirection, maxDistance, distance)) continue;
+
+			if (node.left == 0) {
+				for (uint32_t o = node.first; o < node.first + node.count; ++o) {
+					if (IntersectRay(m_bounds[m_objects[o]], ray.origin, inverseDirection, maxDistance, distance))
+						hits.push_back(RayHit{ m_objects[o], distance });
+				}
+			} else {
+				stack[stackSize++] = node.left;
+				stack[stackSize++] = node.left + 1;
+			}
+		}
+
+		std::sort(hits.begin() + firstHit, hits.end(), [](const RayHit& a, const RayHit& b) { return a.distance < b.distance; });
+	}
+
+}
@@ -0,0 +1,97 @@
+// VR Renderer - Bounding Volume Hierarchy
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/Bounds.h"
+#include "renderer/Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Binary tree of axis-aligned boxes over a set of objects, identified by their index.
+	/// Built top-down with the binned surface area heuristic, then kept valid by refitting the moved objects.
+	/// Refits let the tree quality drift, it is rebuilt once its cost grew past a threshold.
+	class BoundingVolumeHierarchy {
+	public:
+		struct RayHit {
+			uint32_t object;
+			float distance;	// Along the ray to the object box, 0 if the origin is inside
+		};
+
+		/// @brief Builds the tree from scratch.
+		/// @param bounds Bounding box of each object, the objects are identified by their index.
+		void build(const std::vector<AABB>& bounds);
+
+		/// @brief Changes the bounds of an object. The tree is only updated on the next refit.
+		void update(uint32_t object, const AABB& bounds);
+
+		/// @brief Propagates the updated bounds up the tree, then rebuilds it if it degraded too much.
+		/// @return true if the tree was rebuilt.
+		bool refit();
+
+		/// @brief Appends the objects whose box overlaps the frustum.
+		void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects) const;
+
+		/// @brief Appends the objects whose box overlaps the sphere.
+		void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const;
+
+		/// @brief Appends the objects whose box overlaps the box.
+		void queryBox(const AABB& box, std::vector<uint32_t>& objects) const;
+
+		/// @brief Appends the objects whose box is hit by the ray, sorted by distance.
+		/// @param maxDistance Length of the ray, in units of its direction.
+		void queryRay(const Ray& ray, float maxDistance, std::vector<RayHit>& hits) const;
+
+		const std::vector<AABB>& getBounds() const { return m_bounds; }
+		/// @brief Provides the box containing every object, as of the last refit. Empty without objects.
+		AABB getRootBounds() const { return m_nodes.empty() ? AABB{} : m_nodes[0].bounds; }
+		uint32_t getObjectCount() const { return static_cast<uint32_t>(m_bounds.size()); }
+		uint32_t getNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+		/// @brief Provides the surface area heuristic cost of the tree, relative to the one after the last build.
+		float getDegradation() const;
+
+		/// @brief Relative cost above which a refit rebuilds the tree.
+		float rebuildThreshold = 1.5f;
+
+	private:
+		// Children of an internal node are stored next to each other, leaves have no children.
+		// The objects under any node are a contiguous range of m_objects.
+		struct Node {
+			AABB bounds;
+			uint32_t first;	// First object in m_objects
+			uint32_t count;
+			uint32_t left;	// 0 for leaves, the root is never a child
+		};
+
+		void rebuild();
+		void subdivide(uint32_t node, uint32_t depth, const std::vector<glm::vec3>& centroids);
+		void refitNode(uint32_t node);
+
+		// Depth-first traversal, the test classifies a box as outside (0), overlapping (1) or inside (2) the volume.
+		template<typename Test>
+		void queryVolume(const Test& test, std::vector<uint32_t>& objects) const;
+
+	private:
+		static constexpr uint32_t s_MAX_LEAF_SIZE = 4;
+		static constexpr uint32_t s_BIN_COUNT = 12;
+		static constexpr uint32_t s_MAX_DEPTH = 64;
+
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_parents;
+		std::vector<uint32_t> m_objects;	// Objects ordered by leaf
+		std::vector<uint32_t> m_leaves;		// Leaf of each object
+		std::vector<AABB> m_bounds;			// Bounds of each object
+		std::vector<bool> m_dirty;
+
+		float m_areaSum = 0.0f;		// Summed area of the nodes, the tree cost up to a constant factor
+		float m_builtCost = 0.0f;	// Relative cost right after the last build
+	};
+
+}
@@ -0,0 +1,67 @@
+// VR Renderer - Bounding Volumes
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <limits>
+
+namespace vr {
+
+	/// @brief Axis-aligned bounding box.
+	struct AABB {
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+		bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+		glm::vec3 getCenter() const { return 0.5f * (min + max); }
+		glm::vec3 getExtents() const { return 0.5f * (max - min); }
+
+		/// @brief Grows the box to contain a point.
+		void expand(const glm::vec3& point) {
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		/// @brief Grows the box to contain another box.
+		void expand(const AABB& other) {
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		/// @brief Provides the box containing this box once transformed.
+		/// @param matrix Affine transform to apply.
+		AABB transformed(const glm::mat4& matrix) const {
+			// Transform center, and project extents on the transformed axes (Arvo's method).
+			const glm::vec3 center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+			const glm::mat3 absolute(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2])));
+			const glm::vec3 extents = absolute * getExtents();
+
+			return { center - extents, center + extents };
+		}
+
+		/// @brief Provides the area of the box faces, the cost metric of bounding volume hierarchies.
+		float getSurfaceArea() const {
+			const glm::vec3 size = max - min;
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		bool overlaps(const AABB& other) const {
+			return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+		}
+
+		bool contains(const AABB& other) const {
+			return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+		}
+	};
+
+	/// @brief Half-line starting at an origin.
+	struct Ray {
+		glm::vec3 origin;
+		glm::vec3 direction;
+	};
+
+}
@@ -6,18 +6,77 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace vr {
 
-	void DirectionalLight::computeMatrix(const Camera& camera, float size) {
-		
-		glm::mat4 proj = glm::ortho(-size, size, -size, size, 0.1f, 75.0f);
+	void DirectionalLight::computeCascades(const Camera& camera, const AABB& sceneBounds, uint32_t count, float splitLambda, float distance, uint32_t resolution) {
+		cascadeCount = std::clamp(count, s_MIN_CASCADES, s_MAX_CASCADES);
+		splits = glm::vec4(0.0f);
+
+		// Fixed light orientation, so that the texel grid doesn't depend on the camera
+		const glm::vec3 lightDirection = glm::normalize(direction);
+		const glm::vec3 lightUp = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDirection, lightUp);
+
+		// Depth range of the scene along the light, in light space (looking down -z)
+		float sceneMinZ = -std::numeric_limits<float>::max();
+		float sceneMaxZ = -std::numeric_limits<float>::max();
+		if (sceneBounds.isValid()) {
+			sceneMinZ = std::numeric_limits<float>::max();
+			for (uint32_t corner = 0; corner < 8; ++corner) {
+				const glm::vec3 point((corner & 1) ? sceneBounds.max.x : sceneBounds.min.x, (corner & 2) ? sceneBounds.max.y : sceneBounds.min.y, (corner & 4) ? sceneBounds.max.z : sceneBounds.min.z);
+				const float z = glm::vec3(lightRotation * glm::vec4(point, 1.0f)).z;
+				sceneMinZ = std::min(sceneMinZ, z);
+				sceneMaxZ = std::max(sceneMaxZ, z);
+			}
+		}
+
+		// Half diagonal of the frustum section, per unit of view depth
+		const float tanY = std::tan(0.5f * glm::radians(camera.fovy));
+		const float slope2 = tanY * tanY * (1.0f + camera.aspect * camera.aspect);
+
+		const float zNear = camera.zNear;
+		const float zFar = std::clamp(distance, zNear, camera.zFar);
+		const glm::vec3 forward = glm::normalize(camera.forward);
+
+		float splitBegin = zNear;
+		for (uint32_t c = 0; c < cascadeCount; ++c) {
+			// Practical split scheme, logarithmic splits blended with uniform ones
+			const float t = static_cast<float>(c + 1) / cascadeCount;
+			const float logSplit = zNear * std::pow(zFar / zNear, t);
+			const float uniformSplit = zNear + (zFar - zNear) * t;
+			const float splitEnd = splitLambda * logSplit + (1.0f - splitLambda) * uniformSplit;
+			splits[c] = splitEnd;
+
+			// Smallest sphere around the slice, its center is on the view axis
+			const float centerDepth = std::min(0.5f * (splitBegin + splitEnd) * (1.0f + slope2), splitEnd);
+			const float beginOffset = centerDepth - splitBegin;
+			float radius = std::sqrt(beginOffset * beginOffset + splitBegin * splitBegin * slope2);
+			const float endOffset = splitEnd - centerDepth;
+			radius = std::max(radius, std::sqrt(endOffset * endOffset + splitEnd * splitEnd * slope2));
+
+			// Quantize the radius, so that float noise doesn't change the projection
+			radius = std::ceil(radius * 64.0f) / 64.0f;
+
+			// Snap the center to the texel grid in light space
+			const float texelSize = 2.0f * radius / resolution;
+			glm::vec3 center = glm::vec3(lightRotation * glm::vec4(camera.eyePos + centerDepth * forward, 1.0f));
+			center.x = std::floor(center.x / texelSize) * texelSize;
+			center.y = std::floor(center.y / texelSize) * texelSize;
 
-		glm::vec3 targetPos = camera.eyePos + 2.0f * camera.forward;
-		glm::vec3 viewPos = targetPos - 50.0f * glm::normalize(direction);
+			// Depth range from the casters closest to the light to the farthest receivers of the cascade,
+			// quantized outward so that moving objects rarely change it.
+			const float depthStep = 0.5f * radius;
+			const float maxZ = std::ceil(std::max(sceneMaxZ, center.z + radius) / depthStep) * depthStep;
+			const float minZ = std::min(std::floor(std::max(sceneMinZ, center.z - radius) / depthStep) * depthStep, maxZ - depthStep);
 
-		glm::mat4 view = glm::lookAt(viewPos, targetPos, glm::vec3(0.0f, 1.0f, 0.0f));
-		
-		matrix = proj * view;
+			const glm::mat4 projection = glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius, -maxZ, -minZ);
+			matrices[c] = projection * lightRotation;
+			splitBegin = splitEnd;
+		}
 	}
 
-}
\ No newline at end of file
+}
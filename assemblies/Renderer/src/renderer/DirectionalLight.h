@@ -4,19 +4,40 @@
 
 #pragma once
 
+#include "renderer/Bounds.h"
 #include "renderer/Camera.h"
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 namespace vr {
 
 	struct DirectionalLight {
+		static constexpr uint32_t s_MIN_CASCADES = 2;
+		static constexpr uint32_t s_MAX_CASCADES = 4;
+
 		alignas(16) glm::vec3 direction;
 		alignas(16) glm::vec3 color;
 		float power;
-		alignas(16) glm::mat4 matrix;
 
-		void computeMatrix(const Camera& camera, float size = 5.0f);
+		// Shadow cascades, computed by the renderer
+		alignas(16) glm::mat4 matrices[s_MAX_CASCADES];
+		alignas(16) glm::vec4 splits;	// View depth where each cascade ends
+		uint32_t cascadeCount = 0;
+
+		/// @brief Splits the camera frustum in cascades and fits a shadow projection to each one.
+		/// Cascades are bounded by the smallest sphere around their slice of the frustum, so that their size doesn't
+		/// change when the camera turns, and their center is snapped to the shadow texels so that edges don't shimmer.
+		/// @param camera Camera the shadows are seen from.
+		/// @param sceneBounds Bounds of every caster, the depth range of each cascade reaches them.
+		/// @param count Number of cascades, from s_MIN_CASCADES to s_MAX_CASCADES.
+		/// @param splitLambda Blend between uniform (0) and logarithmic (1) split distances.
+		/// @param distance View depth past which there are no shadows, clamped to the camera far plane.
+		/// @param resolution Size of a cascade shadow map, in texels.
+		void computeCascades(const Camera& camera, const AABB& sceneBounds, uint32_t count, float splitLambda, float distance, uint32_t resolution);
 	};
 
-}
\ No newline at end of file
+	static_assert(sizeof(DirectionalLight) == 320, "DirectionalLight must match the std430 layout of the shaders.");
+
+}
@@ -0,0 +1,76 @@
+// VR Renderer - Dynamic Resolution
+// Rodolphe VALICON
+// 2025
+
+#include "DynamicResolution.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace vr {
+
+	// Bounds of the accumulated error, so that a long stall at a scale bound doesn't wind the controller up
+	static constexpr float s_INTEGRAL_LIMIT = 4.0f;
+
+	DynamicResolution::DynamicResolution() {
+		for (uint32_t i = 0; i < m_frameBegin.size(); ++i) {
+			m_frameBegin[i] = gpu::Query(GL_TIMESTAMP);
+			m_frameEnd[i] = gpu::Query(GL_TIMESTAMP);
+		}
+	}
+
+	float DynamicResolution::update() {
+		m_settings.minScale = std::clamp(m_settings.minScale, 0.1f, 1.0f);
+		m_settings.maxScale = std::clamp(m_settings.maxScale, m_settings.minScale, s_MAX_SCALE);
+		if (!m_settings.enabled) {
+			m_integral = 0.0f;
+			m_previousError = 0.0f;
+			m_stats.scale = 1.0f;
+			return m_stats.scale;
+		}
+
+		// Only the frame about to reuse its queries is read, the controller runs once per measured frame
+		gpu::Query& frameEnd = m_frameEnd[m_timerIndex];
+		if (!frameEnd.isAvailable())
+			return m_stats.scale = std::clamp(m_stats.scale, m_settings.minScale, m_settings.maxScale);
+
+		m_stats.gpuFrameTime = (frameEnd.getResult() - m_frameBegin[m_timerIndex].getResult()) / 1e6f;
+
+		// Positive when there is time left
+		const float target = std::max(m_settings.targetFrameTime, 0.1f);
+		const float error = (target - m_stats.gpuFrameTime) / target;
+		const float derivative = error - m_previousError;
+		m_previousError = error;
+
+		if (std::abs(error) < m_settings.deadBand) {
+			m_integral *= 0.9f;
+			return m_stats.scale = std::clamp(m_stats.scale, m_settings.minScale, m_settings.maxScale);
+		}
+
+		m_integral = std::clamp(m_integral + error, -s_INTEGRAL_LIMIT, s_INTEGRAL_LIMIT);
+		const float correction = m_settings.proportional * error + m_settings.integral * m_integral + m_settings.derivative * derivative;
+
+		// GPU time follows the shaded pixels, the correction applies to the area rather than to the sides
+		const float area = m_stats.scale * m_stats.scale * std::clamp(1.0f + correction, 0.5f, 1.5f);
+		m_stats.scale = std::clamp(std::sqrt(area), m_settings.minScale, m_settings.maxScale);
+		return m_stats.scale;
+	}
+
+	void DynamicResolution::begin() {
+		if (!m_settings.enabled) return;
+
+		m_frameBegin[m_timerIndex].timestamp();
+		m_timing = true;
+	}
+
+	void DynamicResolution::end() {
+		if (!m_timing) return;
+
+		m_frameEnd[m_timerIndex].timestamp();
+		m_timerIndex = (m_timerIndex + 1) % static_cast<uint32_t>(m_frameEnd.size());
+		m_timing = false;
+	}
+
+}
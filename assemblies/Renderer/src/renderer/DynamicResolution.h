@@ -0,0 +1,65 @@
+// VR Renderer - Dynamic Resolution
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/Query.h"
+
+#include <array>
+#include <cstdint>
+
+namespace vr {
+
+	/// @brief Scales the render resolution to hold a GPU frame time target.
+	/// Frames are timed with timestamp queries, read a few frames later. A PID controller corrects the pixel
+	/// count from the relative error to the target, errors within a dead band leave the resolution unchanged.
+	class DynamicResolution {
+	public:
+		static constexpr float s_MAX_SCALE = 2.0f;	// Bound of the supersampling scale, per axis
+
+		struct Settings {
+			bool enabled = false;
+			float targetFrameTime = 11.1f;	// GPU time of a frame to hold, in milliseconds
+			float minScale = 0.5f;			// Bounds of the resolution scale, per axis
+			float maxScale = 1.0f;			// Above 1 supersamples, the target is allocated at this scale
+			float deadBand = 0.05f;			// Relative error ignored, so that the resolution settles
+			float proportional = 0.5f;		// Controller gains
+			float integral = 0.05f;
+			float derivative = 0.2f;
+		};
+
+		struct Stats {
+			float gpuFrameTime = 0.0f;	// GPU time of the last measured frame, in milliseconds
+			float scale = 1.0f;			// Current resolution scale, per axis
+		};
+
+		DynamicResolution();
+
+		/// @brief Reads the time of a previous frame and corrects the scale with it.
+		/// @return The resolution scale of the frame, per axis.
+		float update();
+
+		/// @brief Marks the start of the frame commands.
+		void begin();
+
+		/// @brief Marks the end of the frame commands.
+		void end();
+
+		Settings& getSettings() { return m_settings; }
+		const Stats& getStats() const { return m_stats; }
+
+	private:
+		Settings m_settings;
+		Stats m_stats;
+
+		float m_integral = 0.0f;
+		float m_previousError = 0.0f;
+
+		std::array<gpu::Query, 3> m_frameBegin;
+		std::array<gpu::Query, 3> m_frameEnd;
+		uint32_t m_timerIndex = 0;
+		bool m_timing = false;
+	};
+
+}
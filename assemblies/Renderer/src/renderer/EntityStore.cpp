@@ -0,0 +1,130 @@
+// VR Renderer - Entity Store
+// Rodolphe VALICON
+// 2025
+
+#include "EntityStore.h"
+
+#include <atomic>
+#include <type_traits>
+
+namespace vr {
+
+	static std::atomic<uint64_t> s_lastRevision = 0;
+
+	// Resizes the renderables of an entity in every per renderable array, the following ones are shifted
+	static void ResizeRenderables(EntityStore::Layout& layout, uint32_t first, uint32_t oldCount, uint32_t newCount) {
+		auto resize = [&](auto& array) {
+			using Value = typename std::decay_t<decltype(array)>::value_type;
+			if (newCount > oldCount)
+				array.insert(array.begin() + first + oldCount, newCount - oldCount, Value{});
+			else
+				array.erase(array.begin() + first + newCount, array.begin() + first + oldCount);
+		};
+
+		resize(layout.entities);
+		resize(layout.flags);
+		resize(layout.bounds);
+		resize(layout.geometries);
+		resize(layout.materials);
+		resize(layout.occluders);
+		resize(layout.sources);
+	}
+
+	static uint8_t MaskedFlag(const Primitive& primitive) {
+		return primitive.material->renderFlags.alphaCutoff > 0.0f ? EntityStore::AlphaMasked : 0;
+	}
+
+	uint32_t EntityStore::add(const Mesh& mesh) {
+		Layout& layout = editLayout();
+		const uint32_t entity = getCount();
+		m_transforms.push_back(mesh.transform);
+		m_parents.push_back(s_NO_ENTITY);
+		layout.entityFlags.push_back(mesh.isStatic ? Static : 0);
+
+		const uint32_t first = layout.getRenderableCount();
+		const uint32_t count = static_cast<uint32_t>(mesh.primitives.size());
+		ResizeRenderables(layout, first, 0, count);
+		for (uint32_t j = 0; j < count; ++j)
+			writeRenderable(layout, first + j, entity, mesh.primitives[j]);
+		layout.firstRenderables.push_back(first + count);
+
+		return entity;
+	}
+
+	void EntityStore::truncate(uint32_t count) {
+		if (count >= getCount()) return;
+
+		Layout& layout = editLayout();
+		const uint32_t renderableCount = layout.firstRenderables[count];
+		ResizeRenderables(layout, renderableCount, layout.getRenderableCount() - renderableCount, 0);
+		layout.firstRenderables.resize(count + 1);
+		layout.entityFlags.resize(count);
+
+		m_transforms.resize(count);
+		m_parents.resize(count);
+		for (uint32_t& parent : m_parents) {
+			if (parent != s_NO_ENTITY && parent >= count)
+				parent = s_NO_ENTITY;
+		}
+	}
+
+	std::vector<Primitive> EntityStore::setPrimitives(uint32_t entity, const std::vector<Primitive>& primitives) {
+		Layout& layout = editLayout();
+		const uint32_t first = layout.firstRenderables[entity];
+		const uint32_t oldCount = layout.firstRenderables[entity + 1] - first;
+		const uint32_t newCount = static_cast<uint32_t>(primitives.size());
+		std::vector<Primitive> replaced(layout.sources.begin() + first, layout.sources.begin() + first + oldCount);
+
+		ResizeRenderables(layout, first, oldCount, newCount);
+		for (uint32_t j = 0; j < newCount; ++j)
+			writeRenderable(layout, first + j, entity, primitives[j]);
+
+		// Renderables of the following entities moved along
+		for (uint32_t e = entity + 1; e < layout.firstRenderables.size(); ++e)
+			layout.firstRenderables[e] = layout.firstRenderables[e] - oldCount + newCount;
+
+		return replaced;
+	}
+
+	void EntityStore::setGeometry(uint32_t renderable, std::shared_ptr<gpu::VertexArray> vertexArray) {
+		Layout& layout = editLayout();
+		layout.geometries[renderable] = vertexArray.get();
+		layout.sources[renderable].vertexArray = std::move(vertexArray);
+	}
+
+	void EntityStore::setMaterial(uint32_t renderable, std::shared_ptr<MaterialInstance> material) {
+		Layout& layout = editLayout();
+		layout.materials[renderable] = material.get();
+		layout.sources[renderable].material = std::move(material);
+		layout.flags[renderable] = static_cast<uint8_t>((layout.flags[renderable] & ~AlphaMasked) | MaskedFlag(layout.sources[renderable]));
+	}
+
+	void EntityStore::setStatic(uint32_t entity, bool isStatic) {
+		if (this->isStatic(entity) == isStatic) return;
+
+		Layout& layout = editLayout();
+		layout.entityFlags[entity] ^= Static;
+		for (uint32_t r = layout.firstRenderables[entity]; r < layout.firstRenderables[entity + 1]; ++r)
+			layout.flags[r] ^= Static;
+	}
+
+	EntityStore::Layout& EntityStore::editLayout() {
+		// Snapshots are captured by this thread, a layout it holds alone can't be shared behind its back
+		if (m_layout.use_count() > 1)
+			m_layout = std::make_shared<Layout>(*m_layout);
+
+		m_layout->revision = ++s_lastRevision;
+		return *m_layout;
+	}
+
+	void EntityStore::writeRenderable(Layout& layout, uint32_t renderable, uint32_t entity, const Primitive& primitive) {
+		layout.entities[renderable] = entity;
+		layout.flags[renderable] = static_cast<uint8_t>((layout.entityFlags[entity] & Static) | MaskedFlag(primitive));
+		layout.bounds[renderable] = primitive.bounds;
+		layout.geometries[renderable] = primitive.vertexArray.get();
+		layout.materials[renderable] = primitive.material.get();
+		layout.occluders[renderable] = primitive.occluder.get();
+		layout.sources[renderable] = primitive;
+	}
+
+}
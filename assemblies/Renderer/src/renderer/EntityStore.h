@@ -0,0 +1,97 @@
+// VR Renderer - Entity Store
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/Mesh.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Packed storage of the objects of a scene, the source of truth of their transforms, bounds, geometries,
+	/// materials and flags. An entity is a mesh placed in the scene, each of its primitives becomes a renderable.
+	/// Transforms and parents are stored per entity and edited in place by the update thread. Renderables are stored
+	/// as structure of arrays, in entity order, in a layout shared with the render thread: it is copied on the first
+	/// edit made while a snapshot still holds it, and every edit gives it a new revision.
+	class EntityStore {
+	public:
+		static constexpr uint32_t s_NO_ENTITY = 0xFFFFFFFF;
+
+		enum Flags : uint8_t {
+			Static = 1 << 0,		// Expected to rarely move, shadows are cached
+			AlphaMasked = 1 << 1,	// Needs the albedo alpha in depth passes
+		};
+
+		/// @brief Entities and their renderables, everything but the transforms.
+		struct Layout {
+			uint64_t revision = 0;	// Unique to each edit, across every store
+
+			// Per entity
+			std::vector<uint32_t> firstRenderables;	// Renderables of entity e are [firstRenderables[e], firstRenderables[e + 1])
+			std::vector<uint8_t> entityFlags;
+
+			// Per renderable
+			std::vector<uint32_t> entities;
+			std::vector<uint8_t> flags;				// Flags of the entity, and the masking of the material
+			std::vector<AABB> bounds;				// In entity space
+			std::vector<gpu::VertexArray*> geometries;
+			std::vector<MaterialInstance*> materials;
+			std::vector<const OccluderGeometry*> occluders;
+			std::vector<Primitive> sources;			// Owners of the handles above, only read when editing
+
+			Layout() : firstRenderables{ 0 } {}
+
+			uint32_t getEntityCount() const { return static_cast<uint32_t>(entityFlags.size()); }
+			uint32_t getRenderableCount() const { return static_cast<uint32_t>(entities.size()); }
+		};
+
+	public:
+		/// @brief Adds an entity placing a mesh, with its transform and static flag. Primitives are shared with the mesh.
+		/// @return Index of the entity.
+		uint32_t add(const Mesh& mesh);
+
+		/// @brief Removes the entities added after the first ones, parents among them are detached.
+		void truncate(uint32_t count);
+
+		/// @brief Replaces the primitives of an entity.
+		/// @return The replaced primitives, their GL objects may have to be released by the render thread.
+		std::vector<Primitive> setPrimitives(uint32_t entity, const std::vector<Primitive>& primitives);
+
+		void setGeometry(uint32_t renderable, std::shared_ptr<gpu::VertexArray> vertexArray);
+		void setMaterial(uint32_t renderable, std::shared_ptr<MaterialInstance> material);
+		void setStatic(uint32_t entity, bool isStatic);
+
+		/// @brief Makes the transform of an entity relative to a parent entity, or detaches it with s_NO_ENTITY.
+		void setParent(uint32_t entity, uint32_t parent) { m_parents[entity] = parent; }
+
+		uint32_t getCount() const { return static_cast<uint32_t>(m_transforms.size()); }
+		Transform& getTransform(uint32_t entity) { return m_transforms[entity]; }
+		const Transform& getTransform(uint32_t entity) const { return m_transforms[entity]; }
+		uint32_t getParent(uint32_t entity) const { return m_parents[entity]; }
+		bool isStatic(uint32_t entity) const { return (m_layout->entityFlags[entity] & Static) != 0; }
+
+		uint32_t getFirstRenderable(uint32_t entity) const { return m_layout->firstRenderables[entity]; }
+		uint32_t getRenderableCount(uint32_t entity) const { return m_layout->firstRenderables[entity + 1] - m_layout->firstRenderables[entity]; }
+		const Primitive& getPrimitive(uint32_t renderable) const { return m_layout->sources[renderable]; }
+
+		const std::vector<Transform>& getTransforms() const { return m_transforms; }
+		const std::vector<uint32_t>& getParents() const { return m_parents; }
+		std::shared_ptr<const Layout> getLayout() const { return m_layout; }
+
+	private:
+		/// @brief Provides the layout for an edit, copied if a snapshot holds it, with a new revision.
+		Layout& editLayout();
+
+		void writeRenderable(Layout& layout, uint32_t renderable, uint32_t entity, const Primitive& primitive);
+
+	private:
+		std::vector<Transform> m_transforms;
+		std::vector<uint32_t> m_parents;
+		std::shared_ptr<Layout> m_layout = std::make_shared<Layout>();
+	};
+
+}
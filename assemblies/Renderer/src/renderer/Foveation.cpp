@@ -0,0 +1,147 @@
+// VR Renderer - Foveation
+// Rodolphe VALICON
+// 2025
+
+#include "Foveation.h"
+#include "gpu/StateCache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace vr {
+
+	static constexpr uint32_t s_RESOLVE_GROUP_SIZE = 8;
+
+	Foveation::Foveation()
+		: m_resolveShader("res/shaders/renderpasses/foveatedResolve.glsl"),
+		m_resolveLayeredShader("res/shaders/renderpasses/foveatedResolve.glsl", { "LAYERED" }) {
+		const gpu::ShaderProgram* shaders[] = { &m_resolveShader, &m_resolveLayeredShader };
+		for (uint32_t i = 0; i < m_uniforms.size(); ++i) {
+			m_uniforms[i] = ResolveUniforms{
+				.centerRect = shaders[i]->getUniform<glm::vec4>("uCenterRect"),
+				.peripheryRect = shaders[i]->getUniform<glm::vec4>("uPeripheryRect"),
+				.texelSize = shaders[i]->getUniform<glm::vec2>("uTexelSize"),
+				.centerSize = shaders[i]->getUniform<float>("uCenterSize"),
+				.blendWidth = shaders[i]->getUniform<float>("uBlendWidth"),
+				.layer = shaders[i]->getUniform<int32_t>("uLayer"),
+				.destination = shaders[i]->getUniform<glm::ivec4>("uDestination"),
+			};
+		}
+		for (uint32_t region = 0; region < s_REGION_COUNT; ++region) {
+			m_regions[region] = glm::ivec4(0);
+			m_regionTransforms[region] = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+		}
+	}
+
+	void Foveation::prepare(const RenderTarget& eyeTarget) {
+		m_settings.centerSize = std::clamp(m_settings.centerSize, 0.1f, 1.0f);
+		m_settings.peripheryScale = std::clamp(m_settings.peripheryScale, 0.1f, 1.0f);
+		m_settings.blendWidth = std::clamp(m_settings.blendWidth, 0.0f, 0.5f);
+
+		const glm::ivec2 viewSize(eyeTarget.getNominalWidth(), eyeTarget.getNominalHeight());
+		const bool layoutChanged = m_settings.centerSize != m_layoutSettings.centerSize ||
+			m_settings.peripheryScale != m_layoutSettings.peripheryScale ||
+			m_settings.blendWidth != m_layoutSettings.blendWidth;
+
+		if (m_target && !layoutChanged && viewSize == m_viewSize &&
+			m_target->getSamples() == eyeTarget.getSamples() && m_target->getLayers() == eyeTarget.getLayers())
+			return;
+
+		m_layoutSettings = m_settings;
+		m_viewSize = viewSize;
+
+		// Center and periphery side by side
+		const glm::ivec2 centerSize = glm::max(glm::ivec2(glm::round(glm::vec2(viewSize) * m_settings.centerSize)), glm::ivec2(1));
+		const glm::ivec2 peripherySize = glm::max(glm::ivec2(glm::round(glm::vec2(viewSize) * m_settings.peripheryScale)), glm::ivec2(1));
+		m_regions[0] = glm::ivec4(0, 0, centerSize);
+		m_regions[1] = glm::ivec4(centerSize.x, 0, peripherySize);
+
+		// The center covers a part of the view, scaled up to fill its viewport
+		m_regionTransforms[0] = glm::vec4(glm::vec2(1.0f / m_settings.centerSize), 0.0f, 0.0f);
+		m_regionTransforms[1] = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+		// Periphery texels under the center, short of the blended edge and of a bilinear tap
+		const float maskExtent = m_settings.centerSize * (1.0f - m_settings.blendWidth);
+		const glm::vec2 maskMin = glm::ceil(glm::vec2(peripherySize) * (1.0f - maskExtent) * 0.5f) + 1.0f;
+		const glm::vec2 maskMax = glm::floor(glm::vec2(peripherySize) * (1.0f + maskExtent) * 0.5f) - 1.0f;
+		const glm::ivec2 maskSize = glm::max(glm::ivec2(maskMax - maskMin), glm::ivec2(0));
+		m_mask = glm::ivec4(m_regions[1].x + static_cast<int32_t>(maskMin.x), static_cast<int32_t>(maskMin.y), maskSize);
+
+		const float viewArea = static_cast<float>(viewSize.x) * viewSize.y;
+		m_shadedRatio = (static_cast<float>(centerSize.x) * centerSize.y + static_cast<float>(peripherySize.x) * peripherySize.y -
+			static_cast<float>(maskSize.x) * maskSize.y) / viewArea;
+
+		const int32_t width = centerSize.x + peripherySize.x;
+		const int32_t height = std::max(centerSize.y, peripherySize.y);
+		m_target = std::make_unique<RenderTarget>(width, height, eyeTarget.getSamples(), eyeTarget.getLayers());
+		m_resolveTarget = eyeTarget.getSamples() > 1 ? std::make_unique<RenderTarget>(width, height, 1, eyeTarget.getLayers()) : nullptr;
+	}
+
+	void Foveation::clear() const {
+		glBindFramebuffer(GL_FRAMEBUFFER, m_target->getFramebuffer());
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClearDepth(1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		// Nothing passes the depth test where the center is drawn
+		if (m_mask.z > 0 && m_mask.w > 0) {
+			gpu::StateCache& state = gpu::StateCache::getInstance();
+			state.enable(GL_SCISSOR_TEST);
+			glScissor(m_mask.x, m_mask.y, m_mask.z, m_mask.w);
+			glClearDepth(0.0f);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			glClearDepth(1.0f);
+			state.disable(GL_SCISSOR_TEST);
+		}
+	}
+
+	void Foveation::bindViewports() const {
+		for (uint32_t region = 0; region < s_REGION_COUNT; ++region) {
+			const glm::vec4 viewport(m_regions[region]);
+			glViewportIndexedf(region, viewport.x, viewport.y, viewport.z, viewport.w);
+		}
+	}
+
+	void Foveation::resolve(const gpu::Texture& destination, int32_t width, int32_t height, uint32_t viewCount) {
+		// Multisampled layers are resolved one at a time, layered blits only read the first one
+		const int32_t layers = m_target->getLayers();
+		if (m_resolveTarget) {
+			for (int32_t layer = 0; layer < layers; ++layer) {
+				glBlitNamedFramebuffer(
+					m_target->getLayerFramebuffer(layer), m_resolveTarget->getLayerFramebuffer(layer),
+					0, 0, m_target->getWidth(), m_target->getHeight(), 0, 0, m_target->getWidth(), m_target->getHeight(),
+					GL_COLOR_BUFFER_BIT, GL_NEAREST
+				);
+			}
+		}
+
+		const RenderTarget& source = m_resolveTarget ? *m_resolveTarget : *m_target;
+		const gpu::ShaderProgram& shader = layers > 1 ? m_resolveLayeredShader : m_resolveShader;
+		const ResolveUniforms& uniforms = m_uniforms[layers > 1];
+		const glm::vec2 size(source.getWidth(), source.getHeight());
+		auto uvRect = [&](const glm::ivec4& region) {
+			return glm::vec4(glm::vec2(region.x, region.y) / size, glm::vec2(region.z, region.w) / size);
+		};
+
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.useProgram(shader);
+		uniforms.centerRect.set(uvRect(m_regions[0]));
+		uniforms.peripheryRect.set(uvRect(m_regions[1]));
+		uniforms.texelSize.set(1.0f / size);
+		uniforms.centerSize.set(m_layoutSettings.centerSize);
+		uniforms.blendWidth.set(m_layoutSettings.blendWidth);
+		state.bindTextureUnit(0, *source.getColorTexture());
+		glBindImageTexture(1, destination, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+		// Views side by side, like the resolve of a stereo target
+		const int32_t viewWidth = width / static_cast<int32_t>(viewCount);
+		for (int32_t view = 0; view < static_cast<int32_t>(viewCount); ++view) {
+			uniforms.layer.set(view);
+			uniforms.destination.set(glm::ivec4(view * viewWidth, 0, viewWidth, height));
+			glDispatchCompute((viewWidth + s_RESOLVE_GROUP_SIZE - 1) / s_RESOLVE_GROUP_SIZE, (height + s_RESOLVE_GROUP_SIZE - 1) / s_RESOLVE_GROUP_SIZE, 1);
+		}
+	}
+
+}
\ No newline at end of file
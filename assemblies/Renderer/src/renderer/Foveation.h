@@ -0,0 +1,84 @@
+// VR Renderer - Foveation
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/ShaderProgram.h"
+#include "renderer/RenderTarget.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace vr {
+
+	/// @brief Fixed foveated rendering, the lens compresses the periphery of the eye buffers so it is shaded at a lower rate.
+	/// Each view is drawn once per region in the same pass, into the viewports of a packed target: a full resolution
+	/// center, and the whole view at a lower resolution. The center of the periphery is masked with a depth cleared to 0,
+	/// so that it isn't shaded twice. The resolve upscales the periphery and composites the center over it.
+	class Foveation {
+	public:
+		static constexpr uint32_t s_REGION_COUNT = 2;
+
+		struct Settings {
+			bool enabled = false;
+			float centerSize = 0.6f;		// Share of the view width and height rendered at full resolution
+			float peripheryScale = 0.5f;	// Resolution scale of the periphery
+			float blendWidth = 0.1f;		// Share of the center blended with the periphery near its edge
+		};
+
+		Foveation();
+
+		/// @brief Sizes the packed target for the eye buffers of a target, it is only recreated when the layout changes.
+		void prepare(const RenderTarget& eyeTarget);
+
+		/// @brief Clears the packed target and masks the center of the periphery region.
+		void clear() const;
+
+		/// @brief Sets the viewport of every region, indexed by region.
+		void bindViewports() const;
+
+		/// @brief Upscales the regions of every view into a single sample RGBA16F texture, views side by side.
+		/// The texture is written with image stores, readers wait on them.
+		void resolve(const gpu::Texture& destination, int32_t width, int32_t height, uint32_t viewCount);
+
+		/// @brief Clip space scale (xy) and offset (zw) moving a region to its viewport.
+		glm::vec4 getRegionTransform(uint32_t region) const { return m_regionTransforms[region]; }
+
+		/// @brief Provides the shaded pixels of a view relative to a full resolution view.
+		float getShadedRatio() const { return m_shadedRatio; }
+
+		Settings& getSettings() { return m_settings; }
+		const RenderTarget& getTarget() const { return *m_target; }
+
+	private:
+		Settings m_settings;
+		Settings m_layoutSettings;	// Settings the packed target was laid out with
+		std::unique_ptr<RenderTarget> m_target;
+		std::unique_ptr<RenderTarget> m_resolveTarget;	// Single sample copy of a multisampled packed target
+		glm::ivec2 m_viewSize{ 0 };
+
+		glm::ivec4 m_regions[s_REGION_COUNT];	// Viewport of each region, center first
+		glm::vec4 m_regionTransforms[s_REGION_COUNT];
+		glm::ivec4 m_mask{ 0 };					// Periphery rectangle covered by the center
+		float m_shadedRatio = 1.0f;
+
+		struct ResolveUniforms {
+			gpu::UniformHandle<glm::vec4> centerRect;
+			gpu::UniformHandle<glm::vec4> peripheryRect;
+			gpu::UniformHandle<glm::vec2> texelSize;
+			gpu::UniformHandle<float> centerSize;
+			gpu::UniformHandle<float> blendWidth;
+			gpu::UniformHandle<int32_t> layer;
+			gpu::UniformHandle<glm::ivec4> destination;
+		};
+
+		gpu::ShaderProgram m_resolveShader;
+		gpu::ShaderProgram m_resolveLayeredShader;
+		std::array<ResolveUniforms, 2> m_uniforms;	// Single, then layered
+	};
+
+}
\ No newline at end of file
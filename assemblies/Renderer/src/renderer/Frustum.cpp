@@ -0,0 +1,47 @@
+// VR Renderer - Frustum
+// Rodolphe VALICON
+// 2025
+
+#include "Frustum.h"
+
+namespace vr {
+
+	Frustum::Frustum(const glm::mat4& viewProjection) {
+		// Gribb-Hartmann plane extraction, on the rows of the matrix.
+		const glm::mat4 m = glm::transpose(viewProjection);
+		m_planes[0] = m[3] + m[0]; // Left
+		m_planes[1] = m[3] - m[0]; // Right
+		m_planes[2] = m[3] + m[1]; // Bottom
+		m_planes[3] = m[3] - m[1]; // Top
+		m_planes[4] = m[3] + m[2]; // Near
+		m_planes[5] = m[3] - m[2]; // Far
+
+		for (glm::vec4& plane : m_planes)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	bool Frustum::intersects(const AABB& box) const {
+		for (const glm::vec4& plane : m_planes) {
+			// Test the box corner the furthest along the plane normal.
+			const glm::vec3 normal(plane);
+			const glm::vec3 positive = glm::mix(box.min, box.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+			if (glm::dot(normal, positive) + plane.w < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Frustum::contains(const AABB& box) const {
+		for (const glm::vec4& plane : m_planes) {
+			// Test the box corner the furthest against the plane normal.
+			const glm::vec3 normal(plane);
+			const glm::vec3 negative = glm::mix(box.max, box.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+			if (glm::dot(normal, negative) + plane.w < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,39 @@
+// VR Renderer - Frustum
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/Bounds.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace vr {
+
+	/// @brief Convex volume bounded by the six clip planes of a view-projection matrix.
+	class Frustum {
+	public:
+		Frustum() = default;
+
+		/// @brief Extracts the frustum planes of a view-projection matrix.
+		/// @param viewProjection Matrix transforming world space to OpenGL clip space.
+		Frustum(const glm::mat4& viewProjection);
+
+		/// @brief Conservatively tests whether a box overlaps the frustum.
+		/// @return false only if the box is fully outside of the frustum.
+		bool intersects(const AABB& box) const;
+
+		/// @brief Tests whether a box is fully inside the frustum.
+		bool contains(const AABB& box) const;
+
+		/// @brief Provides the planes as (normal, distance), with normals pointing inside the frustum.
+		const std::array<glm::vec4, 6>& getPlanes() const { return m_planes; }
+
+	private:
+		// Planes as (normal, distance), with normals pointing inside the frustum.
+		std::array<glm::vec4, 6> m_planes;
+	};
+
+}
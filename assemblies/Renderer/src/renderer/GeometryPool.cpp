@@ -0,0 +1,59 @@
+// VR Renderer - Geometry Pool
+// Rodolphe VALICON
+// 2025
+
+#include "GeometryPool.h"
+
+namespace vr {
+
+	void GeometryPool::build(const std::vector<gpu::VertexArray*>& sources) {
+		struct PageLayout {
+			const gpu::VertexLayout* layout;
+			GLenum topology;
+			uint32_t vertexCount;
+			uint32_t elementCount;
+		};
+
+		m_pages.clear();
+		m_allocations.clear();
+		m_memorySize = 0;
+
+		// Place every source at the end of the page of its vertex format
+		std::vector<PageLayout> pageLayouts;
+		std::vector<gpu::VertexArray*> uniqueSources;
+		for (gpu::VertexArray* source : sources) {
+			if (m_allocations.contains(source)) continue;
+
+			uint32_t page = 0;
+			while (page < pageLayouts.size() && !(pageLayouts[page].topology == source->getTopology() && *pageLayouts[page].layout == source->getLayout()))
+				++page;
+
+			if (page == pageLayouts.size())
+				pageLayouts.push_back(PageLayout{ &source->getLayout(), source->getTopology(), 0, 0 });
+
+			PageLayout& pageLayout = pageLayouts[page];
+			m_allocations[source] = Allocation{ page, pageLayout.elementCount, static_cast<int32_t>(pageLayout.vertexCount), source->getElementCount() };
+			pageLayout.vertexCount += source->getVertexCount();
+			pageLayout.elementCount += source->getElementCount();
+			uniqueSources.push_back(source);
+		}
+
+		// Allocate the pages and copy the sources in place
+		for (const PageLayout& pageLayout : pageLayouts) {
+			m_pages.push_back(std::make_unique<gpu::VertexArray>(*pageLayout.layout, pageLayout.topology, pageLayout.vertexCount, pageLayout.elementCount));
+			m_memorySize += static_cast<size_t>(pageLayout.vertexCount) * pageLayout.layout->getStride() + pageLayout.elementCount * sizeof(uint32_t);
+		}
+
+		for (gpu::VertexArray* source : uniqueSources) {
+			const Allocation& allocation = m_allocations[source];
+			const gpu::VertexArray& page = *m_pages[allocation.page];
+			const GLsizei stride = source->getLayout().getStride();
+
+			glCopyNamedBufferSubData(source->getVertexBuffer(), page.getVertexBuffer(), 0,
+				static_cast<GLintptr>(allocation.baseVertex) * stride, static_cast<GLsizeiptr>(source->getVertexCount()) * stride);
+			glCopyNamedBufferSubData(source->getElementBuffer(), page.getElementBuffer(), 0,
+				static_cast<GLintptr>(allocation.firstIndex) * sizeof(uint32_t), static_cast<GLsizeiptr>(source->getElementCount()) * sizeof(uint32_t));
+		}
+	}
+
+}
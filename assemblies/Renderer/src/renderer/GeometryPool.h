@@ -0,0 +1,49 @@
+// VR Renderer - Geometry Pool
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/VertexArray.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Vertices and indices of many vertex arrays merged into a few shared pages, one per vertex format.
+	/// Primitives of the same page can be drawn by a single multi-draw call, with their own first index and base vertex.
+	/// Data is copied on the GPU, the source vertex arrays are left untouched.
+	class GeometryPool {
+	public:
+		struct Allocation {
+			uint32_t page;
+			uint32_t firstIndex;
+			int32_t baseVertex;
+			uint32_t elementCount;
+		};
+
+		/// @brief Merges vertex arrays in pages, replacing the previous content. Shared sources are only copied once.
+		/// @param sources Vertex arrays to merge, they must outlive the following getAllocation calls.
+		void build(const std::vector<gpu::VertexArray*>& sources);
+
+		/// @brief Provides where a source vertex array was copied.
+		const Allocation& getAllocation(const gpu::VertexArray* source) const { return m_allocations.at(source); }
+
+		gpu::VertexArray& getPage(uint32_t page) const { return *m_pages[page]; }
+		uint32_t getPageCount() const { return static_cast<uint32_t>(m_pages.size()); }
+
+		/// @brief Provides the GPU memory used by the pages, in bytes.
+		size_t getMemorySize() const { return m_memorySize; }
+
+	private:
+		std::vector<std::unique_ptr<gpu::VertexArray>> m_pages;
+		std::unordered_map<const gpu::VertexArray*, Allocation> m_allocations;
+		size_t m_memorySize = 0;
+	};
+
+}
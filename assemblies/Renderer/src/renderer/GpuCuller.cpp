@@ -0,0 +1,231 @@
+// VR Renderer - GPU Culler
+// Rodolphe VALICON
+// 2025
+
+#include "GpuCuller.h"
+#include "gpu/StateCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace vr {
+
+	static constexpr uint32_t s_CULL_GROUP_SIZE = 64;
+	static constexpr uint32_t s_PYRAMID_GROUP_SIZE = 8;
+	static constexpr uint32_t s_COMMAND_SIZE = 5;	// Draw elements indirect command, in 32 bit words
+
+	GpuCuller::GpuCuller()
+		: m_cullShader("res/shaders/renderpasses/gpuCulling.glsl"),
+		m_pyramidShader("res/shaders/renderpasses/depthPyramid.glsl") {
+		m_cullUniforms = CullUniforms{
+			.frustumPlanes = m_cullShader.getUniform<glm::vec4>("uFrustumPlanes"),
+			.pyramidViewProjection = m_cullShader.getUniform<glm::mat4>("uPyramidViewProjection"),
+			.pyramidSize = m_cullShader.getUniform<glm::ivec2>("uPyramidSize"),
+			.pyramidLevels = m_cullShader.getUniform<int32_t>("uPyramidLevels"),
+			.occlusion = m_cullShader.getUniform<int32_t>("uOcclusion"),
+			.compact = m_cullShader.getUniform<int32_t>("uCompact"),
+			.instanceCount = m_cullShader.getUniform<uint32_t>("uInstanceCount"),
+			.instanceViews = m_cullShader.getUniform<uint32_t>("uInstanceViews"),
+			.commandBase = m_cullShader.getUniform<uint32_t>("uCommandBase"),
+		};
+		m_pyramidUniforms = PyramidUniforms{
+			.sampleCount = m_pyramidShader.getUniform<int32_t>("uSampleCount"),
+			.depthSize = m_pyramidShader.getUniform<glm::ivec2>("uDepthSize"),
+			.level = m_pyramidShader.getUniform<int32_t>("uLevel"),
+		};
+
+		// Draw counts are read on the GPU since OpenGL 4.6, otherwise every command is drawn and culled ones have no instance.
+		m_compact = glMultiDrawElementsIndirectCount != nullptr;
+	}
+
+	void GpuCuller::sync(const RenderableStore& store) {
+		if (store.getRevision() == m_storeRevision) return;
+		m_storeRevision = store.getRevision();
+
+		// Merge the geometry of every renderable
+		std::vector<gpu::VertexArray*> sources;
+		sources.reserve(store.getCount());
+		for (const RenderableStore::Archetype& archetype : store.getArchetypes())
+			sources.insert(sources.end(), archetype.geometries.begin(), archetype.geometries.end());
+
+		m_geometry.build(sources);
+
+		// Group renderables sharing a material and a page, keeping the material order of the store
+		std::vector<Instance> instances;
+		instances.reserve(store.getCount());
+		m_batches.clear();
+
+		std::vector<uint32_t> order;
+		for (uint32_t a = 0; a < RenderableStore::s_ARCHETYPE_COUNT; ++a) {
+			const RenderableStore::Archetype& archetype = store.getArchetypes()[a];
+			order.resize(archetype.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) {
+				if (archetype.materials[l] != archetype.materials[r])
+					return archetype.materials[l] < archetype.materials[r];
+				return m_geometry.getAllocation(archetype.geometries[l]).page < m_geometry.getAllocation(archetype.geometries[r]).page;
+			});
+
+			for (uint32_t r : order) {
+				const GeometryPool::Allocation& allocation = m_geometry.getAllocation(archetype.geometries[r]);
+				if (m_batches.empty() || m_batches.back().archetype != a || m_batches.back().material != archetype.materials[r] || m_batches.back().page != allocation.page) {
+					m_batches.push_back(Batch{ a, archetype.materials[r], allocation.page, static_cast<uint32_t>(instances.size()), 0 });
+				}
+
+				Batch& batch = m_batches.back();
+				instances.push_back(Instance{
+					.primitive = archetype.primitives[r],
+					.object = archetype.first + r,
+					.elementCount = allocation.elementCount,
+					.firstIndex = allocation.firstIndex,
+					.baseVertex = allocation.baseVertex,
+					.batch = static_cast<uint32_t>(m_batches.size() - 1),
+					.batchFirst = batch.firstCommand,
+					.slot = static_cast<uint32_t>(instances.size()),
+				});
+				++batch.commandCount;
+			}
+		}
+
+		m_instanceCount = static_cast<uint32_t>(instances.size());
+		m_instances = gpu::Buffer(instances.size() * sizeof(Instance), GL_STATIC_DRAW, reinterpret_cast<const uint8_t*>(instances.data()));
+		m_drawBuffer = gpu::Buffer((m_batches.size() + instances.size() * s_COMMAND_SIZE) * sizeof(uint32_t), GL_DYNAMIC_COPY);
+
+		// Pending readbacks have the old batch layout
+		for (Readback& readback : m_readbacks) {
+			if (readback.fence)
+				glDeleteSync(readback.fence);
+			readback.fence = nullptr;
+			readback.buffer = gpu::Buffer(std::max<size_t>(m_batches.size(), 1) * sizeof(uint32_t), GL_STREAM_READ);
+		}
+
+		m_stats.instances = m_instanceCount;
+		m_stats.visible = 0;
+		m_stats.geometryMemory = m_geometry.getMemorySize();
+	}
+
+	void GpuCuller::cull(const Frustum& frustum, bool occlusion, uint32_t instanceViews) {
+		if (m_instanceCount == 0) return;
+
+		const GLsizeiptr countsSize = m_batches.size() * sizeof(uint32_t);
+		glClearNamedBufferSubData(m_drawBuffer, GL_R32UI, 0, countsSize, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.useProgram(m_cullShader);
+		const std::array<glm::vec4, 6>& planes = frustum.getPlanes();
+		m_cullUniforms.frustumPlanes.set(planes.data(), static_cast<GLsizei>(planes.size()));
+		m_cullUniforms.pyramidViewProjection.set(m_pyramidViewProjection);
+		m_cullUniforms.pyramidSize.set(m_pyramidSize);
+		m_cullUniforms.pyramidLevels.set(m_pyramidLevels);
+		m_cullUniforms.occlusion.set(occlusion && m_pyramidValid);
+		m_cullUniforms.compact.set(m_compact);
+		m_cullUniforms.instanceCount.set(m_instanceCount);
+		m_cullUniforms.instanceViews.set(instanceViews);
+		m_cullUniforms.commandBase.set(static_cast<uint32_t>(m_batches.size()));
+
+		state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_instances);
+		state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, m_drawBuffer);
+		if (m_pyramidValid)
+			state.bindTextureUnit(0, *m_pyramid);
+
+		glDispatchCompute((m_instanceCount + s_CULL_GROUP_SIZE - 1) / s_CULL_GROUP_SIZE, 1, 1);
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		readStatistics();
+	}
+
+	void GpuCuller::buildDepthPyramid(const RenderTarget& target, const glm::mat4& viewProjection) {
+		// Power of two sizes, so that each level texel covers exactly 2x2 texels of the level below. The pyramid
+		// is sized by the whole target and covers its viewport, it is kept when the resolution scale changes.
+		const glm::ivec2 size(std::bit_floor(static_cast<uint32_t>(target.getWidth())), std::bit_floor(static_cast<uint32_t>(target.getHeight())));
+		if (!m_pyramid || size != m_pyramidSize) {
+			gpu::Sampler sampler;
+			sampler.minFilter = GL_NEAREST_MIPMAP_NEAREST;
+			sampler.magFilter = GL_NEAREST;
+			sampler.wrapS = GL_CLAMP_TO_EDGE;
+			sampler.wrapT = GL_CLAMP_TO_EDGE;
+
+			m_pyramidSize = size;
+			m_pyramidLevels = static_cast<int32_t>(std::bit_width(static_cast<uint32_t>(std::max(size.x, size.y))));
+			m_pyramid = std::make_unique<gpu::Texture>(GL_TEXTURE_2D, sampler);
+			glTextureStorage2D(*m_pyramid, m_pyramidLevels, GL_R32F, size.x, size.y);
+		}
+
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.useProgram(m_pyramidShader);
+		const bool multisampled = target.getSamples() > 1;
+		state.bindTextureUnit(multisampled ? 0 : 1, *target.getDepthStencilTexture());
+		m_pyramidUniforms.sampleCount.set(multisampled ? target.getSamples() : 0);
+		m_pyramidUniforms.depthSize.set(glm::ivec2(target.getViewportWidth(), target.getViewportHeight()));
+
+		for (int32_t level = 0; level < m_pyramidLevels; ++level) {
+			const glm::ivec2 levelSize = glm::max(size >> level, glm::ivec2(1));
+			m_pyramidUniforms.level.set(level);
+			if (level > 0)
+				glBindImageTexture(1, *m_pyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(0, *m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+			glDispatchCompute((levelSize.x + s_PYRAMID_GROUP_SIZE - 1) / s_PYRAMID_GROUP_SIZE, (levelSize.y + s_PYRAMID_GROUP_SIZE - 1) / s_PYRAMID_GROUP_SIZE, 1);
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		}
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		m_pyramidViewProjection = viewProjection;
+		m_pyramidValid = true;
+	}
+
+	void GpuCuller::draw(uint32_t batch) const {
+		const Batch& drawBatch = m_batches[batch];
+		if (drawBatch.commandCount == 0) return;
+
+		gpu::VertexArray& page = m_geometry.getPage(drawBatch.page);
+		const uintptr_t commandOffset = (m_batches.size() + static_cast<size_t>(drawBatch.firstCommand) * s_COMMAND_SIZE) * sizeof(uint32_t);
+
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.bindVertexArray(page);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_drawBuffer);
+		if (m_compact) {
+			glBindBuffer(GL_PARAMETER_BUFFER, m_drawBuffer);
+			glMultiDrawElementsIndirectCount(page.getTopology(), GL_UNSIGNED_INT, reinterpret_cast<const void*>(commandOffset),
+				static_cast<GLintptr>(batch) * sizeof(uint32_t), drawBatch.commandCount, 0);
+		} else {
+			glMultiDrawElementsIndirect(page.getTopology(), GL_UNSIGNED_INT, reinterpret_cast<const void*>(commandOffset), drawBatch.commandCount, 0);
+		}
+	}
+
+	uint32_t GpuCuller::readCommands(uint32_t batch, std::vector<DrawCommand>& commands) const {
+		static_assert(sizeof(DrawCommand) == s_COMMAND_SIZE * sizeof(uint32_t));
+		const Batch& readBatch = m_batches[batch];
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		uint32_t count = 0;
+		glGetNamedBufferSubData(m_drawBuffer, static_cast<GLintptr>(batch) * sizeof(uint32_t), sizeof(uint32_t), &count);
+
+		commands.resize(readBatch.commandCount);
+		const GLintptr commandOffset = (m_batches.size() + static_cast<size_t>(readBatch.firstCommand) * s_COMMAND_SIZE) * sizeof(uint32_t);
+		glGetNamedBufferSubData(m_drawBuffer, commandOffset, commands.size() * sizeof(DrawCommand), commands.data());
+		return count;
+	}
+
+	void GpuCuller::readStatistics() {
+		// Read the draw counts of an older frame once the GPU is done with them, never waiting for it
+		Readback& readback = m_readbacks[m_readbackIndex];
+		if (readback.fence) {
+			const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+
+			std::vector<uint32_t> counts(m_batches.size());
+			glGetNamedBufferSubData(readback.buffer, 0, counts.size() * sizeof(uint32_t), counts.data());
+			m_stats.visible = std::accumulate(counts.begin(), counts.end(), 0u);
+
+			glDeleteSync(readback.fence);
+			readback.fence = nullptr;
+		}
+
+		glCopyNamedBufferSubData(m_drawBuffer, readback.buffer, 0, 0, m_batches.size() * sizeof(uint32_t));
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_readbackIndex = (m_readbackIndex + 1) % m_readbacks.size();
+	}
+
+}
@@ -0,0 +1,151 @@
+// VR Renderer - GPU Culler
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/Buffer.h"
+#include "gpu/ShaderProgram.h"
+#include "gpu/Texture.h"
+#include "renderer/Frustum.h"
+#include "renderer/GeometryPool.h"
+#include "renderer/MaterialInstance.h"
+#include "renderer/RenderTarget.h"
+#include "renderer/RenderableStore.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace vr {
+
+	/// @brief GPU driven culling and drawing of the renderables of a store.
+	/// A compute pass tests every renderable against the view frustum and a depth pyramid of the previous frame,
+	/// then compacts the visible ones into indirect draw commands. Commands are grouped in batches sharing an archetype,
+	/// a material and a geometry pool page, each batch is drawn by one multi-draw reading its draw count on the GPU.
+	/// Before drawing, the world bounds of the primitives must be bound to the storage buffer binding 5.
+	class GpuCuller {
+	public:
+		struct Batch {
+			uint32_t archetype;
+			MaterialInstance* material;
+			uint32_t page;
+			uint32_t firstCommand;
+			uint32_t commandCount;	// Renderables in the batch, the upper bound of its draw count
+		};
+
+		// Draw elements indirect command, as filled by the culling pass
+		struct DrawCommand {
+			uint32_t elementCount;
+			uint32_t instanceCount;
+			uint32_t firstIndex;
+			int32_t baseVertex;
+			uint32_t baseInstance;	// Object index of the renderable
+		};
+
+		struct Stats {
+			uint32_t instances = 0;
+			uint32_t visible = 0;		// Read back from the GPU, a few frames late
+			size_t geometryMemory = 0;	// Size of the merged geometry, in bytes
+		};
+
+		GpuCuller();
+
+		/// @brief Rebuilds the batches and the merged geometry if the store changed since the last sync.
+		void sync(const RenderableStore& store);
+
+		/// @brief Fills the indirect draw commands with the renderables passing the culling tests.
+		/// @param frustum Camera frustum of the current frame.
+		/// @param occlusion Enables the depth pyramid test, once a pyramid has been built.
+		/// @param instanceViews Instances drawn per visible renderable, 2 for instanced stereo.
+		void cull(const Frustum& frustum, bool occlusion, uint32_t instanceViews = 1);
+
+		/// @brief Builds the depth pyramid tested by the next frame culling from the depth of a target.
+		/// @param viewProjection Matrix the target depth was rendered with.
+		void buildDepthPyramid(const RenderTarget& target, const glm::mat4& viewProjection);
+
+		/// @brief Draws the visible renderables of a batch. The batch material must already be in use.
+		void draw(uint32_t batch) const;
+
+		/// @brief Reads back the draw count and the commands of a batch, waiting for the GPU. Meant for tests, not per frame use.
+		/// @param commands Receives every command of the batch. Compacted commands come first, in no particular order,
+		/// otherwise each renderable keeps its command and culled ones have no instance.
+		/// @return The draw count of the batch.
+		uint32_t readCommands(uint32_t batch, std::vector<DrawCommand>& commands) const;
+
+		const std::vector<Batch>& getBatches() const { return m_batches; }
+		const Stats& getStats() const { return m_stats; }
+
+		/// @brief Tells whether draw counts are read on the GPU, or culled commands are drawn with no instance.
+		bool isCompacting() const { return m_compact; }
+
+	private:
+		// Static draw data of a renderable, matching the compute shader layout
+		struct Instance {
+			uint32_t primitive;
+			uint32_t object;		// Renderable object index, passed as base instance
+			uint32_t elementCount;
+			uint32_t firstIndex;
+			int32_t baseVertex;
+			uint32_t batch;
+			uint32_t batchFirst;	// First command of the batch
+			uint32_t slot;			// Own command, when commands are not compacted
+		};
+
+		struct Readback {
+			gpu::Buffer buffer;
+			GLsync fence = nullptr;
+		};
+
+		struct CullUniforms {
+			gpu::UniformHandle<glm::vec4> frustumPlanes;
+			gpu::UniformHandle<glm::mat4> pyramidViewProjection;
+			gpu::UniformHandle<glm::ivec2> pyramidSize;
+			gpu::UniformHandle<int32_t> pyramidLevels;
+			gpu::UniformHandle<int32_t> occlusion;
+			gpu::UniformHandle<int32_t> compact;
+			gpu::UniformHandle<uint32_t> instanceCount;
+			gpu::UniformHandle<uint32_t> instanceViews;
+			gpu::UniformHandle<uint32_t> commandBase;
+		};
+
+		struct PyramidUniforms {
+			gpu::UniformHandle<int32_t> sampleCount;
+			gpu::UniformHandle<glm::ivec2> depthSize;
+			gpu::UniformHandle<int32_t> level;
+		};
+
+		void readStatistics();
+
+	private:
+		gpu::ShaderProgram m_cullShader;
+		gpu::ShaderProgram m_pyramidShader;
+		CullUniforms m_cullUniforms;
+		PyramidUniforms m_pyramidUniforms;
+		bool m_compact;
+
+		uint64_t m_storeRevision = std::numeric_limits<uint64_t>::max();
+		GeometryPool m_geometry;
+		std::vector<Batch> m_batches;
+		uint32_t m_instanceCount = 0;
+
+		gpu::Buffer m_instances;
+		gpu::Buffer m_drawBuffer;	// Draw count of every batch, followed by the draw commands
+
+		std::unique_ptr<gpu::Texture> m_pyramid;
+		glm::ivec2 m_pyramidSize{ 0 };
+		int32_t m_pyramidLevels = 0;
+		glm::mat4 m_pyramidViewProjection{ 1.0f };
+		bool m_pyramidValid = false;
+
+		std::array<Readback, 3> m_readbacks;
+		uint32_t m_readbackIndex = 0;
+		Stats m_stats;
+	};
+
+}
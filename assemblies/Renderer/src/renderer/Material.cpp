@@ -8,12 +8,96 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <fstream>
 
 namespace vr {
 
+	// Macro defined in the shader source of each variant.
+	static const char* s_VARIANT_DEFINES[] = { nullptr, "MATERIAL_INDEXED" };
+	static const char* s_STEREO_DEFINES[] = { nullptr, "STEREO_MULTIVIEW", "STEREO_INSTANCED" };
+
 	Material::Material(const char* shaderPath)
-		: m_shader(std::make_unique<gpu::ShaderProgram>(shaderPath)), m_uniformBufferSize(0) {}
+		: m_shaderPath(shaderPath), m_uniformBufferSize(0) {
+		m_shaders[0] = std::make_unique<gpu::ShaderProgram>(shaderPath);
+	}
+
+	gpu::ShaderProgram& Material::getShaderProgram(ShaderVariant variant, StereoMode stereo, bool foveated) const {
+		const size_t index = (static_cast<size_t>(variant) * static_cast<size_t>(StereoMode::Count) + static_cast<size_t>(stereo)) * 2 + foveated;
+		std::unique_ptr<gpu::ShaderProgram>& shader = m_shaders[index];
+		if (!shader) {
+			std::vector<std::string> defines;
+			for (const char* define : { s_VARIANT_DEFINES[static_cast<size_t>(variant)], s_STEREO_DEFINES[static_cast<size_t>(stereo)], foveated ? "FOVEATED" : nullptr }) {
+				if (define)
+					defines.emplace_back(define);
+			}
+
+			shader = std::make_unique<gpu::ShaderProgram>(m_shaderPath.c_str(), defines);
+			validateLayout(*shader, variant);
+		}
+
+		return *shader;
+	}
+
+	void Material::reload() {
+		for (size_t i = 0; i < m_shaders.size(); ++i) {
+			if (!m_shaders[i]) continue;
+
+			m_shaders[i]->reload();
+			validateLayout(*m_shaders[i], static_cast<ShaderVariant>(i / (static_cast<size_t>(StereoMode::Count) * 2)));
+		}
+	}
+
+	void Material::validateLayout(const gpu::ShaderProgram& program, ShaderVariant variant) const {
+		using Variable = gpu::ShaderProgram::Reflection::Variable;
+		if (program == 0 || m_uniformLayout.empty()) return;
+
+		// Parameters are read from the uniform block at binding 2, or from the rows of the material storage
+		const gpu::ShaderProgram::Reflection& reflection = program.getReflection();
+		const bool indexed = variant == ShaderVariant::Indexed;
+		const std::vector<Variable>& members = indexed ? reflection.bufferVariables : reflection.uniforms;
+		const GLint block = indexed ? reflection.findStorageBlock(s_MATERIAL_STORAGE_BINDING) : reflection.findUniformBlock(2);
+		if (block < 0) {
+			logger::warn("Shader '{}' has no material block.", m_shaderPath);
+			return;
+		}
+
+		// Members are prefixed by their block or their array, the uniform name follows the last dot
+		auto findMember = [&members, block](const std::string& name) -> const Variable* {
+			for (const Variable& member : members) {
+				const size_t prefix = member.name.size() - name.size();
+				if (member.blockIndex == block && member.name.size() > name.size() && member.name.ends_with(name) && member.name[prefix - 1] == '.')
+					return &member;
+			}
+			return nullptr;
+		};
+
+		for (const auto& [name, uniform] : m_uniformLayout) {
+			const Variable* member = findMember(name);
+			if (!member) {
+				logger::warn("Material uniform '{}' is not in the material block of shader '{}'.", name, m_shaderPath);
+				continue;
+			}
+
+			if (static_cast<size_t>(member->offset) != uniform.offset)
+				logger::warn("Material uniform '{}' is at offset {} in shader '{}', not {}.", name, member->offset, m_shaderPath, uniform.offset);
+
+			const gpu::ShaderType type = gpu::ShaderType::fromGLType(member->type);
+			if ((type & uniform.type) == 0)
+				logger::warn("Material uniform '{}' is of type {} in shader '{}', not {}.", name, type.name(), m_shaderPath, uniform.type.name());
+		}
+
+		if (indexed) {
+			// Rows hold the maps after the parameters, one per texture slot
+			const Variable* maps = findMember("Maps");
+			if (!maps || static_cast<uint32_t>(maps->offset) != getMapsOffset() || static_cast<size_t>(maps->arraySize) != m_textureSlots.size())
+				logger::warn("Material maps of shader '{}' don't follow the parameters, {} maps expected at offset {}.", m_shaderPath, m_textureSlots.size(), getMapsOffset());
+			if (maps && static_cast<uint32_t>(maps->arrayStride) != getMaterialStride())
+				logger::warn("Material rows of shader '{}' are {} bytes apart, not {}.", m_shaderPath, maps->arrayStride, getMaterialStride());
+		} else if (static_cast<uint32_t>(reflection.uniformBlocks[block].dataSize) > m_uniformBufferSize) {
+			logger::warn("Material block of shader '{}' is {} bytes, larger than the {} bytes of the layout.", m_shaderPath, reflection.uniformBlocks[block].dataSize, m_uniformBufferSize);
+		}
+	}
 
 	void Material::setUniformLayout(const std::vector<Material::UniformDescriptor>& layout) {
 		// Compute uniform offsets
@@ -35,7 +119,77 @@ namespace vr {
 	void Material::setTextureLayout(const std::vector<Material::TextureDescriptor>& layout) {
 		for (const TextureDescriptor& descriptor : layout) {
 			m_textureLayout[descriptor.name] = descriptor.slot;
+			m_textureSlots.push_back(descriptor.slot);
 		}
+		std::sort(m_textureSlots.begin(), m_textureSlots.end());
+	}
+
+	uint32_t Material::allocateMaterialID() {
+		uint32_t materialID;
+		if (!m_freeMaterialIDs.empty()) {
+			materialID = m_freeMaterialIDs.back();
+			m_freeMaterialIDs.pop_back();
+		} else {
+			materialID = m_materialCount++;
+		}
+
+		// Grow the storage, rows of the live instances are kept
+		if (materialID >= m_materialCapacity) {
+			const uint32_t capacity = std::max(64u, m_materialCapacity * 2);
+			gpu::Buffer storage(static_cast<size_t>(capacity) * getMaterialStride(), GL_DYNAMIC_DRAW);
+			if (m_materialCapacity > 0)
+				glCopyNamedBufferSubData(m_materialStorage, storage, 0, 0, static_cast<GLsizeiptr>(m_materialCapacity) * getMaterialStride());
+
+			m_materialStorage = std::move(storage);
+			m_materialCapacity = capacity;
+		}
+
+		glClearNamedBufferSubData(m_materialStorage, GL_R32UI, static_cast<GLintptr>(materialID) * getMaterialStride(), getMaterialStride(), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+		return materialID;
+	}
+
+	void Material::releaseMaterialID(uint32_t materialID) {
+		m_freeMaterialIDs.push_back(materialID);
+	}
+
+	void Material::writeMaterialData(uint32_t materialID, uint32_t offset, uint32_t size, const void* data) {
+		glNamedBufferSubData(m_materialStorage, static_cast<GLintptr>(materialID) * getMaterialStride() + offset, size, data);
+	}
+
+	bool Material::writeMaterialMap(uint32_t materialID, GLuint slot, const std::shared_ptr<gpu::Texture>& array, uint32_t layer) {
+		auto map = std::find(m_textureSlots.begin(), m_textureSlots.end(), slot);
+		if (map == m_textureSlots.end())
+			return false;
+
+		// Reuse the unit of the array, or the first unit whose array was released
+		uint32_t unit = s_MAX_TEXTURE_ARRAYS;
+		for (uint32_t i = 0; i < s_MAX_TEXTURE_ARRAYS && unit == s_MAX_TEXTURE_ARRAYS; ++i) {
+			if (m_textureArrays[i].lock() == array)
+				unit = i;
+		}
+		for (uint32_t i = 0; i < s_MAX_TEXTURE_ARRAYS && unit == s_MAX_TEXTURE_ARRAYS; ++i) {
+			if (m_textureArrays[i].expired()) {
+				m_textureArrays[i] = array;
+				m_textureArrayHandles[i] = *array;
+				unit = i;
+			}
+		}
+		if (unit == s_MAX_TEXTURE_ARRAYS)
+			return false;
+
+		const uint32_t packed = (unit << 16) | layer;
+		writeMaterialData(materialID, getMapsOffset() + static_cast<uint32_t>(map - m_textureSlots.begin()) * sizeof(uint32_t), sizeof(uint32_t), &packed);
+		return true;
+	}
+
+	std::array<GLuint, Material::s_MAX_TEXTURE_ARRAYS> Material::getTextureArrays() const {
+		std::array<GLuint, s_MAX_TEXTURE_ARRAYS> handles{};
+		for (uint32_t i = 0; i < s_MAX_TEXTURE_ARRAYS; ++i) {
+			if (!m_textureArrays[i].expired())
+				handles[i] = m_textureArrayHandles[i];
+		}
+
+		return handles;
 	}
 
 	const Material::Uniform* Material::getUniformInfo(const std::string& name) const {
@@ -81,6 +235,7 @@ namespace vr {
 			textureLayout.push_back({ texture["name"], texture["slot"] });
 		}
 		material->setTextureLayout(textureLayout);
+		material->setIndexed(content.value("indexed", false));
 
 		logger::info("Loaded material '{}'.", static_cast<std::string>(content["name"]));
 
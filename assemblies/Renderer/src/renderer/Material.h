@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include "gpu/Buffer.h"
 #include "gpu/ShaderProgram.h"
 #include "gpu/ShaderType.h"
 #include "gpu/Texture.h"
 
 #include <glad/glad.h>
 
+#include <array>
 #include <cstdint>
 #include <unordered_map>
 #include <string>
@@ -17,9 +19,37 @@
 #include <vector>
 
 namespace vr {
+
+	/// @brief Shader programs compiled from the same material source, for the different ways of issuing draws.
+	enum class ShaderVariant : uint32_t {
+		Instanced = 0,	// Object transforms from the objects storage buffer, indexed by base instance and instance
+		Indexed,		// Instanced, parameters and maps fetched from the material storage by the material ID of the object
+
+		Count
+	};
+
+	/// @brief Ways of drawing the views of a layered target in one pass.
+	enum class StereoMode : uint32_t {
+		Mono = 0,	// Single view
+		Multiview,	// Views broadcast by OVR_multiview
+		Instanced,	// Instances doubled, odd instances are routed to the second layer from the vertex shader
+
+		Count
+	};
 	
+	/// @brief Shader, uniform layout and texture slots shared by material instances.
+	/// Instances of an indexed class also own a row of its material storage, a storage buffer indexed by material ID
+	/// holding their parameters then the map of each texture slot, a layer of one of the texture arrays of the class.
+	/// The indexed variant binds the same storage and arrays for every instance, which leaves nothing to rebind
+	/// between materials of the class.
 	class Material {
 	public:
+		static constexpr uint32_t s_NO_MATERIAL = ~0u;
+		static constexpr GLuint s_MATERIAL_STORAGE_BINDING = 10;	// Storage binding of the material rows
+		static constexpr GLuint s_TEXTURE_ARRAY_UNIT = 9;			// First texture unit of the arrays
+		static constexpr uint32_t s_MAX_TEXTURE_ARRAYS = 8;
+
+
 		struct UniformDescriptor {
 			std::string name;
 			gpu::ShaderType type;
@@ -44,7 +74,30 @@ namespace vr {
 
 		void setDefaultTexture(GLuint slot, std::shared_ptr<gpu::Texture> texture) { m_defaultTextures[slot] = texture; }
 
-		gpu::ShaderProgram& getShaderProgram() const { return *m_shader; }
+		/// @brief Gives each instance a row of the material storage, drawn by the indexed variant.
+		/// Rows mirror the uniform block with std430 rules, identical to std140 for blocks of scalars and vectors.
+		void setIndexed(bool indexed) { m_indexed = indexed; }
+		bool isIndexed() const { return m_indexed; }
+
+		/// @brief Allocates a row of the material storage, cleared to zero.
+		uint32_t allocateMaterialID();
+		void releaseMaterialID(uint32_t materialID);
+
+		/// @brief Writes parameters of a row, at an offset of the uniform layout.
+		void writeMaterialData(uint32_t materialID, uint32_t offset, uint32_t size, const void* data);
+
+		/// @brief Maps a texture slot of a row to a layer of a texture array, packed as (array << 16) | layer.
+		/// @return Whether the array could be given a unit, a class holds up to s_MAX_TEXTURE_ARRAYS arrays at once.
+		bool writeMaterialMap(uint32_t materialID, GLuint slot, const std::shared_ptr<gpu::Texture>& array, uint32_t layer);
+
+		const gpu::Buffer& getMaterialStorage() const { return m_materialStorage; }
+
+		/// @brief Provides the handle of each array unit, 0 for the units whose array was released.
+		std::array<GLuint, s_MAX_TEXTURE_ARRAYS> getTextureArrays() const;
+
+		/// @brief Provides a variant of the material shader, compiled on first use.
+		/// @param foveated Draws every object once per foveation region, see Foveation.
+		gpu::ShaderProgram& getShaderProgram(ShaderVariant variant = ShaderVariant::Instanced, StereoMode stereo = StereoMode::Mono, bool foveated = false) const;
 		const Uniform* getUniformInfo(const std::string& name) const;
 		int32_t getTextureSlot(const std::string& name) const;
 
@@ -54,17 +107,37 @@ namespace vr {
 		const std::unordered_map<std::string, GLuint>& getTextureLayout() const { return m_textureLayout; }
 		const std::unordered_map<GLuint, std::shared_ptr<gpu::Texture>>& getDefaultTextures() const { return m_defaultTextures; }
 
-		void reload() { m_shader->reload(); }
+		void reload();
 
 		static std::shared_ptr<Material> loadFromJSON(const std::string& path);
 
 	private:
-		std::unique_ptr<gpu::ShaderProgram> m_shader;
+		/// @brief Checks the uniform layout against the material block reflected from a variant, the rows of the
+		/// material storage for the indexed variant. Mismatches are reported, the layout is kept.
+		void validateLayout(const gpu::ShaderProgram& program, ShaderVariant variant) const;
+
+		uint32_t getMapsOffset() const { return (m_uniformBufferSize + 3) & ~3u; }
+		uint32_t getMaterialStride() const { return (getMapsOffset() + static_cast<uint32_t>(m_textureSlots.size()) * sizeof(uint32_t) + 15) & ~15u; }
+
+	private:
+		std::string m_shaderPath;
+		// Indexed by variant, stereo mode and foveation
+		mutable std::array<std::unique_ptr<gpu::ShaderProgram>, static_cast<size_t>(ShaderVariant::Count) * static_cast<size_t>(StereoMode::Count) * 2> m_shaders;
 		std::unordered_map<std::string, Uniform> m_uniformLayout;
 		std::unordered_map<std::string, GLuint> m_textureLayout;
 		std::unordered_map<GLuint, std::shared_ptr<gpu::Texture>> m_defaultTextures;
 
 		uint32_t m_uniformBufferSize;
+
+		// Material storage of the indexed classes
+		bool m_indexed = false;
+		std::vector<GLuint> m_textureSlots;	// Slots in map order
+		gpu::Buffer m_materialStorage;
+		uint32_t m_materialCapacity = 0;
+		uint32_t m_materialCount = 0;
+		std::vector<uint32_t> m_freeMaterialIDs;
+		std::array<std::weak_ptr<gpu::Texture>, s_MAX_TEXTURE_ARRAYS> m_textureArrays;
+		std::array<GLuint, s_MAX_TEXTURE_ARRAYS> m_textureArrayHandles{};
 	};
 
 }
@@ -3,46 +3,165 @@
 // 2025
 
 #include "MaterialInstance.h"
+#include "gpu/StateCache.h"
 
 #include <imgui.h>
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
 namespace vr {
+
+	// Deltas recorded by each thread, the update thread hands its own over with the frame snapshot
+	static thread_local std::vector<MaterialInstance::Delta> s_pendingDeltas;
+
+	// Calls bind(first, count, textures) for each run of consecutive units, the textures of the instance override
+	// the defaults of the class. Units past the table are bound one by one.
+	template<typename Bind>
+	static void ForEachTextureRun(const Material& material, const std::unordered_map<GLuint, std::shared_ptr<gpu::Texture>>& textures, Bind&& bind) {
+		constexpr GLuint unitCount = 32;
+		std::array<GLuint, unitCount> units{};
+		GLuint first = unitCount, last = 0;
+		auto gather = [&](const std::unordered_map<GLuint, std::shared_ptr<gpu::Texture>>& slots) {
+			for (const auto& [slot, texture] : slots) {
+				const GLuint handle = *texture;
+				if (slot >= unitCount) {
+					bind(slot, 1, &handle);
+					continue;
+				}
+
+				units[slot] = handle;
+				first = std::min(first, slot);
+				last = std::max(last, slot);
+			}
+		};
+
+		gather(material.getDefaultTextures());
+		gather(textures);
+
+		for (GLuint unit = first; unit <= last && first < unitCount;) {
+			if (units[unit] == 0) {
+				++unit;
+				continue;
+			}
+
+			GLuint end = unit + 1;
+			while (end <= last && units[end] != 0) ++end;
+			bind(unit, static_cast<GLsizei>(end - unit), &units[unit]);
+			unit = end;
+		}
+	}
 	
 	MaterialInstance::MaterialInstance(std::shared_ptr<Material> materialClass)
 		: m_materialClass(materialClass) {
 		// Allocate buffer
 		m_bufferData = std::make_unique<uint8_t[]>(materialClass->getUniformBufferSize());
+		m_renderData = std::make_unique<uint8_t[]>(materialClass->getUniformBufferSize());
 		m_buffer = gpu::Buffer(materialClass->getUniformBufferSize(), GL_DYNAMIC_DRAW);
+
+		if (materialClass->isIndexed())
+			m_materialID = materialClass->allocateMaterialID();
 	}
 
-	void MaterialInstance::use() {
-		// Update buffer data if needed
-		if (m_dataPending) {
-			glNamedBufferSubData(m_buffer, 0, m_materialClass->getUniformBufferSize(), m_bufferData.get());
-			m_dataPending = false;
-		}
+	MaterialInstance::~MaterialInstance() {
+		if (m_materialID != Material::s_NO_MATERIAL)
+			m_materialClass->releaseMaterialID(m_materialID);
+	}
+
+	void MaterialInstance::setTextureLayer(const std::string& name, std::shared_ptr<gpu::Texture> texture, std::shared_ptr<gpu::Texture> array, uint32_t layer) {
+		setTexture(name, texture);
+
+		const int32_t slot = m_materialClass->getTextureSlot(name);
+		if (slot == -1 || m_materialID == Material::s_NO_MATERIAL)
+			return;
+
+		// Without a free array unit the instance keeps drawing with its own bindings
+		if (m_materialClass->writeMaterialMap(m_materialID, slot, array, layer))
+			m_textureLayers[slot] = std::move(array);
+		else
+			logger::warn("Texture '{}' has no free array unit, the material is not indexed.", name);
+	}
 
+	bool MaterialInstance::isIndexed() const {
+		return m_materialID != Material::s_NO_MATERIAL && m_textureLayers.size() == m_textures.size();
+	}
+
+	void MaterialInstance::use(ShaderVariant variant, StereoMode stereo, bool foveated) {
 		// Bind shader and uniform buffer
-		glUseProgram(m_materialClass->getShaderProgram());
-		glBindBufferBase(GL_UNIFORM_BUFFER, 2, m_buffer);
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.useProgram(m_materialClass->getShaderProgram(variant, stereo, foveated));
+		if (variant == ShaderVariant::Indexed) {
+			// Bindings shared by every instance of the class, the material is fetched by ID and samples the arrays only
+			const std::array<GLuint, Material::s_MAX_TEXTURE_ARRAYS> arrays = m_materialClass->getTextureArrays();
+			state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, Material::s_MATERIAL_STORAGE_BINDING, m_materialClass->getMaterialStorage());
+			state.bindTextures(Material::s_TEXTURE_ARRAY_UNIT, Material::s_MAX_TEXTURE_ARRAYS, arrays.data());
+		} else {
+			state.bindBufferBase(GL_UNIFORM_BUFFER, 2, m_buffer);
+			bindTextures();
+		}
+
+		renderFlags.apply();
+	}
+
+	void MaterialInstance::bindTextures() const {
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		ForEachTextureRun(*m_materialClass, m_textures, [&state](GLuint first, GLsizei count, const GLuint* textures) {
+			state.bindTextures(first, count, textures);
+		});
+	}
+
+	std::vector<MaterialInstance::Delta> MaterialInstance::TakeDeltas() {
+		return std::exchange(s_pendingDeltas, {});
+	}
+
+	void MaterialInstance::ApplyDelta(const Delta& delta) {
+		std::memcpy(&delta.material->m_renderData[delta.offset], delta.data.data(), delta.size);
+		glNamedBufferSubData(delta.material->m_buffer, delta.offset, delta.size, delta.data.data());
+		if (delta.material->m_materialID != Material::s_NO_MATERIAL)
+			delta.material->m_materialClass->writeMaterialData(delta.material->m_materialID, delta.offset, delta.size, delta.data.data());
+	}
 
-		// Bind textures
-		for (const auto& [slot, texture] : m_materialClass->getDefaultTextures()) {
-			glBindTextureUnit(slot, *texture);
+	void MaterialInstance::recordDelta(uint32_t offset, uint32_t size) {
+		// The delta keeps the instance alive until the render thread applies it, which is the only writer of its parameters
+		std::shared_ptr<MaterialInstance> material = weak_from_this().lock();
+		assert(material && "Edited material instances must be owned by a shared pointer.");
+		if (!material) {
+			logger::error("Material instance edited without being owned by a shared pointer, the edit is dropped.");
+			return;
 		}
 
-		for (const auto& [slot, texture] : m_textures) {
-			glBindTextureUnit(slot, *texture);
+		Delta& delta = s_pendingDeltas.emplace_back(Delta{ .material = std::move(material), .offset = offset, .size = size, .data = {} });
+		std::memcpy(delta.data.data(), &m_bufferData[offset], size);
+	}
+
+	void MaterialInstance::record(gpu::CommandBuffer& commands, ShaderVariant variant, StereoMode stereo, bool foveated) const {
+		commands.useProgram(m_materialClass->getShaderProgram(variant, stereo, foveated));
+		if (variant == ShaderVariant::Indexed) {
+			const std::array<GLuint, Material::s_MAX_TEXTURE_ARRAYS> arrays = m_materialClass->getTextureArrays();
+			commands.bindBufferBase(GL_SHADER_STORAGE_BUFFER, Material::s_MATERIAL_STORAGE_BINDING, m_materialClass->getMaterialStorage());
+			commands.bindTextures(Material::s_TEXTURE_ARRAY_UNIT, Material::s_MAX_TEXTURE_ARRAYS, arrays.data());
+		} else {
+			commands.bindBufferBase(GL_UNIFORM_BUFFER, 2, m_buffer);
+			recordTextures(commands);
 		}
 
-		renderFlags.apply();
+		renderFlags.record(commands);
+	}
+
+	void MaterialInstance::recordTextures(gpu::CommandBuffer& commands) const {
+		ForEachTextureRun(*m_materialClass, m_textures, [&commands](GLuint first, GLsizei count, const GLuint* textures) {
+			commands.bindTextures(first, count, textures);
+		});
 	}
 
 	void MaterialInstance::immediateGUI() {
-		bool modified = false;
 		ImGui::PushID(this);
 		for (auto& [name, uniform] : m_materialClass->getUniformLayout()) {
+			bool modified = false;
 			switch (uniform.type) {
 			case gpu::ShaderType::Bool:
 				modified = ImGui::Checkbox(name.c_str(), reinterpret_cast<bool*>(&m_bufferData[uniform.offset]));
@@ -50,6 +169,9 @@ namespace vr {
 			case gpu::ShaderType::Int:
 				modified = ImGui::DragInt(name.c_str(), reinterpret_cast<int*>(&m_bufferData[uniform.offset]), 0.01f);
 				break;
+			case gpu::ShaderType::UInt:
+				modified = ImGui::DragScalar(name.c_str(), ImGuiDataType_U32, &m_bufferData[uniform.offset], 0.01f);
+				break;
 			case gpu::ShaderType::Float:
 				modified = ImGui::DragFloat(name.c_str(), reinterpret_cast<float*>(&m_bufferData[uniform.offset]), 0.01f);
 				break;
@@ -81,7 +203,7 @@ namespace vr {
 				break;
 			}
 
-			if (modified) m_dataPending = true;
+			if (modified) recordDelta(static_cast<uint32_t>(uniform.offset), uniform.type.size());
 		}
 		ImGui::PopID();
 	}
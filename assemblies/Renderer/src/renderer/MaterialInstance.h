@@ -6,19 +6,37 @@
 
 #include "core/Logger.h"
 #include "gpu/Buffer.h"
+#include "gpu/CommandBuffer.h"
 #include "gpu/ShaderType.h"
 #include "renderer/Material.h"
 #include "renderer/RenderFlags.h"
 #include "utils/Macros.h"
 
+#include <array>
 #include <memory>
+#include <vector>
 
 namespace vr {
 
-	class MaterialInstance {
+	/// @brief Parameters and textures of a material.
+	/// Parameters are edited by the update thread and read by the render thread, each has its own copy. Edits are
+	/// recorded as deltas, handed over with the frame snapshot and applied to the copy of the render thread. The deltas
+	/// hold the instance, edited instances must be owned by a shared pointer.
+	/// Instances of an indexed class mirror the parameters of the render thread into their row of the material storage.
+	class MaterialInstance : public std::enable_shared_from_this<MaterialInstance> {
+	public:
+		/// @brief Edit of the parameters, bytes copied at an offset of the uniform buffer.
+		struct Delta {
+			std::shared_ptr<MaterialInstance> material;
+			uint32_t offset;
+			uint32_t size;
+			std::array<uint8_t, 64> data;
+		};
+
 	public:
 		MaterialInstance() = default;
 		MaterialInstance(std::shared_ptr<Material> materialClass);
+		~MaterialInstance();
 
 		template<typename T>
 		T get(const std::string& name) const {
@@ -56,7 +74,7 @@ namespace vr {
 			}
 
 			std::memcpy(&m_bufferData[uniform->offset], &value, sizeof(T));
-			m_dataPending = true;
+			recordDelta(static_cast<uint32_t>(uniform->offset), sizeof(T));
 		}
 
 		void setTexture(const std::string& name, std::shared_ptr<gpu::Texture> texture) {
@@ -67,20 +85,50 @@ namespace vr {
 			}
 
 			m_textures[slot] = texture;
+			m_textureLayers.erase(slot);
 		}
 
-		void use();
+		/// @brief Sets the layer of a texture array sampled by the indexed variant, along with the texture of the slot.
+		/// @param texture View of the layer, sampled by the other variants.
+		void setTextureLayer(const std::string& name, std::shared_ptr<gpu::Texture> texture, std::shared_ptr<gpu::Texture> array, uint32_t layer);
+
+		/// @brief Whether the instance can be drawn by the indexed variant: its class is indexed and each of its
+		/// textures is a layer of an array.
+		bool isIndexed() const;
+		uint32_t getMaterialID() const { return m_materialID; }
+
+		void use(ShaderVariant variant = ShaderVariant::Instanced, StereoMode stereo = StereoMode::Mono, bool foveated = false);
+		void bindTextures() const;
+
+		/// @brief Records the bindings of use() and bindTextures(), from any thread.
+		/// The parameters of the render thread are uploaded when their deltas are applied, recording never uploads.
+		void record(gpu::CommandBuffer& commands, ShaderVariant variant = ShaderVariant::Instanced, StereoMode stereo = StereoMode::Mono, bool foveated = false) const;
+		void recordTextures(gpu::CommandBuffer& commands) const;
+
+		const Material& getMaterialClass() const { return *m_materialClass; }
+
 		void immediateGUI();
+
+		/// @brief Takes the deltas the calling thread recorded since the last call, across every material.
+		static std::vector<Delta> TakeDeltas();
+
+		/// @brief Applies a delta to the parameters of the render thread, and uploads it.
+		static void ApplyDelta(const Delta& delta);
+
+	private:
+		void recordDelta(uint32_t offset, uint32_t size);
+
 	public:
 		RenderFlags renderFlags;
 	private:
 		std::shared_ptr<Material> m_materialClass;
-		std::unique_ptr<uint8_t[]> m_bufferData;
+		std::unique_ptr<uint8_t[]> m_bufferData;	// Parameters of the update thread
+		std::unique_ptr<uint8_t[]> m_renderData;	// Parameters of the render thread, uploaded to the buffer
 		gpu::Buffer m_buffer;
 
-		bool m_dataPending = false;
-
 		std::unordered_map<GLuint, std::shared_ptr<gpu::Texture>> m_textures;
+		std::unordered_map<GLuint, std::shared_ptr<gpu::Texture>> m_textureLayers;	// Array of each slot mapped in the material storage
+		uint32_t m_materialID = Material::s_NO_MATERIAL;
 	};
 
 }
@@ -9,6 +9,7 @@
 #include "gpu/VertexArray.h"
 #include "gpu/Renderbuffer.h"
 #include "gpu/Framebuffer.h"
+#include "gpu/StateCache.h"
 
 #include <filesystem>
 
@@ -60,9 +61,10 @@ static std::shared_ptr<vr::gpu::Texture> ComputeCookTorranceLUT(uint32_t size) {
 	glViewport(0, 0, size, size);
 
 	gpu::ShaderProgram cookTorranceLUTShader("res/shaders/pre-render/cook-torrance_LUT.glsl");
-	glUseProgram(cookTorranceLUTShader);
-	glBindTextureUnit(0, *LUT);
-	glBindVertexArray(quad);
+	gpu::StateCache& state = gpu::StateCache::getInstance();
+	state.useProgram(cookTorranceLUTShader);
+	state.bindTextureUnit(0, *LUT);
+	state.bindVertexArray(quad);
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 
 	return LUT;
@@ -101,7 +103,7 @@ namespace vr {
 
 	void MaterialRegistry::reloadMaterials() {
 		for (auto& material : s_materials) {
-			material.second->getShaderProgram().reload();
+			material.second->reload();
 		}
 	}
 
@@ -7,13 +7,19 @@
 #include "renderer/Primitive.h"
 #include "renderer/Transform.h"
 
+#include <memory>
 #include <vector>
 
 namespace vr {
 	
 	struct Mesh {
 		std::vector<Primitive> primitives;
+
+		// Initial placement of the entities made from the mesh, see EntityStore::add.
 		Transform transform;
+
+		// Static meshes are expected to rarely move, their shadows are cached.
+		bool isStatic = false;
 	};
 	
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+// VR Renderer - Occluder Geometry
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vr {
+
+	/// @brief CPU copy of a primitive positions, rasterized by the occlusion culler.
+	struct OccluderGeometry {
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+}
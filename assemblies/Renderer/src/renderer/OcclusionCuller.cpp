@@ -0,0 +1,254 @@
+// VR Renderer - Occlusion Culler
+// Rodolphe VALICON
+// 2025
+
+#include "OcclusionCuller.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vr {
+
+	static constexpr uint32_t s_TILES_X = OcclusionCuller::s_WIDTH / OcclusionCuller::s_TILE_SIZE;
+	static constexpr uint32_t s_TILES_Y = OcclusionCuller::s_HEIGHT / OcclusionCuller::s_TILE_SIZE;
+
+	OcclusionCuller::OcclusionCuller(JobSystem& jobSystem)
+		: m_jobSystem(jobSystem), m_viewProjection(1.0f),
+		m_depth(s_WIDTH * s_HEIGHT, 1.0f), m_tileMaxDepth(s_TILES_X * s_TILES_Y, 1.0f), m_bands(s_TILES_Y)
+	{}
+
+	void OcclusionCuller::begin(const glm::mat4& viewProjection) {
+		m_viewProjection = viewProjection;
+		m_occluders.clear();
+		m_triangleCount = 0;
+
+		std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+		std::fill(m_tileMaxDepth.begin(), m_tileMaxDepth.end(), 1.0f);
+	}
+
+	void OcclusionCuller::addOccluder(const OccluderGeometry& geometry, const glm::mat4& modelMatrix) {
+		const uint32_t firstVertex = m_occluders.empty() ? 0
+			: m_occluders.back().firstVertex + static_cast<uint32_t>(m_occluders.back().geometry->positions.size());
+
+		m_occluders.push_back(Occluder{ &geometry, m_viewProjection * modelMatrix, firstVertex });
+		m_triangleCount += static_cast<uint32_t>(geometry.indices.size() / 3);
+	}
+
+	void OcclusionCuller::rasterize() {
+		if (m_occluders.empty()) return;
+
+		// Transform the occluders vertices to screen space
+		const Occluder& last = m_occluders.back();
+		m_screenVertices.resize(last.firstVertex + last.geometry->positions.size());
+
+		m_jobSystem.parallelFor(static_cast<uint32_t>(m_occluders.size()), [this](uint32_t o) {
+			const Occluder& occluder = m_occluders[o];
+			glm::vec4* output = &m_screenVertices[occluder.firstVertex];
+
+			for (const glm::vec3& position : occluder.geometry->positions) {
+				const glm::vec4 clip = occluder.matrix * glm::vec4(position, 1.0f);
+				if (clip.w <= 1e-5f || clip.z < -clip.w) {
+					// Behind the near plane, triangles using this vertex are skipped
+					*output++ = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+					continue;
+				}
+
+				const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+				*output++ = glm::vec4(
+					(ndc.x * 0.5f + 0.5f) * s_WIDTH,
+					(ndc.y * 0.5f + 0.5f) * s_HEIGHT,
+					ndc.z * 0.5f + 0.5f,
+					1.0f
+				);
+			}
+		});
+
+		// Bin the triangles facing the screen by band of tiles
+		for (std::vector<uint32_t>& band : m_bands)
+			band.clear();
+
+		for (const Occluder& occluder : m_occluders) {
+			const std::vector<uint32_t>& indices = occluder.geometry->indices;
+
+			for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+				const uint32_t i0 = occluder.firstVertex + indices[i];
+				const uint32_t i1 = occluder.firstVertex + indices[i + 1];
+				const uint32_t i2 = occluder.firstVertex + indices[i + 2];
+				const glm::vec4& v0 = m_screenVertices[i0];
+				const glm::vec4& v1 = m_screenVertices[i1];
+				const glm::vec4& v2 = m_screenVertices[i2];
+
+				// Skipping an occluder triangle is always safe
+				if (v0.w < 0.0f || v1.w < 0.0f || v2.w < 0.0f) continue;
+
+				const float minY = std::min({ v0.y, v1.y, v2.y });
+				const float maxY = std::max({ v0.y, v1.y, v2.y });
+				const int32_t first = std::max(0, static_cast<int32_t>(minY) / static_cast<int32_t>(s_TILE_SIZE));
+				const int32_t last = std::min(static_cast<int32_t>(s_TILES_Y) - 1, static_cast<int32_t>(maxY) / static_cast<int32_t>(s_TILE_SIZE));
+				for (int32_t band = first; band <= last; ++band)
+					m_bands[band].insert(m_bands[band].end(), { i0, i1, i2 });
+			}
+		}
+
+		// Rasterize the triangles, one band of tiles per job
+		m_jobSystem.parallelFor(s_TILES_Y, [this](uint32_t tileRow) { rasterizeBand(tileRow); });
+	}
+
+	void OcclusionCuller::rasterizeBand(uint32_t tileRow) {
+		const uint32_t rowBegin = tileRow * s_TILE_SIZE;
+		const uint32_t rowEnd = rowBegin + s_TILE_SIZE;
+
+		const std::vector<uint32_t>& triangles = m_bands[tileRow];
+		for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+			rasterizeTriangle(m_screenVertices[triangles[i]], m_screenVertices[triangles[i + 1]], m_screenVertices[triangles[i + 2]], rowBegin, rowEnd);
+
+		// Update the maximum depth of the band tiles
+		for (uint32_t tileX = 0; tileX < s_TILES_X; ++tileX) {
+			__m128 maxDepth = _mm_setzero_ps();
+			for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+				const float* row = &m_depth[y * s_WIDTH + tileX * s_TILE_SIZE];
+				for (uint32_t x = 0; x < s_TILE_SIZE; x += 4)
+					maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(row + x));
+			}
+
+			alignas(16) float lanes[4];
+			_mm_store_ps(lanes, maxDepth);
+			m_tileMaxDepth[tileRow * s_TILES_X + tileX] = std::max({ lanes[0], lanes[1], lanes[2], lanes[3] });
+		}
+	}
+
+	void OcclusionCuller::rasterizeTriangle(const glm::vec4& v0, glm::vec4 v1, glm::vec4 v2, uint32_t rowBegin, uint32_t rowEnd) {
+		// Orient the triangle counter-clockwise, occluders are treated as double-sided
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+		if (std::abs(area) < 1e-6f) return;
+		if (area < 0.0f) {
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		// Pixel bounds, restricted to the band
+		const int32_t xBegin = std::max(0, static_cast<int32_t>(std::floor(std::min({ v0.x, v1.x, v2.x }))));
+		const int32_t xEnd = std::min(static_cast<int32_t>(s_WIDTH), static_cast<int32_t>(std::ceil(std::max({ v0.x, v1.x, v2.x }))));
+		const int32_t yBegin = std::max(static_cast<int32_t>(rowBegin), static_cast<int32_t>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+		const int32_t yEnd = std::min(static_cast<int32_t>(rowEnd), static_cast<int32_t>(std::ceil(std::max({ v0.y, v1.y, v2.y }))));
+		if (xBegin >= xEnd || yBegin >= yEnd) return;
+
+		// Edge functions E(x, y) = a * x + b * y + c, positive inside, sampled at pixel centers.
+		// Pixels on a shared edge belong to one triangle only, so meshes are rasterized without cracks.
+		const glm::vec4* vertices[3] = { &v0, &v1, &v2 };
+		__m128 edgeA[3], edgeRow[3], edgeThreshold[3];
+		float edgeB[3], edgeC[3];
+		for (uint32_t e = 0; e < 3; ++e) {
+			const glm::vec4& p = *vertices[e];
+			const glm::vec4& q = *vertices[(e + 1) % 3];
+			const float a = p.y - q.y;
+			const float b = q.x - p.x;
+			edgeA[e] = _mm_set1_ps(a);
+			edgeB[e] = b;
+			edgeC[e] = p.x * q.y - p.y * q.x;
+			// Top-left fill rule: pixels exactly on a right or bottom edge are left out
+			const bool topLeft = a > 0.0f || (a == 0.0f && b < 0.0f);
+			edgeThreshold[e] = _mm_set1_ps(topLeft ? 0.0f : std::numeric_limits<float>::min());
+		}
+
+		// Depth plane, taking the farthest depth over the pixel square to stay conservative
+		const float dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+		const float dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+		const float zBias = 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+		const __m128 depthA = _mm_set1_ps(dzdx);
+
+		const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const int32_t xAligned = xBegin & ~3;
+
+		for (int32_t y = yBegin; y < yEnd; ++y) {
+			const float py = y + 0.5f;
+			for (uint32_t e = 0; e < 3; ++e)
+				edgeRow[e] = _mm_set1_ps(edgeB[e] * py + edgeC[e]);
+			const __m128 depthRow = _mm_set1_ps(v0.z + dzdy * (py - v0.y) - dzdx * v0.x + zBias);
+
+			float* row = &m_depth[y * s_WIDTH];
+			for (int32_t x = xAligned; x < xEnd; x += 4) {
+				const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+				__m128 covered = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], px), edgeRow[0]), edgeThreshold[0]);
+				covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], px), edgeRow[1]), edgeThreshold[1]));
+				covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], px), edgeRow[2]), edgeThreshold[2]));
+				if (_mm_movemask_ps(covered) == 0) continue;
+
+				const __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, px), depthRow);
+				const __m128 current = _mm_loadu_ps(row + x);
+				const __m128 nearest = _mm_min_ps(current, depth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(covered, nearest), _mm_andnot_ps(covered, current)));
+			}
+		}
+	}
+
+	bool OcclusionCuller::projectBounds(const AABB& bounds, ScreenRect& rect) const {
+		rect.min = glm::vec2(std::numeric_limits<float>::max());
+		rect.max = glm::vec2(-std::numeric_limits<float>::max());
+		rect.depth = 1.0f;
+
+		for (uint32_t corner = 0; corner < 8; ++corner) {
+			const glm::vec3 position(
+				(corner & 1) ? bounds.max.x : bounds.min.x,
+				(corner & 2) ? bounds.max.y : bounds.min.y,
+				(corner & 4) ? bounds.max.z : bounds.min.z
+			);
+
+			const glm::vec4 clip = m_viewProjection * glm::vec4(position, 1.0f);
+			if (clip.w <= 1e-5f || clip.z < -clip.w) return false;
+
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			const glm::vec2 pixel = (glm::vec2(ndc) * 0.5f + 0.5f) * glm::vec2(s_WIDTH, s_HEIGHT);
+			rect.min = glm::min(rect.min, pixel);
+			rect.max = glm::max(rect.max, pixel);
+			rect.depth = std::min(rect.depth, ndc.z * 0.5f + 0.5f);
+		}
+
+		return true;
+	}
+
+	bool OcclusionCuller::isVisible(const AABB& bounds) const {
+		ScreenRect rect;
+		if (!projectBounds(bounds, rect)) return true;
+
+		const int32_t xBegin = std::max(0, static_cast<int32_t>(std::floor(rect.min.x)));
+		const int32_t xEnd = std::min(static_cast<int32_t>(s_WIDTH), static_cast<int32_t>(std::ceil(rect.max.x)));
+		const int32_t yBegin = std::max(0, static_cast<int32_t>(std::floor(rect.min.y)));
+		const int32_t yEnd = std::min(static_cast<int32_t>(s_HEIGHT), static_cast<int32_t>(std::ceil(rect.max.y)));
+		if (xBegin >= xEnd || yBegin >= yEnd) return false;
+
+		// Visible as soon as one pixel of the rectangle is not in front of the box
+		for (int32_t tileY = yBegin / s_TILE_SIZE; tileY * static_cast<int32_t>(s_TILE_SIZE) < yEnd; ++tileY) {
+			for (int32_t tileX = xBegin / s_TILE_SIZE; tileX * static_cast<int32_t>(s_TILE_SIZE) < xEnd; ++tileX) {
+				// Whole tile in front of the box
+				if (m_tileMaxDepth[tileY * s_TILES_X + tileX] < rect.depth) continue;
+
+				const int32_t x0 = std::max(xBegin, tileX * static_cast<int32_t>(s_TILE_SIZE));
+				const int32_t x1 = std::min(xEnd, (tileX + 1) * static_cast<int32_t>(s_TILE_SIZE));
+				const int32_t y0 = std::max(yBegin, tileY * static_cast<int32_t>(s_TILE_SIZE));
+				const int32_t y1 = std::min(yEnd, (tileY + 1) * static_cast<int32_t>(s_TILE_SIZE));
+				for (int32_t y = y0; y < y1; ++y) {
+					for (int32_t x = x0; x < x1; ++x) {
+						if (m_depth[y * s_WIDTH + x] >= rect.depth) return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+	float OcclusionCuller::getScreenCoverage(const AABB& bounds) const {
+		ScreenRect rect;
+		if (!projectBounds(bounds, rect)) return 1.0f;
+
+		const glm::vec2 size = glm::clamp(rect.max, glm::vec2(0.0f), glm::vec2(s_WIDTH, s_HEIGHT))
+			- glm::clamp(rect.min, glm::vec2(0.0f), glm::vec2(s_WIDTH, s_HEIGHT));
+		return glm::max(size.x, 0.0f) * glm::max(size.y, 0.0f) / (s_WIDTH * s_HEIGHT);
+	}
+
+}
@@ -0,0 +1,86 @@
+// VR Renderer - Occlusion Culler
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "core/JobSystem.h"
+#include "renderer/Bounds.h"
+#include "renderer/OccluderGeometry.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Software occlusion culling on a low resolution CPU depth buffer.
+	/// A few large occluders are conservatively rasterized with SSE, one band of tiles per job,
+	/// then the screen rectangle of each candidate box is tested against the buffer.
+	/// Does not depend on the GPU, depths follow the OpenGL convention remapped to [0, 1].
+	class OcclusionCuller {
+	public:
+		static constexpr uint32_t s_WIDTH = 256;
+		static constexpr uint32_t s_HEIGHT = 144;
+		static constexpr uint32_t s_TILE_SIZE = 8;
+
+		OcclusionCuller(JobSystem& jobSystem);
+
+		/// @brief Clears the depth buffer and the occluder list.
+		/// @param viewProjection Matrix transforming world space to clip space.
+		void begin(const glm::mat4& viewProjection);
+
+		/// @brief Queues an occluder to rasterize. The geometry must outlive the rasterization.
+		/// @param geometry Triangle list of the occluder.
+		/// @param modelMatrix Transform of the occluder to world space.
+		void addOccluder(const OccluderGeometry& geometry, const glm::mat4& modelMatrix);
+
+		/// @brief Rasterizes the queued occluders in the depth buffer, on the job system workers.
+		void rasterize();
+
+		/// @brief Conservatively tests whether a box may be visible.
+		/// @param bounds World space bounding box.
+		/// @return false only if the box is out of screen or fully hidden behind the occluders.
+		bool isVisible(const AABB& bounds) const;
+
+		/// @brief Provides the share of the screen a box bounding rectangle covers, in [0, 1].
+		float getScreenCoverage(const AABB& bounds) const;
+
+		uint32_t getOccluderCount() const { return static_cast<uint32_t>(m_occluders.size()); }
+		uint32_t getTriangleCount() const { return m_triangleCount; }
+		const std::vector<float>& getDepthBuffer() const { return m_depth; }
+
+	private:
+		struct Occluder {
+			const OccluderGeometry* geometry;
+			glm::mat4 matrix;		// Model to clip space
+			uint32_t firstVertex;	// Offset in the screen vertices
+		};
+
+		struct ScreenRect {
+			glm::vec2 min;
+			glm::vec2 max;
+			float depth;			// Nearest depth
+		};
+
+		// Projects a box to the screen, returns false if it crosses the near plane.
+		bool projectBounds(const AABB& bounds, ScreenRect& rect) const;
+
+		void rasterizeBand(uint32_t tileRow);
+		void rasterizeTriangle(const glm::vec4& v0, glm::vec4 v1, glm::vec4 v2, uint32_t rowBegin, uint32_t rowEnd);
+
+	private:
+		JobSystem& m_jobSystem;
+		glm::mat4 m_viewProjection;
+
+		std::vector<Occluder> m_occluders;
+		std::vector<glm::vec4> m_screenVertices;	// Pixel x, y, depth, and w > 0 if in front of the near plane
+		uint32_t m_triangleCount = 0;
+
+		std::vector<float> m_depth;
+		std::vector<float> m_tileMaxDepth;
+		std::vector<std::vector<uint32_t>> m_bands;	// Screen vertex indices of the triangles overlapping each band
+	};
+
+}
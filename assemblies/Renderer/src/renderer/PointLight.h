@@ -16,6 +16,13 @@ namespace vr {
 		alignas(16) glm::vec3 color;
 		float power;
 		float radius;
+
+		/// @brief Provides the distance beyond which the light radiance falls under a threshold.
+		/// @param threshold Radiance under which the light is considered negligible.
+		float getInfluenceRadius(float threshold = 0.01f) const {
+			const float intensity = power * glm::max(color.r, glm::max(color.g, color.b));
+			return glm::sqrt(glm::max(intensity, 0.0f) / threshold);
+		}
 	};
 
 }
\ No newline at end of file
@@ -5,13 +5,17 @@
 #pragma once
 
 #include "gpu/VertexArray.h"
+#include "renderer/Bounds.h"
 #include "renderer/MaterialInstance.h"
+#include "renderer/OccluderGeometry.h"
 
 namespace vr {
 
 	struct Primitive {
 		std::shared_ptr<gpu::VertexArray> vertexArray;
 		std::shared_ptr<MaterialInstance> material;
+		AABB bounds;
+		std::shared_ptr<const OccluderGeometry> occluder;
 	};
 
 }
\ No newline at end of file
@@ -3,17 +3,29 @@
 // 2025
 
 #include "RenderFlags.h"
+#include "gpu/StateCache.h"
 
 namespace vr {
 
 	void RenderFlags::apply() {
+		gpu::StateCache& state = gpu::StateCache::getInstance();
 		if (cullingEnable) {
-			glEnable(GL_CULL_FACE);
+			state.enable(GL_CULL_FACE);
 		} else {
-			glDisable(GL_CULL_FACE);
+			state.disable(GL_CULL_FACE);
 		}
 
-		glDepthFunc(depthFunc);
+		state.depthFunc(depthFunc);
+	}
+
+	void RenderFlags::record(gpu::CommandBuffer& commands) const {
+		if (cullingEnable) {
+			commands.enable(GL_CULL_FACE);
+		} else {
+			commands.disable(GL_CULL_FACE);
+		}
+
+		commands.depthFunc(depthFunc);
 	}
 
 }
\ No newline at end of file
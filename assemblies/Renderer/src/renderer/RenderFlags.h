@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "gpu/CommandBuffer.h"
+
 #include <glad/glad.h>
 
 namespace vr {
@@ -11,8 +13,10 @@ namespace vr {
 	struct RenderFlags {
 		bool cullingEnable = true;
 		GLenum depthFunc = GL_LESS;
+		float alphaCutoff = 0.0f; // Alpha masking threshold of the albedo map, 0 if opaque
 
 		void apply();
+		void record(gpu::CommandBuffer& commands) const;
 	};
 
 }
\ No newline at end of file
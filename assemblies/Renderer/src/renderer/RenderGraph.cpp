@@ -0,0 +1,394 @@
+// VR Renderer - Render Graph
+// Rodolphe VALICON
+// 2025
+
+#include "RenderGraph.h"
+
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace vr {
+
+	// Barrier an access waits on after image stores
+	static GLbitfield GetBarrierBit(RenderGraph::Access access) {
+		switch (access) {
+		case RenderGraph::Access::Sampled:
+			return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case RenderGraph::Access::Image:
+			return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case RenderGraph::Access::Attachment:
+			return GL_FRAMEBUFFER_BARRIER_BIT;
+		}
+		return GL_ALL_BARRIER_BITS;
+	}
+
+	static GLenum GetDepthAttachment(GLenum format) {
+		return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+	}
+
+	static std::shared_ptr<gpu::Texture> CreateTexture(const RenderGraph::TextureDesc& desc) {
+		const bool multisampled = desc.type == GL_TEXTURE_2D_MULTISAMPLE || desc.type == GL_TEXTURE_2D_MULTISAMPLE_ARRAY;
+		auto texture = multisampled ? std::make_shared<gpu::Texture>(desc.type) : std::make_shared<gpu::Texture>(desc.type, desc.sampler);
+
+		switch (desc.type) {
+		case GL_TEXTURE_2D:
+			glTextureStorage2D(*texture, desc.levels, desc.format, desc.width, desc.height);
+			break;
+		case GL_TEXTURE_2D_ARRAY:
+			glTextureStorage3D(*texture, desc.levels, desc.format, desc.width, desc.height, desc.layers);
+			break;
+		case GL_TEXTURE_2D_MULTISAMPLE:
+			glTextureStorage2DMultisample(*texture, desc.samples, desc.format, desc.width, desc.height, GL_TRUE);
+			break;
+		case GL_TEXTURE_2D_MULTISAMPLE_ARRAY:
+			glTextureStorage3DMultisample(*texture, desc.samples, desc.format, desc.width, desc.height, desc.layers, GL_TRUE);
+			break;
+		default:
+			logger::error("Render graph textures of type {} are not supported.", desc.type);
+			break;
+		}
+
+		return texture;
+	}
+
+	// === Builder ===
+
+	RenderGraph::Resource RenderGraph::Builder::create(const std::string& name, const TextureDesc& desc) {
+		m_graph.m_textures.push_back({ .name = name, .desc = desc });
+		m_graph.m_resources.push_back({ .texture = static_cast<uint32_t>(m_graph.m_textures.size() - 1) });
+		return static_cast<Resource>(m_graph.m_resources.size() - 1);
+	}
+
+	RenderGraph::Resource RenderGraph::Builder::read(Resource resource, Access access) {
+		const ResourceNode& node = m_graph.m_resources[resource];
+		const TextureNode& texture = m_graph.m_textures[node.texture];
+		if (node.producer == s_NO_PASS && !texture.imported)
+			logger::warn("Render graph pass '{}' reads '{}' before it is written.", m_graph.m_passes[m_pass].name, texture.name);
+
+		m_graph.m_passes[m_pass].reads.emplace_back(resource, access);
+		return resource;
+	}
+
+	RenderGraph::Resource RenderGraph::Builder::write(Resource resource, Access access) {
+		// The first write of a created texture produces it, later ones make a new version of it
+		Resource written = resource;
+		if (m_graph.m_resources[resource].producer != s_NO_PASS || m_graph.m_textures[m_graph.m_resources[resource].texture].imported) {
+			m_graph.m_resources.push_back({ .texture = m_graph.m_resources[resource].texture, .previous = resource });
+			written = static_cast<Resource>(m_graph.m_resources.size() - 1);
+		}
+
+		m_graph.m_resources[written].producer = m_pass;
+		m_graph.m_passes[m_pass].writes.emplace_back(written, access);
+		return written;
+	}
+
+	void RenderGraph::Builder::setSideEffect() {
+		m_graph.m_passes[m_pass].sideEffect = true;
+	}
+
+	// === Context ===
+
+	const gpu::Texture& RenderGraph::Context::getTexture(Resource resource) const {
+		return *m_graph.getPhysicalTexture(resource);
+	}
+
+	GLuint RenderGraph::Context::getFramebuffer(Resource color, Resource depth, int32_t layer) const {
+		const std::shared_ptr<gpu::Texture> colorTexture = color != s_NO_RESOURCE ? m_graph.getPhysicalTexture(color) : nullptr;
+		const std::shared_ptr<gpu::Texture> depthTexture = depth != s_NO_RESOURCE ? m_graph.getPhysicalTexture(depth) : nullptr;
+		const FramebufferKey key{ colorTexture ? static_cast<GLuint>(*colorTexture) : 0u, depthTexture ? static_cast<GLuint>(*depthTexture) : 0u, layer };
+
+		auto [entry, created] = m_graph.m_framebuffers.try_emplace(key);
+		CachedFramebuffer& cached = entry->second;
+		cached.used = true;
+		if (!created) return cached.framebuffer;
+
+		cached.color = colorTexture;
+		cached.depth = depthTexture;
+
+		const auto attach = [&](GLenum attachment, GLuint texture) {
+			if (layer < 0)
+				glNamedFramebufferTexture(cached.framebuffer, attachment, texture, 0);
+			else
+				glNamedFramebufferTextureLayer(cached.framebuffer, attachment, texture, 0, layer);
+		};
+
+		if (colorTexture) {
+			attach(GL_COLOR_ATTACHMENT0, *colorTexture);
+		} else {
+			glNamedFramebufferDrawBuffer(cached.framebuffer, GL_NONE);
+			glNamedFramebufferReadBuffer(cached.framebuffer, GL_NONE);
+		}
+
+		if (depthTexture)
+			attach(GetDepthAttachment(m_graph.getDesc(depth).format), *depthTexture);
+
+		if (glCheckNamedFramebufferStatus(cached.framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			logger::error("Render graph framebuffer is incomplete.");
+
+		return cached.framebuffer;
+	}
+
+	// === Graph ===
+
+	RenderGraph::Resource RenderGraph::import(const std::string& name, std::shared_ptr<gpu::Texture> texture, const TextureDesc& desc) {
+		m_textures.push_back({ .name = name, .desc = desc, .imported = std::move(texture) });
+		m_resources.push_back({ .texture = static_cast<uint32_t>(m_textures.size() - 1) });
+		return static_cast<Resource>(m_resources.size() - 1);
+	}
+
+	void RenderGraph::execute() {
+		cull();
+		sort();
+		place();
+
+		Context context(*this);
+		for (uint32_t index : m_order) {
+			PassNode& pass = m_passes[index];
+
+			// Image stores must be visible to any later access of the texture, writes included
+			GLbitfield barriers = 0;
+			const auto wait = [&](Resource resource, Access access) {
+				const auto pending = m_pendingBarriers.find(*getPhysicalTexture(resource));
+				if (pending != m_pendingBarriers.end())
+					barriers |= pending->second & GetBarrierBit(access);
+			};
+			for (const auto& [resource, access] : pass.reads)
+				wait(resource, access);
+			for (const auto& [resource, access] : pass.writes)
+				wait(resource, access);
+
+			// Barriers cover every previous store, not only the ones of the textures waited on
+			if (barriers) {
+				glMemoryBarrier(barriers);
+				for (auto& [texture, pending] : m_pendingBarriers)
+					pending &= ~barriers;
+			}
+
+			pass.execute(context);
+
+			for (const auto& [resource, access] : pass.writes) {
+				const GLuint texture = *getPhysicalTexture(resource);
+				if (access == Access::Image)
+					m_pendingBarriers[texture] = GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT;
+				else
+					m_pendingBarriers.erase(texture);
+			}
+		}
+
+		m_passes.clear();
+		m_order.clear();
+		m_resources.clear();
+		m_textures.clear();
+		releasePool();
+	}
+
+	size_t RenderGraph::GetMemorySize(const TextureDesc& desc) {
+		size_t texelSize = 4;
+		switch (desc.format) {
+		case GL_RGBA32F:
+			texelSize = 16;
+			break;
+		case GL_RGBA16F:
+		case GL_RG32F:
+		case GL_DEPTH32F_STENCIL8:
+			texelSize = 8;
+			break;
+		case GL_R16F:
+		case GL_RG8:
+		case GL_DEPTH_COMPONENT16:
+			texelSize = 2;
+			break;
+		case GL_R8:
+			texelSize = 1;
+			break;
+		}
+
+		size_t texels = 0;
+		for (int32_t level = 0; level < desc.levels; ++level)
+			texels += static_cast<size_t>(std::max(desc.width >> level, 1)) * std::max(desc.height >> level, 1);
+
+		return texels * texelSize * std::max(desc.layers, 1) * std::max(desc.samples, 1);
+	}
+
+	const std::shared_ptr<gpu::Texture>& RenderGraph::getPhysicalTexture(Resource resource) const {
+		const TextureNode& texture = m_textures[m_resources[resource].texture];
+		return texture.imported ? texture.imported : m_pool[texture.pooled].texture;
+	}
+
+	void RenderGraph::cull() {
+		for (PassNode& pass : m_passes) {
+			pass.culled = false;
+			pass.references = static_cast<uint32_t>(pass.writes.size());
+			for (const auto& [resource, access] : pass.reads)
+				++m_resources[resource].readers;
+		}
+
+		// Imported textures are read out of the graph, their versions are never unused
+		const auto isUnused = [&](Resource resource) {
+			const ResourceNode& node = m_resources[resource];
+			return node.readers == 0 && node.producer != s_NO_PASS && !m_textures[node.texture].imported;
+		};
+
+		std::vector<Resource> unused;
+		const auto cullPass = [&](PassNode& pass) {
+			pass.culled = true;
+			for (const auto& [resource, access] : pass.reads) {
+				--m_resources[resource].readers;
+				if (isUnused(resource))
+					unused.push_back(resource);
+			}
+		};
+
+		for (Resource resource = 0; resource < m_resources.size(); ++resource)
+			if (isUnused(resource))
+				unused.push_back(resource);
+		for (PassNode& pass : m_passes)
+			if (pass.references == 0 && !pass.sideEffect)
+				cullPass(pass);
+
+		// Passes are culled once none of their writes is read, which may leave their inputs unread in turn
+		while (!unused.empty()) {
+			PassNode& producer = m_passes[m_resources[unused.back()].producer];
+			unused.pop_back();
+			if (producer.culled || producer.sideEffect || --producer.references > 0) continue;
+			cullPass(producer);
+		}
+	}
+
+	void RenderGraph::sort() {
+		const uint32_t passCount = static_cast<uint32_t>(m_passes.size());
+		std::vector<std::vector<uint32_t>> successors(passCount);
+		std::vector<uint32_t> predecessors(passCount, 0);
+		const auto depend = [&](uint32_t before, uint32_t after) {
+			if (before == s_NO_PASS || before == after || m_passes[before].culled) return;
+			successors[before].push_back(after);
+			++predecessors[after];
+		};
+
+		// Reads wait for the producer of the version they read
+		std::vector<std::vector<uint32_t>> readers(m_resources.size());
+		for (uint32_t pass = 0; pass < passCount; ++pass) {
+			if (m_passes[pass].culled) continue;
+			for (const auto& [resource, access] : m_passes[pass].reads) {
+				readers[resource].push_back(pass);
+				depend(m_resources[resource].producer, pass);
+			}
+		}
+
+		// A new version overwrites the texture of the previous one, once it is written and read
+		for (uint32_t pass = 0; pass < passCount; ++pass) {
+			if (m_passes[pass].culled) continue;
+			for (const auto& [resource, access] : m_passes[pass].writes) {
+				const Resource previous = m_resources[resource].previous;
+				if (previous == s_NO_RESOURCE) continue;
+				depend(m_resources[previous].producer, pass);
+				for (uint32_t reader : readers[previous])
+					depend(reader, pass);
+			}
+		}
+
+		// Passes whose dependencies ran are executed in recording order
+		std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+		uint32_t executed = 0;
+		for (uint32_t pass = 0; pass < passCount; ++pass) {
+			if (m_passes[pass].culled) continue;
+			++executed;
+			if (predecessors[pass] == 0)
+				ready.push(pass);
+		}
+
+		m_order.clear();
+		while (!ready.empty()) {
+			const uint32_t pass = ready.top();
+			ready.pop();
+			m_order.push_back(pass);
+			for (uint32_t successor : successors[pass])
+				if (--predecessors[successor] == 0)
+					ready.push(successor);
+		}
+
+		if (m_order.size() != executed) {
+			logger::warn("Render graph passes depend on each other in a cycle, they are executed in recording order.");
+			m_order.clear();
+			for (uint32_t pass = 0; pass < passCount; ++pass)
+				if (!m_passes[pass].culled)
+					m_order.push_back(pass);
+		}
+	}
+
+	void RenderGraph::place() {
+		m_stats = Stats{ .passes = static_cast<uint32_t>(m_passes.size()) };
+		m_stats.culledPasses = static_cast<uint32_t>(m_passes.size() - m_order.size());
+
+		// Lifetimes of the textures over the execution order
+		for (uint32_t step = 0; step < m_order.size(); ++step) {
+			const PassNode& pass = m_passes[m_order[step]];
+			const auto extend = [&](Resource resource) {
+				TextureNode& texture = m_textures[m_resources[resource].texture];
+				texture.firstPass = std::min(texture.firstPass, step);
+				texture.lastPass = std::max(texture.lastPass, step);
+			};
+			for (const auto& [resource, access] : pass.reads)
+				extend(resource);
+			for (const auto& [resource, access] : pass.writes)
+				extend(resource);
+		}
+
+		for (PooledTexture& pooled : m_pool) {
+			pooled.used = false;
+			pooled.busyUntil = 0;
+		}
+
+		std::vector<uint32_t> transients;
+		for (uint32_t texture = 0; texture < m_textures.size(); ++texture)
+			if (!m_textures[texture].imported && m_textures[texture].firstPass != s_NO_PASS)
+				transients.push_back(texture);
+		std::stable_sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b) { return m_textures[a].firstPass < m_textures[b].firstPass; });
+
+		// OpenGL has no placed resources, a pooled texture is shared by transient textures with the same description
+		// whose lifetimes don't overlap. The pool is kept across frames, a stable frame doesn't allocate.
+		for (uint32_t index : transients) {
+			TextureNode& texture = m_textures[index];
+			const auto pooled = std::find_if(m_pool.begin(), m_pool.end(), [&](const PooledTexture& pooled) {
+				return pooled.desc == texture.desc && (!pooled.used || pooled.busyUntil < texture.firstPass);
+			});
+
+			if (pooled != m_pool.end()) {
+				texture.pooled = static_cast<uint32_t>(pooled - m_pool.begin());
+			} else {
+				texture.pooled = static_cast<uint32_t>(m_pool.size());
+				m_pool.push_back({ .desc = texture.desc, .texture = CreateTexture(texture.desc) });
+			}
+
+			PooledTexture& placed = m_pool[texture.pooled];
+			if (!placed.used) {
+				++m_stats.pooledTextures;
+				m_stats.pooledMemory += GetMemorySize(placed.desc);
+			}
+			placed.used = true;
+			placed.busyUntil = texture.lastPass;
+
+			++m_stats.transientTextures;
+			m_stats.transientMemory += GetMemorySize(texture.desc);
+		}
+	}
+
+	void RenderGraph::releasePool() {
+		for (PooledTexture& pooled : m_pool)
+			pooled.unusedFrames = pooled.used ? 0 : pooled.unusedFrames + 1;
+
+		std::erase_if(m_pool, [&](const PooledTexture& pooled) {
+			if (pooled.unusedFrames <= s_MAX_UNUSED_FRAMES) return false;
+			m_pendingBarriers.erase(*pooled.texture);
+			return true;
+		});
+
+		// Framebuffers are only kept while the textures they attach are used, so that released textures are deleted
+		std::erase_if(m_framebuffers, [](const auto& entry) { return !entry.second.used; });
+		for (auto& [key, cached] : m_framebuffers)
+			cached.used = false;
+	}
+
+}
@@ -0,0 +1,205 @@
+// VR Renderer - Render Graph
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/Framebuffer.h"
+#include "gpu/Sampler.h"
+#include "gpu/Texture.h"
+
+#include <glad/glad.h>
+
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Graph of the passes of a frame and of the textures they exchange.
+	/// Passes declare the textures they read and write when they are recorded, and are executed once the frame is
+	/// recorded. Passes whose results nothing reads are culled, the others are sorted on the versions of the textures
+	/// they exchange: a pass runs after the producers of what it reads, and a new version of a texture is written
+	/// after every access to the previous one. The recording order breaks the ties. The memory barriers a pass needs
+	/// are derived from the accesses of the previous ones, and transient textures whose lifetimes don't overlap share
+	/// the same pooled texture. Pooled textures outlive the frame, so that the next frames don't allocate them again.
+	class RenderGraph {
+	public:
+		using Resource = uint32_t;
+		static constexpr Resource s_NO_RESOURCE = ~0u;
+
+		/// @brief Access of a pass to a texture. Image stores are the only incoherent writes, later accesses wait for them.
+		enum class Access : uint32_t {
+			Sampled,	// Texture fetches
+			Image,		// Image loads and stores
+			Attachment,	// Framebuffer attachment, blit source or destination
+		};
+
+		struct TextureDesc {
+			GLenum type = GL_TEXTURE_2D;	// 2D or 2D array, multisampled or not
+			GLenum format = GL_RGBA16F;
+			int32_t width = 1;
+			int32_t height = 1;
+			int32_t layers = 1;
+			int32_t levels = 1;
+			int32_t samples = 1;
+			gpu::Sampler sampler{ GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };	// Ignored by multisampled textures
+
+			bool operator==(const TextureDesc& other) const = default;
+		};
+
+		struct Stats {
+			uint32_t passes = 0;
+			uint32_t culledPasses = 0;
+			uint32_t transientTextures = 0;
+			uint32_t pooledTextures = 0;	// Pooled textures the transient textures of the frame were placed in
+			size_t transientMemory = 0;		// Memory of the transient textures if each had its own, in bytes
+			size_t pooledMemory = 0;		// Memory of the pooled textures they were placed in, in bytes
+		};
+
+		/// @brief Declares the textures of a pass while it is recorded.
+		class Builder {
+		public:
+			/// @brief Creates a transient texture, it lives from its first write to its last read.
+			Resource create(const std::string& name, const TextureDesc& desc);
+
+			/// @return The resource read.
+			Resource read(Resource resource, Access access);
+
+			/// @return A new version of the resource, the later passes read it rather than the one written.
+			Resource write(Resource resource, Access access);
+
+			/// @brief Keeps the pass when nothing reads its results, e.g. when it presents or writes out of the graph.
+			void setSideEffect();
+
+		private:
+			friend class RenderGraph;
+			Builder(RenderGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+
+			RenderGraph& m_graph;
+			uint32_t m_pass;
+		};
+
+		/// @brief Provides the textures of a pass while it executes.
+		class Context {
+		public:
+			const gpu::Texture& getTexture(Resource resource) const;
+			const TextureDesc& getDesc(Resource resource) const { return m_graph.getDesc(resource); }
+
+			/// @brief Provides a framebuffer with a color and a depth attachment, either may be s_NO_RESOURCE.
+			/// @param layer Layer of array textures to attach, -1 attaches every layer.
+			GLuint getFramebuffer(Resource color, Resource depth = s_NO_RESOURCE, int32_t layer = -1) const;
+
+		private:
+			friend class RenderGraph;
+			Context(RenderGraph& graph) : m_graph(graph) {}
+
+			RenderGraph& m_graph;
+		};
+
+		/// @brief Adds a texture owned out of the graph. It is never placed in the pool, and passes writing it are never culled.
+		Resource import(const std::string& name, std::shared_ptr<gpu::Texture> texture, const TextureDesc& desc);
+
+		/// @brief Records a pass. The setup declares its textures in its data immediately, the execution runs with the graph.
+		/// @return The data of the pass, to read the resources it wrote.
+		template<typename Data>
+		const Data& addPass(const std::string& name, const std::function<void(Builder&, Data&)>& setup, std::function<void(const Data&, Context&)> execute) {
+			auto data = std::make_shared<Data>();
+			const uint32_t pass = static_cast<uint32_t>(m_passes.size());
+			m_passes.push_back({ .name = name });
+
+			Builder builder(*this, pass);
+			setup(builder, *data);
+			m_passes[pass].execute = [data, execute = std::move(execute)](Context& context) { execute(*data, context); };
+			return *data;
+		}
+
+		const TextureDesc& getDesc(Resource resource) const { return m_textures[m_resources[resource].texture].desc; }
+
+		/// @brief Culls, places and executes the recorded passes, then clears them for the next frame.
+		void execute();
+
+		const Stats& getStats() const { return m_stats; }
+
+		/// @brief Provides the memory a texture takes, in bytes.
+		static size_t GetMemorySize(const TextureDesc& desc);
+
+	private:
+		const std::shared_ptr<gpu::Texture>& getPhysicalTexture(Resource resource) const;
+		void cull();
+		void sort();
+		void place();
+		void releasePool();
+
+	private:
+		static constexpr uint32_t s_NO_PASS = ~0u;
+		static constexpr uint32_t s_MAX_UNUSED_FRAMES = 8;	// Frames a pooled texture is kept without being used
+
+		struct TextureNode {
+			std::string name;
+			TextureDesc desc;
+			std::shared_ptr<gpu::Texture> imported = nullptr;
+			uint32_t pooled = s_NO_PASS;	// Pooled texture holding a transient texture
+			uint32_t firstPass = s_NO_PASS;	// Steps of the execution order accessing the texture
+			uint32_t lastPass = 0;
+		};
+
+		// A version of a texture, written by a single pass
+		struct ResourceNode {
+			uint32_t texture;
+			uint32_t producer = s_NO_PASS;
+			uint32_t readers = 0;
+			Resource previous = s_NO_RESOURCE;	// Version the write replaced
+		};
+
+		struct PassNode {
+			std::string name;
+			std::function<void(Context&)> execute = nullptr;
+			std::vector<std::pair<Resource, Access>> reads = {};
+			std::vector<std::pair<Resource, Access>> writes = {};
+			bool sideEffect = false;
+			bool culled = false;
+			uint32_t references = 0;
+		};
+
+		struct PooledTexture {
+			TextureDesc desc;
+			std::shared_ptr<gpu::Texture> texture;
+			uint32_t busyUntil = 0;		// Last step of the transient textures placed in it this frame
+			bool used = false;
+			uint32_t unusedFrames = 0;
+		};
+
+		struct FramebufferKey {
+			GLuint color;
+			GLuint depth;
+			int32_t layer;
+
+			auto operator<=>(const FramebufferKey& other) const = default;
+		};
+
+		// Framebuffers keep their attachments alive, so that their names aren't reused while they are cached
+		struct CachedFramebuffer {
+			gpu::Framebuffer framebuffer;
+			std::shared_ptr<gpu::Texture> color;
+			std::shared_ptr<gpu::Texture> depth;
+			bool used = false;
+		};
+
+		std::vector<TextureNode> m_textures;
+		std::vector<ResourceNode> m_resources;
+		std::vector<PassNode> m_passes;
+		std::vector<uint32_t> m_order;	// Executed passes, in execution order
+
+		std::vector<PooledTexture> m_pool;
+		std::map<FramebufferKey, CachedFramebuffer> m_framebuffers;
+		std::unordered_map<GLuint, GLbitfield> m_pendingBarriers;	// Barriers the image stores to each texture still need, across frames
+		Stats m_stats;
+	};
+
+}
@@ -4,14 +4,62 @@
 
 #include "RenderTarget.h"
 
+#include "gpu/Extensions.h"
+
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace vr {
 
-	RenderTarget::RenderTarget(int32_t width, int32_t height, int32_t samples)
-		: m_width(width), m_height(height)
+	RenderTarget::RenderTarget(int32_t nominalWidth, int32_t nominalHeight, int32_t samples, int32_t layers, float maxScale)
+		: m_nominalWidth(nominalWidth), m_nominalHeight(nominalHeight), m_samples(samples), m_layers(layers),
+		m_viewportWidth(nominalWidth), m_viewportHeight(nominalHeight)
 	{
-		if (samples == 1) {
+		// Room for the viewports of scales above 1, the textures are never smaller than the nominal size
+		m_width = std::max(static_cast<int32_t>(std::ceil(nominalWidth * std::max(maxScale, 1.0f))), 1);
+		m_height = std::max(static_cast<int32_t>(std::ceil(nominalHeight * std::max(maxScale, 1.0f))), 1);
+		const int32_t width = m_width;
+		const int32_t height = m_height;
+
+		if (layers > 1) {
+			// One layer per view, drawn at once through a layered or multiview framebuffer
+			const GLenum textureType = samples == 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D_MULTISAMPLE_ARRAY;
+			m_color = std::make_shared<gpu::Texture>(textureType);
+			m_depthStencil = std::make_shared<gpu::Texture>(textureType);
+			if (samples == 1) {
+				glTextureStorage3D(*m_color, 1, GL_RGBA16F, width, height, layers);
+				glTextureParameteri(*m_color, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTextureParameteri(*m_color, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glTextureParameteri(*m_color, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTextureParameteri(*m_color, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+				glTextureStorage3D(*m_depthStencil, 1, GL_DEPTH24_STENCIL8, width, height, layers);
+				glTextureParameteri(*m_depthStencil, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTextureParameteri(*m_depthStencil, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			} else {
+				glTextureStorage3DMultisample(*m_color, samples, GL_RGBA16F, width, height, layers, GL_TRUE);
+				glTextureStorage3DMultisample(*m_depthStencil, samples, GL_DEPTH24_STENCIL8, width, height, layers, GL_TRUE);
+			}
+
+			if (gpu::isMultiviewSupported()) {
+				m_multiviewFramebuffer = std::make_unique<gpu::Framebuffer>();
+				gpu::framebufferTextureMultiview(*m_multiviewFramebuffer, GL_COLOR_ATTACHMENT0, *m_color, 0, layers);
+				gpu::framebufferTextureMultiview(*m_multiviewFramebuffer, GL_DEPTH_STENCIL_ATTACHMENT, *m_depthStencil, 0, layers);
+
+				// Some drivers don't take multisampled views, stereo then falls back to instancing
+				if (glCheckNamedFramebufferStatus(*m_multiviewFramebuffer, GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+					m_multiviewFramebuffer.reset();
+			}
+
+			// Single layer framebuffers, to resolve and read each view
+			m_layerFramebuffers.resize(layers);
+			for (int32_t layer = 0; layer < layers; ++layer) {
+				glNamedFramebufferTextureLayer(m_layerFramebuffers[layer], GL_COLOR_ATTACHMENT0, *m_color, 0, layer);
+				glNamedFramebufferTextureLayer(m_layerFramebuffers[layer], GL_DEPTH_STENCIL_ATTACHMENT, *m_depthStencil, 0, layer);
+			}
+		} else if (samples == 1) {
 			m_color = std::make_shared<gpu::Texture>(GL_TEXTURE_2D);
 			glTextureStorage2D(*m_color, 1, GL_RGBA16F, width, height);
 			glTextureParameteri(*m_color, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -19,19 +67,26 @@ namespace vr {
 			glTextureParameteri(*m_color, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTextureParameteri(*m_color, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-			m_depthStencil = std::make_shared<gpu::Renderbuffer>();
-			glNamedRenderbufferStorage(*m_depthStencil, GL_DEPTH24_STENCIL8, width, height);
+			m_depthStencil = std::make_shared<gpu::Texture>(GL_TEXTURE_2D);
+			glTextureStorage2D(*m_depthStencil, 1, GL_DEPTH24_STENCIL8, width, height);
+			glTextureParameteri(*m_depthStencil, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTextureParameteri(*m_depthStencil, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		} else {
 			m_color = std::make_shared<gpu::Texture>(GL_TEXTURE_2D_MULTISAMPLE);
 			glTextureStorage2DMultisample(*m_color, samples, GL_RGBA16F, width, height, GL_TRUE);
 
-			m_depthStencil = std::make_shared<gpu::Renderbuffer>();
-			glNamedRenderbufferStorageMultisample(*m_depthStencil, samples, GL_DEPTH24_STENCIL8, width, height);
+			m_depthStencil = std::make_shared<gpu::Texture>(GL_TEXTURE_2D_MULTISAMPLE);
+			glTextureStorage2DMultisample(*m_depthStencil, samples, GL_DEPTH24_STENCIL8, width, height, GL_TRUE);
 		}
 
 		m_framebuffer = gpu::Framebuffer();
 		glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0, *m_color, 0);
-		glNamedFramebufferRenderbuffer(m_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, *m_depthStencil);
+		glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, *m_depthStencil, 0);
+	}
+
+	void RenderTarget::setViewport(int32_t width, int32_t height) {
+		m_viewportWidth = std::clamp(width, 1, m_width);
+		m_viewportHeight = std::clamp(height, 1, m_height);
 	}
 
 }
\ No newline at end of file
@@ -6,31 +6,58 @@
 
 #include "gpu/Framebuffer.h"
 #include "gpu/Texture.h"
-#include "gpu/Renderbuffer.h"
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace vr {
 
 	class RenderTarget {
 	public:
-		RenderTarget(int32_t width, int32_t height, int32_t samples = 1);
+		/// @param layers Views of the target, more than one makes array textures for stereo rendering.
+		/// @param maxScale Largest resolution scale drawn in the target, its textures are the size times this scale.
+		RenderTarget(int32_t width, int32_t height, int32_t samples = 1, int32_t layers = 1, float maxScale = 1.0f);
 
+		/// @brief Framebuffer of the whole target, layered when the target has several layers.
 		const gpu::Framebuffer& getFramebuffer() const { return m_framebuffer; }
+		/// @brief Framebuffer broadcasting draws to every layer with OVR_multiview, 0 when unsupported or single layer.
+		GLuint getMultiviewFramebuffer() const { return m_multiviewFramebuffer ? static_cast<GLuint>(*m_multiviewFramebuffer) : 0; }
+		/// @brief Framebuffer of a single layer, the target framebuffer itself when single layer.
+		GLuint getLayerFramebuffer(int32_t layer) const { return m_layers > 1 ? static_cast<GLuint>(m_layerFramebuffers[layer]) : static_cast<GLuint>(m_framebuffer); }
 		std::shared_ptr<gpu::Texture> getColorTexture() const { return m_color; }
-		std::shared_ptr<gpu::Renderbuffer> getDepthStencilBuffer() const { return m_depthStencil; }
+		std::shared_ptr<gpu::Texture> getDepthStencilTexture() const { return m_depthStencil; }
 
+		/// @brief Restricts drawing to a region from the origin, so that the resolution changes without reallocation.
+		void setViewport(int32_t width, int32_t height);
+		int32_t getViewportWidth() const { return m_viewportWidth; }
+		int32_t getViewportHeight() const { return m_viewportHeight; }
+
+		/// @brief Size of the frames at a resolution scale of 1, the default viewport.
+		int32_t getNominalWidth() const { return m_nominalWidth; }
+		int32_t getNominalHeight() const { return m_nominalHeight; }
+
+		/// @brief Allocated size of the textures.
 		int32_t getWidth() const { return m_width; }
 		int32_t getHeight() const { return m_height; }
+		int32_t getSamples() const { return m_samples; }
+		int32_t getLayers() const { return m_layers; }
 
 	private:
 		gpu::Framebuffer m_framebuffer;
+		std::unique_ptr<gpu::Framebuffer> m_multiviewFramebuffer;
+		std::vector<gpu::Framebuffer> m_layerFramebuffers;
 		std::shared_ptr<gpu::Texture> m_color;
-		std::shared_ptr<gpu::Renderbuffer> m_depthStencil;
+		std::shared_ptr<gpu::Texture> m_depthStencil;	// A texture so that depth can be read back by compute passes
 
+		int32_t m_nominalWidth;
+		int32_t m_nominalHeight;
 		int32_t m_width;
 		int32_t m_height;
+		int32_t m_samples;
+		int32_t m_layers;
+		int32_t m_viewportWidth;	// Region in use, the whole target by default
+		int32_t m_viewportHeight;
 	};
 
 }
\ No newline at end of file
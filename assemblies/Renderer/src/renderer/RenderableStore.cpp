@@ -0,0 +1,79 @@
+// VR Renderer - Renderable Store
+// Rodolphe VALICON
+// 2025
+
+#include "RenderableStore.h"
+
+#include <algorithm>
+
+namespace vr {
+
+	bool RenderableStore::sync(const SceneSnapshot& scene) {
+		if (m_layout && scene.layout->revision == m_layout->revision) return false;
+
+		// Gather the renderables of every archetype, in entity order
+		struct Entry {
+			uint32_t transform;
+			uint32_t primitive;
+			const MaterialInstance* material;
+			const gpu::VertexArray* geometry;
+		};
+
+		const EntityStore::Layout& layout = *scene.layout;
+		const uint32_t count = layout.getRenderableCount();
+		std::array<std::vector<Entry>, s_ARCHETYPE_COUNT> entries;
+		for (uint32_t r = 0; r < count; ++r)
+			entries[layout.flags[r]].push_back(Entry{ layout.entities[r], r, layout.materials[r], layout.geometries[r] });
+
+		// Pack each archetype, sorted by material, geometry then entity
+		m_locations.resize(count);
+		uint32_t first = 0;
+		for (uint32_t flags = 0; flags < s_ARCHETYPE_COUNT; ++flags) {
+			std::vector<Entry>& archetypeEntries = entries[flags];
+			std::stable_sort(archetypeEntries.begin(), archetypeEntries.end(), [](const Entry& a, const Entry& b) {
+				if (a.material != b.material)
+					return a.material < b.material;
+				if (a.geometry != b.geometry)
+					return a.geometry < b.geometry;
+				return a.transform < b.transform;
+			});
+
+			Archetype& archetype = m_archetypes[flags];
+			archetype = Archetype{};
+			archetype.flags = flags;
+			archetype.first = first;
+			first += static_cast<uint32_t>(archetypeEntries.size());
+			archetype.transforms.reserve(archetypeEntries.size());
+			archetype.primitives.reserve(archetypeEntries.size());
+			archetype.drawCalls.reserve(archetypeEntries.size());
+			archetype.geometries.reserve(archetypeEntries.size());
+			archetype.materials.reserve(archetypeEntries.size());
+			archetype.occluders.reserve(archetypeEntries.size());
+
+			for (const Entry& entry : archetypeEntries) {
+				gpu::VertexArray& vertexArray = *layout.geometries[entry.primitive];
+				m_locations[entry.primitive] = Location{ flags, static_cast<uint32_t>(archetype.size()) };
+
+				archetype.transforms.push_back(entry.transform);
+				archetype.primitives.push_back(entry.primitive);
+				archetype.drawCalls.push_back(DrawCall{ vertexArray, vertexArray.getTopology(), static_cast<GLsizei>(vertexArray.getElementCount()) });
+				archetype.geometries.push_back(&vertexArray);
+				archetype.materials.push_back(layout.materials[entry.primitive]);
+				archetype.occluders.push_back(layout.occluders[entry.primitive]);
+			}
+		}
+
+		m_layout = scene.layout;
+		++m_revision;
+		return true;
+	}
+
+	RenderableStore::Location RenderableStore::locateObject(uint32_t object) const {
+		uint32_t flags = 0;
+		while (flags + 1 < s_ARCHETYPE_COUNT && object >= m_archetypes[flags + 1].first)
+			++flags;
+
+		return Location{ flags, object - m_archetypes[flags].first };
+	}
+
+}
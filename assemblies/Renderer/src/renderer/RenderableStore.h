@@ -0,0 +1,86 @@
+// VR Renderer - Renderable Store
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/MaterialInstance.h"
+#include "renderer/OccluderGeometry.h"
+#include "renderer/SceneSnapshot.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Draw order of the renderables of a scene entity store, one renderable per primitive.
+	/// Renderables are grouped by archetype, the set of flags a pass filters on, and each archetype stores its
+	/// components in contiguous arrays. Passes iterate the archetypes they need without any pointer chasing,
+	/// and renderables are sorted by material then geometry inside an archetype to limit state changes, and so that
+	/// the repeated geometries of a material are neighbours that can be drawn as instances.
+	/// Each renderable also has an object index, its rank over all archetypes, used to address per-object GPU data.
+	/// Handles are borrowed from the layout of the last sync, which the store holds until the next one.
+	class RenderableStore {
+	public:
+		enum Flags : uint32_t {
+			Static = EntityStore::Static,			// Shadows are cached
+			AlphaMasked = EntityStore::AlphaMasked,	// Needs the albedo alpha in depth passes
+		};
+
+		static constexpr uint32_t s_ARCHETYPE_COUNT = 4;
+
+		struct DrawCall {
+			GLuint vertexArray;
+			GLenum topology;
+			GLsizei elementCount;
+		};
+
+		struct Archetype {
+			uint32_t flags = 0;
+			uint32_t first = 0;	// Object index of the first renderable, objects follow the archetypes order
+			std::vector<uint32_t> transforms;	// Entity index, also its transform node
+			std::vector<uint32_t> primitives;	// Renderable index in the entity store, to look up bounds and visibility
+			std::vector<DrawCall> drawCalls;
+			std::vector<gpu::VertexArray*> geometries;	// Source of the draw calls, for the passes merging geometry
+			std::vector<MaterialInstance*> materials;
+			std::vector<const OccluderGeometry*> occluders;
+
+			size_t size() const { return drawCalls.size(); }
+		};
+
+		struct Location {
+			uint32_t archetype;
+			uint32_t index;
+		};
+
+		/// @brief Rebuilds the store if the layout of the entity store was edited since the last sync.
+		/// @return true if the store was rebuilt.
+		bool sync(const SceneSnapshot& scene);
+
+		const std::array<Archetype, s_ARCHETYPE_COUNT>& getArchetypes() const { return m_archetypes; }
+		const Archetype& getArchetype(uint32_t flags) const { return m_archetypes[flags]; }
+
+		/// @brief Finds a renderable from its index in the entity store.
+		const Location& locate(uint32_t primitive) const { return m_locations[primitive]; }
+
+		/// @brief Finds a renderable from its object index.
+		Location locateObject(uint32_t object) const;
+
+		uint32_t getCount() const { return static_cast<uint32_t>(m_locations.size()); }
+
+		/// @brief Provides a counter incremented by every rebuild, for derived data to detect they are outdated.
+		uint64_t getRevision() const { return m_revision; }
+
+	private:
+		std::array<Archetype, s_ARCHETYPE_COUNT> m_archetypes;
+		std::vector<Location> m_locations;
+		uint64_t m_revision = 0;
+
+		std::shared_ptr<const EntityStore::Layout> m_layout;	// Layout of the last sync
+	};
+
+}
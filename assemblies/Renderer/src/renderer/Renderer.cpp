@@ -4,47 +4,135 @@
 
 #include "Renderer.h"
 
+#include "core/Logger.h"
+#include "gpu/Extensions.h"
+#include "gpu/StateCache.h"
 #include "gpu/VertexLayout.h"
+#include "renderer/Frustum.h"
 #include "renderer/MaterialRegistry.h"
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
 namespace vr {
+	std::unique_ptr<JobSystem> Renderer::s_jobSystem;
 	std::unique_ptr<gpu::VertexArray> Renderer::s_renderVertexArray;
-	std::unique_ptr<RenderTarget> Renderer::s_intermediateTarget;
+	glm::ivec2 Renderer::s_screenSize{ 1 };
 	std::unique_ptr<gpu::ShaderProgram> Renderer::s_shadowMapShader;
 	std::unique_ptr<gpu::ShaderProgram> Renderer::s_shadowCubeMapShader;
+	std::unique_ptr<gpu::ShaderProgram> Renderer::s_shadowCubeMapLayeredShader;
+	std::unique_ptr<gpu::ShaderProgram> Renderer::s_lightClusterShader;
+	std::array<std::unique_ptr<gpu::ShaderProgram>, static_cast<size_t>(StereoMode::Count) * 2> Renderer::s_depthShaders;
+	std::array<std::unique_ptr<gpu::ShaderProgram>, static_cast<size_t>(StereoMode::Count) * 2> Renderer::s_depthMaskedShaders;
+	Renderer::PassUniforms Renderer::s_passUniforms;
+
+	static constexpr float s_CUBE_SHADOW_FAR = 100.0f;
+	static constexpr uint32_t s_POINT_UNIT = 1u << 31;	// Shadow unit keys are the light index and face or cascade, flagged for point lights
+
+	// Index of the depth pre-pass shaders of a stereo mode and foveation.
+	static size_t DepthShaderIndex(StereoMode stereo, bool foveated) {
+		return static_cast<size_t>(stereo) * 2 + foveated;
+	}
+
+	// Description of the color or depth of a target, to import it in the frame graph.
+	static RenderGraph::TextureDesc DescribeTarget(const RenderTarget& target, GLenum format) {
+		const bool multisampled = target.getSamples() > 1;
+		GLenum type = multisampled ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+		if (target.getLayers() > 1)
+			type = multisampled ? GL_TEXTURE_2D_MULTISAMPLE_ARRAY : GL_TEXTURE_2D_ARRAY;
+
+		return {
+			.type = type,
+			.format = format,
+			.width = target.getWidth(),
+			.height = target.getHeight(),
+			.layers = target.getLayers(),
+			.samples = target.getSamples(),
+		};
+	}
+
+	// View-projections and culling frusta of the 6 faces of a point light shadow cube map.
+	struct CubeShadowView {
+		glm::mat4 viewProjs[6];
+		Frustum frusta[6];
+	};
+
+	static CubeShadowView ComputeCubeShadowView(const glm::vec3& position) {
+		static const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, s_CUBE_SHADOW_FAR);
+
+		CubeShadowView view;
+		view.viewProjs[0] = projection * glm::lookAt(position, position + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+		view.viewProjs[1] = projection * glm::lookAt(position, position + glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+		view.viewProjs[2] = projection * glm::lookAt(position, position + glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f, 1.0f));
+		view.viewProjs[3] = projection * glm::lookAt(position, position + glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f,-1.0f));
+		view.viewProjs[4] = projection * glm::lookAt(position, position + glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+		view.viewProjs[5] = projection * glm::lookAt(position, position + glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+
+		for (uint32_t face = 0; face < 6; ++face)
+			view.frusta[face] = Frustum(view.viewProjs[face]);
+
+		return view;
+	}
+
+	// Bounds of the volume lit through a cube face, the light pyramid clipped to its influence radius.
+	static AABB ComputeCubeFaceBounds(const glm::vec3& position, float radius, uint32_t face) {
+		AABB bounds{ position - radius, position + radius };
+		const uint32_t axis = face / 2;
+		if (face % 2 == 0)
+			bounds.min[axis] = position[axis];
+		else
+			bounds.max[axis] = position[axis];
+
+		return bounds;
+	}
+
+	// Rough share of the screen a light influence sphere covers.
+	static float ComputeScreenInfluence(const Frustum& cameraFrustum, const glm::vec3& eyePosition, const glm::vec3& position, float radius) {
+		// Lights out of view still cast shadows in view, they are only less important
+		static constexpr float minInfluence = 0.05f;
+		if (!cameraFrustum.intersects(AABB{ position - radius, position + radius }))
+			return minInfluence;
+
+		const float distance = glm::length(position - eyePosition);
+		return glm::clamp(radius / glm::max(distance, radius), minInfluence, 1.0f);
+	}
 
 	Renderer::Renderer(std::weak_ptr<RenderTarget> target) : m_target(target) {
 		
-		// Prepare scene matrices and matrix buffer
-		m_matrixBuffer = gpu::Buffer(sizeof(Matrices), GL_DYNAMIC_DRAW);
-		m_directionalLightBuffer = gpu::Buffer(sizeof(DirectionalLight), GL_DYNAMIC_DRAW);
-		m_pointLightBuffer = gpu::Buffer(sizeof(PointLight), GL_DYNAMIC_DRAW);
-		m_matrices = {};
-
-		// Prepare shadow map and cubemap texture arrays and framebuffer
-		gpu::Sampler sampler;
-		sampler.magFilter = GL_LINEAR;
-		sampler.minFilter = GL_LINEAR;
-		sampler.wrapS = GL_CLAMP_TO_BORDER;
-		sampler.wrapT = GL_CLAMP_TO_BORDER;
-		sampler.wrapR = GL_CLAMP_TO_BORDER;
-		
-		m_shadowMap = std::make_unique<gpu::Texture>(GL_TEXTURE_2D_ARRAY, sampler);
-		float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-		glTextureParameterfv(*m_shadowMap, GL_TEXTURE_BORDER_COLOR, borderColor);
-		glTextureStorage3D(*m_shadowMap, 1, GL_DEPTH_COMPONENT32F, m_SHADOW_SIZE, m_SHADOW_SIZE, m_MAX_SHADOW);
-
-		m_shadowCubeMap = std::make_unique<gpu::Texture>(GL_TEXTURE_CUBE_MAP_ARRAY, sampler);
-		glTextureParameterfv(*m_shadowCubeMap, GL_TEXTURE_BORDER_COLOR, borderColor);
-		glTextureStorage3D(*m_shadowCubeMap, 1, GL_DEPTH_COMPONENT32F, m_SHADOW_SIZE / 4, m_SHADOW_SIZE / 4, m_MAX_SHADOW * 6);
+		// Prepare the per-frame uniform ring buffer
+		m_uniformRing = gpu::RingBuffer(64 * 1024);
+		m_emptyBuffer = gpu::Buffer(0, GL_STATIC_DRAW);
+		m_sceneData = {};
 
+		// Prepare the light cluster grid, each cluster holds a fixed capacity light list. Stereo frames have a grid per eye.
+		const uint32_t clusterCount = m_CLUSTER_GRID.x * m_CLUSTER_GRID.y * m_CLUSTER_GRID.z;
+		m_clusterData = {};
+		m_clusterData.gridSize = glm::uvec4(m_CLUSTER_GRID, clusterCount);
+		m_clusterCounts = gpu::Buffer(s_MAX_VIEWS * clusterCount * sizeof(uint32_t), GL_DYNAMIC_COPY);
+		m_clusterLights = gpu::Buffer(s_MAX_VIEWS * clusterCount * m_CLUSTER_MAX_LIGHTS * sizeof(uint32_t), GL_DYNAMIC_COPY);
 
+		// The shadow atlas is sized on the first frame, from the lights to shadow
 		m_shadowFramebuffer = std::make_unique<gpu::Framebuffer>();
+
+		for (gpu::Query& timer : m_shadowTimers)
+			timer = gpu::Query(GL_TIME_ELAPSED);
+
+		for (uint32_t i = 0; i < m_prepassQueries.size(); ++i) {
+			m_prepassQueries[i] = gpu::Query(GL_FRAGMENT_SHADER_INVOCATIONS);
+			m_shadingQueries[i] = gpu::Query(GL_FRAGMENT_SHADER_INVOCATIONS);
+		}
+
+		m_occlusionCuller = std::make_unique<OcclusionCuller>(*s_jobSystem);
+		m_gpuCuller = std::make_unique<GpuCuller>();
 	}
 
 	void Renderer::init(int32_t width, int32_t height) {
+		s_jobSystem = std::make_unique<JobSystem>();
+
 		// Prepare rendering quad
 		float quadVertices[] = {
 			-1.0f, -1.0f, 0.0f, 0.0f,
@@ -66,190 +154,1301 @@ namespace vr {
 		s_renderVertexArray = std::make_unique<gpu::VertexArray>(quadGeometry);
 		s_shadowMapShader = std::make_unique<gpu::ShaderProgram>("res/shaders/renderpasses/shadowMap.glsl");
 		s_shadowCubeMapShader = std::make_unique<gpu::ShaderProgram>("res/shaders/renderpasses/shadowCubeMap.glsl");
+		s_passUniforms.lightViewProj = s_shadowMapShader->getUniform<glm::mat4>("uLightViewProj");
+		s_passUniforms.cubeViewProj = s_shadowCubeMapShader->getUniform<glm::mat4>("uLightViewProj");
+		s_passUniforms.cubeLightIndex = s_shadowCubeMapShader->getUniform<uint32_t>("uLightIndex");
+		s_lightClusterShader = std::make_unique<gpu::ShaderProgram>("res/shaders/renderpasses/lightClusters.glsl");
+		// Depth passes of the stereo paths and foveation the context supports
+		auto loadDepthShaders = [](StereoMode mode, bool foveated) {
+			static const char* stereoDefines[] = { nullptr, "STEREO_MULTIVIEW", "STEREO_INSTANCED" };
+			std::vector<std::string> defines;
+			if (stereoDefines[static_cast<size_t>(mode)])
+				defines.emplace_back(stereoDefines[static_cast<size_t>(mode)]);
+			if (foveated)
+				defines.emplace_back("FOVEATED");
+
+			const size_t index = DepthShaderIndex(mode, foveated);
+			s_depthShaders[index] = std::make_unique<gpu::ShaderProgram>("res/shaders/renderpasses/depth.glsl", defines);
+			s_depthMaskedShaders[index] = std::make_unique<gpu::ShaderProgram>("res/shaders/renderpasses/depthMasked.glsl", defines);
+			s_passUniforms.alphaCutoff[index] = s_depthMaskedShaders[index]->getUniform<float>("uAlphaCutoff");
+		};
+
+		loadDepthShaders(StereoMode::Mono, false);
+		if (gpu::isMultiviewSupported())
+			loadDepthShaders(StereoMode::Multiview, false);
+
+		// Layered cube shadows, instanced stereo and foveation need to select the layer or viewport from the vertex shader.
+		if (gpu::isExtensionSupported("GL_ARB_shader_viewport_layer_array")) {
+			s_shadowCubeMapLayeredShader = std::make_unique<gpu::ShaderProgram>("res/shaders/renderpasses/shadowCubeMapLayered.glsl");
+			s_passUniforms.layeredViewProj = s_shadowCubeMapLayeredShader->getUniform<glm::mat4>("uLightViewProj");
+			s_passUniforms.layeredFaces = s_shadowCubeMapLayeredShader->getUniform<uint32_t>("uFaces");
+			s_passUniforms.layeredLightIndex = s_shadowCubeMapLayeredShader->getUniform<uint32_t>("uLightIndex");
+			loadDepthShaders(StereoMode::Instanced, false);
+			loadDepthShaders(StereoMode::Mono, true);
+			loadDepthShaders(StereoMode::Instanced, true);
+			if (gpu::isMultiviewSupported())
+				loadDepthShaders(StereoMode::Multiview, true);
+		} else {
+			logger::warn("GL_ARB_shader_viewport_layer_array is not supported, point light shadows are rendered face by face.");
+			if (!gpu::isMultiviewSupported())
+				logger::warn("Neither OVR_multiview nor GL_ARB_shader_viewport_layer_array are supported, stereo frames only render the left eye.");
+			logger::warn("Foveated rendering is not supported.");
+		}
 
 		adapt(width, height);
 	}
 
 	void Renderer::adapt(int32_t width, int32_t height) {
-		s_intermediateTarget = std::make_unique<RenderTarget>(width, height);
+		s_screenSize = { width, height };
+	}
+
+	bool Renderer::beginFrame() {
+		m_reprojection.getSettings() = m_settings.reprojection;
+		return m_reprojection.beginFrame();
 	}
 
 	void Renderer::beginScene(const Camera& camera) {
-		if (auto target = m_target.lock()) {
-			m_matrices.eyePosition = camera.eyePos;
-			m_matrices.viewTransform = camera.getViewMatrix();
-			m_matrices.projectionTransform = camera.getProjectionMatrix();
-			glNamedBufferSubData(m_matrixBuffer, 0, sizeof(Matrices), &m_matrices);
+		beginViews(std::span<const Camera>(&camera, 1), camera);
+	}
+
+	void Renderer::beginScene(const Camera& left, const Camera& right) {
+		// Move the eyes midpoint back until its frustum encloses both eye frusta, their apexes are half the
+		// eye separation apart. Near and far planes are pushed back by the same distance.
+		const float halfSeparation = 0.5f * glm::length(right.eyePos - left.eyePos);
+		const float tanX = std::tan(0.5f * glm::radians(left.fovy)) * left.aspect;
+		m_cullingOffset = halfSeparation / std::max(tanX, 1e-4f);
+
+		Camera cullingCamera = left;
+		cullingCamera.eyePos = 0.5f * (left.eyePos + right.eyePos) - glm::normalize(left.forward) * m_cullingOffset;
+		cullingCamera.zNear = left.zNear + m_cullingOffset;
+		cullingCamera.zFar = left.zFar + m_cullingOffset;
+
+		const Camera views[] = { left, right };
+		beginViews(views, cullingCamera);
+	}
+
+	void Renderer::beginViews(std::span<const Camera> views, const Camera& cullingCamera) {
+		auto target = m_target.lock();
+		if (!target) return;
+
+		// Stereo needs a layer per eye, and a way to reach the second one in the same pass
+		m_stereoMode = StereoMode::Mono;
+		if (views.size() > 1 && target->getLayers() >= static_cast<int32_t>(s_MAX_VIEWS)) {
+			if (m_settings.multiview && target->getMultiviewFramebuffer() && s_depthShaders[DepthShaderIndex(StereoMode::Multiview, false)])
+				m_stereoMode = StereoMode::Multiview;
+			else if (s_depthShaders[DepthShaderIndex(StereoMode::Instanced, false)])
+				m_stereoMode = StereoMode::Instanced;
+		}
+
+		// Foveated views are drawn in the regions of a packed target, with the layers and samples of the target
+		m_foveated = m_settings.foveation.enabled && s_depthShaders[DepthShaderIndex(m_stereoMode, true)];
+		const RenderTarget* viewTarget = target.get();
+		if (m_foveated) {
+			m_foveation.getSettings() = m_settings.foveation;
+			m_foveation.prepare(*target);
+			viewTarget = &m_foveation.getTarget();
+		}
 
-			glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_matrixBuffer);
+		// The scale of the previous frames holds for the whole frame, the target keeps its size
+		m_dynamicResolution.getSettings() = m_settings.dynamicResolution;
+		const float scale = m_foveated ? 1.0f : m_dynamicResolution.update();
+		target->setViewport(static_cast<int32_t>(std::lround(target->getNominalWidth() * scale)), static_cast<int32_t>(std::lround(target->getNominalHeight() * scale)));
+		m_dynamicResolution.begin();
 
+		m_reprojection.beginScene();
+		m_viewCount = m_stereoMode == StereoMode::Mono ? 1 : s_MAX_VIEWS;
+		m_instanceViews = (m_stereoMode == StereoMode::Instanced ? m_viewCount : 1) * (m_foveated ? Foveation::s_REGION_COUNT : 1);
+		m_viewFramebuffer = m_stereoMode == StereoMode::Multiview ? viewTarget->getMultiviewFramebuffer() : static_cast<GLuint>(viewTarget->getFramebuffer());
+		m_camera = m_viewCount > 1 ? cullingCamera : views[0];
+		if (m_viewCount == 1)
+			m_cullingOffset = 0.0f;
+
+		for (uint32_t v = 0; v < s_MAX_VIEWS; ++v) {
+			const Camera& camera = views[std::min(v, m_viewCount - 1)];
+			m_sceneData.eyePositions[v] = glm::vec4(camera.eyePos, 1.0f);
+			m_sceneData.viewTransforms[v] = camera.getViewMatrix();
+			m_sceneData.projectionTransforms[v] = camera.getProjectionMatrix();
+			m_clusterData.inverseProjections[v] = glm::inverse(m_sceneData.projectionTransforms[v]);
+		}
+		for (uint32_t region = 0; region < Foveation::s_REGION_COUNT; ++region)
+			m_sceneData.regions[region] = m_foveated ? m_foveation.getRegionTransform(region) : glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+		m_sceneData.viewCount = m_viewCount;
+
+		// Exponential depth slices, so that clusters keep a similar shape along the view
+		const Camera& camera = views[0];
+		const float sliceScale = m_CLUSTER_GRID.z / std::log(camera.zFar / camera.zNear);
+		m_clusterData.depthParams = { camera.zNear, camera.zFar, sliceScale, -sliceScale * std::log(camera.zNear) };
+		m_clusterData.screenSize = { target->getViewportWidth(), target->getViewportHeight() };
+
+		// Layered framebuffers clear every layer
+		if (m_foveated) {
+			m_foveation.clear();
+		} else {
 			glBindFramebuffer(GL_FRAMEBUFFER, target->getFramebuffer());
 			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 			glClearDepth(1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-			glEnable(GL_DEPTH_TEST);
-
-			glViewport(0, 0, target->getWidth(), target->getHeight());
 		}
-	}
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.enable(GL_DEPTH_TEST);
 
-	void Renderer::submit(const Scene& scene) {
-		// Upload and bind scene light
-		int32_t dirLightCap;
-		glGetNamedBufferParameteriv(m_directionalLightBuffer, GL_BUFFER_SIZE, &dirLightCap);
-		dirLightCap /= sizeof(DirectionalLight);
+		bindViews();
+	}
 
-		int32_t dirLightCount = static_cast<int32_t>(scene.directionalLights.size());
-		if (dirLightCap != dirLightCount) {
-			// Reallocate buffer to match light count
-			m_directionalLightBuffer = gpu::Buffer(dirLightCount * sizeof(DirectionalLight), GL_DYNAMIC_DRAW);
+	void Renderer::bindViews() const {
+		glBindFramebuffer(GL_FRAMEBUFFER, m_viewFramebuffer);
+		if (m_foveated) {
+			m_foveation.bindViewports();
+		} else if (auto target = m_target.lock()) {
+			glViewport(0, 0, target->getViewportWidth(), target->getViewportHeight());
 		}
+	}
 
-		glNamedBufferSubData(m_directionalLightBuffer, 0, dirLightCount * sizeof(DirectionalLight), scene.directionalLights.data());
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_directionalLightBuffer);
+	void Renderer::submit(const SceneSnapshot& scene) {
+		const auto start = std::chrono::steady_clock::now();
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		m_stats.drawCalls = 0;
+		m_stats.instances = 0;
 
-		int32_t ptLightCap;
+		// Upload scene, object and light data for every pass of the frame
+		syncTransforms(scene);
+		m_renderables.sync(scene);
+		uploadFrameData(scene);
+		if (m_settings.gpuCulling)
+			cullPrimitivesOnGpu();
+		else
+			cullPrimitives(scene);
 
-		int32_t ptLightCount = static_cast<int32_t>(scene.pointLights.size());
-		glGetNamedBufferParameteriv(m_pointLightBuffer, GL_BUFFER_SIZE, &ptLightCap);
-		ptLightCap /= sizeof(PointLight);
-		if (ptLightCap != ptLightCount) {
-			// Reallocate buffer to match light count
-			m_pointLightBuffer = gpu::Buffer(ptLightCount * sizeof(PointLight), GL_DYNAMIC_DRAW);
-		}
+		// Light clustering pass
+		buildLightClusters();
 
-		glNamedBufferSubData(m_pointLightBuffer, 0, ptLightCount * sizeof(PointLight), scene.pointLights.data());
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_pointLightBuffer);
+		// Model passes are recorded by the workers along with the shadow passes
+		if (!m_settings.gpuCulling)
+			addModelRecorders();
 
 		// Shadow Pass
 		renderShadowMap(scene);
-		glBindTextureUnit(1, *m_shadowMap);
-		glBindTextureUnit(2, *m_shadowCubeMap);
+		state.bindTextureUnit(1, m_shadowAtlas.getTexture());
 
-		if (auto target = m_target.lock()) {
-			glBindFramebuffer(GL_FRAMEBUFFER, target->getFramebuffer());
-			glViewport(0, 0, target->getWidth(), target->getHeight());
-		}
+		bindViews();
 		
 		// Bind skybox environment map
 		if (scene.skybox)
-			glBindTextureUnit(0, scene.skybox->getCubeMap());
+			state.bindTextureUnit(0, scene.skybox->getCubeMap());
+
+		// Depth pre-pass, so that only visible fragments are shaded
+		readStatistics();
+		if (m_settings.depthPrepass && m_settings.gpuCulling)
+			renderDepthPrepassIndirect();
+		else if (m_settings.depthPrepass)
+			renderDepthPrepass();
 
 		// Model Pass
-		for (auto& mesh : scene.meshes) {
-			m_matrices.modelTransform = mesh->transform.getModelMatrix();
-			m_matrices.normalTransform = mesh->transform.getNormalMatrix();
-			glNamedBufferSubData(m_matrixBuffer, 0, sizeof(Matrices), &m_matrices);
+		if (m_settings.depthPrepass)
+			state.depthMask(GL_FALSE);
 
-			for (const Primitive& primitive : mesh->primitives) {
-				primitive.material->use();
-				glBindVertexArray(*primitive.vertexArray);
-				glDrawElements(primitive.vertexArray->getTopology(), primitive.vertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
-			}
-		}
+		m_shadingQueries[m_statsIndex].begin();
+		if (m_settings.gpuCulling)
+			renderModelsIndirect();
+		else
+			renderModels();
+		m_shadingQueries[m_statsIndex].end();
+		m_statsIndex = (m_statsIndex + 1) % m_shadingQueries.size();
+		state.depthMask(GL_TRUE);
 
 		// Skybox Pass
 		if (scene.skybox) {
-			scene.skybox->material->use();
-			glBindVertexArray(*scene.skybox->vertexArray);
-			glDrawElements(GL_TRIANGLES, scene.skybox->vertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
+			scene.skybox->material->use(ShaderVariant::Instanced, m_stereoMode, m_foveated);
+			state.bindVertexArray(*scene.skybox->vertexArray);
+			glDrawElementsInstanced(GL_TRIANGLES, scene.skybox->vertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr, m_instanceViews);
 		}
+
+		// Depth pyramid tested by the next frame GPU culling. Stereo depth is seen from the eyes rather than the culling camera,
+		// foveated depth is split in regions.
+		if (m_settings.gpuCulling && m_viewCount == 1 && !m_foveated) {
+			if (auto target = m_target.lock())
+				m_gpuCuller->buildDepthPyramid(*target, m_camera.getProjectionMatrix() * m_camera.getViewMatrix());
+		}
+
+		// Every command reading this frame's uniforms has been issued.
+		m_uniformRing.endFrame();
+		m_stats.submitTime = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		// State changes since the previous submission, which covers a whole frame
+		const gpu::StateCache::Counters stateCalls = state.takeCounters();
+		m_stats.stateCalls = stateCalls.issued;
+		m_stats.skippedStateCalls = stateCalls.skipped;
 	}
 
 	void Renderer::endScene() {
-		if (auto target = m_target.lock()) {
+		auto target = m_target.lock();
+		if (!target) return;
+
+		m_sceneFrame = true;
+
+		// Scene colors keep the margin of the target above its nominal size, for viewports scaled above 1
+		const glm::vec2 margin = m_foveated ? glm::vec2(1.0f) :
+			glm::vec2(target->getWidth(), target->getHeight()) / glm::vec2(target->getNominalWidth(), target->getNominalHeight());
+		const glm::ivec2 colorSize = glm::ceil(glm::vec2(s_screenSize) * margin);
+		const RenderGraph::TextureDesc colorDesc{ .width = colorSize.x, .height = colorSize.y };
+
+		struct ResolveData {
+			RenderGraph::Resource views = RenderGraph::s_NO_RESOURCE;	// Single sample layers of a multisampled stereo target
+			RenderGraph::Resource color;
+		};
+
+		if (m_foveated) {
+			m_frameViewport = s_screenSize;
+			m_frameColor = m_renderGraph.addPass<ResolveData>("Foveated resolve",
+				[&](RenderGraph::Builder& builder, ResolveData& data) {
+					data.color = builder.write(builder.create("Scene color", colorDesc), RenderGraph::Access::Image);
+				},
+				[this, viewCount = m_viewCount](const ResolveData& data, RenderGraph::Context& context) {
+					m_foveation.resolve(context.getTexture(data.color), s_screenSize.x, s_screenSize.y, viewCount);
+				}
+			).color;
+			return;
+		}
+
+		// Only the viewport is resolved, post-processing and display read it from the scene color
+		const int32_t width = target->getViewportWidth();
+		const int32_t height = target->getViewportHeight();
+		const RenderGraph::Resource eyeColor = m_renderGraph.import("Eye color", target->getColorTexture(), DescribeTarget(*target, GL_RGBA16F));
+		if (target->getLayers() == 1) {
 			// Multi sample to single sample
-			glBlitNamedFramebuffer(
-				target->getFramebuffer(), s_intermediateTarget->getFramebuffer(),
-				0, 0, target->getWidth(), target->getHeight(),
-				0, 0, s_intermediateTarget->getWidth(), s_intermediateTarget->getHeight(),
-				GL_COLOR_BUFFER_BIT, GL_NEAREST
-			);
+			m_frameViewport = { width, height };
+			m_frameColor = m_renderGraph.addPass<ResolveData>("Resolve",
+				[&](RenderGraph::Builder& builder, ResolveData& data) {
+					builder.read(eyeColor, RenderGraph::Access::Attachment);
+					data.color = builder.write(builder.create("Scene color", colorDesc), RenderGraph::Access::Attachment);
+				},
+				[target, width, height](const ResolveData& data, RenderGraph::Context& context) {
+					glBlitNamedFramebuffer(
+						target->getFramebuffer(), context.getFramebuffer(data.color),
+						0, 0, width, height,
+						0, 0, width, height,
+						GL_COLOR_BUFFER_BIT, GL_NEAREST
+					);
+				}
+			).color;
+			return;
 		}
+
+		// Eyes side by side in the scene color, so that post-processing and display are unchanged
+		m_frameViewport = {
+			static_cast<int32_t>(std::lround(static_cast<float>(s_screenSize.x) * width / target->getNominalWidth())),
+			static_cast<int32_t>(std::lround(static_cast<float>(s_screenSize.y) * height / target->getNominalHeight()))
+		};
+
+		RenderGraph::TextureDesc viewsDesc = DescribeTarget(*target, GL_RGBA16F);
+		viewsDesc.type = GL_TEXTURE_2D_ARRAY;
+		viewsDesc.samples = 1;
+
+		m_frameColor = m_renderGraph.addPass<ResolveData>("Stereo resolve",
+			[&](RenderGraph::Builder& builder, ResolveData& data) {
+				builder.read(eyeColor, RenderGraph::Access::Attachment);
+				if (target->getSamples() > 1)
+					data.views = builder.write(builder.create("Resolved views", viewsDesc), RenderGraph::Access::Attachment);
+				data.color = builder.write(builder.create("Scene color", colorDesc), RenderGraph::Access::Attachment);
+			},
+			[target, width, height, viewCount = m_viewCount, viewport = m_frameViewport](const ResolveData& data, RenderGraph::Context& context) {
+				const int32_t viewWidth = viewport.x / static_cast<int32_t>(viewCount);
+				for (int32_t v = 0; v < static_cast<int32_t>(viewCount); ++v) {
+					// Multisampled layers can only be resolved in place, they are copied side by side afterwards
+					GLuint source = target->getLayerFramebuffer(v);
+					if (data.views != RenderGraph::s_NO_RESOURCE) {
+						const GLuint resolved = context.getFramebuffer(data.views, RenderGraph::s_NO_RESOURCE, v);
+						glBlitNamedFramebuffer(
+							source, resolved,
+							0, 0, width, height, 0, 0, width, height,
+							GL_COLOR_BUFFER_BIT, GL_NEAREST
+						);
+						source = resolved;
+					}
+
+					glBlitNamedFramebuffer(
+						source, context.getFramebuffer(data.color),
+						0, 0, width, height,
+						v * viewWidth, 0, (v + 1) * viewWidth, viewport.y,
+						GL_COLOR_BUFFER_BIT, GL_LINEAR
+					);
+				}
+			}
+		).color;
 	}
 
 	void Renderer::postprocess(Effect& effect) {
-		effect.apply(*s_intermediateTarget);
+		if (m_frameColor == RenderGraph::s_NO_RESOURCE) return;
+		m_frameColor = effect.addPasses(m_renderGraph, m_frameColor, m_frameViewport);
+	}
+
+	void Renderer::reproject(const Camera& camera) {
+		reprojectViews(std::span<const Camera>(&camera, 1));
+	}
+
+	void Renderer::reproject(const Camera& left, const Camera& right) {
+		const Camera views[] = { left, right };
+		reprojectViews(views);
+	}
+
+	void Renderer::reprojectViews(std::span<const Camera> views) {
+		if (!m_settings.reprojection.enabled) return;
+		auto target = m_target.lock();
+		if (!target) return;
+
+		// Post-processed frames are kept, with the depth of the eye buffers. Foveated frames have none to read.
+		uint32_t keptViews = m_reprojection.getViewCount();
+		if (m_sceneFrame && m_frameColor != RenderGraph::s_NO_RESOURCE) {
+			std::array<Reprojection::View, s_MAX_VIEWS> drawnViews;
+			for (uint32_t v = 0; v < m_viewCount; ++v)
+				drawnViews[v] = { m_sceneData.viewTransforms[v], m_sceneData.projectionTransforms[v] };
+
+			const RenderGraph::Resource eyeDepth = m_foveated ? RenderGraph::s_NO_RESOURCE :
+				m_renderGraph.import("Eye depth", target->getDepthStencilTexture(), DescribeTarget(*target, GL_DEPTH24_STENCIL8));
+
+			struct CaptureData {
+				RenderGraph::Resource color;
+			};
+
+			// The kept frame outlives the graph, the capture is a side effect
+			m_renderGraph.addPass<CaptureData>("Reprojection capture",
+				[&](RenderGraph::Builder& builder, CaptureData& data) {
+					data.color = builder.read(m_frameColor, RenderGraph::Access::Attachment);
+					if (eyeDepth != RenderGraph::s_NO_RESOURCE)
+						builder.read(eyeDepth, RenderGraph::Access::Attachment);
+					builder.setSideEffect();
+				},
+				[this, target, drawnViews, foveated = m_foveated, viewCount = m_viewCount, viewport = m_frameViewport](const CaptureData& data, RenderGraph::Context& context) {
+					const RenderGraph::TextureDesc& desc = context.getDesc(data.color);
+					m_reprojection.capture(context.getFramebuffer(data.color), { desc.width, desc.height }, viewport,
+						foveated ? nullptr : target.get(), std::span(drawnViews.data(), viewCount));
+				}
+			);
+
+			keptViews = m_viewCount;
+			m_sceneFrame = false;
+		}
+
+		// Stereo poses of a frame drawn with the left eye only keep the left eye
+		std::array<Reprojection::View, s_MAX_VIEWS> newViews;
+		const size_t viewCount = std::min<size_t>(views.size(), keptViews);
+		for (size_t v = 0; v < viewCount; ++v)
+			newViews[v] = { views[v].getViewMatrix(), views[v].getProjectionMatrix() };
+
+		struct ReprojectData {
+			RenderGraph::Resource color;
+			RenderGraph::Resource depth;
+		};
+
+		// The warped frame doesn't overlap the scene color it was captured from, they share the same texture
+		const RenderGraph::TextureDesc colorDesc{ .width = s_screenSize.x, .height = s_screenSize.y };
+		const RenderGraph::TextureDesc depthDesc{
+			.format = GL_DEPTH24_STENCIL8,
+			.width = s_screenSize.x,
+			.height = s_screenSize.y,
+			.sampler{ GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE },
+		};
+
+		m_frameViewport = s_screenSize;
+		m_frameColor = m_renderGraph.addPass<ReprojectData>("Reprojection",
+			[&](RenderGraph::Builder& builder, ReprojectData& data) {
+				data.color = builder.write(builder.create("Reprojected color", colorDesc), RenderGraph::Access::Attachment);
+				data.depth = builder.write(builder.create("Reprojection depth", depthDesc), RenderGraph::Access::Attachment);
+			},
+			[this, newViews, viewCount](const ReprojectData& data, RenderGraph::Context& context) {
+				m_reprojection.reproject(context.getFramebuffer(data.color, data.depth), s_screenSize, std::span(newViews.data(), viewCount));
+			}
+		).color;
 	}
 
 	void Renderer::display(const gpu::ShaderProgram& screenShader) {
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-		glDisable(GL_STENCIL_TEST);
-		glDisable(GL_DEPTH_TEST);
-		glUseProgram(screenShader);
-		glBindTextureUnit(0, *s_intermediateTarget->getColorTexture());
-		glBindVertexArray(*s_renderVertexArray);
-		glDrawElements(GL_TRIANGLES, s_renderVertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
-	}
-
-	void Renderer::renderShadowMap(const Scene& scene) {
-		glBindFramebuffer(GL_FRAMEBUFFER, *m_shadowFramebuffer);
-		// Directional lights
-		glCullFace(GL_FRONT);
-		glUseProgram(*s_shadowMapShader);
-		glViewport(0, 0, m_SHADOW_SIZE, m_SHADOW_SIZE);
-
-		for (uint32_t i = 0; i < scene.directionalLights.size() && i < m_MAX_SHADOW; ++i) {
-			glUniform1ui(glGetUniformLocation(*s_shadowMapShader, "uLightIndex"), i);
-			glNamedFramebufferTextureLayer(*m_shadowFramebuffer, GL_DEPTH_ATTACHMENT, *m_shadowMap, 0, i);
-			glClear(GL_DEPTH_BUFFER_BIT);
-
-			// Compute models depth
-			for (auto& mesh : scene.meshes) {
-				m_matrices.modelTransform = mesh->transform.getModelMatrix();
-				m_matrices.normalTransform = mesh->transform.getNormalMatrix();
-				glNamedBufferSubData(m_matrixBuffer, 0, sizeof(Matrices), &m_matrices);
-
-				for (const Primitive& primitive : mesh->primitives) {
-					glBindVertexArray(*primitive.vertexArray);
-					glDrawElements(primitive.vertexArray->getTopology(), primitive.vertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
+		if (s_passUniforms.screenShader != &screenShader) {
+			s_passUniforms.screenShader = &screenShader;
+			s_passUniforms.viewportScale = screenShader.getUniform<glm::vec2>("uViewportScale");
+		}
+
+		struct DisplayData {
+			RenderGraph::Resource color = RenderGraph::s_NO_RESOURCE;
+		};
+
+		m_renderGraph.addPass<DisplayData>("Display",
+			[&](RenderGraph::Builder& builder, DisplayData& data) {
+				if (m_frameColor != RenderGraph::s_NO_RESOURCE)
+					data.color = builder.read(m_frameColor, RenderGraph::Access::Sampled);
+				builder.setSideEffect();
+			},
+			[&screenShader, viewport = m_frameViewport](const DisplayData& data, RenderGraph::Context& context) {
+				// The viewport of the frame color is scaled to fill the window
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glViewport(0, 0, s_screenSize.x, s_screenSize.y);
+				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT);
+				if (data.color == RenderGraph::s_NO_RESOURCE) return;
+
+				gpu::StateCache& state = gpu::StateCache::getInstance();
+				state.disable(GL_STENCIL_TEST);
+				state.disable(GL_DEPTH_TEST);
+				state.useProgram(screenShader);
+				const RenderGraph::TextureDesc& desc = context.getDesc(data.color);
+				s_passUniforms.viewportScale.set(glm::vec2(viewport) / glm::vec2(desc.width, desc.height));
+				state.bindTextureUnit(0, context.getTexture(data.color));
+				state.bindVertexArray(*s_renderVertexArray);
+				glDrawElements(GL_TRIANGLES, s_renderVertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
+			}
+		);
+
+		m_renderGraph.execute();
+		m_frameColor = RenderGraph::s_NO_RESOURCE;
+		m_dynamicResolution.end();
+	}
+
+	void Renderer::syncTransforms(const SceneSnapshot& scene) {
+		static_assert(EntityStore::s_NO_ENTITY == TransformHierarchy::s_NO_PARENT, "Entity parents are used as transform nodes.");
+
+		// Entities may have been replaced by others at the same index when the layout changed
+		const uint32_t entityCount = static_cast<uint32_t>(scene.transforms.size());
+		if (scene.layout->revision != m_transformLayout) {
+			m_transformLayout = scene.layout->revision;
+			m_transforms.resize(entityCount);
+
+			// Force every node to be relinked and copied
+			m_transformParents.assign(entityCount, TransformHierarchy::s_NO_PARENT);
+			m_transformRevisions.assign(entityCount, std::numeric_limits<uint64_t>::max());
+			for (uint32_t i = 0; i < entityCount; ++i)
+				m_transforms.setParent(i, TransformHierarchy::s_NO_PARENT);
+		}
+
+		for (uint32_t i = 0; i < entityCount; ++i) {
+			const uint32_t parent = scene.parents[i];
+			if (parent != m_transformParents[i]) {
+				m_transforms.setParent(i, parent);
+				m_transformParents[i] = parent;
+			}
+
+			const Transform& transform = scene.transforms[i];
+			const uint64_t revision = transform.getRevision();
+			if (revision != m_transformRevisions[i]) {
+				m_transforms.setLocal(i, transform);
+				m_transformRevisions[i] = revision;
+			}
+		}
+
+		// Only the moved entities and their children are recomputed
+		m_transforms.update();
+	}
+
+	void Renderer::uploadFrameData(const SceneSnapshot& scene) {
+		const size_t dirLightSize = scene.directionalLights.size() * sizeof(DirectionalLight);
+		const size_t ptLightSize = scene.pointLights.size() * sizeof(PointLight);
+
+		// One object per renderable, GPU culling also needs the primitive bounds. Indexed materials read the material ID of each object.
+		const size_t objectsSize = m_renderables.getCount() * sizeof(ObjectData);
+		const size_t objectMaterialsSize = m_settings.indexedMaterials ? m_renderables.getCount() * sizeof(uint32_t) : 0;
+		const size_t boundsSize = m_settings.gpuCulling ? m_renderables.getCount() * sizeof(AABB) : 0;
+
+		// Shadow tiles are written by the shadow pass, every cascade slot of the directional lights and 6 faces per point light
+		const size_t shadowTilesSize = (scene.directionalLights.size() * DirectionalLight::s_MAX_CASCADES + scene.pointLights.size() * 6) * sizeof(ShadowTileData);
+
+		// Reserve the whole frame at once, so that the ring never overflows mid-frame.
+		m_uniformRing.beginFrame(
+			m_uniformRing.alignedSize(sizeof(SceneData)) +
+			m_uniformRing.alignedSize(sizeof(ClusterData)) +
+			m_uniformRing.alignedSize(objectsSize) +
+			m_uniformRing.alignedSize(objectMaterialsSize) +
+			m_uniformRing.alignedSize(dirLightSize) +
+			m_uniformRing.alignedSize(ptLightSize) +
+			m_uniformRing.alignedSize(shadowTilesSize) +
+			m_uniformRing.alignedSize(boundsSize)
+		);
+
+		// Scene uniforms
+		GLintptr sceneOffset = m_uniformRing.write(m_sceneData);
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.bindBufferRange(GL_UNIFORM_BUFFER, 0, m_uniformRing, sceneOffset, sizeof(SceneData));
+
+		m_clusterData.debugView = m_settings.clusterDebugView;
+		GLintptr clusterOffset = m_uniformRing.write(m_clusterData);
+		state.bindBufferRange(GL_UNIFORM_BUFFER, 3, m_uniformRing, clusterOffset, sizeof(ClusterData));
+
+		// Objects in renderables order, so that neighbouring renderables are drawn as consecutive instances.
+		// Shared by the shadow and model passes, and by the indirect draws.
+		if (objectsSize > 0) {
+			uint8_t* data = nullptr;
+			GLintptr offset = m_uniformRing.allocate(objectsSize, &data);
+			ObjectData* objects = reinterpret_cast<ObjectData*>(data);
+			for (const RenderableStore::Archetype& archetype : m_renderables.getArchetypes()) {
+				for (size_t r = 0; r < archetype.size(); ++r) {
+					const uint32_t transform = archetype.transforms[r];
+					objects[archetype.first + r] = ObjectData{
+						.modelTransform = m_transforms.getWorldMatrix(transform),
+						.normalTransform = m_transforms.getNormalMatrix(transform),
+					};
 				}
 			}
+
+			state.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 4, m_uniformRing, offset, objectsSize);
 		}
 
+		// Material ID of each object, no material for those drawn with their own bindings
+		m_stats.indexedMaterials = 0;
+		if (objectMaterialsSize > 0) {
+			uint8_t* data = nullptr;
+			GLintptr offset = m_uniformRing.allocate(objectMaterialsSize, &data);
+			uint32_t* objectMaterials = reinterpret_cast<uint32_t*>(data);
+			for (const RenderableStore::Archetype& archetype : m_renderables.getArchetypes()) {
+				const MaterialInstance* counted = nullptr;
+				for (size_t r = 0; r < archetype.size(); ++r) {
+					const MaterialInstance* material = archetype.materials[r];
+					const bool indexed = material->isIndexed();
+					objectMaterials[archetype.first + r] = indexed ? material->getMaterialID() : Material::s_NO_MATERIAL;
+					if (indexed && material != counted) {
+						++m_stats.indexedMaterials;
+						counted = material;
+					}
+				}
+			}
 
-		// Point lights
-		static glm::mat4 lightProj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
-		glViewport(0, 0, m_SHADOW_SIZE / 4, m_SHADOW_SIZE / 4);
-		glUseProgram(*s_shadowCubeMapShader);
-		int32_t uViewProjLocation = glGetUniformLocation(*s_shadowCubeMapShader, "uLightViewProj");
-		
-		glCullFace(GL_BACK);
-		for (uint32_t i = 0; i < scene.pointLights.size() && i < m_MAX_SHADOW; ++i) {
-			const PointLight& light = scene.pointLights[i];
-			glUniform1ui(glGetUniformLocation(*s_shadowCubeMapShader, "uLightIndex"), i);
-
-			glm::mat4 viewMatrices[6] = {
-				glm::lookAt(light.position, light.position + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
-				glm::lookAt(light.position, light.position + glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
-				glm::lookAt(light.position, light.position + glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-				glm::lookAt(light.position, light.position + glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f, 0.0f,-1.0f)),
-				glm::lookAt(light.position, light.position + glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
-				glm::lookAt(light.position, light.position + glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
+			state.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 9, m_uniformRing, offset, objectMaterialsSize);
+		}
+
+		// World bounds of the renderables, refitted for the moved entities only
+		m_sceneBVH.update(scene, m_transforms);
+
+		// Scene lights
+		auto bindStorage = [this, &state](GLuint binding, const void* data, size_t size) {
+			if (size == 0) {
+				// Buffer ranges can't be empty, bind an empty buffer so that the light count is 0.
+				state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_emptyBuffer);
+				return;
+			}
+
+			GLintptr offset = m_uniformRing.write(data, size);
+			state.bindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, m_uniformRing, offset, size);
+		};
+
+		// Directional lights are written by the shadow pass, along with the cascades of their shadow layers
+		bindStorage(1, scene.pointLights.data(), ptLightSize);
+
+		if (m_settings.gpuCulling) {
+			// World bounds of the renderables, read by the culling pass
+			static_assert(sizeof(AABB) == 6 * sizeof(float), "The culling shader reads bounds as 6 packed floats.");
+			bindStorage(5, m_sceneBVH.getPrimitiveBounds().data(), m_sceneBVH.getPrimitiveBounds().size() * sizeof(AABB));
+		}
+	}
+
+	size_t Renderer::findInstances(const RenderableStore::Archetype& archetype, size_t first) const {
+		size_t end = first + 1;
+		if (!m_settings.instancing) return end;
+
+		// Renderables are sorted by material then geometry, instances are the visible neighbours sharing both
+		while (end < archetype.size() &&
+			archetype.materials[end] == archetype.materials[first] &&
+			archetype.drawCalls[end].vertexArray == archetype.drawCalls[first].vertexArray &&
+			m_primitiveVisible[archetype.primitives[end]])
+			++end;
+
+		return end;
+	}
+
+	void Renderer::recordInstances(gpu::CommandBuffer& commands, const RenderableStore::DrawCall& drawCall, uint32_t firstObject, uint32_t count, uint32_t instanceViews) const {
+		// Instanced stereo draws each object once per view, shaders halve the instance index
+		commands.bindVertexArray(drawCall.vertexArray);
+		commands.drawElementsInstancedBaseInstance(drawCall.topology, drawCall.elementCount, count * instanceViews, firstObject);
+	}
+
+	void Renderer::cullPrimitives(const SceneSnapshot& scene) {
+		const auto start = std::chrono::steady_clock::now();
+		const glm::mat4 viewProjection = m_camera.getProjectionMatrix() * m_camera.getViewMatrix();
+		const Frustum frustum(viewProjection);
+		const std::vector<AABB>& primitiveBounds = m_sceneBVH.getPrimitiveBounds();
+
+		m_primitiveVisible.assign(primitiveBounds.size(), 0);
+		m_queryResults.clear();
+		m_sceneBVH.getTree().queryFrustum(frustum, m_queryResults);
+		for (uint32_t p : m_queryResults)
+			m_primitiveVisible[p] = 1;
+
+		m_stats.occluders = 0;
+		m_stats.occluderTriangles = 0;
+		if (m_settings.occlusionCulling) {
+			// Candidate occluders: opaque static primitives in view, covering a good share of the screen
+			struct Candidate {
+				const OccluderGeometry* occluder;
+				uint32_t transform;
+				float coverage;
 			};
 
-			
+			m_occlusionCuller->begin(viewProjection);
+			std::vector<Candidate> candidates;
+			const RenderableStore::Archetype& opaqueStatic = m_renderables.getArchetype(RenderableStore::Static);
+			for (size_t r = 0; r < opaqueStatic.size(); ++r) {
+				const uint32_t p = opaqueStatic.primitives[r];
+				if (!opaqueStatic.occluders[r] || !m_primitiveVisible[p]) continue;
+
+				const float coverage = m_occlusionCuller->getScreenCoverage(primitiveBounds[p]);
+				if (coverage >= m_MIN_OCCLUDER_COVERAGE)
+					candidates.push_back({ opaqueStatic.occluders[r], opaqueStatic.transforms[r], coverage });
+			}
+
+			// Largest occluders first, until the triangle budget is spent
+			std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.coverage > b.coverage; });
+			for (const Candidate& candidate : candidates) {
+				const uint32_t triangles = static_cast<uint32_t>(candidate.occluder->indices.size() / 3);
+				if (m_occlusionCuller->getTriangleCount() + triangles > m_MAX_OCCLUDER_TRIANGLES) continue;
+
+				m_occlusionCuller->addOccluder(*candidate.occluder, m_transforms.getWorldMatrix(candidate.transform));
+			}
+			m_occlusionCuller->rasterize();
+
+			// Stereo occluders are rasterized from the culling camera, behind the eyes. Bounds are grown by the
+			// distance to the eyes, so that parallax rarely hides what an eye sees past an occluder edge.
+			const float eyeDistance = glm::length(glm::vec3(m_sceneData.eyePositions[0]) - m_camera.eyePos);
+			for (uint32_t p : m_queryResults) {
+				const AABB& bounds = primitiveBounds[p];
+				m_primitiveVisible[p] = m_occlusionCuller->isVisible(eyeDistance > 0.0f ? AABB{ bounds.min - eyeDistance, bounds.max + eyeDistance } : bounds);
+			}
+
+			m_stats.occluders = m_occlusionCuller->getOccluderCount();
+			m_stats.occluderTriangles = m_occlusionCuller->getTriangleCount();
+		}
+
+		m_stats.culledPrimitives = static_cast<uint32_t>(std::count(m_primitiveVisible.begin(), m_primitiveVisible.end(), 0));
+		m_stats.occlusionTime = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Renderer::cullPrimitivesOnGpu() {
+		const auto start = std::chrono::steady_clock::now();
+
+		m_gpuCuller->sync(m_renderables);
+		m_gpuCuller->cull(Frustum(m_camera.getProjectionMatrix() * m_camera.getViewMatrix()), m_settings.occlusionCulling && m_viewCount == 1 && !m_foveated, m_instanceViews);
+
+		// Visibility is read back a few frames late, the CPU never waits for it
+		const GpuCuller::Stats& stats = m_gpuCuller->getStats();
+		m_stats.occluders = 0;
+		m_stats.occluderTriangles = 0;
+		m_stats.culledPrimitives = stats.instances - std::min(stats.visible, stats.instances);
+		m_stats.occlusionTime = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	ShaderVariant Renderer::modelVariant(const MaterialInstance& material) const {
+		// Object material IDs are only uploaded along with the setting
+		return m_settings.indexedMaterials && material.isIndexed() ? ShaderVariant::Indexed : ShaderVariant::Instanced;
+	}
+
+	void Renderer::addModelRecorders() {
+		// Programs are compiled on first use, which recording can't do. Materials are sorted, each is resolved once.
+		const MaterialInstance* resolved = nullptr;
+		for (const RenderableStore::Archetype& archetype : m_renderables.getArchetypes()) {
+			for (MaterialInstance* material : archetype.materials) {
+				if (material == resolved) continue;
+
+				material->getMaterialClass().getShaderProgram(modelVariant(*material), m_stereoMode, m_foveated);
+				resolved = material;
+			}
+		}
+
+		// One recording per archetype and pass
+		auto addRecorders = [this](void (Renderer::*record)(const RenderableStore::Archetype&, PassRecording&) const) {
+			PassRange range{ static_cast<uint32_t>(m_recorders.size()) };
+			range.last = range.first;
+			for (const RenderableStore::Archetype& archetype : m_renderables.getArchetypes()) {
+				if (archetype.size() == 0) continue;
+
+				range.last = addRecorder([this, &archetype, record](PassRecording& recording) { (this->*record)(archetype, recording); }) + 1;
+			}
+			return range;
+		};
+
+		m_prepassRecordings = m_settings.depthPrepass ? addRecorders(&Renderer::recordDepthPrepass) : PassRange{};
+		m_modelRecordings = addRecorders(&Renderer::recordModels);
+	}
+
+	void Renderer::recordDepthPrepass(const RenderableStore::Archetype& archetype, PassRecording& recording) const {
+		gpu::CommandBuffer& commands = recording.commands;
+
+		// Opaque geometry is position only, alpha masked geometry samples the albedo alpha
+		const bool masked = archetype.flags & RenderableStore::AlphaMasked;
+		const gpu::ShaderProgram& depthShader = *s_depthShaders[DepthShaderIndex(m_stereoMode, m_foveated)];
+		const gpu::ShaderProgram& depthMaskedShader = *s_depthMaskedShaders[DepthShaderIndex(m_stereoMode, m_foveated)];
+		commands.useProgram(masked ? depthMaskedShader : depthShader);
+
+		const MaterialInstance* boundMaterial = nullptr;
+		for (size_t r = 0; r < archetype.size();) {
+			if (!m_primitiveVisible[archetype.primitives[r]]) {
+				++r;
+				continue;
+			}
+
+			const MaterialInstance* material = archetype.materials[r];
+			if (material != boundMaterial) {
+				boundMaterial = material;
+				if (masked) {
+					material->recordTextures(commands);
+					commands.uniform1f(s_passUniforms.alphaCutoff[DepthShaderIndex(m_stereoMode, m_foveated)].getLocation(), material->renderFlags.alphaCutoff);
+				}
+				material->renderFlags.record(commands);
+			}
+
+			const size_t end = findInstances(archetype, r);
+			recordInstances(commands, archetype.drawCalls[r], archetype.first + static_cast<uint32_t>(r), static_cast<uint32_t>(end - r), m_instanceViews);
+			++recording.count.draws;
+			recording.count.instances += static_cast<uint32_t>(end - r);
+			r = end;
+		}
+	}
+
+	void Renderer::renderDepthPrepass() {
+		m_prepassQueries[m_statsIndex].begin();
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+		const DrawCount count = replayPasses(m_prepassRecordings);
+		m_stats.drawCalls += count.draws;
+		m_stats.instances += count.instances;
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		m_prepassQueries[m_statsIndex].end();
+	}
+
+	void Renderer::renderDepthPrepassIndirect() {
+		m_prepassQueries[m_statsIndex].begin();
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+		const gpu::ShaderProgram& depthShader = *s_depthShaders[DepthShaderIndex(m_stereoMode, m_foveated)];
+		const gpu::ShaderProgram& depthMaskedShader = *s_depthMaskedShaders[DepthShaderIndex(m_stereoMode, m_foveated)];
+		const gpu::UniformHandle<float>& alphaCutoff = s_passUniforms.alphaCutoff[DepthShaderIndex(m_stereoMode, m_foveated)];
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		const std::vector<GpuCuller::Batch>& batches = m_gpuCuller->getBatches();
+		for (uint32_t b = 0; b < batches.size(); ++b) {
+			const GpuCuller::Batch& batch = batches[b];
+			const bool masked = batch.archetype & RenderableStore::AlphaMasked;
+			state.useProgram(masked ? depthMaskedShader : depthShader);
+			if (masked) {
+				batch.material->bindTextures();
+				alphaCutoff.set(batch.material->renderFlags.alphaCutoff);
+			}
+			batch.material->renderFlags.apply();
+
+			m_gpuCuller->draw(b);
+			++m_stats.drawCalls;
+		}
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		m_prepassQueries[m_statsIndex].end();
+	}
+
+	void Renderer::recordModels(const RenderableStore::Archetype& archetype, PassRecording& recording) const {
+		gpu::CommandBuffer& commands = recording.commands;
+		const MaterialInstance* boundMaterial = nullptr;
+
+		for (size_t r = 0; r < archetype.size();) {
+			if (!m_primitiveVisible[archetype.primitives[r]]) {
+				++r;
+				continue;
+			}
+
+			// Renderables are sorted by material, each one is only bound once
+			if (archetype.materials[r] != boundMaterial) {
+				boundMaterial = archetype.materials[r];
+				archetype.materials[r]->record(commands, modelVariant(*archetype.materials[r]), m_stereoMode, m_foveated);
+				if (m_settings.depthPrepass)
+					commands.depthFunc(GL_EQUAL);
+			}
+
+			const size_t end = findInstances(archetype, r);
+			recordInstances(commands, archetype.drawCalls[r], archetype.first + static_cast<uint32_t>(r), static_cast<uint32_t>(end - r), m_instanceViews);
+			++recording.count.draws;
+			recording.count.instances += static_cast<uint32_t>(end - r);
+			r = end;
+		}
+	}
+
+	void Renderer::renderModels() {
+		const DrawCount count = replayPasses(m_modelRecordings);
+		m_stats.drawCalls += count.draws;
+		m_stats.instances += count.instances;
+	}
+
+	void Renderer::renderModelsIndirect() {
+		const MaterialInstance* boundMaterial = nullptr;
+		const std::vector<GpuCuller::Batch>& batches = m_gpuCuller->getBatches();
+		for (uint32_t b = 0; b < batches.size(); ++b) {
+			if (batches[b].material != boundMaterial) {
+				boundMaterial = batches[b].material;
+				batches[b].material->use(modelVariant(*batches[b].material), m_stereoMode, m_foveated);
+				if (m_settings.depthPrepass)
+					gpu::StateCache::getInstance().depthFunc(GL_EQUAL);
+			}
+
+			m_gpuCuller->draw(b);
+			++m_stats.drawCalls;
+		}
+	}
+
+	uint32_t Renderer::addRecorder(PassRecorder recorder) {
+		m_recorders.push_back(std::move(recorder));
+		return static_cast<uint32_t>(m_recorders.size() - 1);
+	}
+
+	void Renderer::recordPasses() {
+		const auto start = std::chrono::steady_clock::now();
+		const uint32_t count = static_cast<uint32_t>(m_recorders.size());
+		if (m_recordings.size() < count)
+			m_recordings.resize(count);
+
+		auto record = [this](uint32_t p) {
+			PassRecording& recording = m_recordings[p];
+			recording.commands.reset();
+			recording.count = {};
+			m_recorders[p](recording);
+		};
+
+		// Recorders only read the state of the frame, each writes its own recording
+		if (m_settings.parallelRecording) {
+			s_jobSystem->parallelFor(count, record);
+		} else {
+			for (uint32_t p = 0; p < count; ++p)
+				record(p);
+		}
+
+		m_stats.recordedPasses = count;
+		m_stats.recordedSize = 0;
+		for (uint32_t p = 0; p < count; ++p)
+			m_stats.recordedSize += m_recordings[p].commands.getSize();
+
+		m_recorders.clear();
+		m_stats.recordTime = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	Renderer::DrawCount Renderer::replayPasses(PassRange range) const {
+		DrawCount count;
+		for (uint32_t p = range.first; p < range.last; ++p) {
+			m_recordings[p].commands.execute();
+			count += m_recordings[p].count;
+		}
+
+		return count;
+	}
+
+	void Renderer::readStatistics() {
+		// Queries of this slot were issued a few frames ago, their result should be ready
+		if (m_shadingQueries[m_statsIndex].isAvailable())
+			m_stats.shadingFragments = m_shadingQueries[m_statsIndex].getResult();
+
+		if (!m_settings.depthPrepass)
+			m_stats.prepassFragments = 0;
+		else if (m_prepassQueries[m_statsIndex].isAvailable())
+			m_stats.prepassFragments = m_prepassQueries[m_statsIndex].getResult();
+	}
+
+	void Renderer::buildLightClusters() {
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_clusterCounts);
+		state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_clusterLights);
+
+		state.useProgram(*s_lightClusterShader);
+		glDispatchCompute((m_clusterData.gridSize.w + 127) / 128, m_viewCount, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	void Renderer::renderShadowMap(const SceneSnapshot& scene) {
+		m_shadowScheduler.getSettings() = m_settings.shadows;
+		m_shadowAtlas.getSettings().format = m_settings.shadowDepthBits == 16 ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT32F;
+		m_shadowAtlas.getSettings().maxSize = m_settings.shadowAtlasSize;
+
+		// Fit the cascades of the directional lights to the view
+		const uint32_t directionalCount = static_cast<uint32_t>(scene.directionalLights.size());
+		const uint32_t pointCount = static_cast<uint32_t>(scene.pointLights.size());
+		const uint32_t cascadeCount = std::clamp(m_settings.shadowCascades, DirectionalLight::s_MIN_CASCADES, DirectionalLight::s_MAX_CASCADES);
+		const AABB sceneBounds = m_sceneBVH.getTree().getRootBounds();
+		m_directionalLights.assign(scene.directionalLights.begin(), scene.directionalLights.end());
+
+		std::vector<glm::mat4> cascadeMatrices(directionalCount * DirectionalLight::s_MAX_CASCADES, glm::mat4(0.0f));
+		for (uint32_t i = 0; i < directionalCount; ++i) {
+			DirectionalLight& light = m_directionalLights[i];
+			light.computeCascades(m_camera, sceneBounds, cascadeCount, m_settings.cascadeSplitLambda, m_settings.shadowDistance, m_CASCADE_SIZE);
+			light.splits -= glm::vec4(m_cullingOffset);	// Cascades are selected with the eye depth, in front of the culling camera
+			for (uint32_t c = 0; c < cascadeCount; ++c)
+				cascadeMatrices[i * DirectionalLight::s_MAX_CASCADES + c] = light.matrices[c];
+		}
+
+		m_shadowCache.update(scene, m_transforms, cascadeMatrices);
+
+		// Request an atlas tile per unit, sized by its share of the screen
+		const Frustum cameraFrustum(m_camera.getProjectionMatrix() * m_camera.getViewMatrix());
+		std::vector<CubeShadowView> views(pointCount);
+		std::vector<float> faceWeights(pointCount * 6);
+		m_shadowAtlas.begin();
+
+		for (uint32_t i = 0; i < directionalCount; ++i) {
+			// Cascades cover the whole view, the nearest ones matter most
+			for (uint32_t c = 0; c < cascadeCount; ++c)
+				m_shadowAtlas.request(shadowUnitKey(false, i, c), static_cast<float>(m_CASCADE_SIZE), 2.0f / (c + 1));
+		}
+
+		for (uint32_t i = 0; i < pointCount; ++i) {
+			const PointLight& light = scene.pointLights[i];
+			const float influenceRadius = light.getInfluenceRadius();
+			const float influence = ComputeScreenInfluence(cameraFrustum, m_camera.eyePos, light.position, influenceRadius);
+			views[i] = ComputeCubeShadowView(light.position);
+
 			for (uint32_t face = 0; face < 6; ++face) {
-				glm::mat4 viewProj = lightProj * viewMatrices[face];
-				glUniformMatrix4fv(uViewProjLocation, 1, GL_FALSE, glm::value_ptr(viewProj));
-				glNamedFramebufferTextureLayer(*m_shadowFramebuffer, GL_DEPTH_ATTACHMENT, *m_shadowCubeMap, 0, i * 6 + face);
-				glClear(GL_DEPTH_BUFFER_BIT);
-				
-				// Compute models depth
-				for (auto& mesh : scene.meshes) {
-					m_matrices.modelTransform = mesh->transform.getModelMatrix();
-					m_matrices.normalTransform = mesh->transform.getNormalMatrix();
-					glNamedBufferSubData(m_matrixBuffer, 0, sizeof(Matrices), &m_matrices);
-
-					for (const Primitive& primitive : mesh->primitives) {
-						glBindVertexArray(*primitive.vertexArray);
-						glDrawElements(primitive.vertexArray->getTopology(), primitive.vertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
-					}
+				// Faces looking away from the view matter less
+				const float facing = cameraFrustum.intersects(ComputeCubeFaceBounds(light.position, influenceRadius, face)) ? 1.0f : 0.25f;
+				faceWeights[i * 6 + face] = influence * facing;
+				m_shadowAtlas.request(shadowUnitKey(true, i, face), m_POINT_SHADOW_SIZE * influence * facing, influence * facing);
+			}
+		}
+
+		m_shadowAtlas.allocate();
+
+		// Units whose tile moved, or lost its content, are rendered again from scratch
+		const bool atlasReset = m_shadowAtlas.getRevision() != m_shadowAtlasRevision;
+		m_shadowAtlasRevision = m_shadowAtlas.getRevision();
+
+		std::unordered_map<uint32_t, ShadowUnit> units;
+		auto updateUnit = [&](uint32_t key, bool dirty) {
+			const ShadowAtlas::Tile tile = m_shadowAtlas.getTile(key);
+			if (tile.size == 0) return;
+
+			ShadowUnit& unit = units[key];
+			auto previous = m_shadowUnits.find(key);
+			if (!atlasReset && previous != m_shadowUnits.end() && previous->second.tile == tile)
+				unit = previous->second;
+			else
+				unit.tile = tile;
+
+			unit.staticPending = unit.staticPending || dirty;
+		};
+
+		for (uint32_t i = 0; i < directionalCount; ++i) {
+			for (uint32_t c = 0; c < cascadeCount; ++c)
+				updateUnit(shadowUnitKey(false, i, c), m_shadowCache.isCascadeDirty(i * DirectionalLight::s_MAX_CASCADES + c));
+		}
+
+		for (uint32_t i = 0; i < pointCount; ++i) {
+			for (uint32_t face = 0; face < 6; ++face)
+				updateUnit(shadowUnitKey(true, i, face), m_shadowCache.isPointDirty(i));
+		}
+
+		m_shadowUnits = std::move(units);
+		glBindFramebuffer(GL_FRAMEBUFFER, *m_shadowFramebuffer);
+
+		// Feed the scheduler with the GPU time of a previous shadow pass
+		gpu::Query& timer = m_shadowTimers[m_shadowTimerIndex];
+		if (timer.isAvailable())
+			m_shadowScheduler.reportGpuTime(timer.getResult() / 1000.0f, m_shadowTimerCounts[m_shadowTimerIndex].draws, m_shadowTimerCounts[m_shadowTimerIndex].instances);
+		timer.begin();
+		m_shadowCount = {};
+		m_shadowScheduler.begin();
+
+		// Directional lights requests, one per cascade
+		std::vector<Frustum> cascadeFrusta(cascadeMatrices.size());
+		std::vector<uint32_t> cascadeDynamicCosts(cascadeMatrices.size(), 0);
+		for (uint32_t i = 0; i < directionalCount; ++i) {
+			for (uint32_t c = 0; c < cascadeCount; ++c) {
+				const uint32_t key = shadowUnitKey(false, i, c);
+				const uint32_t layer = i * DirectionalLight::s_MAX_CASCADES + c;
+				auto unit = m_shadowUnits.find(key);
+				if (unit == m_shadowUnits.end()) continue;
+
+				cascadeFrusta[layer] = Frustum(cascadeMatrices[layer]);
+				cascadeDynamicCosts[layer] = queryCasters(cascadeFrusta[layer], false);
+				if (!unit->second.staticPending && cascadeDynamicCosts[layer] == 0 && !unit->second.hasDynamic)
+					continue;
+
+				// Far cascades cover less of the screen per texel, they can wait longer. Empty tiles come first.
+				const uint32_t staticCost = unit->second.staticPending ? queryCasters(cascadeFrusta[layer], true) : 0;
+				const float motion = !unit->second.rendered ? 8.0f : (m_shadowCache.isCascadeDirty(layer) ? 4.0f : 1.0f);
+				m_shadowScheduler.request(key, motion / (c + 1), staticCost + cascadeDynamicCosts[layer]);
+			}
+		}
+
+		// Point lights requests, one per cube face. Casters are looked up once in the light influence sphere.
+		std::vector<uint8_t> pointDynamicMasks(pointCount, 0);
+		for (uint32_t i = 0; i < pointCount; ++i) {
+			const PointLight& light = scene.pointLights[i];
+			m_queryResults.clear();
+			m_sceneBVH.getTree().querySphere(light.position, light.getInfluenceRadius(), m_queryResults);
+
+			uint32_t staticCosts[6] = {};
+			uint32_t dynamicCosts[6] = {};
+			for (uint32_t p : m_queryResults) {
+				const bool isStatic = (m_renderables.locate(p).archetype & RenderableStore::Static) != 0;
+				const AABB& bounds = m_sceneBVH.getPrimitiveBounds()[p];
+				for (uint32_t face = 0; face < 6; ++face) {
+					if (views[i].frusta[face].intersects(bounds))
+						++(isStatic ? staticCosts : dynamicCosts)[face];
 				}
 			}
+
+			const float motion = m_shadowCache.isPointDirty(i) ? 4.0f : 1.0f;
+			for (uint32_t face = 0; face < 6; ++face) {
+				const uint32_t key = shadowUnitKey(true, i, face);
+				auto unit = m_shadowUnits.find(key);
+				if (unit == m_shadowUnits.end()) continue;
+
+				if (dynamicCosts[face] > 0) pointDynamicMasks[i] |= 1 << face;
+				if (!unit->second.staticPending && dynamicCosts[face] == 0 && !unit->second.hasDynamic)
+					continue;
+
+				const uint32_t staticCost = unit->second.staticPending ? staticCosts[face] : 0;
+				m_shadowScheduler.request(key, faceWeights[i * 6 + face] * (unit->second.rendered ? motion : 8.0f), staticCost + dynamicCosts[face]);
+			}
+		}
+
+		// Split the scheduled units per light, directional units are cascades
+		std::vector<bool> cascadeScheduled(cascadeMatrices.size(), false);
+		std::vector<uint8_t> pointScheduled(pointCount, 0);
+		const std::vector<uint32_t> scheduled = m_shadowScheduler.schedule();
+		for (uint32_t key : scheduled) {
+			const uint32_t light = (key & ~s_POINT_UNIT) >> 3;
+			if (key & s_POINT_UNIT)
+				pointScheduled[light] |= 1 << (key & 7);
+			else
+				cascadeScheduled[light * DirectionalLight::s_MAX_CASCADES + (key & 7)] = true;
+		}
+
+		std::vector<uint8_t> staticMasks(pointCount), dynamicMasks(pointCount);
+		for (uint32_t i = 0; i < pointCount; ++i) {
+			dynamicMasks[i] = pointScheduled[i] & pointDynamicMasks[i];
+			for (uint32_t face = 0; face < 6; ++face) {
+				if ((pointScheduled[i] & (1 << face)) && m_shadowUnits[shadowUnitKey(true, i, face)].staticPending)
+					staticMasks[i] |= 1 << face;
+			}
+		}
+
+		// One recording per cascade and per point light. Tiles are rendered through the viewport,
+		// the scissor keeps rasterization inside them.
+		auto addCascadeRecorders = [&](bool staticCasters) {
+			PassRange range{ static_cast<uint32_t>(m_recorders.size()) };
+			range.last = range.first;
+			for (uint32_t layer = 0; layer < cascadeMatrices.size(); ++layer) {
+				if (!cascadeScheduled[layer]) continue;
+
+				const ShadowUnit& unit = m_shadowUnits.at(shadowUnitKey(false, layer / DirectionalLight::s_MAX_CASCADES, layer % DirectionalLight::s_MAX_CASCADES));
+				if (staticCasters ? !unit.staticPending : cascadeDynamicCosts[layer] == 0) continue;
+
+				range.last = addRecorder([this, &unit, &cascadeFrusta, &cascadeMatrices, layer, staticCasters](PassRecording& recording) {
+					recording.commands.useProgram(*s_shadowMapShader);
+					recording.commands.viewport(unit.tile.x, unit.tile.y, unit.tile.size, unit.tile.size);
+					recording.commands.scissor(unit.tile.x, unit.tile.y, unit.tile.size, unit.tile.size);
+					recording.commands.uniformMatrix4fv(s_passUniforms.lightViewProj.getLocation(), 1, glm::value_ptr(cascadeMatrices[layer]));
+					recordCasters(recording, cascadeFrusta[layer], staticCasters);
+				}) + 1;
+			}
+			return range;
+		};
+
+		const PassRange staticCascades = addCascadeRecorders(true);
+		const PassRange staticPoints = addPointShadowRecorders(scene, views, staticMasks, true);
+		const PassRange dynamicCascades = addCascadeRecorders(false);
+		const PassRange dynamicPoints = addPointShadowRecorders(scene, views, dynamicMasks, false);
+		recordPasses();
+
+		// Static casters are rendered once in the cached tiles, then copied under the dynamic casters
+		const float clearDepth = 1.0f;
+		for (uint32_t key : scheduled) {
+			const ShadowUnit& unit = m_shadowUnits.at(key);
+			if (!unit.staticPending) continue;
+
+			glClearTexSubImage(m_shadowAtlas.getStaticTexture(), 0, unit.tile.x, unit.tile.y, 0, unit.tile.size, unit.tile.size, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+		}
+
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.enable(GL_SCISSOR_TEST);
+		glNamedFramebufferTexture(*m_shadowFramebuffer, GL_DEPTH_ATTACHMENT, m_shadowAtlas.getStaticTexture(), 0);
+		state.cullFace(GL_FRONT);
+		m_shadowCount += replayPasses(staticCascades);
+		state.cullFace(GL_BACK);
+		m_shadowCount += replayPasses(staticPoints);
+
+		// Composite the cached static depth with the dynamic casters, units keep the projection they are rendered with
+		for (uint32_t key : scheduled) {
+			ShadowUnit& unit = m_shadowUnits[key];
+			const uint32_t light = (key & ~s_POINT_UNIT) >> 3;
+			const uint32_t face = key & 7;
+			glCopyImageSubData(
+				m_shadowAtlas.getStaticTexture(), GL_TEXTURE_2D, 0, unit.tile.x, unit.tile.y, 0,
+				m_shadowAtlas.getTexture(), GL_TEXTURE_2D, 0, unit.tile.x, unit.tile.y, 0,
+				unit.tile.size, unit.tile.size, 1
+			);
+
+			unit.viewProjection = (key & s_POINT_UNIT) ? views[light].viewProjs[face] : cascadeMatrices[light * DirectionalLight::s_MAX_CASCADES + face];
+			unit.hasDynamic = (key & s_POINT_UNIT) ? (pointDynamicMasks[light] & (1 << face)) != 0 : cascadeDynamicCosts[light * DirectionalLight::s_MAX_CASCADES + face] > 0;
+			unit.staticPending = false;
+			unit.rendered = true;
+		}
+
+		glNamedFramebufferTexture(*m_shadowFramebuffer, GL_DEPTH_ATTACHMENT, m_shadowAtlas.getTexture(), 0);
+		state.cullFace(GL_FRONT);
+		m_shadowCount += replayPasses(dynamicCascades);
+		state.cullFace(GL_BACK);
+		m_shadowCount += replayPasses(dynamicPoints);
+		state.disable(GL_SCISSOR_TEST);
+
+		// Directional lights carry the cascade splits, the tiles carry the projections
+		if (m_directionalLights.empty()) {
+			state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_emptyBuffer);
+		} else {
+			const size_t directionalSize = m_directionalLights.size() * sizeof(DirectionalLight);
+			GLintptr directionalOffset = m_uniformRing.write(m_directionalLights.data(), directionalSize);
+			state.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_uniformRing, directionalOffset, directionalSize);
+		}
+
+		uploadShadowTiles(directionalCount, pointCount);
+
+		timer.end();
+		m_shadowTimerCounts[m_shadowTimerIndex] = m_shadowCount;
+		m_shadowTimerIndex = (m_shadowTimerIndex + 1) % m_shadowTimers.size();
+	}
+
+	uint32_t Renderer::shadowUnitKey(bool point, uint32_t light, uint32_t face) const {
+		return (point ? s_POINT_UNIT : 0) | (light << 3) | face;
+	}
+
+	void Renderer::uploadShadowTiles(uint32_t directionalCount, uint32_t pointCount) {
+		// Cascade slots of the directional lights first, then the faces of the point lights
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		m_shadowTiles.assign(directionalCount * DirectionalLight::s_MAX_CASCADES + pointCount * 6, ShadowTileData{});
+		if (m_shadowTiles.empty()) {
+			state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, m_emptyBuffer);
+			return;
+		}
+
+		const float texelSize = 1.0f / std::max(m_shadowAtlas.getSize(), 1u);
+		for (const auto& [key, unit] : m_shadowUnits) {
+			if (!unit.rendered) continue;
+
+			const uint32_t light = (key & ~s_POINT_UNIT) >> 3;
+			const uint32_t index = (key & s_POINT_UNIT) ? directionalCount * DirectionalLight::s_MAX_CASCADES + light * 6 + (key & 7) : light * DirectionalLight::s_MAX_CASCADES + (key & 7);
+			m_shadowTiles[index] = ShadowTileData{
+				.viewProjection = unit.viewProjection,
+				.rect = glm::vec4(unit.tile.x, unit.tile.y, unit.tile.size, 1.0f) * texelSize,
+			};
+		}
+
+		const size_t size = m_shadowTiles.size() * sizeof(ShadowTileData);
+		GLintptr offset = m_uniformRing.write(m_shadowTiles.data(), size);
+		state.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 8, m_uniformRing, offset, size);
+	}
+
+	uint32_t Renderer::queryCasters(const Frustum& frustum, bool staticCasters) {
+		m_queryResults.clear();
+		m_sceneBVH.getTree().queryFrustum(frustum, m_queryResults);
+		std::erase_if(m_queryResults, [&](uint32_t p) { return ((m_renderables.locate(p).archetype & RenderableStore::Static) != 0) != staticCasters; });
+		return static_cast<uint32_t>(m_queryResults.size());
+	}
+
+	void Renderer::recordCasters(PassRecording& recording, const Frustum& frustum, bool staticCasters) const {
+		std::vector<uint32_t>& casters = recording.casters;
+		casters.clear();
+		m_sceneBVH.getTree().queryFrustum(frustum, casters);
+		std::erase_if(casters, [&](uint32_t p) { return ((m_renderables.locate(p).archetype & RenderableStore::Static) != 0) != staticCasters; });
+
+		// Casters in objects order, so that the ones sharing geometry are consecutive instances
+		for (uint32_t& p : casters) {
+			const RenderableStore::Location& location = m_renderables.locate(p);
+			p = m_renderables.getArchetype(location.archetype).first + location.index;
+		}
+		std::sort(casters.begin(), casters.end());
+
+		for (size_t c = 0; c < casters.size();) {
+			const RenderableStore::Location location = m_renderables.locateObject(casters[c]);
+			const RenderableStore::DrawCall& drawCall = m_renderables.getArchetype(location.archetype).drawCalls[location.index];
+
+			size_t end = c + 1;
+			while (m_settings.instancing && end < casters.size() && casters[end] == casters[end - 1] + 1) {
+				const RenderableStore::Location next = m_renderables.locateObject(casters[end]);
+				if (m_renderables.getArchetype(next.archetype).drawCalls[next.index].vertexArray != drawCall.vertexArray) break;
+				++end;
+			}
+
+			recordInstances(recording.commands, drawCall, casters[c], static_cast<uint32_t>(end - c));
+			++recording.count.draws;
+			recording.count.instances += static_cast<uint32_t>(end - c);
+			c = end;
+		}
+	}
+
+	Renderer::PassRange Renderer::addPointShadowRecorders(const SceneSnapshot& scene, const std::vector<CubeShadowView>& views, const std::vector<uint8_t>& faceMasks, bool staticCasters) {
+		const bool layered = s_shadowCubeMapLayeredShader && *s_shadowCubeMapLayeredShader;
+		PassRange range{ static_cast<uint32_t>(m_recorders.size()) };
+		range.last = range.first;
+
+		for (uint32_t i = 0; i < faceMasks.size(); ++i) {
+			if (faceMasks[i] == 0) continue;
+
+			const PointLight& light = scene.pointLights[i];
+			const CubeShadowView& view = views[i];
+			const uint8_t faceMask = faceMasks[i];
+			range.last = addRecorder([this, &light, &view, i, faceMask, staticCasters, layered](PassRecording& recording) {
+				if (layered)
+					recordPointShadowLayered(recording, light, i, view, faceMask, staticCasters);
+				else
+					recordPointShadowPerFace(recording, i, view, faceMask, staticCasters);
+			}) + 1;
+		}
+
+		return range;
+	}
+
+	void Renderer::recordPointShadowLayered(PassRecording& recording, const PointLight& light, uint32_t lightIndex, const CubeShadowView& view, uint8_t faceMask, bool staticCasters) const {
+		gpu::CommandBuffer& commands = recording.commands;
+		commands.useProgram(*s_shadowCubeMapLayeredShader);
+		commands.uniform1ui(s_passUniforms.layeredLightIndex.getLocation(), lightIndex);
+		commands.uniformMatrix4fv(s_passUniforms.layeredViewProj.getLocation(), 6, glm::value_ptr(view.viewProjs[0]));
+
+		// One viewport per face tile, the face is selected per instance.
+		for (uint32_t face = 0; face < 6; ++face) {
+			if (!(faceMask & (1 << face))) continue;
+
+			const ShadowAtlas::Tile& tile = m_shadowUnits.at(shadowUnitKey(true, lightIndex, face)).tile;
+			commands.viewportIndexed(face, static_cast<float>(tile.x), static_cast<float>(tile.y), static_cast<float>(tile.size), static_cast<float>(tile.size));
+			commands.scissorIndexed(face, tile.x, tile.y, tile.size, tile.size);
+		}
+
+		// Casters are looked up in the light influence sphere, no light reaches past it
+		std::vector<uint32_t>& casters = recording.casters;
+		casters.clear();
+		m_sceneBVH.getTree().querySphere(light.position, light.getInfluenceRadius(), casters);
+
+		// Compute models depth, broadcasting each primitive to the faces its bounds overlap.
+		// Instances select the faces, so each caster is its own draw.
+		for (uint32_t p : casters) {
+			const RenderableStore::Location& location = m_renderables.locate(p);
+			if (((location.archetype & RenderableStore::Static) != 0) != staticCasters) continue;
+
+			const AABB& bounds = m_sceneBVH.getPrimitiveBounds()[p];
+			GLuint faces[6];
+			GLsizei faceCount = 0;
+			for (uint32_t face = 0; face < 6; ++face) {
+				if ((faceMask & (1 << face)) && view.frusta[face].intersects(bounds))
+					faces[faceCount++] = face;
+			}
+			if (faceCount == 0) continue;
+
+			const RenderableStore::Archetype& archetype = m_renderables.getArchetype(location.archetype);
+			commands.uniform1uiv(s_passUniforms.layeredFaces.getLocation(), faceCount, faces);
+			recordInstances(commands, archetype.drawCalls[location.index], archetype.first + location.index, faceCount);
+			++recording.count.draws;
+			recording.count.instances += static_cast<uint32_t>(faceCount);
+		}
+	}
+
+	void Renderer::recordPointShadowPerFace(PassRecording& recording, uint32_t lightIndex, const CubeShadowView& view, uint8_t faceMask, bool staticCasters) const {
+		gpu::CommandBuffer& commands = recording.commands;
+		commands.useProgram(*s_shadowCubeMapShader);
+		commands.uniform1ui(s_passUniforms.cubeLightIndex.getLocation(), lightIndex);
+
+		for (uint32_t face = 0; face < 6; ++face) {
+			if (!(faceMask & (1 << face))) continue;
+
+			const ShadowAtlas::Tile& tile = m_shadowUnits.at(shadowUnitKey(true, lightIndex, face)).tile;
+			commands.viewport(tile.x, tile.y, tile.size, tile.size);
+			commands.scissor(tile.x, tile.y, tile.size, tile.size);
+			commands.uniformMatrix4fv(s_passUniforms.cubeViewProj.getLocation(), 1, glm::value_ptr(view.viewProjs[face]));
+			recordCasters(recording, view.frusta[face], staticCasters);
 		}
 	}
 
-}
\ No newline at end of file
+}
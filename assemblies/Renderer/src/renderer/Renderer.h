@@ -4,61 +4,337 @@
 
 #pragma once
 
+#include "core/JobSystem.h"
 #include "renderer/RenderTarget.h"
+#include "renderer/Bounds.h"
 #include "renderer/Camera.h"
-#include "renderer/Scene.h"
+#include "renderer/DynamicResolution.h"
+#include "renderer/Foveation.h"
+#include "renderer/Frustum.h"
+#include "renderer/GpuCuller.h"
+#include "renderer/OcclusionCuller.h"
+#include "renderer/RenderableStore.h"
+#include "renderer/RenderGraph.h"
+#include "renderer/Reprojection.h"
+#include "renderer/SceneBVH.h"
+#include "renderer/SceneSnapshot.h"
+#include "renderer/ShadowAtlas.h"
+#include "renderer/ShadowCache.h"
+#include "renderer/ShadowScheduler.h"
+#include "renderer/TransformHierarchy.h"
 #include "gpu/Buffer.h"
+#include "gpu/CommandBuffer.h"
+#include "gpu/Query.h"
+#include "gpu/RingBuffer.h"
 #include "gpu/VertexArray.h"
 #include "effects/Effect.h"
 
+#include <array>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
 namespace vr {
 
+	struct CubeShadowView;
+
 	class Renderer {
-		struct Matrices {
+		// Views drawn in one pass, the eyes of a stereo frame
+		static constexpr uint32_t s_MAX_VIEWS = 2;
+
+		// Per-frame uniforms, bound at uniform binding 0. Mono frames only fill the first view.
+		struct alignas(16) SceneData {
+			glm::mat4 viewTransforms[s_MAX_VIEWS];
+			glm::mat4 projectionTransforms[s_MAX_VIEWS];
+			glm::vec4 eyePositions[s_MAX_VIEWS];
+			glm::vec4 regions[Foveation::s_REGION_COUNT];	// Clip space scale and offset of the foveation regions
+			uint32_t viewCount;
+		};
+
+		// Per-renderable data, stored in renderables order at storage binding 4 and indexed by the draws instances.
+		struct ObjectData {
 			glm::mat4 modelTransform;
 			glm::mat4 normalTransform;
-			glm::mat4 viewTransform;
-			glm::mat4 projectionTransform;
-			glm::vec3 eyePosition;
+		};
+
+		// Light clustering parameters, bound at uniform binding 3. Each view has its own grid.
+		struct alignas(16) ClusterData {
+			glm::mat4 inverseProjections[s_MAX_VIEWS];
+			glm::uvec4 gridSize;	// Clusters of a view in w
+			glm::vec4 depthParams; // near, far, slice scale, slice bias
+			glm::vec2 screenSize;
+			uint32_t debugView;
+		};
+
+		// Shadow atlas tile of a directional cascade or point light face, stored at storage binding 8.
+		struct ShadowTileData {
+			glm::mat4 viewProjection;
+			glm::vec4 rect;	// Atlas UV offset, UV size and texel size, zero when the unit has no shadow
+		};
+
+		// Atlas state of a shadow unit, a directional cascade or a point light cube face.
+		struct ShadowUnit {
+			ShadowAtlas::Tile tile;						// Tile the unit was last rendered in
+			glm::mat4 viewProjection = glm::mat4(0.0f);	// Projection the unit was last rendered with
+			bool rendered = false;
+			bool staticPending = true;
+			bool hasDynamic = false;
+		};
+
+		// Draw calls of passes and the instances they render
+		struct DrawCount {
+			uint32_t draws = 0;
+			uint32_t instances = 0;
+
+			DrawCount& operator+=(const DrawCount& other) {
+				draws += other.draws;
+				instances += other.instances;
+				return *this;
+			}
+		};
+
+		// Commands of a pass, recorded by a worker and replayed in order by the render thread
+		struct PassRecording {
+			gpu::CommandBuffer commands;
+			std::vector<uint32_t> casters;	// Caster queries of the pass
+			DrawCount count;
+		};
+
+		using PassRecorder = std::function<void(PassRecording&)>;
+
+		// Recordings [first, last) of a pass split across workers
+		struct PassRange {
+			uint32_t first = 0;
+			uint32_t last = 0;
+		};
+
+		// Uniforms of the pass programs, resolved when they are linked. Recorders never call GL, they read the locations.
+		struct PassUniforms {
+			std::array<gpu::UniformHandle<float>, static_cast<size_t>(StereoMode::Count) * 2> alphaCutoff;	// By depth masked shader
+			gpu::UniformHandle<glm::mat4> lightViewProj;
+			gpu::UniformHandle<glm::mat4> cubeViewProj;
+			gpu::UniformHandle<uint32_t> cubeLightIndex;
+			gpu::UniformHandle<glm::mat4> layeredViewProj;
+			gpu::UniformHandle<uint32_t> layeredFaces;
+			gpu::UniformHandle<uint32_t> layeredLightIndex;
+			const gpu::ShaderProgram* screenShader = nullptr;	// Display program of the application, the handle below is resolved on it
+			gpu::UniformHandle<glm::vec2> viewportScale;
 		};
 
 	public:
+		struct Settings {
+			bool depthPrepass = true;
+			bool occlusionCulling = true;
+			bool gpuCulling = false;	// Culls on the GPU and draws the scene from indirect commands
+			bool instancing = true;		// Draws neighbouring renderables sharing material and geometry as instances
+			bool clusterDebugView = false;
+			bool multiview = true;		// Draws stereo frames with OVR_multiview when supported, with instanced stereo otherwise
+			bool parallelRecording = true;	// Records the shadow and model passes on the workers, the render thread replays them
+			bool indexedMaterials = true;	// Draws the instances of indexed material classes from the material storage and texture arrays
+			uint32_t shadowCascades = 4;		// Directional shadow cascades, from DirectionalLight::s_MIN_CASCADES to s_MAX_CASCADES
+			float cascadeSplitLambda = 0.9f;	// Blend between uniform (0) and logarithmic (1) cascade splits
+			float shadowDistance = 10.0f;		// View depth covered by the cascades
+			uint32_t shadowDepthBits = 32;		// Shadow atlas depth precision, 16 or 32
+			uint32_t shadowAtlasSize = 8192;	// Largest shadow atlas side, tiles shrink past it
+			ShadowScheduler::Settings shadows;
+			Foveation::Settings foveation;
+			Reprojection::Settings reprojection;
+			DynamicResolution::Settings dynamicResolution;	// Scales the viewport of the target, foveated frames keep the full resolution
+		};
+
+		struct Stats {
+			uint64_t prepassFragments = 0;	// Fragment shader invocations of the depth pre-pass
+			uint64_t shadingFragments = 0;	// Fragment shader invocations of the model pass
+			uint32_t occluders = 0;			// Primitives rasterized in the occlusion buffer
+			uint32_t occluderTriangles = 0;
+			uint32_t culledPrimitives = 0;	// Primitives skipped by the frustum and occlusion tests
+			uint32_t drawCalls = 0;			// Draws issued by the depth pre-pass and the model pass
+			uint32_t instances = 0;			// Instances rendered by those draws, unknown to the CPU when the GPU culls
+			float occlusionTime = 0.0f;		// CPU time of the culling, in microseconds
+			float submitTime = 0.0f;		// CPU time of the whole submission, in microseconds
+			float recordTime = 0.0f;		// CPU time of the pass recording, in microseconds
+			uint32_t recordedPasses = 0;
+			size_t recordedSize = 0;		// Commands recorded by the passes, in bytes
+			uint32_t stateCalls = 0;		// Bindings and state changes issued over the last frame
+			uint32_t skippedStateCalls = 0;	// Bindings and state changes the state cache found already set
+			uint32_t indexedMaterials = 0;	// Materials of the frame drawn by the indexed variant
+		};
+
 		Renderer(std::weak_ptr<RenderTarget> target);
 
 		static void init(int32_t width, int32_t height);
 		static void adapt(int32_t width, int32_t heigt);
 
+		/// @brief Starts a display frame.
+		/// @return Whether the scene should be drawn, false when the last frame is only reprojected to keep the display rate.
+		bool beginFrame();
+
 		void beginScene(const Camera& camera);
-		void submit(const Scene& scene);
+
+		/// @brief Begins a stereo frame, both eyes are drawn in one pass into the two layers of the target.
+		/// Culling and shadows are computed once for a camera enclosing both eye frusta. Eyes are expected
+		/// to share their orientation and projection. Falls back to the left eye if the target has a single
+		/// layer or no stereo path is supported.
+		void beginScene(const Camera& left, const Camera& right);
+		void submit(const SceneSnapshot& scene);
 		void endScene();
 		void postprocess(Effect& effect);
+
+		/// @brief Warps the last completed frame with the newest poses, right before it is displayed.
+		/// Keeps the frame drawn since the previous call as the source of the next reprojections. Does nothing
+		/// unless reprojection is enabled.
+		void reproject(const Camera& camera);
+		void reproject(const Camera& left, const Camera& right);
 		void display(const gpu::ShaderProgram& screenShader);
 
-		std::shared_ptr<gpu::Texture> getIntermediateTexture() { return s_intermediateTarget->getColorTexture(); }
+		Settings& getSettings() { return m_settings; }
+		const Stats& getStats() const { return m_stats; }
+		StereoMode getStereoMode() const { return m_stereoMode; }	// Stereo path of the current frame
+		bool isFoveated() const { return m_foveated; }				// Whether the current frame is foveated
+		const Foveation& getFoveation() const { return m_foveation; }
+		const Reprojection& getReprojection() const { return m_reprojection; }
+		const DynamicResolution& getDynamicResolution() const { return m_dynamicResolution; }
+		const RenderGraph& getRenderGraph() const { return m_renderGraph; }
+		const ShadowScheduler& getShadowScheduler() const { return m_shadowScheduler; }
+		const ShadowAtlas& getShadowAtlas() const { return m_shadowAtlas; }
+		const SceneBVH& getSceneBVH() const { return m_sceneBVH; }
+		const TransformHierarchy& getTransforms() const { return m_transforms; }
+		const RenderableStore& getRenderables() const { return m_renderables; }
+		const GpuCuller& getGpuCuller() const { return *m_gpuCuller; }
 		
 	private:
-		void renderShadowMap(const Scene& scene);
+		void beginViews(std::span<const Camera> views, const Camera& cullingCamera);
+		void bindViews() const;
+		void reprojectViews(std::span<const Camera> views);
+		void syncTransforms(const SceneSnapshot& scene);
+		void uploadFrameData(const SceneSnapshot& scene);
+		size_t findInstances(const RenderableStore::Archetype& archetype, size_t first) const;
+		void recordInstances(gpu::CommandBuffer& commands, const RenderableStore::DrawCall& drawCall, uint32_t firstObject, uint32_t count, uint32_t instanceViews = 1) const;
+		void cullPrimitives(const SceneSnapshot& scene);
+		void cullPrimitivesOnGpu();
+		void buildLightClusters();
+		ShaderVariant modelVariant(const MaterialInstance& material) const;
+		void addModelRecorders();
+		void recordDepthPrepass(const RenderableStore::Archetype& archetype, PassRecording& recording) const;
+		void recordModels(const RenderableStore::Archetype& archetype, PassRecording& recording) const;
+		void renderDepthPrepass();
+		void renderDepthPrepassIndirect();
+		void renderModels();
+		void renderModelsIndirect();
+		uint32_t addRecorder(PassRecorder recorder);
+		void recordPasses();
+		DrawCount replayPasses(PassRange range) const;
+		void readStatistics();
+		void renderShadowMap(const SceneSnapshot& scene);
+		uint32_t shadowUnitKey(bool point, uint32_t light, uint32_t face) const;
+		uint32_t queryCasters(const Frustum& frustum, bool staticCasters);
+		void recordCasters(PassRecording& recording, const Frustum& frustum, bool staticCasters) const;
+		void uploadShadowTiles(uint32_t directionalCount, uint32_t pointCount);
+		PassRange addPointShadowRecorders(const SceneSnapshot& scene, const std::vector<CubeShadowView>& views, const std::vector<uint8_t>& faceMasks, bool staticCasters);
+		void recordPointShadowLayered(PassRecording& recording, const PointLight& light, uint32_t lightIndex, const CubeShadowView& view, uint8_t faceMask, bool staticCasters) const;
+		void recordPointShadowPerFace(PassRecording& recording, uint32_t lightIndex, const CubeShadowView& view, uint8_t faceMask, bool staticCasters) const;
 
 	private:
 		std::weak_ptr<RenderTarget> m_target;
-		gpu::Buffer m_matrixBuffer;
-		gpu::Buffer m_directionalLightBuffer;
-		gpu::Buffer m_pointLightBuffer;
-		Matrices m_matrices;
-
-		const uint32_t m_SHADOW_SIZE = 4096;
-		const uint32_t m_MAX_SHADOW = 4;
-		std::unique_ptr<gpu::Texture> m_shadowMap;
-		std::unique_ptr<gpu::Texture> m_shadowCubeMap;
+		Settings m_settings;
+		Stats m_stats;
+		gpu::RingBuffer m_uniformRing;
+		gpu::Buffer m_emptyBuffer;
+		SceneData m_sceneData;
+		Camera m_camera;	// Culling camera, encloses every view of the frame
+
+		// Stereo frames draw both eyes at once, into the layers of the target
+		StereoMode m_stereoMode = StereoMode::Mono;
+		uint32_t m_viewCount = 1;
+		uint32_t m_instanceViews = 1;	// Instances drawn per object, one per view with instanced stereo and per foveation region
+		float m_cullingOffset = 0.0f;	// Distance of the culling camera behind the eyes
+		GLuint m_viewFramebuffer = 0;
+
+		// Passes from the resolve of the target to the display, executed with their transient textures when the frame is displayed
+		RenderGraph m_renderGraph;
+		RenderGraph::Resource m_frameColor = RenderGraph::s_NO_RESOURCE;	// Latest color of the frame, views side by side
+		glm::ivec2 m_frameViewport{ 0 };	// Part of the frame color drawn, from its origin
+
+		// Foveated frames draw the views in the regions of a packed target, resolved into the frame color
+		Foveation m_foveation;
+		bool m_foveated = false;
+
+		// Frames are drawn in a viewport of the target, scaled to hold a GPU frame time
+		DynamicResolution m_dynamicResolution;
+
+		// Last completed frame, reprojected with the newest poses before it is displayed
+		Reprojection m_reprojection;
+		bool m_sceneFrame = false;	// Whether a scene frame was drawn since the last reprojection
+
+		// World transforms of the scene entities, node i holds entity i
+		TransformHierarchy m_transforms;
+		uint64_t m_transformLayout = std::numeric_limits<uint64_t>::max();	// Layout revision the nodes were linked for
+		std::vector<uint32_t> m_transformParents;
+		std::vector<uint64_t> m_transformRevisions;
+
+		RenderableStore m_renderables;
+		SceneBVH m_sceneBVH;
+		std::vector<uint32_t> m_queryResults;
+		std::vector<uint8_t> m_primitiveVisible;	// Camera visibility of the flattened primitives
+
+		// Software occlusion culling, the largest static primitives occlude the others
+		const uint32_t m_MAX_OCCLUDER_TRIANGLES = 20000;
+		const float m_MIN_OCCLUDER_COVERAGE = 0.02f;
+		std::unique_ptr<OcclusionCuller> m_occlusionCuller;
+
+		// GPU driven alternative, culls in compute and draws from indirect commands
+		std::unique_ptr<GpuCuller> m_gpuCuller;
+
+		// Clustered lighting, point lights are binned in view space froxels
+		const glm::uvec3 m_CLUSTER_GRID = { 16, 9, 24 };
+		const uint32_t m_CLUSTER_MAX_LIGHTS = 128;
+		ClusterData m_clusterData;
+		gpu::Buffer m_clusterCounts;
+		gpu::Buffer m_clusterLights;
+
+		// Shadow maps of every light share one atlas, tiles are sized by the light share of the screen
+		const uint32_t m_CASCADE_SIZE = 2048;
+		const uint32_t m_POINT_SHADOW_SIZE = 1024;	// Cube face tile size of a light filling the view
+		ShadowAtlas m_shadowAtlas;
+		uint32_t m_shadowAtlasRevision = 0;
 		std::unique_ptr<gpu::Framebuffer> m_shadowFramebuffer;
+		ShadowCache m_shadowCache;
+		ShadowScheduler m_shadowScheduler;
+		std::unordered_map<uint32_t, ShadowUnit> m_shadowUnits;	// Units with a tile, by scheduler key
+		std::vector<ShadowTileData> m_shadowTiles;
+		std::vector<DirectionalLight> m_directionalLights;	// Scene lights with the splits of their cascades
+
+		std::array<gpu::Query, 3> m_shadowTimers;
+		std::array<DrawCount, 3> m_shadowTimerCounts = {};
+		uint32_t m_shadowTimerIndex = 0;
+		DrawCount m_shadowCount;
+
+		std::array<gpu::Query, 3> m_prepassQueries;
+		std::array<gpu::Query, 3> m_shadingQueries;
+		uint32_t m_statsIndex = 0;
+
+		// Shadow and model passes are recorded at once by the workers, each recorder into its own command buffer.
+		// Recordings keep their storage across frames.
+		std::vector<PassRecorder> m_recorders;
+		std::vector<PassRecording> m_recordings;
+		PassRange m_prepassRecordings;
+		PassRange m_modelRecordings;
 		
 
+		static std::unique_ptr<JobSystem> s_jobSystem;
 		static std::unique_ptr<gpu::VertexArray> s_renderVertexArray;
-		static std::unique_ptr<RenderTarget> s_intermediateTarget;
+		static glm::ivec2 s_screenSize;	// Size of the window, frame colors drawn at a resolution scale of 1
 		static std::unique_ptr<gpu::ShaderProgram> s_shadowMapShader;
 		static std::unique_ptr<gpu::ShaderProgram> s_shadowCubeMapShader;
+		static std::unique_ptr<gpu::ShaderProgram> s_shadowCubeMapLayeredShader;
+		static std::unique_ptr<gpu::ShaderProgram> s_lightClusterShader;
+		// Depth pre-pass shaders, by stereo mode and foveation
+		static std::array<std::unique_ptr<gpu::ShaderProgram>, static_cast<size_t>(StereoMode::Count) * 2> s_depthShaders;
+		static std::array<std::unique_ptr<gpu::ShaderProgram>, static_cast<size_t>(StereoMode::Count) * 2> s_depthMaskedShaders;
+		static PassUniforms s_passUniforms;
 	};
 
 }
\ No newline at end of file
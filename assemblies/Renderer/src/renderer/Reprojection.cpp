@@ -0,0 +1,208 @@
+// VR Renderer - Reprojection
+// Rodolphe VALICON
+// 2025
+
+#include "Reprojection.h"
+#include "gpu/StateCache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace vr {
+
+	Reprojection::Reprojection()
+		: m_shader("res/shaders/renderpasses/reprojection.glsl"),
+		m_layeredShader("res/shaders/renderpasses/reprojection.glsl", { "LAYERED" }) {
+		const gpu::ShaderProgram* shaders[] = { &m_shader, &m_layeredShader };
+		for (uint32_t i = 0; i < m_uniforms.size(); ++i) {
+			m_uniforms[i] = WarpUniforms{
+				.positional = shaders[i]->getUniform<int32_t>("uPositional"),
+				.frameScale = shaders[i]->getUniform<glm::vec2>("uFrameScale"),
+				.layer = shaders[i]->getUniform<int32_t>("uLayer"),
+				.inverseProjection = shaders[i]->getUniform<glm::mat4>("uInverseProjection"),
+				.reprojection = shaders[i]->getUniform<glm::mat4>("uReprojection"),
+			};
+		}
+		for (uint32_t i = 0; i < m_sceneBegin.size(); ++i) {
+			m_sceneBegin[i] = gpu::Query(GL_TIMESTAMP);
+			m_sceneEnd[i] = gpu::Query(GL_TIMESTAMP);
+		}
+	}
+
+	bool Reprojection::beginFrame() {
+		if (!m_settings.enabled || !m_frame) {
+			m_stats.interval = 1;
+			m_framesSinceScene = 0;
+			return true;
+		}
+
+		uint32_t interval = std::clamp(m_settings.sceneInterval, 1u, s_MAX_INTERVAL);
+		if (m_settings.sceneInterval == 0) {
+			// A tenth of each display frame is left to the reprojection. The interval grows as soon as the scene
+			// misses its budget, and shrinks once it fits with a margin, so that it doesn't go back and forth.
+			const float budget = 0.9f * 1e6f / std::max(m_settings.targetRate, 1.0f);
+			interval = std::max(m_stats.interval, 1u);
+			while (interval < s_MAX_INTERVAL && m_stats.sceneGpuTime > budget * interval)
+				++interval;
+			while (interval > 1 && m_stats.sceneGpuTime < 0.8f * budget * (interval - 1))
+				--interval;
+		}
+		m_stats.interval = interval;
+
+		if (++m_framesSinceScene < interval) {
+			++m_stats.reprojectedFrames;
+			return false;
+		}
+
+		m_framesSinceScene = 0;
+		return true;
+	}
+
+	void Reprojection::beginScene() {
+		if (!m_settings.enabled) return;
+
+		// GPU time of a previous scene frame, read before its queries are reused
+		if (m_sceneEnd[m_timerIndex].isAvailable())
+			m_stats.sceneGpuTime = (m_sceneEnd[m_timerIndex].getResult() - m_sceneBegin[m_timerIndex].getResult()) / 1000.0f;
+
+		m_sceneBegin[m_timerIndex].timestamp();
+		m_sceneTimed = true;
+	}
+
+	void Reprojection::capture(GLuint frame, glm::ivec2 frameSize, glm::ivec2 frameViewport, const RenderTarget* eyeTarget, std::span<const View> views) {
+		if (m_sceneTimed) {
+			m_sceneEnd[m_timerIndex].timestamp();
+			m_timerIndex = (m_timerIndex + 1) % static_cast<uint32_t>(m_sceneEnd.size());
+			m_sceneTimed = false;
+		}
+
+		m_viewCount = static_cast<uint32_t>(std::min(views.size(), m_views.size()));
+		if (m_viewCount == 0) return;
+		std::copy_n(views.begin(), m_viewCount, m_views.begin());
+
+		// Depth is read from the eye buffers, their views must match the frame ones. The kept frame is sized
+		// like the eye buffers and holds their viewport, so that a resolution change doesn't reallocate it.
+		m_hasDepth = eyeTarget && eyeTarget->getLayers() >= static_cast<int32_t>(m_viewCount);
+		const int32_t frameViewWidth = frameViewport.x / static_cast<int32_t>(m_viewCount);
+		const int32_t width = m_hasDepth ? eyeTarget->getViewportWidth() : frameViewWidth;
+		const int32_t height = m_hasDepth ? eyeTarget->getViewportHeight() : frameViewport.y;
+		const int32_t allocatedWidth = m_hasDepth ? eyeTarget->getWidth() : frameSize.x / static_cast<int32_t>(m_viewCount);
+		const int32_t allocatedHeight = m_hasDepth ? eyeTarget->getHeight() : frameSize.y;
+		const int32_t layers = static_cast<int32_t>(m_viewCount);
+		if (!m_frame || m_frame->getWidth() != allocatedWidth || m_frame->getHeight() != allocatedHeight || m_frame->getLayers() != layers)
+			m_frame = std::make_unique<RenderTarget>(allocatedWidth, allocatedHeight, 1, layers);
+		m_frame->setViewport(width, height);
+
+		const glm::ivec3 gridLayout(allocatedWidth, allocatedHeight, std::max(m_settings.gridSpacing, 1u));
+		if (!m_grid || gridLayout != m_gridLayout) {
+			m_gridLayout = gridLayout;
+			buildGrid(allocatedWidth, allocatedHeight);
+		}
+
+		// Multisampled depth can only be resolved in place, one layer at a time
+		for (int32_t view = 0; view < layers; ++view) {
+			glBlitNamedFramebuffer(
+				frame, m_frame->getLayerFramebuffer(view),
+				view * frameViewWidth, 0, (view + 1) * frameViewWidth, frameViewport.y, 0, 0, width, height,
+				GL_COLOR_BUFFER_BIT, GL_LINEAR
+			);
+
+			if (m_hasDepth) {
+				glBlitNamedFramebuffer(
+					eyeTarget->getLayerFramebuffer(view), m_frame->getLayerFramebuffer(view),
+					0, 0, width, height, 0, 0, width, height,
+					GL_DEPTH_BUFFER_BIT, GL_NEAREST
+				);
+			}
+		}
+	}
+
+	void Reprojection::reproject(GLuint destination, glm::ivec2 size, std::span<const View> views) {
+		if (!m_frame) return;
+
+		const uint32_t viewCount = static_cast<uint32_t>(std::min<size_t>(views.size(), m_viewCount));
+		const bool layered = m_frame->getLayers() > 1;
+		const gpu::ShaderProgram& shader = layered ? m_layeredShader : m_shader;
+		const WarpUniforms& uniforms = m_uniforms[layered];
+		const bool positional = m_settings.mode == Mode::Positional && m_hasDepth;
+
+		// Parts of the views the kept frame doesn't cover stay black
+		glBindFramebuffer(GL_FRAMEBUFFER, destination);
+		glViewport(0, 0, size.x, size.y);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClearDepth(1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// Grid triangles folding over each other are sorted by their new depth
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.enable(GL_DEPTH_TEST);
+		state.depthFunc(GL_LEQUAL);
+		state.depthMask(GL_TRUE);
+		state.disable(GL_CULL_FACE);
+		state.disable(GL_STENCIL_TEST);
+
+		state.useProgram(shader);
+		uniforms.positional.set(positional);
+		uniforms.frameScale.set(glm::vec2(
+			static_cast<float>(m_frame->getViewportWidth()) / m_frame->getWidth(),
+			static_cast<float>(m_frame->getViewportHeight()) / m_frame->getHeight()));
+		state.bindTextureUnit(0, *m_frame->getColorTexture());
+		state.bindTextureUnit(1, *m_frame->getDepthStencilTexture());
+		state.bindVertexArray(*m_grid);
+
+		const int32_t viewWidth = size.x / static_cast<int32_t>(std::max(viewCount, 1u));
+		for (uint32_t view = 0; view < viewCount; ++view) {
+			// From the view space the frame was drawn in, to the clip space of the newest pose
+			const glm::mat4 inverseProjection = glm::inverse(m_views[view].projection);
+			const glm::mat4 reprojection = views[view].projection * views[view].view * glm::inverse(m_views[view].view);
+
+			glViewport(static_cast<int32_t>(view) * viewWidth, 0, viewWidth, size.y);
+			uniforms.layer.set(static_cast<int32_t>(view));
+			uniforms.inverseProjection.set(inverseProjection);
+			uniforms.reprojection.set(reprojection);
+			glDrawElements(GL_TRIANGLES, m_grid->getElementCount(), GL_UNSIGNED_INT, nullptr);
+		}
+
+		glViewport(0, 0, size.x, size.y);
+		state.depthFunc(GL_LESS);
+	}
+
+	void Reprojection::buildGrid(int32_t width, int32_t height) {
+		const int32_t spacing = m_gridLayout.z;
+		const int32_t columns = std::max((width + spacing - 1) / spacing, 1);
+		const int32_t rows = std::max((height + spacing - 1) / spacing, 1);
+
+		// Vertices on texel corners, the last row and column on the view edges
+		std::vector<float> vertices;
+		vertices.reserve(static_cast<size_t>(columns + 1) * (rows + 1) * 2);
+		for (int32_t y = 0; y <= rows; ++y) {
+			for (int32_t x = 0; x <= columns; ++x) {
+				vertices.push_back(static_cast<float>(std::min(x * spacing, width)) / width);
+				vertices.push_back(static_cast<float>(std::min(y * spacing, height)) / height);
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		indices.reserve(static_cast<size_t>(columns) * rows * 6);
+		for (int32_t y = 0; y < rows; ++y) {
+			for (int32_t x = 0; x < columns; ++x) {
+				const uint32_t corner = static_cast<uint32_t>(y * (columns + 1) + x);
+				const uint32_t above = corner + static_cast<uint32_t>(columns + 1);
+				indices.insert(indices.end(), { corner, corner + 1, above + 1, above + 1, above, corner });
+			}
+		}
+
+		gpu::GeometryData grid{
+			.layout = gpu::VertexLayout{ gpu::VertexAttribute(gpu::Attribute::Position, GL_FLOAT, 2) },
+			.vertex_data{ reinterpret_cast<uint8_t*>(vertices.data()), reinterpret_cast<uint8_t*>(vertices.data() + vertices.size()) },
+			.indices = std::move(indices),
+			.topology = GL_TRIANGLES,
+		};
+
+		m_grid = std::make_unique<gpu::VertexArray>(grid);
+	}
+
+}
@@ -0,0 +1,118 @@
+// VR Renderer - Reprojection
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/Query.h"
+#include "gpu/ShaderProgram.h"
+#include "gpu/VertexArray.h"
+#include "renderer/RenderTarget.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace vr {
+
+	/// @brief Reprojection (timewarp) of the last completed frame with the newest head pose, right before it is presented.
+	/// The frame color and depth are kept with the views they were drawn with. Each view is warped through a grid moved
+	/// by the kept depth, or only rotated. Scene frames that don't fit in the display budget are drawn every few display
+	/// frames, the display frames in between reproject the last one, so that the display rate holds.
+	class Reprojection {
+	public:
+		static constexpr uint32_t s_MAX_VIEWS = 2;
+		static constexpr uint32_t s_MAX_INTERVAL = 4;	// Most display frames per scene frame
+
+		enum class Mode : uint32_t {
+			Rotation = 0,	// Orientation change only, the frame is moved as if infinitely far
+			Positional,		// Depth aware, every point of the frame is moved by the pose change
+		};
+
+		struct Settings {
+			bool enabled = false;
+			Mode mode = Mode::Positional;
+			float targetRate = 90.0f;	// Display frames per second
+			uint32_t sceneInterval = 0;	// Display frames per scene frame, 0 adapts it to the GPU time of the scene
+			uint32_t gridSpacing = 8;	// Pixels between the vertices of the warp grid
+		};
+
+		struct Stats {
+			float sceneGpuTime = 0.0f;		// GPU time of a scene frame, in microseconds
+			uint32_t interval = 1;			// Display frames per scene frame
+			uint32_t reprojectedFrames = 0;	// Display frames that only reprojected the last scene frame
+		};
+
+		/// @brief Transforms of a view, as it was drawn or as it is about to be presented.
+		struct View {
+			glm::mat4 view;
+			glm::mat4 projection;
+		};
+
+		Reprojection();
+
+		/// @brief Starts a display frame.
+		/// @return Whether the scene is drawn, false when the last frame is only reprojected.
+		bool beginFrame();
+
+		/// @brief Marks the start of the scene commands, to measure their GPU time.
+		void beginScene();
+
+		/// @brief Keeps a completed frame as the source of the next reprojections.
+		/// @param frame Framebuffer of the single sample color of the frame, views side by side.
+		/// @param frameSize Size of the frame color.
+		/// @param frameViewport Part of the frame color drawn, from its origin.
+		/// @param eyeTarget Depth of each view in its layers, nullptr when the frame has none. The frame is then only rotated.
+		/// @param views Views the frame was drawn with.
+		void capture(GLuint frame, glm::ivec2 frameSize, glm::ivec2 frameViewport, const RenderTarget* eyeTarget, std::span<const View> views);
+
+		/// @brief Warps the kept frame into a framebuffer with a color and a depth attachment, views side by side, with newer views.
+		void reproject(GLuint destination, glm::ivec2 size, std::span<const View> views);
+
+		bool hasFrame() const { return m_frame != nullptr; }
+		uint32_t getViewCount() const { return m_viewCount; }
+		Settings& getSettings() { return m_settings; }
+		const Stats& getStats() const { return m_stats; }
+
+	private:
+		void buildGrid(int32_t width, int32_t height);
+
+	private:
+		Settings m_settings;
+		Stats m_stats;
+
+		// Last completed frame, a layer per view
+		std::unique_ptr<RenderTarget> m_frame;
+		std::array<View, s_MAX_VIEWS> m_views{};
+		uint32_t m_viewCount = 0;
+		bool m_hasDepth = false;
+
+		// Grid covering a view, its vertices are the UVs of the kept frame
+		std::unique_ptr<gpu::VertexArray> m_grid;
+		glm::ivec3 m_gridLayout{ 0 };	// Frame size and spacing the grid was built for
+
+		// Scene frames pacing, against the GPU time of previous scene frames
+		std::array<gpu::Query, 3> m_sceneBegin;
+		std::array<gpu::Query, 3> m_sceneEnd;
+		uint32_t m_timerIndex = 0;
+		bool m_sceneTimed = false;
+		uint32_t m_framesSinceScene = 0;
+
+		// Warp program of single and layered frames, along with their uniforms
+		struct WarpUniforms {
+			gpu::UniformHandle<int32_t> positional;
+			gpu::UniformHandle<glm::vec2> frameScale;
+			gpu::UniformHandle<int32_t> layer;
+			gpu::UniformHandle<glm::mat4> inverseProjection;
+			gpu::UniformHandle<glm::mat4> reprojection;
+		};
+
+		gpu::ShaderProgram m_shader;
+		gpu::ShaderProgram m_layeredShader;
+		std::array<WarpUniforms, 2> m_uniforms;	// Single, then layered
+	};
+
+}
@@ -5,7 +5,7 @@
 #pragma once
 
 #include "renderer/Skybox.h"
-#include "renderer/Mesh.h"
+#include "renderer/EntityStore.h"
 #include "renderer/DirectionalLight.h"
 #include "renderer/PointLight.h"
 
@@ -17,7 +17,7 @@ namespace vr {
 
 	struct Scene {
 		std::shared_ptr<Skybox> skybox;
-		std::vector<std::shared_ptr<Mesh>> meshes;
+		EntityStore entities;
 		std::vector<DirectionalLight> directionalLights;
 		std::vector<PointLight> pointLights;
 	};
@@ -0,0 +1,68 @@
+// VR Renderer - Scene BVH
+// Rodolphe VALICON
+// 2025
+
+#include "SceneBVH.h"
+
+namespace vr {
+
+	void SceneBVH::update(const SceneSnapshot& scene, const TransformHierarchy& transforms) {
+		m_stats.refittedPrimitives = 0;
+
+		// Rebuild when entities or renderables were added, removed or edited
+		const EntityStore::Layout& layout = *scene.layout;
+		if (layout.revision != m_layoutRevision) {
+			build(layout, transforms);
+			return;
+		}
+
+		// Refit the moved entities only
+		for (uint32_t e = 0; e < layout.getEntityCount(); ++e) {
+			const uint64_t revision = transforms.getRevision(e);
+			if (revision == m_revisions[e]) continue;
+
+			m_revisions[e] = revision;
+			const glm::mat4& modelMatrix = transforms.getWorldMatrix(e);
+			const uint32_t first = layout.firstRenderables[e];
+			const uint32_t end = layout.firstRenderables[e + 1];
+			for (uint32_t r = first; r < end; ++r)
+				m_tree.update(r, layout.bounds[r].transformed(modelMatrix));
+
+			m_stats.refittedPrimitives += end - first;
+		}
+
+		if (m_tree.refit())
+			++m_stats.builds;
+	}
+
+	bool SceneBVH::raycast(const Ray& ray, float maxDistance, Item& item) const {
+		std::vector<BoundingVolumeHierarchy::RayHit> hits;
+		m_tree.queryRay(ray, maxDistance, hits);
+
+		for (const BoundingVolumeHierarchy::RayHit& hit : hits) {
+			if (hit.distance <= 0.0f) continue;
+
+			item = getItem(hit.object);
+			return true;
+		}
+
+		return false;
+	}
+
+	void SceneBVH::build(const EntityStore::Layout& layout, const TransformHierarchy& transforms) {
+		m_layoutRevision = layout.revision;
+		m_entities = layout.entities;
+		m_revisions.resize(layout.getEntityCount());
+		for (uint32_t e = 0; e < layout.getEntityCount(); ++e)
+			m_revisions[e] = transforms.getRevision(e);
+
+		std::vector<AABB> bounds(layout.getRenderableCount());
+		for (uint32_t r = 0; r < layout.getRenderableCount(); ++r)
+			bounds[r] = layout.bounds[r].transformed(transforms.getWorldMatrix(layout.entities[r]));
+
+		m_tree.build(bounds);
+		m_stats.refittedPrimitives = static_cast<uint32_t>(bounds.size());
+		++m_stats.builds;
+	}
+
+}
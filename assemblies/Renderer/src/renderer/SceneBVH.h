@@ -0,0 +1,56 @@
+// VR Renderer - Scene BVH
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/BoundingVolumeHierarchy.h"
+#include "renderer/SceneSnapshot.h"
+#include "renderer/TransformHierarchy.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Spatial index of the primitives of a scene, in world space.
+	/// Primitives are identified by their renderable index in the entity store of the scene.
+	/// Moved entities are refitted, the tree is only built from scratch when the layout of the store is edited.
+	class SceneBVH {
+	public:
+		struct Item {
+			uint32_t entity;
+			uint32_t renderable;
+		};
+
+		struct Stats {
+			uint32_t refittedPrimitives = 0;	// During the last update
+			uint32_t builds = 0;				// Full builds, including the rebuilds of degraded trees
+		};
+
+		/// @brief Follows the changes of the scene since the last update.
+		/// @param transforms Up to date world transforms of the scene entities, in the same order.
+		void update(const SceneSnapshot& scene, const TransformHierarchy& transforms);
+
+		/// @brief Finds the nearest primitive box in front of the ray origin, ignoring the boxes around it.
+		/// @return false if no box is hit.
+		bool raycast(const Ray& ray, float maxDistance, Item& item) const;
+
+		const BoundingVolumeHierarchy& getTree() const { return m_tree; }
+		const std::vector<AABB>& getPrimitiveBounds() const { return m_tree.getBounds(); }
+		Item getItem(uint32_t primitive) const { return Item{ m_entities[primitive], primitive }; }
+		const Stats& getStats() const { return m_stats; }
+
+	private:
+		void build(const EntityStore::Layout& layout, const TransformHierarchy& transforms);
+
+	private:
+		BoundingVolumeHierarchy m_tree;
+		std::vector<uint32_t> m_entities;	// Entity of each primitive
+		std::vector<uint64_t> m_revisions;	// World transform revision of each entity
+		uint64_t m_layoutRevision = std::numeric_limits<uint64_t>::max();
+		Stats m_stats;
+	};
+
+}
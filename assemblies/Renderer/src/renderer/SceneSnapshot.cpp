@@ -0,0 +1,40 @@
+// VR Renderer - Scene Snapshot
+// Rodolphe VALICON
+// 2025
+
+#include "SceneSnapshot.h"
+
+namespace vr {
+
+	void SceneSnapshot::capture(const Scene& scene) {
+		skybox = scene.skybox;
+		layout = scene.entities.getLayout();
+		directionalLights.assign(scene.directionalLights.begin(), scene.directionalLights.end());
+		pointLights.assign(scene.pointLights.begin(), scene.pointLights.end());
+
+		// Revisions are brought up to date before the copy, the render thread compares them without touching the scene
+		const std::vector<Transform>& sceneTransforms = scene.entities.getTransforms();
+		for (const Transform& transform : sceneTransforms)
+			transform.getRevision();
+		transforms.assign(sceneTransforms.begin(), sceneTransforms.end());
+		parents.assign(scene.entities.getParents().begin(), scene.entities.getParents().end());
+
+		materialDeltas = MaterialInstance::TakeDeltas();
+	}
+
+	void SceneSnapshot::applyMaterialDeltas() const {
+		for (const MaterialInstance::Delta& delta : materialDeltas)
+			MaterialInstance::ApplyDelta(delta);
+
+		// Materials loaded by the render thread record their initial parameters on it
+		for (const MaterialInstance::Delta& delta : MaterialInstance::TakeDeltas())
+			MaterialInstance::ApplyDelta(delta);
+	}
+
+	void SceneSnapshot::release() {
+		skybox.reset();
+		layout.reset();
+		materialDeltas.clear();
+	}
+
+}
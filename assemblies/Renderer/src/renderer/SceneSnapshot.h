@@ -0,0 +1,40 @@
+// VR Renderer - Scene Snapshot
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/MaterialInstance.h"
+#include "renderer/Scene.h"
+#include "renderer/Transform.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Immutable copy of a scene, rendered by the render thread while the update thread edits the scene.
+	/// Transforms, parents and lights are copied. The layout of the entity store is shared, the update thread copies it
+	/// before editing it again. Material edits are carried as deltas.
+	struct SceneSnapshot {
+		std::shared_ptr<Skybox> skybox;
+		std::shared_ptr<const EntityStore::Layout> layout;
+		std::vector<Transform> transforms;		// Local transform of each entity
+		std::vector<uint32_t> parents;			// Parent entity of each entity, EntityStore::s_NO_ENTITY for none
+		std::vector<DirectionalLight> directionalLights;
+		std::vector<PointLight> pointLights;
+		std::vector<MaterialInstance::Delta> materialDeltas;
+
+		/// @brief Copies a scene, with the material edits recorded by the calling thread since the last capture.
+		/// Vectors keep their storage across captures.
+		void capture(const Scene& scene);
+
+		/// @brief Applies the material edits to the render thread copies, with the ones the render thread recorded itself.
+		void applyMaterialDeltas() const;
+
+		/// @brief Drops the references to the scene, on the render thread.
+		void release();
+	};
+
+}
@@ -0,0 +1,308 @@
+// VR Renderer - Shadow Atlas
+// Rodolphe VALICON
+// 2025
+
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <unordered_set>
+
+namespace vr {
+
+	// Even bits of a Morton code, the other coordinate is in the odd bits.
+	static uint32_t CompactBits(uint64_t code) {
+		code &= 0x5555555555555555ull;
+		code = (code | (code >> 1)) & 0x3333333333333333ull;
+		code = (code | (code >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+		code = (code | (code >> 4)) & 0x00FF00FF00FF00FFull;
+		code = (code | (code >> 8)) & 0x0000FFFF0000FFFFull;
+		code = (code | (code >> 16)) & 0x00000000FFFFFFFFull;
+		return static_cast<uint32_t>(code);
+	}
+
+	void ShadowAtlas::begin() {
+		m_requests.clear();
+	}
+
+	void ShadowAtlas::request(uint32_t key, float resolution, float priority) {
+		const uint32_t maxTileSize = std::bit_floor(m_settings.maxSize);
+		const float level = std::log2(std::clamp(resolution, static_cast<float>(m_settings.minTileSize), static_cast<float>(maxTileSize)));
+		uint32_t size = 1u << static_cast<uint32_t>(std::lround(level));
+
+		// Small changes of influence keep the current size, so that tiles don't move back and forth
+		const Tile current = getTile(key);
+		if (current.size > 0 && std::abs(level - std::log2(static_cast<float>(current.size))) < 0.75f)
+			size = current.size;
+
+		m_requests.push_back({ key, std::clamp(size, m_settings.minTileSize, maxTileSize), priority });
+	}
+
+	void ShadowAtlas::allocate() {
+		// Depth can't be converted, a format change drops every tile. So does a size limit below the atlas size.
+		if (m_settings.format != m_format || m_size > std::bit_floor(m_settings.maxSize)) {
+			m_format = m_settings.format;
+			m_tiles.clear();
+			resize(0, false);
+		}
+
+		// Free the tiles no longer requested
+		std::unordered_set<uint32_t> requested;
+		for (const Request& request : m_requests)
+			requested.insert(request.key);
+
+		for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+			if (requested.contains(it->first)) {
+				++it;
+				continue;
+			}
+
+			freeBlock(it->second);
+			it = m_tiles.erase(it);
+		}
+
+		// Most important units first, the others get smaller tiles or none once the atlas is full
+		std::sort(m_requests.begin(), m_requests.end(), [](const Request& a, const Request& b) {
+			return a.priority != b.priority ? a.priority > b.priority : a.key < b.key;
+		});
+
+		// Halve the largest tiles, least important first, until every request fits in the largest atlas
+		const uint32_t maxSize = std::bit_floor(m_settings.maxSize);
+		const uint64_t maxArea = static_cast<uint64_t>(maxSize) * maxSize;
+		uint64_t area = 0;
+		for (const Request& request : m_requests)
+			area += static_cast<uint64_t>(request.size) * request.size;
+
+		for (uint32_t size = maxSize; area > maxArea && size > m_settings.minTileSize; size /= 2) {
+			for (auto it = m_requests.rbegin(); it != m_requests.rend() && area > maxArea; ++it) {
+				if (it->size != size) continue;
+				area -= static_cast<uint64_t>(size) * size * 3 / 4;
+				it->size /= 2;
+			}
+		}
+
+		bool failed = false;
+		for (const Request& request : m_requests) {
+			auto current = m_tiles.find(request.key);
+			if (current != m_tiles.end() && current->second.size == request.size) continue;
+
+			// Grow by quadrants, the placed tiles keep their position
+			Tile tile;
+			bool placed = allocateBlock(request.size, tile);
+			while (!placed && m_size < maxSize) {
+				resize(m_size > 0 ? m_size * 2 : request.size, true);
+				placed = allocateBlock(request.size, tile);
+			}
+
+			// Resized tiles keep their block until a new one is found, moving everything would cost more
+			if (current != m_tiles.end()) {
+				if (placed) {
+					freeBlock(current->second);
+					current->second = tile;
+				}
+				continue;
+			}
+
+			for (uint32_t size = request.size / 2; !placed && size >= m_settings.minTileSize; size /= 2)
+				placed = allocateBlock(size, tile);
+
+			failed |= !placed || tile.size != request.size;
+			if (placed)
+				m_tiles[request.key] = tile;
+		}
+
+		// Fragmentation rather than the lack of space left a new tile out, place every tile again
+		if (failed)
+			repack();
+
+		// Shrink by quadrants while the tiles fit in the first one, leaving room to grow again
+		while (m_size > 0) {
+			if (m_tiles.empty()) {
+				resize(0, false);
+				break;
+			}
+
+			const uint32_t half = m_size / 2;
+			uint64_t usedArea = 0;
+			bool fits = half >= m_settings.minTileSize;
+			for (const auto& [key, tile] : m_tiles) {
+				usedArea += static_cast<uint64_t>(tile.size) * tile.size;
+				fits &= tile.x + tile.size <= half && tile.y + tile.size <= half;
+			}
+
+			if (!fits || usedArea * 2 > static_cast<uint64_t>(half) * half) break;
+			resize(half, true);
+		}
+	}
+
+	ShadowAtlas::Tile ShadowAtlas::getTile(uint32_t key) const {
+		auto it = m_tiles.find(key);
+		return it != m_tiles.end() ? it->second : Tile{};
+	}
+
+	size_t ShadowAtlas::getMemorySize() const {
+		const size_t texelSize = m_format == GL_DEPTH_COMPONENT16 ? 2 : 4;
+		return 2 * static_cast<size_t>(m_size) * m_size * texelSize;
+	}
+
+	uint32_t ShadowAtlas::getLevel(uint32_t size) const {
+		return std::countr_zero(m_size) - std::countr_zero(size);
+	}
+
+	bool ShadowAtlas::allocateBlock(uint32_t size, Tile& tile) {
+		if (size > m_size || size < m_settings.minTileSize) return false;
+
+		const uint32_t level = getLevel(size);
+		int32_t source = static_cast<int32_t>(level);
+		while (source >= 0 && m_freeBlocks[source].empty())
+			--source;
+		if (source < 0) return false;
+
+		// Blocks closest to the origin first, so that the atlas can shrink
+		std::vector<Tile>& blocks = m_freeBlocks[source];
+		auto it = std::min_element(blocks.begin(), blocks.end(), [](const Tile& a, const Tile& b) {
+			return std::max(a.x, a.y) != std::max(b.x, b.y) ? std::max(a.x, a.y) < std::max(b.x, b.y) : (a.y != b.y ? a.y < b.y : a.x < b.x);
+		});
+
+		Tile block = *it;
+		blocks.erase(it);
+
+		// Split down to the requested size, freeing the other quadrants
+		for (uint32_t l = source; l < level; ++l) {
+			const uint32_t half = block.size / 2;
+			m_freeBlocks[l + 1].push_back({ block.x + half, block.y, half });
+			m_freeBlocks[l + 1].push_back({ block.x, block.y + half, half });
+			m_freeBlocks[l + 1].push_back({ block.x + half, block.y + half, half });
+			block.size = half;
+		}
+
+		tile = block;
+		return true;
+	}
+
+	void ShadowAtlas::freeBlock(const Tile& tile) {
+		Tile block = tile;
+		for (uint32_t level = getLevel(block.size); level > 0; --level) {
+			const uint32_t parentSize = block.size * 2;
+			const Tile parent{ block.x & ~(parentSize - 1), block.y & ~(parentSize - 1), parentSize };
+
+			// Merge with the 3 other quadrants of the parent when they are all free
+			std::vector<Tile>& blocks = m_freeBlocks[level];
+			auto isSibling = [&](const Tile& other) {
+				return (other.x & ~(parentSize - 1)) == parent.x && (other.y & ~(parentSize - 1)) == parent.y;
+			};
+
+			if (std::count_if(blocks.begin(), blocks.end(), isSibling) < 3) break;
+			std::erase_if(blocks, isSibling);
+			block = parent;
+		}
+
+		m_freeBlocks[getLevel(block.size)].push_back(block);
+	}
+
+	void ShadowAtlas::rebuildFreeBlocks() {
+		m_freeBlocks.clear();
+		if (m_size == 0) return;
+
+		m_freeBlocks.resize(getLevel(m_settings.minTileSize) + 1);
+		m_freeBlocks[0].push_back({ 0, 0, m_size });
+
+		// Carve each tile out of the free block holding it
+		for (const auto& [key, tile] : m_tiles) {
+			for (uint32_t level = 0; level <= getLevel(tile.size); ++level) {
+				std::vector<Tile>& blocks = m_freeBlocks[level];
+				auto it = std::find_if(blocks.begin(), blocks.end(), [&](const Tile& block) {
+					return tile.x >= block.x && tile.x < block.x + block.size && tile.y >= block.y && tile.y < block.y + block.size;
+				});
+				if (it == blocks.end()) continue;
+
+				Tile block = *it;
+				blocks.erase(it);
+				while (block.size > tile.size) {
+					const uint32_t half = block.size / 2;
+					const Tile quadrants[4] = {
+						{ block.x, block.y, half }, { block.x + half, block.y, half },
+						{ block.x, block.y + half, half }, { block.x + half, block.y + half, half },
+					};
+
+					for (const Tile& quadrant : quadrants) {
+						if (tile.x >= quadrant.x && tile.x < quadrant.x + half && tile.y >= quadrant.y && tile.y < quadrant.y + half)
+							block = quadrant;
+						else
+							m_freeBlocks[getLevel(half)].push_back(quadrant);
+					}
+				}
+				break;
+			}
+		}
+	}
+
+	bool ShadowAtlas::repack() {
+		const uint32_t maxSize = std::bit_floor(m_settings.maxSize);
+		uint64_t area = 0;
+		for (const Request& request : m_requests)
+			area += static_cast<uint64_t>(request.size) * request.size;
+
+		if (area > static_cast<uint64_t>(maxSize) * maxSize) return false;
+
+		uint32_t size = m_settings.minTileSize;
+		while (static_cast<uint64_t>(size) * size < area)
+			size *= 2;
+
+		// Power of two tiles sorted by decreasing size follow the Z-order curve without any gap
+		std::vector<Request> requests = m_requests;
+		std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+			return a.size != b.size ? a.size > b.size : a.key < b.key;
+		});
+
+		m_tiles.clear();
+		const uint64_t cellArea = static_cast<uint64_t>(m_settings.minTileSize) * m_settings.minTileSize;
+		uint64_t offset = 0;
+		for (const Request& request : requests) {
+			const uint64_t cell = offset / cellArea;
+			m_tiles[request.key] = Tile{ CompactBits(cell) * m_settings.minTileSize, CompactBits(cell >> 1) * m_settings.minTileSize, request.size };
+			offset += static_cast<uint64_t>(request.size) * request.size;
+		}
+
+		resize(size, false);
+		rebuildFreeBlocks();
+		return true;
+	}
+
+	void ShadowAtlas::resize(uint32_t size, bool keepContent) {
+		if (!keepContent)
+			++m_revision;
+		if (size == m_size) return;
+
+		std::unique_ptr<gpu::Texture> texture;
+		std::unique_ptr<gpu::Texture> staticTexture;
+		if (size > 0) {
+			// Tiles are sampled within their bounds, no border is needed
+			gpu::Sampler sampler;
+			sampler.magFilter = GL_LINEAR;
+			sampler.minFilter = GL_LINEAR;
+			sampler.wrapS = GL_CLAMP_TO_EDGE;
+			sampler.wrapT = GL_CLAMP_TO_EDGE;
+			sampler.wrapR = GL_CLAMP_TO_EDGE;
+
+			texture = std::make_unique<gpu::Texture>(GL_TEXTURE_2D, sampler);
+			staticTexture = std::make_unique<gpu::Texture>(GL_TEXTURE_2D, sampler);
+			glTextureStorage2D(*texture, 1, m_format, size, size);
+			glTextureStorage2D(*staticTexture, 1, m_format, size, size);
+
+			// Growing keeps the atlas in the first quadrant, shrinking keeps the first quadrant
+			if (keepContent && m_size > 0) {
+				const uint32_t copySize = std::min(size, m_size);
+				glCopyImageSubData(*m_texture, GL_TEXTURE_2D, 0, 0, 0, 0, *texture, GL_TEXTURE_2D, 0, 0, 0, 0, copySize, copySize, 1);
+				glCopyImageSubData(*m_staticTexture, GL_TEXTURE_2D, 0, 0, 0, 0, *staticTexture, GL_TEXTURE_2D, 0, 0, 0, 0, copySize, copySize, 1);
+			}
+		}
+
+		m_texture = std::move(texture);
+		m_staticTexture = std::move(staticTexture);
+		m_size = size;
+		rebuildFreeBlocks();
+	}
+
+}
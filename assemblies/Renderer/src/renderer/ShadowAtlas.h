@@ -0,0 +1,92 @@
+// VR Renderer - Shadow Atlas
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/Texture.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Single depth texture holding the shadow maps of every shadowed light, one square tile per unit.
+	/// Tile sizes are requested each frame and rounded to powers of two, so that a quadtree buddy allocator
+	/// places them. Tiles keep their place while their size doesn't change, the atlas grows and shrinks by
+	/// quadrants so that resizing keeps the content, and a full repack only happens when fragmentation makes
+	/// an allocation fail. A mirrored static atlas holds the cached static casters depth of the same tiles.
+	class ShadowAtlas {
+	public:
+		struct Settings {
+			GLenum format = GL_DEPTH_COMPONENT32F;	// GL_DEPTH_COMPONENT16 or GL_DEPTH_COMPONENT32F
+			uint32_t maxSize = 8192;				// Largest atlas side
+			uint32_t minTileSize = 64;
+		};
+
+		struct Tile {
+			uint32_t x = 0;
+			uint32_t y = 0;
+			uint32_t size = 0;	// 0 when the unit has no tile
+
+			bool operator==(const Tile& other) const = default;
+		};
+
+		ShadowAtlas() = default;
+
+		/// @brief Starts collecting the tile requests of a frame.
+		void begin();
+
+		/// @brief Requests a tile for a shadow unit.
+		/// @param key Unique and stable identifier of the unit.
+		/// @param resolution Desired tile side in texels, rounded to a power of two.
+		/// @param priority Importance of the unit, the least important tiles are dropped when the atlas is full.
+		void request(uint32_t key, float resolution, float priority);
+
+		/// @brief Places the requested tiles, frees the ones no longer requested, and resizes the textures.
+		/// Content is kept for the tiles that didn't move, the others have to be rendered again.
+		void allocate();
+
+		/// @brief Provides the tile of a unit, of size 0 if it didn't get one.
+		Tile getTile(uint32_t key) const;
+
+		Settings& getSettings() { return m_settings; }
+		uint32_t getSize() const { return m_size; }
+		uint32_t getRevision() const { return m_revision; }	// Changes whenever the tiles content is lost
+		uint32_t getTileCount() const { return static_cast<uint32_t>(m_tiles.size()); }
+		size_t getMemorySize() const;
+		GLuint getTexture() const { return m_texture ? static_cast<GLuint>(*m_texture) : 0; }
+		GLuint getStaticTexture() const { return m_staticTexture ? static_cast<GLuint>(*m_staticTexture) : 0; }
+
+	private:
+		struct Request {
+			uint32_t key;
+			uint32_t size;
+			float priority;
+		};
+
+		uint32_t getLevel(uint32_t size) const;
+		bool allocateBlock(uint32_t size, Tile& tile);
+		void freeBlock(const Tile& tile);
+		void rebuildFreeBlocks();
+		bool repack();
+		void resize(uint32_t size, bool keepContent);
+
+	private:
+		Settings m_settings;
+		GLenum m_format = GL_NONE;
+		uint32_t m_size = 0;
+		uint32_t m_revision = 0;
+		std::unique_ptr<gpu::Texture> m_texture;
+		std::unique_ptr<gpu::Texture> m_staticTexture;
+
+		std::vector<Request> m_requests;
+		std::unordered_map<uint32_t, Tile> m_tiles;
+		std::vector<std::vector<Tile>> m_freeBlocks;	// Per quadtree level, level 0 is the whole atlas
+	};
+
+}
@@ -0,0 +1,54 @@
+// VR Renderer - Shadow Cache
+// Rodolphe VALICON
+// 2025
+
+#include "ShadowCache.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace vr {
+
+	void ShadowCache::update(const SceneSnapshot& scene, const TransformHierarchy& transforms, const std::vector<glm::mat4>& cascadeMatrices) {
+		// Static casters change with the layout of the entities, or when one of them moves
+		const EntityStore::Layout& layout = *scene.layout;
+		bool castersChanged = m_invalidated || layout.revision != m_layoutRevision;
+		m_layoutRevision = layout.revision;
+		m_casterRevisions.resize(layout.getEntityCount());
+		for (uint32_t e = 0; e < layout.getEntityCount(); ++e) {
+			if (!(layout.entityFlags[e] & EntityStore::Static)) continue;
+
+			const uint64_t revision = transforms.getRevision(e);
+			castersChanged = castersChanged || revision != m_casterRevisions[e];
+			m_casterRevisions[e] = revision;
+		}
+		m_invalidated = false;
+
+		// Directional cascades only depend on their projection
+		m_cascadeDirty.assign(cascadeMatrices.size(), castersChanged);
+		m_cascadeMatrices.resize(cascadeMatrices.size(), glm::mat4(0.0f));
+		for (uint32_t i = 0; i < cascadeMatrices.size(); ++i) {
+			if (cascadeMatrices[i] != m_cascadeMatrices[i]) {
+				m_cascadeMatrices[i] = cascadeMatrices[i];
+				m_cascadeDirty[i] = true;
+			}
+		}
+
+		// Point lights only depend on their position
+		const uint32_t pointCount = static_cast<uint32_t>(scene.pointLights.size());
+		m_pointDirty.assign(pointCount, castersChanged);
+		m_pointPositions.resize(pointCount, glm::vec3(std::numeric_limits<float>::quiet_NaN()));
+		for (uint32_t i = 0; i < pointCount; ++i) {
+			const glm::vec3& position = scene.pointLights[i].position;
+			if (position != m_pointPositions[i]) {
+				m_pointPositions[i] = position;
+				m_pointDirty[i] = true;
+			}
+		}
+	}
+
+	void ShadowCache::invalidate() {
+		m_invalidated = true;
+	}
+
+}
@@ -0,0 +1,45 @@
+// VR Renderer - Shadow Cache
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/SceneSnapshot.h"
+#include "renderer/TransformHierarchy.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Tracks the scene state the cached static shadow layers were rendered with.
+	/// A static layer is dirty when its projection moved, or when any static caster changed.
+	/// Directional lights have one layer per cascade, point lights one per light for their 6 faces.
+	class ShadowCache {
+	public:
+		/// @brief Compares the scene with the cached state, and flags the lights to re-render.
+		/// @param scene Scene about to be rendered.
+		/// @param transforms Up to date world transforms of the scene entities, in the same order.
+		/// @param cascadeMatrices Projections of the directional shadow cascades, DirectionalLight::s_MAX_CASCADES per light.
+		void update(const SceneSnapshot& scene, const TransformHierarchy& transforms, const std::vector<glm::mat4>& cascadeMatrices);
+
+		/// @brief Flags every light static layer as dirty.
+		void invalidate();
+
+		bool isCascadeDirty(uint32_t layer) const { return m_cascadeDirty[layer]; }
+		bool isPointDirty(uint32_t light) const { return m_pointDirty[light]; }
+
+	private:
+		uint64_t m_layoutRevision = 0;
+		std::vector<uint64_t> m_casterRevisions;	// World transform revision of each entity, only kept for the static ones
+		std::vector<glm::mat4> m_cascadeMatrices;
+		std::vector<glm::vec3> m_pointPositions;
+
+		std::vector<bool> m_cascadeDirty;
+		std::vector<bool> m_pointDirty;
+		bool m_invalidated = true;
+	};
+
+}
@@ -0,0 +1,72 @@
+// VR Renderer - Shadow Scheduler
+// Rodolphe VALICON
+// 2025
+
+#include "ShadowScheduler.h"
+
+#include <algorithm>
+
+namespace vr {
+
+	void ShadowScheduler::begin() {
+		m_candidates.clear();
+	}
+
+	void ShadowScheduler::request(uint32_t key, float priority, uint32_t cost) {
+		const uint32_t age = m_ages[key];
+		m_candidates.push_back(Candidate{
+			.key = key,
+			.score = priority * static_cast<float>(age + 1),
+			.cost = cost,
+			.forced = age >= m_settings.maxInterval,
+		});
+	}
+
+	const std::vector<uint32_t>& ShadowScheduler::schedule() {
+		// Derive the budget from the measured instance cost if a time budget is set
+		uint32_t budget = m_settings.instanceBudget;
+		if (m_settings.timeBudget > 0.0f && m_instanceCost > 0.0f)
+			budget = std::min(budget, static_cast<uint32_t>(m_settings.timeBudget / m_instanceCost));
+
+		// Forced units first, then by decreasing score
+		std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& a, const Candidate& b) {
+			if (a.forced != b.forced) return a.forced;
+			return a.score > b.score;
+		});
+
+		m_scheduled.clear();
+		uint32_t spent = 0;
+		std::unordered_map<uint32_t, uint32_t> ages;
+		for (const Candidate& candidate : m_candidates) {
+			// Always make progress, even if a single unit is above budget
+			const bool fits = spent + candidate.cost <= budget || m_scheduled.empty();
+			if (candidate.forced || fits) {
+				m_scheduled.push_back(candidate.key);
+				spent += candidate.cost;
+			} else {
+				ages[candidate.key] = m_ages[candidate.key] + 1;
+			}
+		}
+
+		// Units that were not requested are up to date, forget them
+		m_ages = std::move(ages);
+
+		m_stats.requested = static_cast<uint32_t>(m_candidates.size());
+		m_stats.scheduled = static_cast<uint32_t>(m_scheduled.size());
+		m_stats.instanceBudget = budget;
+
+		return m_scheduled;
+	}
+
+	void ShadowScheduler::reportGpuTime(float microseconds, uint32_t draws, uint32_t instances) {
+		m_stats.gpuTime = microseconds;
+		m_stats.draws = draws;
+		m_stats.instances = instances;
+		if (instances == 0) return;
+
+		// The per draw overhead is folded in the instance cost, instancing lowers it as fewer draws carry the casters
+		const float instanceCost = microseconds / static_cast<float>(instances);
+		m_instanceCost = m_instanceCost > 0.0f ? 0.9f * m_instanceCost + 0.1f * instanceCost : instanceCost;
+	}
+
+}
@@ -0,0 +1,72 @@
+// VR Renderer - Shadow Scheduler
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Spreads shadow map updates over several frames, under a per-frame budget of caster instances.
+	/// Each shadow map unit (cube face, directional map...) needing an update is requested with a priority,
+	/// the most important ones are updated first and the others wait, their priority growing with their age.
+	class ShadowScheduler {
+	public:
+		struct Settings {
+			uint32_t instanceBudget = 2000;	// Maximum number of caster instances drawn per frame
+			float timeBudget = 0.0f;		// GPU time target of the shadow pass in microseconds, 0 to only use the instance budget
+			uint32_t maxInterval = 8;	// Number of frames after which a pending update is forced
+		};
+
+		struct Stats {
+			uint32_t requested = 0;
+			uint32_t scheduled = 0;
+			uint32_t instanceBudget = 0;
+			uint32_t draws = 0;		// Draw calls of the last measured pass
+			uint32_t instances = 0;	// Caster instances of the last measured pass
+			float gpuTime = 0.0f;
+		};
+
+		/// @brief Starts collecting the update requests of a frame.
+		void begin();
+
+		/// @brief Requests the update of a shadow map unit.
+		/// @param key Unique and stable identifier of the unit.
+		/// @param priority Importance of the unit, typically its screen influence weighted by its motion.
+		/// @param cost Estimated number of caster instances the update draws.
+		void request(uint32_t key, float priority, uint32_t cost);
+
+		/// @brief Selects the units to update this frame, within the budget.
+		/// @return The keys of the selected units.
+		const std::vector<uint32_t>& schedule();
+
+		/// @brief Adapts the instance budget to the measured cost of a previous shadow pass.
+		/// @param microseconds GPU time of the shadow pass.
+		/// @param draws Number of draw calls issued during that pass.
+		/// @param instances Number of caster instances those draws rendered, requests are costed in them.
+		void reportGpuTime(float microseconds, uint32_t draws, uint32_t instances);
+
+		Settings& getSettings() { return m_settings; }
+		const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct Candidate {
+			uint32_t key;
+			float score;
+			uint32_t cost;
+			bool forced;
+		};
+
+		Settings m_settings;
+		Stats m_stats;
+		float m_instanceCost = 0.0f;	// Smoothed GPU time of a single caster instance, in microseconds
+
+		std::vector<Candidate> m_candidates;
+		std::vector<uint32_t> m_scheduled;
+		std::unordered_map<uint32_t, uint32_t> m_ages;
+	};
+
+}
@@ -11,6 +11,7 @@
 #include "gpu/Framebuffer.h"
 #include "gpu/Renderbuffer.h"
 #include "gpu/ShaderProgram.h"
+#include "gpu/StateCache.h"
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -41,8 +42,9 @@ namespace vr {
 
 		glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
 		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-		glDisable(GL_CULL_FACE);
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+		state.disable(GL_CULL_FACE);
 
 		const glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
 		const glm::mat4 captureViews[6] = {
@@ -69,9 +71,9 @@ namespace vr {
 		glTextureStorage2D(*environment, 8, GL_RGB32F, mapSize, mapSize);
 
 		gpu::ShaderProgram equiToCubemapShader("res/shaders/pre-render/equirectangular_cubemap.glsl");
-		glUseProgram(equiToCubemapShader);
+		state.useProgram(equiToCubemapShader);
 		glUniform1f(glGetUniformLocation(equiToCubemapShader, "uExposureCorrection"), exposureCorrection);
-		glBindTextureUnit(0, equirectangular);
+		state.bindTextureUnit(0, equirectangular);
 		glUniformMatrix4fv(glGetUniformLocation(equiToCubemapShader, "uProjection"), 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&captureProjection));
 		
 		glViewport(0, 0, mapSize, mapSize);
@@ -80,7 +82,7 @@ namespace vr {
 			glUniformMatrix4fv(glGetUniformLocation(equiToCubemapShader, "uView"), 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&captureViews[face]));
 
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glBindVertexArray(*vertexArray);
+			state.bindVertexArray(*vertexArray);
 			glDrawElements(GL_TRIANGLES, vertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
 		}
 		glGenerateTextureMipmap(*environment);
@@ -96,8 +98,8 @@ namespace vr {
 		glGenerateTextureMipmap(*m_cubeMap);
 
 		gpu::ShaderProgram cookTorranceIrradianceShader("res/shaders/pre-render/cook-torrance_irradiance.glsl");
-		glUseProgram(cookTorranceIrradianceShader);
-		glBindTextureUnit(0, *environment);
+		state.useProgram(cookTorranceIrradianceShader);
+		state.bindTextureUnit(0, *environment);
 		glUniformMatrix4fv(glGetUniformLocation(cookTorranceIrradianceShader, "uProjection"), 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&captureProjection));
 
 		GLsizei sizeFactor = 1;
@@ -115,7 +117,7 @@ namespace vr {
 				glUniformMatrix4fv(glGetUniformLocation(cookTorranceIrradianceShader, "uView"), 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&captureViews[face]));
 
 				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-				glBindVertexArray(*vertexArray);
+				state.bindVertexArray(*vertexArray);
 				glDrawElements(GL_TRIANGLES, vertexArray->getElementCount(), GL_UNSIGNED_INT, nullptr);
 			}
 		}
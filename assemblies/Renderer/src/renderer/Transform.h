@@ -7,6 +7,8 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
+#include <cstdint>
+
 namespace vr {
 
 	struct Transform {
@@ -15,9 +17,23 @@ namespace vr {
 		glm::vec3 translation;
 
 		Transform()
-			: scale(1.0f), rotation({ 0.0f, 0.0f, 0.0f }), translation(0.0f) 
+			: scale(1.0f), rotation({ 0.0f, 0.0f, 0.0f }), translation(0.0f),
+			m_lastScale(scale), m_lastRotation(rotation), m_lastTranslation(translation)
 		{}
 
+		/// @brief Provides a revision number, incremented each time the transform is found modified.
+		/// Fields are public and edited in place, so changes are detected lazily against the last seen state.
+		uint64_t getRevision() const {
+			if (scale != m_lastScale || rotation != m_lastRotation || translation != m_lastTranslation) {
+				m_lastScale = scale;
+				m_lastRotation = rotation;
+				m_lastTranslation = translation;
+				++m_revision;
+			}
+
+			return m_revision;
+		}
+
 		glm::mat4 getModelMatrix() const {
 			glm::mat4 mat(1.0f);
 			mat = glm::scale(mat, scale);
@@ -35,5 +51,10 @@ namespace vr {
 			return mat;
 		}
 
+	private:
+		mutable glm::vec3 m_lastScale;
+		mutable glm::quat m_lastRotation;
+		mutable glm::vec3 m_lastTranslation;
+		mutable uint64_t m_revision = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+// VR Renderer - Transform Hierarchy
+// Rodolphe VALICON
+// 2025
+
+#include "TransformHierarchy.h"
+
+#include "core/Logger.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace vr {
+
+	// Column-major 4x4 product, the output may alias the right operand.
+	static void MultiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& result) {
+		const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+		const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+		const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+		const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+		__m128 columns[4];
+		for (uint32_t j = 0; j < 4; ++j) {
+			__m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[j][0]));
+			column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[j][1])));
+			column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[j][2])));
+			column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[j][3])));
+			columns[j] = column;
+		}
+
+		for (uint32_t j = 0; j < 4; ++j)
+			_mm_storeu_ps(&result[j][0], columns[j]);
+	}
+
+	void TransformHierarchy::resize(uint32_t count) {
+		const uint32_t previousCount = getCount();
+
+		m_scaleX.resize(count, 1.0f);
+		m_scaleY.resize(count, 1.0f);
+		m_scaleZ.resize(count, 1.0f);
+		m_rotationX.resize(count, 0.0f);
+		m_rotationY.resize(count, 0.0f);
+		m_rotationZ.resize(count, 0.0f);
+		m_rotationW.resize(count, 1.0f);
+		m_translationX.resize(count, 0.0f);
+		m_translationY.resize(count, 0.0f);
+		m_translationZ.resize(count, 0.0f);
+
+		m_parents.resize(count, s_NO_PARENT);
+		m_dirty.resize(count, 1);
+		m_worldMatrices.resize(count, glm::mat4(1.0f));
+		m_normalMatrices.resize(count, glm::mat4(1.0f));
+		m_revisions.resize(count, 0);
+
+		// Removed nodes may have been parents
+		for (uint32_t node = 0; node < std::min(previousCount, count); ++node) {
+			if (m_parents[node] != s_NO_PARENT && m_parents[node] >= count) {
+				m_parents[node] = s_NO_PARENT;
+				m_dirty[node] = 1;
+			}
+		}
+
+		m_orderDirty = true;
+	}
+
+	void TransformHierarchy::setLocal(uint32_t node, const Transform& transform) {
+		m_scaleX[node] = transform.scale.x;
+		m_scaleY[node] = transform.scale.y;
+		m_scaleZ[node] = transform.scale.z;
+		m_rotationX[node] = transform.rotation.x;
+		m_rotationY[node] = transform.rotation.y;
+		m_rotationZ[node] = transform.rotation.z;
+		m_rotationW[node] = transform.rotation.w;
+		m_translationX[node] = transform.translation.x;
+		m_translationY[node] = transform.translation.y;
+		m_translationZ[node] = transform.translation.z;
+		m_dirty[node] = 1;
+	}
+
+	void TransformHierarchy::setParent(uint32_t node, uint32_t parent) {
+		if (m_parents[node] == parent) return;
+
+		for (uint32_t ancestor = parent; ancestor != s_NO_PARENT; ancestor = m_parents[ancestor]) {
+			if (ancestor == node) {
+				logger::warn("Transform {} can't be attached to its descendant {}.", node, parent);
+				return;
+			}
+		}
+
+		m_parents[node] = parent;
+		m_dirty[node] = 1;
+		m_orderDirty = true;
+	}
+
+	void TransformHierarchy::update() {
+		if (m_orderDirty)
+			sortNodes();
+
+		// Propagate the changes to the descendants, parents come first
+		m_updated.clear();
+		for (uint32_t node : m_order) {
+			const uint32_t parent = m_parents[node];
+			if (parent != s_NO_PARENT && m_dirty[parent])
+				m_dirty[node] = 1;
+
+			if (m_dirty[node])
+				m_updated.push_back(node);
+		}
+
+		// Local matrices in batches, they don't depend on each other
+		for (size_t i = 0; i < m_updated.size(); i += 4)
+			computeLocalMatrices(&m_updated[i], static_cast<uint32_t>(std::min<size_t>(4, m_updated.size() - i)));
+
+		// Concatenate with the parents, which are already up to date
+		for (uint32_t node : m_updated) {
+			const uint32_t parent = m_parents[node];
+			if (parent != s_NO_PARENT) {
+				MultiplyMatrices(m_worldMatrices[parent], m_worldMatrices[node], m_worldMatrices[node]);
+				MultiplyMatrices(m_normalMatrices[parent], m_normalMatrices[node], m_normalMatrices[node]);
+			}
+
+			m_dirty[node] = 0;
+			++m_revisions[node];
+		}
+	}
+
+	void TransformHierarchy::sortNodes() {
+		// Sorting by depth puts every parent before its children
+		std::vector<uint32_t> depths(getCount(), 0);
+		for (uint32_t node = 0; node < getCount(); ++node) {
+			for (uint32_t ancestor = m_parents[node]; ancestor != s_NO_PARENT; ancestor = m_parents[ancestor])
+				++depths[node];
+		}
+
+		m_order.resize(getCount());
+		std::iota(m_order.begin(), m_order.end(), 0);
+		std::stable_sort(m_order.begin(), m_order.end(), [&](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+		m_orderDirty = false;
+	}
+
+	void TransformHierarchy::computeLocalMatrices(const uint32_t* nodes, uint32_t count) {
+		// Gather up to four nodes in the lanes, missing lanes repeat the first node
+		const uint32_t n0 = nodes[0];
+		const uint32_t n1 = count > 1 ? nodes[1] : n0;
+		const uint32_t n2 = count > 2 ? nodes[2] : n0;
+		const uint32_t n3 = count > 3 ? nodes[3] : n0;
+		auto gather = [&](const std::vector<float>& values) { return _mm_set_ps(values[n3], values[n2], values[n1], values[n0]); };
+
+		const __m128 x = gather(m_rotationX);
+		const __m128 y = gather(m_rotationY);
+		const __m128 z = gather(m_rotationZ);
+		const __m128 w = gather(m_rotationW);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+
+		const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+		// Rotation matrix of a unit quaternion, rotation[column][row]
+		__m128 rotation[3][3];
+		rotation[0][0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+		rotation[0][1] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+		rotation[0][2] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+		rotation[1][0] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+		rotation[1][1] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+		rotation[1][2] = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+		rotation[2][0] = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+		rotation[2][1] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+		rotation[2][2] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+		// Model is T * R * S, normal is the inverse transpose of R * S, which is R * S^-1
+		const __m128 scales[3] = { gather(m_scaleX), gather(m_scaleY), gather(m_scaleZ) };
+		alignas(16) float model[3][3][4];
+		alignas(16) float normal[3][3][4];
+		for (uint32_t column = 0; column < 3; ++column) {
+			const __m128 inverseScale = _mm_div_ps(one, scales[column]);
+			for (uint32_t row = 0; row < 3; ++row) {
+				_mm_store_ps(model[column][row], _mm_mul_ps(rotation[column][row], scales[column]));
+				_mm_store_ps(normal[column][row], _mm_mul_ps(rotation[column][row], inverseScale));
+			}
+		}
+
+		alignas(16) float translation[3][4];
+		_mm_store_ps(translation[0], gather(m_translationX));
+		_mm_store_ps(translation[1], gather(m_translationY));
+		_mm_store_ps(translation[2], gather(m_translationZ));
+
+		// Scatter the lanes back to the matrices
+		for (uint32_t lane = 0; lane < count; ++lane) {
+			glm::mat4& world = m_worldMatrices[nodes[lane]];
+			glm::mat4& normalMatrix = m_normalMatrices[nodes[lane]];
+			for (uint32_t column = 0; column < 3; ++column) {
+				world[column] = glm::vec4(model[column][0][lane], model[column][1][lane], model[column][2][lane], 0.0f);
+				normalMatrix[column] = glm::vec4(normal[column][0][lane], normal[column][1][lane], normal[column][2][lane], 0.0f);
+			}
+
+			world[3] = glm::vec4(translation[0][lane], translation[1][lane], translation[2][lane], 1.0f);
+			normalMatrix[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+}
@@ -0,0 +1,67 @@
+// VR Renderer - Transform Hierarchy
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/Transform.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vr {
+
+	/// @brief Parent/child tree of transforms, caching the world and normal matrices of every node.
+	/// Local scale, rotation and translation are stored as structure of arrays. Only the nodes changed since
+	/// the last update, and their descendants, are recomputed, four local matrices at a time with SSE.
+	class TransformHierarchy {
+	public:
+		static constexpr uint32_t s_NO_PARENT = 0xFFFFFFFF;
+
+		/// @brief Changes the number of nodes, added nodes are identity roots.
+		void resize(uint32_t count);
+
+		/// @brief Copies the local transform of a node, relative to its parent.
+		void setLocal(uint32_t node, const Transform& transform);
+
+		/// @brief Attaches a node to a parent, or detaches it with s_NO_PARENT. Cycles are refused.
+		void setParent(uint32_t node, uint32_t parent);
+
+		/// @brief Recomputes the matrices of the changed nodes and their descendants.
+		void update();
+
+		uint32_t getCount() const { return static_cast<uint32_t>(m_parents.size()); }
+		uint32_t getParent(uint32_t node) const { return m_parents[node]; }
+		const glm::mat4& getWorldMatrix(uint32_t node) const { return m_worldMatrices[node]; }
+		const glm::mat4& getNormalMatrix(uint32_t node) const { return m_normalMatrices[node]; }
+
+		/// @brief Provides a revision number of the node world matrix, incremented each time it is recomputed.
+		uint64_t getRevision(uint32_t node) const { return m_revisions[node]; }
+
+		/// @brief Provides the number of nodes recomputed by the last update.
+		uint32_t getUpdatedCount() const { return static_cast<uint32_t>(m_updated.size()); }
+
+	private:
+		void sortNodes();
+		void computeLocalMatrices(const uint32_t* nodes, uint32_t count);
+
+	private:
+		// Local transforms, one array per component
+		std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+		std::vector<float> m_rotationX, m_rotationY, m_rotationZ, m_rotationW;
+		std::vector<float> m_translationX, m_translationY, m_translationZ;
+
+		std::vector<uint32_t> m_parents;
+		std::vector<uint32_t> m_order;		// Nodes sorted so that parents come before their children
+		std::vector<uint8_t> m_dirty;
+		std::vector<uint32_t> m_updated;	// Nodes recomputed by the last update, in order
+		bool m_orderDirty = false;
+
+		std::vector<glm::mat4> m_worldMatrices;
+		std::vector<glm::mat4> m_normalMatrices;
+		std::vector<uint64_t> m_revisions;
+	};
+
+}
@@ -0,0 +1,28 @@
+// VR Renderer - Bounds Calculator
+// Rodolphe VALICON
+// 2025
+
+#include "BoundsCalculator.h"
+
+#include <cstring>
+
+namespace vr {
+
+	AABB utils::computeBounds(const gpu::GeometryData& geometry) {
+		AABB bounds;
+		if (!geometry.layout.hasAttribute(gpu::Attribute::Position))
+			return bounds;
+
+		const size_t stride = geometry.layout.getStride();
+		const size_t offset = geometry.layout.getAttribute(gpu::Attribute::Position).offset;
+
+		for (uint32_t index : geometry.indices) {
+			glm::vec3 position;
+			std::memcpy(&position, &geometry.vertex_data[index * stride + offset], sizeof(glm::vec3));
+			bounds.expand(position);
+		}
+
+		return bounds;
+	}
+
+}
@@ -0,0 +1,15 @@
+// VR Renderer - Bounds Calculator
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/GeometryData.h"
+#include "renderer/Bounds.h"
+
+namespace vr {
+	namespace utils {
+		/// @brief Computes the bounding box of the float positions of an indexed geometry.
+		AABB computeBounds(const gpu::GeometryData& geometry);
+	}
+}
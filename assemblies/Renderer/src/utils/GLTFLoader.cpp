@@ -10,6 +10,8 @@
 #include "renderer/MaterialInstance.h"
 #include "renderer/MaterialRegistry.h"
 #include "utils/Macros.h"
+#include "utils/BoundsCalculator.h"
+#include "utils/OccluderBuilder.h"
 #include "utils/TangentCalculator.h"
 #include "utils/ImageLoader.h"
 
@@ -17,9 +19,12 @@
 #include <nlohmann/json.hpp>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -66,11 +71,38 @@ namespace vr {
 		}
 	}
 
+	// Internal format of the images of a texture, color textures are sampled in sRGB
+	static GLenum TextureFormat(GLenum pixelFormat, bool sRGB) {
+		if (sRGB) {
+			switch (pixelFormat) {
+			case GL_RGB: return GL_SRGB8;
+			case GL_RGBA: return GL_SRGB8_ALPHA8;
+			}
+		} else {
+			switch (pixelFormat) {
+			case GL_RED: return GL_R8;
+			case GL_RG: return GL_RG8;
+			case GL_RGB: return GL_RGB8;
+			case GL_RGBA: return GL_RGBA8;
+			}
+		}
+		return 0;
+	}
+
+	// A texture in a color space, the same image sampled both in sRGB and linear makes two textures
+	using TextureKey = std::pair<uint32_t, bool>;
+
+	struct TextureLayer {
+		std::shared_ptr<gpu::Texture> array;
+		uint32_t layer;
+	};
+
 	struct GLTFContext {
 		std::string path;
 		json content;
 		mutable std::unordered_map<uint32_t, std::unique_ptr<uint8_t[]>> buffers;
-		mutable std::unordered_map<uint32_t, std::shared_ptr<gpu::Texture>> textures;
+		mutable std::map<TextureKey, std::shared_ptr<gpu::Texture>> textures;
+		mutable std::map<TextureKey, TextureLayer> textureLayers;
 		mutable std::unordered_map<uint32_t, std::shared_ptr<MaterialInstance>> materials;
 		mutable std::unordered_map<uint32_t, gpu::Sampler> samplers;
 
@@ -120,7 +152,8 @@ namespace vr {
 		}
 
 		std::shared_ptr<gpu::Texture> getTexture(uint32_t index, bool loadSRGB = false) const {
-			if (textures.find(index) == textures.end()) {
+			const TextureKey key{ index, loadSRGB };
+			if (textures.find(key) == textures.end()) {
 				// Parse texture description
 				const json& description = content["textures"][index];
 
@@ -129,30 +162,14 @@ namespace vr {
 				if (description.contains("sampler"))
 					sampler = getSampler(description["sampler"]);
 
-				std::string uri = content["images"][static_cast<uint32_t>(description["source"])]["uri"];
-
 				// Read image
-				std::filesystem::path imagePath(path);
-				imagePath.replace_filename(uri);
+				std::filesystem::path imagePath = getImagePath(description);
 
 				logger::debug("Reading glTF image {} at path '{}'", index, imagePath.string());
 				
 				std::shared_ptr<Image> image = utils::loadImage(imagePath.string(), GL_UNSIGNED_BYTE);
 
-				GLenum format = 0;
-				if (loadSRGB) {
-					switch (image->pixelFormat) {
-					case GL_RGB: format = GL_SRGB8; break;
-					case GL_RGBA: format = GL_SRGB8_ALPHA8; break;
-					}
-				} else {
-					switch (image->pixelFormat) {
-					case GL_RED: format = GL_R8; break;
-					case GL_RG: format = GL_RG8; break;
-					case GL_RGB: format = GL_RGB8; break;
-					case GL_RGBA: format = GL_RGBA8; break;
-					}
-				}
+				GLenum format = TextureFormat(image->pixelFormat, loadSRGB);
 
 				auto texture = std::make_shared<gpu::Texture>(GL_TEXTURE_2D, sampler);
 				glTextureParameterf(*texture, GL_TEXTURE_MAX_ANISOTROPY, 16.0f);
@@ -160,10 +177,102 @@ namespace vr {
 				glTextureSubImage2D(*texture, 0, 0, 0, image->width, image->height, image->pixelFormat, image->pixelType, image->pixels.get());
 				glGenerateTextureMipmap(*texture);
 
-				textures[index] = texture;
+				textures[key] = texture;
 			}
 
-			return textures[index];
+			return textures[key];
+		}
+
+		std::filesystem::path getImagePath(const json& texture) const {
+			std::string uri = content["images"][static_cast<uint32_t>(texture["source"])]["uri"];
+			std::filesystem::path imagePath(path);
+			imagePath.replace_filename(uri);
+			return imagePath;
+		}
+
+		/// @brief Loads the textures of the materials of a mesh as layers of texture arrays, one array per size,
+		/// format and sampler. Each texture is a view of its layer, for the materials drawn with their own bindings.
+		void loadTextureArrays(const json& mesh) const {
+			// Textures of the mesh materials in each color space they are sampled in, each gets its own layer
+			std::set<TextureKey> used;
+			for (const json& primitive : mesh["primitives"]) {
+				if (!primitive.contains("material")) continue;
+
+				const json& material = content["materials"][static_cast<uint32_t>(primitive["material"])];
+				auto use = [&material, &used](const json::json_pointer& pointer, bool sRGB) {
+					if (material.contains(pointer))
+						used.emplace(static_cast<uint32_t>(material[pointer]), sRGB);
+				};
+				use("/pbrMetallicRoughness/baseColorTexture/index"_json_pointer, true);
+				use("/pbrMetallicRoughness/metallicRoughnessTexture/index"_json_pointer, false);
+				use("/normalTexture/index"_json_pointer, false);
+				use("/occlusionTexture/index"_json_pointer, false);
+				use("/emissiveTexture/index"_json_pointer, true);
+			}
+
+			// Group the textures from the image headers, images are only decoded once the arrays are allocated
+			struct Group {
+				uint32_t width;
+				uint32_t height;
+				GLenum format;
+				gpu::Sampler sampler;
+				std::vector<TextureKey> textures;
+			};
+			std::vector<Group> groups;
+			for (const TextureKey& key : used) {
+				if (textures.find(key) != textures.end()) continue;
+
+				const auto [index, sRGB] = key;
+				const json& description = content["textures"][index];
+				gpu::Sampler sampler;
+				if (description.contains("sampler"))
+					sampler = getSampler(description["sampler"]);
+
+				uint32_t width, height;
+				GLenum pixelFormat;
+				if (!utils::readImageInfo(getImagePath(description).string(), width, height, pixelFormat)) continue;
+
+				const GLenum format = TextureFormat(pixelFormat, sRGB);
+				auto group = std::find_if(groups.begin(), groups.end(), [&](const Group& group) {
+					return group.width == width && group.height == height && group.format == format && group.sampler == sampler;
+				});
+				if (group == groups.end())
+					group = groups.insert(groups.end(), Group{ width, height, format, sampler, {} });
+
+				group->textures.push_back(key);
+			}
+
+			for (const Group& group : groups) {
+				const GLsizei levels = glm::log2(group.width);
+				const uint32_t layers = static_cast<uint32_t>(group.textures.size());
+				auto array = std::make_shared<gpu::Texture>(GL_TEXTURE_2D_ARRAY, group.sampler);
+				glTextureParameterf(*array, GL_TEXTURE_MAX_ANISOTROPY, 16.0f);
+				glTextureStorage3D(*array, levels, group.format, group.width, group.height, layers);
+				logger::debug("Texture array {}x{} of {} layers", group.width, group.height, layers);
+
+				for (uint32_t layer = 0; layer < layers; ++layer) {
+					const TextureKey& key = group.textures[layer];
+					std::shared_ptr<Image> image = utils::loadImage(getImagePath(content["textures"][key.first]).string(), GL_UNSIGNED_BYTE);
+					if (image)
+						glTextureSubImage3D(*array, 0, 0, 0, layer, image->width, image->height, 1, image->pixelFormat, image->pixelType, image->pixels.get());
+
+					auto view = std::make_shared<gpu::Texture>(*array, GL_TEXTURE_2D, group.format, 0, levels, layer, 1, group.sampler);
+					glTextureParameterf(*view, GL_TEXTURE_MAX_ANISOTROPY, 16.0f);
+					textures[key] = view;
+					textureLayers[key] = TextureLayer{ array, layer };
+				}
+
+				glGenerateTextureMipmap(*array);
+			}
+		}
+
+		/// @brief Sets a texture of a material, as a layer of its array when it has one.
+		void setMaterialTexture(MaterialInstance& material, const std::string& name, uint32_t index, bool loadSRGB = false) const {
+			auto layer = textureLayers.find(TextureKey{ index, loadSRGB });
+			if (layer != textureLayers.end())
+				material.setTextureLayer(name, getTexture(index, loadSRGB), layer->second.array, layer->second.layer);
+			else
+				material.setTexture(name, getTexture(index, loadSRGB));
 		}
 
 		std::shared_ptr<MaterialInstance> getMaterial(uint32_t index) const {
@@ -194,35 +303,35 @@ namespace vr {
 
 				if (pbr.contains("baseColorTexture")) {
 					material->set("AlbedoMap", 1);
-					material->setTexture("sAlbedoMap", getTexture(pbr["/baseColorTexture/index"_json_pointer], true));
+					setMaterialTexture(*material, "sAlbedoMap", pbr["/baseColorTexture/index"_json_pointer], true);
 				} else {
 					material->set("AlbedoMap", 0);
 				}
 
 				if (pbr.contains("metallicRoughnessTexture")) {
 					material->set("MetalRoughnessMap", 1);
-					material->setTexture("sMetalRoughnessMap", getTexture(pbr["/metallicRoughnessTexture/index"_json_pointer]));
+					setMaterialTexture(*material, "sMetalRoughnessMap", pbr["/metallicRoughnessTexture/index"_json_pointer]);
 				} else {
 					material->set("MetalRoughnessMap", 0);
 				}
 
 				if (description.contains("normalTexture")) {
 					material->set("NormalMap", 1);
-					material->setTexture("sNormalMap", getTexture(description["/normalTexture/index"_json_pointer]));
+					setMaterialTexture(*material, "sNormalMap", description["/normalTexture/index"_json_pointer]);
 				} else {
 					material->set("NormalMap", 0);
 				}
 
 				if (description.contains("occlusionTexture")) {
 					material->set("OcclusionMap", 1);
-					material->setTexture("sOcclusionMap", getTexture(description["/occlusionTexture/index"_json_pointer]));
+					setMaterialTexture(*material, "sOcclusionMap", description["/occlusionTexture/index"_json_pointer]);
 				} else {
 					material->set("OcclusionMap", 0);
 				}
 
 				if (description.contains("emissiveTexture")) {
 					material->set("EmissiveMap", 1);
-					material->setTexture("sEmissiveMap", getTexture(description["/emissiveTexture/index"_json_pointer], true));
+					setMaterialTexture(*material, "sEmissiveMap", description["/emissiveTexture/index"_json_pointer], true);
 				} else {
 					material->set("EmissiveMap", 0);
 				}
@@ -234,6 +343,9 @@ namespace vr {
 				if (alphaMode == "MASK") {
 					float alphaCutoff = description.value("alphaCutoff", 0.5f);
 					material->set("AlphaCutoff", alphaCutoff);
+					// The shader only masks with the albedo map alpha
+					if (pbr.contains("baseColorTexture"))
+						material->renderFlags.alphaCutoff = alphaCutoff;
 				} else {
 					material->set("AlphaCutoff", 0.0f);
 				}
@@ -296,11 +408,8 @@ namespace vr {
 		}
 	};
 
-	static Primitive parsePrimitive(const GLTFContext& context, const json& mesh, uint32_t primitiveID) {
-		logger::debug("Parsing primitive {}", primitiveID);
+	static std::shared_ptr<gpu::GeometryData> parseGeometry(const GLTFContext& context, const json& description) {
 		auto geometry = std::make_shared<gpu::GeometryData>();
-		
-		const json& description = mesh["primitives"][primitiveID];
 
 		// Load indices
 		Accessor indexAccessor(context, description["indices"]);
@@ -323,7 +432,7 @@ namespace vr {
 			} break;
 			default:
 				logger::error("Unsuported index type encountered.");
-				return {};
+				return nullptr;
 			}
 		}
 
@@ -406,6 +515,17 @@ namespace vr {
 		// Parse topology mode
 		geometry->topology = description.value("mode", GL_TRIANGLES);
 
+		return geometry;
+	}
+
+	static Primitive parsePrimitive(const GLTFContext& context, const json& mesh, uint32_t primitiveID) {
+		logger::debug("Parsing primitive {}", primitiveID);
+		const json& description = mesh["primitives"][primitiveID];
+
+		std::shared_ptr<gpu::GeometryData> geometry = parseGeometry(context, description);
+		if (!geometry)
+			return {};
+
 		// Load Material
 		std::shared_ptr<MaterialInstance> material = context.getMaterial(description["material"]);
 
@@ -413,6 +533,12 @@ namespace vr {
 		Primitive primitive;
 		primitive.vertexArray = std::make_shared<gpu::VertexArray>(*geometry);
 		primitive.material = material;
+		primitive.bounds = utils::computeBounds(*geometry);
+
+		// Keep a CPU copy of small enough primitives, to be used as occluders
+		static constexpr size_t maxOccluderTriangles = 8192;
+		if (geometry->indices.size() / 3 <= maxOccluderTriangles)
+			primitive.occluder = utils::buildOccluder(*geometry);
 
 		return primitive;
 	}
@@ -420,6 +546,8 @@ namespace vr {
 	static std::shared_ptr<Mesh> parseMesh(const GLTFContext& context, uint32_t meshIndex) {
 		const json& description = context.content["meshes"][meshIndex];
 
+		context.loadTextureArrays(description);
+
 		auto mesh = std::make_shared<Mesh>();
 		mesh->primitives.reserve(description["primitives"].size());
 
@@ -436,5 +564,20 @@ namespace vr {
 		return parseMesh(context, meshIndex);
 	}
 
+	void utils::batchGLTFMesh(const std::string& filePath, uint32_t meshIndex, const glm::mat4& transform, StaticBatcher& batcher) {
+		GLTFContext context(filePath);
+		const json& description = context.content["meshes"][meshIndex];
+		context.loadTextureArrays(description);
+
+		for (uint32_t i = 0; i < description["primitives"].size(); ++i) {
+			logger::debug("Parsing primitive {}", i);
+			const json& primitive = description["primitives"][i];
+
+			std::shared_ptr<gpu::GeometryData> geometry = parseGeometry(context, primitive);
+			if (geometry)
+				batcher.add(*geometry, context.getMaterial(primitive["material"]), transform);
+		}
+	}
+
 }
 
@@ -5,6 +5,9 @@
 #pragma once
 
 #include "renderer/Mesh.h"
+#include "utils/StaticBatcher.h"
+
+#include <glm/glm.hpp>
 
 #include <memory>
 #include <string>
@@ -16,5 +19,13 @@ namespace vr {
 		/// @param meshIndex Index of the mesh to load.
 		/// @return A shared pointer to the loaded model.
 		std::shared_ptr<Mesh> loadGLTFMesh(const std::string& filePath, uint32_t meshIndex);
+
+		/// @brief glTF 2.0 3D model loader, adding the primitives of a static model to a batcher.
+		/// The primitives are only merged when the batcher is built, so that several models can share chunks.
+		/// @param filePath Path to GLTF file.
+		/// @param meshIndex Index of the mesh to load.
+		/// @param transform Transform baked into the vertices.
+		/// @param batcher Batcher receiving the primitives.
+		void batchGLTFMesh(const std::string& filePath, uint32_t meshIndex, const glm::mat4& transform, StaticBatcher& batcher);
 	}
 }
\ No newline at end of file
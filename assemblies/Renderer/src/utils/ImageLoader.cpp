@@ -11,6 +11,16 @@
 
 namespace vr {
 
+	static GLenum PixelFormat(int32_t channels) {
+		switch (channels) {
+		case 1: return GL_RED;
+		case 2: return GL_RG;
+		case 3: return GL_RGB;
+		case 4: return GL_RGBA;
+		default: return 0;
+		}
+	}
+
 	std::shared_ptr<Image> utils::loadImage(const std::string& filePath, GLenum type, bool flip) {
 		int32_t width;
 		int32_t height;
@@ -39,13 +49,7 @@ namespace vr {
 			return {};
 		}
 
-		GLenum pixelFormat = 0;
-		switch (channels) {
-		case 1: pixelFormat = GL_RED; break;
-		case 2: pixelFormat = GL_RG; break;
-		case 3: pixelFormat = GL_RGB; break;
-		case 4: pixelFormat = GL_RGBA; break;
-		}
+		GLenum pixelFormat = PixelFormat(channels);
 
 		std::shared_ptr<Image> image = std::make_shared<Image>();
 		image->width = width;
@@ -64,4 +68,19 @@ namespace vr {
 		return image;
 	}
 
+	bool utils::readImageInfo(const std::string& filePath, uint32_t& width, uint32_t& height, GLenum& pixelFormat) {
+		int32_t x;
+		int32_t y;
+		int32_t channels;
+		if (!stbi_info(filePath.c_str(), &x, &y, &channels)) {
+			logger::error("Failed to read image '{}': {}", filePath, stbi_failure_reason());
+			return false;
+		}
+
+		width = x;
+		height = y;
+		pixelFormat = PixelFormat(channels);
+		return true;
+	}
+
 }
\ No newline at end of file
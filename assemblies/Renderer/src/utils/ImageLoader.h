@@ -12,5 +12,9 @@
 namespace vr {
 	namespace utils {
 		std::shared_ptr<Image> loadImage(const std::string& filePath, GLenum type, bool flip = false);
+
+		/// @brief Reads the size and pixel format of an image from its header, without decoding it.
+		/// @return Whether the image could be read.
+		bool readImageInfo(const std::string& filePath, uint32_t& width, uint32_t& height, GLenum& pixelFormat);
 	}
 }
\ No newline at end of file
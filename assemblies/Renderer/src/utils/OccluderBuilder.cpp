@@ -0,0 +1,28 @@
+// VR Renderer - Occluder Builder
+// Rodolphe VALICON
+// 2025
+
+#include "OccluderBuilder.h"
+
+#include <cstring>
+
+namespace vr {
+
+	std::shared_ptr<OccluderGeometry> utils::buildOccluder(const gpu::GeometryData& geometry) {
+		if (geometry.topology != GL_TRIANGLES || !geometry.layout.hasAttribute(gpu::Attribute::Position))
+			return nullptr;
+
+		const size_t stride = geometry.layout.getStride();
+		const size_t offset = geometry.layout.getAttribute(gpu::Attribute::Position).offset;
+		const size_t vertexCount = geometry.vertex_data.size() / stride;
+
+		auto occluder = std::make_shared<OccluderGeometry>();
+		occluder->positions.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+			std::memcpy(&occluder->positions[i], &geometry.vertex_data[i * stride + offset], sizeof(glm::vec3));
+
+		occluder->indices = geometry.indices;
+		return occluder;
+	}
+
+}
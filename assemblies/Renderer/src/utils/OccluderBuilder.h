@@ -0,0 +1,18 @@
+// VR Renderer - Occluder Builder
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/GeometryData.h"
+#include "renderer/OccluderGeometry.h"
+
+#include <memory>
+
+namespace vr {
+	namespace utils {
+		/// @brief Extracts the float positions and indices of a triangle list geometry, for occlusion culling.
+		/// @return The occluder geometry, or nullptr if the geometry is not a triangle list.
+		std::shared_ptr<OccluderGeometry> buildOccluder(const gpu::GeometryData& geometry);
+	}
+}
@@ -0,0 +1,231 @@
+// VR Renderer - Static Batcher
+// Rodolphe VALICON
+// 2025
+
+#include "StaticBatcher.h"
+
+#include "core/Logger.h"
+#include "utils/BoundsCalculator.h"
+#include "utils/OccluderBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+namespace vr {
+
+	// Vertices per element of the list topologies. Strips and fans can't be cut or appended, they are kept whole.
+	static uint32_t GetElementSize(GLenum topology) {
+		switch (topology) {
+		case GL_TRIANGLES:	return 3;
+		case GL_LINES:		return 2;
+		case GL_POINTS:		return 1;
+		default:			return 0;
+		}
+	}
+
+	static bool HasFloatAttribute(const gpu::VertexLayout& layout, gpu::Attribute attribute, GLuint components) {
+		return layout.hasAttribute(attribute) && layout.getAttribute(attribute).type == GL_FLOAT && layout.getAttribute(attribute).components >= components;
+	}
+
+	static glm::vec3 ReadPosition(const gpu::GeometryData& geometry, uint32_t index) {
+		glm::vec3 position;
+		const size_t offset = geometry.layout.getAttribute(gpu::Attribute::Position).offset;
+		std::memcpy(&position, &geometry.vertex_data[index * geometry.layout.getStride() + offset], sizeof(glm::vec3));
+		return position;
+	}
+
+	void utils::StaticBatcher::add(const gpu::GeometryData& geometry, const std::shared_ptr<MaterialInstance>& material, const glm::mat4& transform) {
+		Source& source = m_sources.emplace_back(Source{ geometry, material });
+		gpu::GeometryData& data = source.geometry;
+		const size_t stride = data.layout.getStride();
+		const size_t vertexCount = stride > 0 ? data.vertex_data.size() / stride : 0;
+
+		const glm::mat3 linear(transform);
+		const glm::mat3 normalTransform = glm::transpose(glm::inverse(linear));
+
+		auto transformAttribute = [&](gpu::Attribute attribute, auto&& function) {
+			if (!HasFloatAttribute(data.layout, attribute, 3)) return;
+
+			const size_t offset = data.layout.getAttribute(attribute).offset;
+			for (size_t v = 0; v < vertexCount; ++v) {
+				glm::vec3 value;
+				std::memcpy(&value, &data.vertex_data[v * stride + offset], sizeof(glm::vec3));
+				value = function(value);
+				std::memcpy(&data.vertex_data[v * stride + offset], &value, sizeof(glm::vec3));
+			}
+		};
+
+		auto normalize = [](const glm::vec3& direction) {
+			const float length = glm::length(direction);
+			return length > 0.0f ? direction / length : direction;
+		};
+
+		transformAttribute(gpu::Attribute::Position, [&](const glm::vec3& position) { return glm::vec3(transform * glm::vec4(position, 1.0f)); });
+		transformAttribute(gpu::Attribute::Normal, [&](const glm::vec3& normal) { return normalize(normalTransform * normal); });
+		transformAttribute(gpu::Attribute::Tangent, [&](const glm::vec3& tangent) { return normalize(linear * tangent); });
+
+		// A mirroring transform flips the bitangent and the triangles winding
+		if (glm::determinant(linear) < 0.0f) {
+			if (HasFloatAttribute(data.layout, gpu::Attribute::Tangent, 4)) {
+				const size_t offset = data.layout.getAttribute(gpu::Attribute::Tangent).offset + 3 * sizeof(float);
+				for (size_t v = 0; v < vertexCount; ++v) {
+					float sign;
+					std::memcpy(&sign, &data.vertex_data[v * stride + offset], sizeof(float));
+					sign = -sign;
+					std::memcpy(&data.vertex_data[v * stride + offset], &sign, sizeof(float));
+				}
+			}
+
+			if (data.topology == GL_TRIANGLES) {
+				for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+					std::swap(data.indices[i + 1], data.indices[i + 2]);
+			}
+		}
+	}
+
+	std::shared_ptr<Mesh> utils::StaticBatcher::build() {
+		auto mesh = std::make_shared<Mesh>();
+		mesh->isStatic = true;
+
+		for (Chunk& chunk : buildChunks()) {
+			Primitive primitive;
+			primitive.vertexArray = std::make_shared<gpu::VertexArray>(chunk.geometry);
+			primitive.material = std::move(chunk.material);
+			primitive.bounds = utils::computeBounds(chunk.geometry);
+			if (chunk.geometry.indices.size() / 3 <= m_settings.maxOccluderTriangles)
+				primitive.occluder = utils::buildOccluder(chunk.geometry);
+
+			mesh->primitives.push_back(std::move(primitive));
+		}
+
+		return mesh;
+	}
+
+	std::vector<utils::StaticBatcher::Chunk> utils::StaticBatcher::buildChunks() {
+		std::vector<Chunk> chunks;
+		m_stats = Stats{ .sourcePrimitives = static_cast<uint32_t>(m_sources.size()) };
+
+		// Chunk extent limit, relative to the whole batch so that it doesn't depend on the model units
+		AABB batchBounds;
+		for (const Source& source : m_sources)
+			batchBounds.expand(utils::computeBounds(source.geometry));
+
+		const glm::vec3 batchSize = batchBounds.isValid() ? batchBounds.max - batchBounds.min : glm::vec3(0.0f);
+		const float maxExtent = m_settings.maxChunkExtent * std::max({ batchSize.x, batchSize.y, batchSize.z });
+
+		// Group the sources that can share their buffers: same material, vertex layout and list topology
+		std::vector<std::vector<uint32_t>> groups;
+		for (uint32_t s = 0; s < m_sources.size(); ++s) {
+			const Source& source = m_sources[s];
+			auto group = std::find_if(groups.begin(), groups.end(), [&](const std::vector<uint32_t>& sources) {
+				const Source& other = m_sources[sources.front()];
+				return GetElementSize(source.geometry.topology) != 0 && other.material == source.material &&
+					other.geometry.topology == source.geometry.topology && other.geometry.layout == source.geometry.layout;
+			});
+
+			if (group != groups.end())
+				group->push_back(s);
+			else
+				groups.push_back({ s });
+		}
+
+		struct Element {
+			uint32_t source;
+			uint32_t firstIndex;
+			AABB bounds;
+		};
+
+		std::vector<Element> elements;
+		std::vector<std::pair<size_t, size_t>> ranges;
+		std::unordered_map<uint64_t, uint32_t> remap;
+		for (const std::vector<uint32_t>& group : groups) {
+			const Source& front = m_sources[group.front()];
+			const gpu::VertexLayout& layout = front.geometry.layout;
+			const uint32_t elementSize = GetElementSize(front.geometry.topology);
+			if (elementSize == 0) {
+				chunks.push_back(Chunk{ front.geometry, front.material });
+				continue;
+			}
+
+			// Elements of the group, their bounds drive the splits
+			const bool hasPositions = HasFloatAttribute(layout, gpu::Attribute::Position, 3);
+			elements.clear();
+			for (uint32_t s : group) {
+				const gpu::GeometryData& geometry = m_sources[s].geometry;
+				for (uint32_t i = 0; i + elementSize <= geometry.indices.size(); i += elementSize) {
+					Element element{ s, i, AABB{} };
+					for (uint32_t k = 0; k < elementSize; ++k)
+						element.bounds.expand(hasPositions ? ReadPosition(geometry, geometry.indices[i + k]) : glm::vec3(0.0f));
+
+					elements.push_back(element);
+				}
+			}
+
+			// Split at the median along the longest axis of the centroids, until chunks are small or compact enough
+			ranges.assign(1, { 0, elements.size() });
+			while (!ranges.empty()) {
+				const auto [begin, end] = ranges.back();
+				ranges.pop_back();
+
+				AABB bounds;
+				AABB centroidBounds;
+				for (size_t e = begin; e < end; ++e) {
+					bounds.expand(elements[e].bounds);
+					centroidBounds.expand(elements[e].bounds.getCenter());
+				}
+
+				const size_t count = end - begin;
+				const glm::vec3 size = bounds.max - bounds.min;
+				const glm::vec3 spread = centroidBounds.max - centroidBounds.min;
+				const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+				const bool split = count > m_settings.maxChunkTriangles ||
+					(count > m_settings.minChunkTriangles && std::max({ size.x, size.y, size.z }) > maxExtent);
+
+				if (split && spread[axis] > 0.0f) {
+					const size_t middle = begin + count / 2;
+					std::nth_element(elements.begin() + begin, elements.begin() + middle, elements.begin() + end, [axis](const Element& a, const Element& b) {
+						return a.bounds.getCenter()[axis] < b.bounds.getCenter()[axis];
+					});
+
+					ranges.push_back({ begin, middle });
+					ranges.push_back({ middle, end });
+					continue;
+				}
+
+				// Copy the vertices the chunk uses, once each
+				gpu::GeometryData chunk;
+				chunk.layout = layout;
+				chunk.topology = front.geometry.topology;
+				chunk.indices.reserve(count * elementSize);
+				remap.clear();
+
+				const size_t stride = layout.getStride();
+				for (size_t e = begin; e < end; ++e) {
+					const gpu::GeometryData& geometry = m_sources[elements[e].source].geometry;
+					for (uint32_t k = 0; k < elementSize; ++k) {
+						const uint32_t index = geometry.indices[elements[e].firstIndex + k];
+						const uint64_t key = (static_cast<uint64_t>(elements[e].source) << 32) | index;
+						auto [vertex, inserted] = remap.try_emplace(key, static_cast<uint32_t>(remap.size()));
+						if (inserted) {
+							const uint8_t* data = &geometry.vertex_data[index * stride];
+							chunk.vertex_data.insert(chunk.vertex_data.end(), data, data + stride);
+						}
+
+						chunk.indices.push_back(vertex->second);
+					}
+				}
+
+				chunks.push_back(Chunk{ std::move(chunk), front.material });
+			}
+		}
+
+		m_stats.chunks = static_cast<uint32_t>(chunks.size());
+		logger::info("Static batching merged {} primitives into {} chunks.", m_stats.sourcePrimitives, m_stats.chunks);
+
+		m_sources.clear();
+		return chunks;
+	}
+
+}
@@ -0,0 +1,75 @@
+// VR Renderer - Static Batcher
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "gpu/GeometryData.h"
+#include "renderer/MaterialInstance.h"
+#include "renderer/Mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace vr {
+	namespace utils {
+
+		/// @brief Merges static primitives sharing a material into a few chunks, at load time.
+		/// Vertices are transformed into the space of the batched mesh, which keeps an identity transform, so that
+		/// a chunk is a single draw whatever the number of primitives it comes from. Chunks are split along their
+		/// longest axis until they are compact enough for culling to keep rejecting them.
+		class StaticBatcher {
+		public:
+			struct Settings {
+				uint32_t maxChunkTriangles = 32768;		// Larger chunks are always split
+				uint32_t minChunkTriangles = 512;		// Smaller chunks are never split
+				float maxChunkExtent = 0.25f;			// Largest chunk side, relative to the largest side of the batch
+				uint32_t maxOccluderTriangles = 8192;	// Smaller chunks keep a CPU copy for occlusion culling
+			};
+
+			struct Stats {
+				uint32_t sourcePrimitives = 0;
+				uint32_t chunks = 0;
+			};
+
+			/// @brief Merged geometry of a chunk, in batch space.
+			struct Chunk {
+				gpu::GeometryData geometry;
+				std::shared_ptr<MaterialInstance> material;
+			};
+
+			StaticBatcher() = default;
+			StaticBatcher(const Settings& settings) : m_settings(settings) {}
+
+			/// @brief Adds a primitive to the batch.
+			/// @param geometry Geometry of the primitive, copied.
+			/// @param material Material of the primitive, only primitives sharing the same instance are merged.
+			/// @param transform Transform from the geometry space to the batch space.
+			void add(const gpu::GeometryData& geometry, const std::shared_ptr<MaterialInstance>& material, const glm::mat4& transform);
+
+			/// @brief Merges the added primitives, and clears the batcher.
+			/// @return A static mesh with an identity transform, holding one primitive per chunk.
+			std::shared_ptr<Mesh> build();
+
+			/// @brief Merges the added primitives into chunks without creating any GL object, and clears the batcher.
+			std::vector<Chunk> buildChunks();
+
+			/// @brief Provides the source and chunk counts of the last build.
+			const Stats& getStats() const { return m_stats; }
+
+		private:
+			struct Source {
+				gpu::GeometryData geometry;	// In batch space
+				std::shared_ptr<MaterialInstance> material;
+			};
+
+		private:
+			Settings m_settings;
+			Stats m_stats;
+			std::vector<Source> m_sources;
+		};
+
+	}
+}
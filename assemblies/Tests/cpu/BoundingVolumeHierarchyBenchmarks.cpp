@@ -0,0 +1,97 @@
+// VR Renderer - Bounding Volume Hierarchy Benchmarks
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "renderer/BoundingVolumeHierarchy.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <format>
+#include <random>
+
+namespace vr {
+
+	// 100k boxes of varied sizes scattered in a cube of side 400, about the density of a large streamed level
+	static std::vector<AABB> ScatteredBoxes(uint32_t count, std::mt19937& rng) {
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(0.1f, 4.0f);
+
+		std::vector<AABB> boxes(count);
+		for (AABB& box : boxes) {
+			box.min = glm::vec3(position(rng), position(rng), position(rng));
+			box.max = box.min + glm::vec3(size(rng), size(rng), size(rng));
+		}
+		return boxes;
+	}
+
+	VR_BENCHMARK(BoundingVolumeHierarchy, BuildAndRefit) {
+		std::mt19937 rng(3);
+		const std::vector<AABB> boxes = ScatteredBoxes(100000, rng);
+
+		BoundingVolumeHierarchy tree;
+		test::measure(std::format("Build ({} objects)", boxes.size()), 10, [&]() { tree.build(boxes); });
+
+		// Moves a share of the objects by a small step each frame, as animated objects do, the tree is never rebuilt
+		tree.rebuildThreshold = 1000.0f;
+		std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+		for (uint32_t share : { 100u, 10u }) {
+			std::vector<AABB> moved = boxes;
+			test::measure(std::format("Refit (1/{} of the objects moved)", share), 100, [&]() {
+				for (uint32_t o = 0; o < moved.size(); o += share) {
+					const glm::vec3 offset(step(rng), step(rng), step(rng));
+					moved[o] = AABB{ moved[o].min + offset, moved[o].max + offset };
+					tree.update(o, moved[o]);
+				}
+				tree.refit();
+			});
+			tree.build(boxes);
+		}
+	}
+
+	// Each query type over 100k objects, with the scan of every box the tree replaces for reference
+	VR_BENCHMARK(BoundingVolumeHierarchy, Queries) {
+		std::mt19937 rng(5);
+		const std::vector<AABB> boxes = ScatteredBoxes(100000, rng);
+
+		BoundingVolumeHierarchy tree;
+		tree.build(boxes);
+
+		const Frustum frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+			* glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		const glm::vec3 center(10.0f, -5.0f, 20.0f);
+		const float radius = 25.0f;
+		const AABB box{ center - glm::vec3(25.0f), center + glm::vec3(25.0f) };
+		const Ray ray{ glm::vec3(-200.0f, -150.0f, -200.0f), glm::normalize(glm::vec3(1.0f, 0.75f, 1.0f)) };
+
+		std::vector<uint32_t> objects;
+		std::vector<BoundingVolumeHierarchy::RayHit> hits;
+		objects.reserve(boxes.size());
+		hits.reserve(boxes.size());
+
+		auto frustumQuery = [&]() { objects.clear(); tree.queryFrustum(frustum, objects); };
+		auto sphereQuery = [&]() { objects.clear(); tree.querySphere(center, radius, objects); };
+		auto boxQuery = [&]() { objects.clear(); tree.queryBox(box, objects); };
+		auto rayQuery = [&]() { hits.clear(); tree.queryRay(ray, 1000.0f, hits); };
+
+		frustumQuery();
+		test::measure(std::format("Frustum ({} found)", objects.size()), 200, frustumQuery);
+		sphereQuery();
+		test::measure(std::format("Sphere ({} found)", objects.size()), 200, sphereQuery);
+		boxQuery();
+		test::measure(std::format("Box ({} found)", objects.size()), 200, boxQuery);
+		rayQuery();
+		test::measure(std::format("Ray ({} hits)", hits.size()), 200, rayQuery);
+
+		test::measure("Frustum, brute force", 20, [&]() {
+			objects.clear();
+			for (uint32_t o = 0; o < boxes.size(); ++o) {
+				if (frustum.intersects(boxes[o]))
+					objects.push_back(o);
+			}
+		});
+		test::keep(objects.data());
+		test::keep(hits.data());
+	}
+
+}
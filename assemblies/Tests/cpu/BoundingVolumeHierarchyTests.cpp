@@ -0,0 +1,161 @@
+// VR Renderer - Bounding Volume Hierarchy Tests
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "renderer/BoundingVolumeHierarchy.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace vr {
+
+	// Boxes of varied sizes scattered in a cube of side 100 centered on the origin
+	static std::vector<AABB> RandomBoxes(uint32_t count, std::mt19937& rng) {
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> size(0.05f, 2.0f);
+
+		std::vector<AABB> boxes(count);
+		for (AABB& box : boxes) {
+			box.min = glm::vec3(position(rng), position(rng), position(rng));
+			box.max = box.min + glm::vec3(size(rng), size(rng), size(rng));
+		}
+		return boxes;
+	}
+
+	static bool SameObjects(std::vector<uint32_t> objects, std::vector<uint32_t> expected) {
+		std::sort(objects.begin(), objects.end());
+		std::sort(expected.begin(), expected.end());
+		return objects == expected;
+	}
+
+	// Checks every query type against a scan of all the boxes
+	static void CheckQueries(const BoundingVolumeHierarchy& tree, const std::vector<AABB>& boxes, std::mt19937& rng) {
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<uint32_t> objects, expected;
+
+		for (uint32_t q = 0; q < 20; ++q) {
+			const glm::vec3 eye(position(rng), position(rng), position(rng));
+			const glm::vec3 target(position(rng), position(rng), position(rng));
+			const Frustum frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 40.0f) * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+			objects.clear();
+			expected.clear();
+			tree.queryFrustum(frustum, objects);
+			for (uint32_t o = 0; o < boxes.size(); ++o) {
+				if (frustum.intersects(boxes[o]))
+					expected.push_back(o);
+			}
+			VR_CHECK(SameObjects(objects, expected));
+
+			const float radius = 2.0f + 10.0f * std::abs(unit(rng));
+			objects.clear();
+			expected.clear();
+			tree.querySphere(eye, radius, objects);
+			for (uint32_t o = 0; o < boxes.size(); ++o) {
+				const glm::vec3 nearest = glm::clamp(eye, boxes[o].min, boxes[o].max);
+				if (glm::dot(nearest - eye, nearest - eye) <= radius * radius)
+					expected.push_back(o);
+			}
+			VR_CHECK(SameObjects(objects, expected));
+
+			const AABB box{ eye - glm::vec3(radius), eye + glm::vec3(radius, 0.5f * radius, 2.0f * radius) };
+			objects.clear();
+			expected.clear();
+			tree.queryBox(box, objects);
+			for (uint32_t o = 0; o < boxes.size(); ++o) {
+				if (box.overlaps(boxes[o]))
+					expected.push_back(o);
+			}
+			VR_CHECK(SameObjects(objects, expected));
+
+			// Slab test of every box, with the direction inverse the tree uses
+			const Ray ray{ eye, glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng))) };
+			const glm::vec3 inverseDirection = 1.0f / ray.direction;
+			std::vector<BoundingVolumeHierarchy::RayHit> hits;
+			tree.queryRay(ray, 80.0f, hits);
+			std::vector<float> distances(boxes.size(), -1.0f);
+			expected.clear();
+			for (uint32_t o = 0; o < boxes.size(); ++o) {
+				const glm::vec3 t0 = (boxes[o].min - ray.origin) * inverseDirection;
+				const glm::vec3 t1 = (boxes[o].max - ray.origin) * inverseDirection;
+				const glm::vec3 entries = glm::min(t0, t1);
+				const glm::vec3 exits = glm::max(t0, t1);
+				const float entry = std::max({ entries.x, entries.y, entries.z, 0.0f });
+				const float exit = std::min({ exits.x, exits.y, exits.z, 80.0f });
+				if (entry <= exit) {
+					expected.push_back(o);
+					distances[o] = entry;
+				}
+			}
+
+			objects.clear();
+			for (const BoundingVolumeHierarchy::RayHit& hit : hits) {
+				objects.push_back(hit.object);
+				VR_CHECK(hit.distance == distances[hit.object]);
+			}
+			VR_CHECK(SameObjects(objects, expected));
+			VR_CHECK(std::is_sorted(hits.begin(), hits.end(), [](const auto& a, const auto& b) { return a.distance < b.distance; }));
+		}
+	}
+
+	VR_TEST(BoundingVolumeHierarchy, QueriesMatchBruteForce) {
+		std::mt19937 rng(7);
+		const std::vector<AABB> boxes = RandomBoxes(20000, rng);
+
+		BoundingVolumeHierarchy tree;
+		tree.build(boxes);
+		VR_CHECK(tree.getObjectCount() == boxes.size());
+		VR_CHECK(std::all_of(boxes.begin(), boxes.end(), [&](const AABB& box) { return tree.getRootBounds().contains(box); }));
+		CheckQueries(tree, boxes, rng);
+	}
+
+	VR_TEST(BoundingVolumeHierarchy, QueriesMatchBruteForceAfterRefit) {
+		std::mt19937 rng(11);
+		std::vector<AABB> boxes = RandomBoxes(20000, rng);
+
+		BoundingVolumeHierarchy tree;
+		tree.rebuildThreshold = 1000.0f;
+		tree.build(boxes);
+
+		// Small moves keep the tree, its nodes are refitted
+		std::uniform_real_distribution<float> offset(-3.0f, 3.0f);
+		for (uint32_t o = 0; o < boxes.size(); o += 7) {
+			const glm::vec3 move(offset(rng), offset(rng), offset(rng));
+			boxes[o] = AABB{ boxes[o].min + move, boxes[o].max + move };
+			tree.update(o, boxes[o]);
+		}
+		VR_CHECK(!tree.refit());
+		CheckQueries(tree, boxes, rng);
+
+		// Scattering the objects degrades the tree past the threshold, it is rebuilt
+		tree.rebuildThreshold = 1.5f;
+		const std::vector<AABB> scattered = RandomBoxes(static_cast<uint32_t>(boxes.size()), rng);
+		for (uint32_t o = 0; o < boxes.size(); ++o) {
+			boxes[o] = scattered[o];
+			tree.update(o, boxes[o]);
+		}
+		VR_CHECK(tree.refit());
+		VR_CHECK(tree.getDegradation() <= 1.01f);
+		CheckQueries(tree, boxes, rng);
+	}
+
+	VR_TEST(BoundingVolumeHierarchy, EmptyTree) {
+		BoundingVolumeHierarchy tree;
+		tree.build({});
+
+		std::vector<uint32_t> objects;
+		std::vector<BoundingVolumeHierarchy::RayHit> hits;
+		tree.queryFrustum(Frustum(glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 10.0f)), objects);
+		tree.querySphere(glm::vec3(0.0f), 10.0f, objects);
+		tree.queryBox(AABB{ glm::vec3(-10.0f), glm::vec3(10.0f) }, objects);
+		tree.queryRay(Ray{ glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f) }, 10.0f, hits);
+		VR_CHECK(objects.empty());
+		VR_CHECK(hits.empty());
+		VR_CHECK(!tree.refit());
+	}
+
+}
@@ -0,0 +1,81 @@
+// VR Renderer - Occlusion Culler Benchmarks
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "renderer/OcclusionCuller.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <format>
+
+namespace vr {
+
+	// Grid of quads in the XY plane, of side 4 centered on the origin
+	static OccluderGeometry Grid(uint32_t quads) {
+		OccluderGeometry grid;
+		for (uint32_t y = 0; y <= quads; ++y) {
+			for (uint32_t x = 0; x <= quads; ++x)
+				grid.positions.emplace_back(4.0f * x / quads - 2.0f, 4.0f * y / quads - 2.0f, 0.0f);
+		}
+
+		for (uint32_t y = 0; y < quads; ++y) {
+			for (uint32_t x = 0; x < quads; ++x) {
+				const uint32_t i = y * (quads + 1) + x;
+				grid.indices.insert(grid.indices.end(), { i, i + 1, i + quads + 2, i, i + quads + 2, i + quads + 1 });
+			}
+		}
+		return grid;
+	}
+
+	// Fixed occluder set, about the 20k triangles the renderer rasterizes at most: a detailed wall facing the camera,
+	// and coarse side walls and floor, with 10k candidate boxes spread behind and around them.
+	VR_BENCHMARK(OcclusionCuller, RasterizeAndQuery) {
+		JobSystem jobSystem;
+		OcclusionCuller culler(jobSystem);
+
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+		const glm::mat4 viewProjection = projection * glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		const OccluderGeometry wall = Grid(96);
+		const OccluderGeometry side = Grid(16);
+		const glm::mat4 occluders[] = {
+			glm::mat4(1.0f),
+			glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f, 0.0f, 2.0f)) * glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+			glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 2.0f)) * glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+			glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -2.0f, 2.0f)) * glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+		};
+
+		std::vector<AABB> boxes;
+		for (uint32_t z = 0; z < 10; ++z) {
+			for (uint32_t y = 0; y < 20; ++y) {
+				for (uint32_t x = 0; x < 50; ++x) {
+					const glm::vec3 min(0.2f * x - 5.0f, 0.2f * y - 2.0f, 4.0f - 1.0f * z);
+					boxes.push_back(AABB{ min, min + glm::vec3(0.1f) });
+				}
+			}
+		}
+
+		auto rasterize = [&]() {
+			culler.begin(viewProjection);
+			culler.addOccluder(wall, occluders[0]);
+			for (uint32_t o = 1; o < 4; ++o)
+				culler.addOccluder(side, occluders[o]);
+			culler.rasterize();
+		};
+
+		uint32_t visible = 0;
+		auto query = [&]() {
+			visible = 0;
+			for (const AABB& box : boxes)
+				visible += culler.isVisible(box) ? 1 : 0;
+		};
+
+		const std::string setup = std::format("{} triangles, {} boxes, {} threads", wall.indices.size() / 3 + 3 * side.indices.size() / 3, boxes.size(), jobSystem.getConcurrency());
+		test::measure(std::format("Rasterize ({})", setup), 200, rasterize);
+		test::measure("Query", 200, query);
+		test::measure("Rasterize + query", 200, [&]() { rasterize(); query(); });
+		test::keep(&visible);
+	}
+
+}
@@ -0,0 +1,106 @@
+// VR Renderer - Occlusion Culler Tests
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "renderer/OcclusionCuller.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+
+namespace vr {
+
+	// Camera 5 units in front of the origin, looking down -Z
+	static glm::mat4 ViewProjection() {
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		return projection * view;
+	}
+
+	// Square of side 4 in the XY plane, centered on the origin
+	static OccluderGeometry Wall() {
+		OccluderGeometry wall;
+		wall.positions = { { -2.0f, -2.0f, 0.0f }, { 2.0f, -2.0f, 0.0f }, { 2.0f, 2.0f, 0.0f }, { -2.0f, 2.0f, 0.0f } };
+		wall.indices = { 0, 1, 2, 0, 2, 3 };
+		return wall;
+	}
+
+	VR_TEST(OcclusionCuller, FullyOccludedBox) {
+		JobSystem jobSystem;
+		OcclusionCuller culler(jobSystem);
+		const OccluderGeometry wall = Wall();
+
+		culler.begin(ViewProjection());
+		culler.addOccluder(wall, glm::mat4(1.0f));
+		culler.rasterize();
+
+		VR_CHECK(culler.getOccluderCount() == 1);
+		VR_CHECK(culler.getTriangleCount() == 2);
+		VR_CHECK(!culler.isVisible(AABB{ { -0.5f, -0.5f, -3.0f }, { 0.5f, 0.5f, -2.0f } }));
+		VR_CHECK(!culler.isVisible(AABB{ { -1.5f, -1.5f, -1.0f }, { 1.5f, 1.5f, -0.1f } }));
+
+		// The same box in front of the wall is visible
+		VR_CHECK(culler.isVisible(AABB{ { -0.5f, -0.5f, 1.0f }, { 0.5f, 0.5f, 2.0f } }));
+	}
+
+	VR_TEST(OcclusionCuller, PartiallyOccludedBox) {
+		JobSystem jobSystem;
+		OcclusionCuller culler(jobSystem);
+		const OccluderGeometry wall = Wall();
+
+		culler.begin(ViewProjection());
+		culler.addOccluder(wall, glm::mat4(1.0f));
+		culler.rasterize();
+
+		// Behind the wall but sticking out of its right edge, once in perspective
+		VR_CHECK(culler.isVisible(AABB{ { 2.5f, -0.5f, -3.0f }, { 3.5f, 0.5f, -2.0f } }));
+
+		// Past the wall edge in world space, yet hidden from the camera
+		VR_CHECK(!culler.isVisible(AABB{ { 2.1f, -0.5f, -3.0f }, { 2.5f, 0.5f, -2.0f } }));
+
+		// Crossing the wall, its front half is in front of it
+		VR_CHECK(culler.isVisible(AABB{ { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } }));
+	}
+
+	VR_TEST(OcclusionCuller, BoxStraddlingNearPlane) {
+		JobSystem jobSystem;
+		OcclusionCuller culler(jobSystem);
+		const OccluderGeometry wall = Wall();
+
+		culler.begin(ViewProjection());
+		culler.addOccluder(wall, glm::mat4(1.0f));
+		culler.rasterize();
+
+		// Boxes crossing the near plane can't be projected, they are kept and cover the whole screen
+		const AABB straddling{ { -0.5f, -0.5f, 4.5f }, { 0.5f, 0.5f, 5.5f } };
+		VR_CHECK(culler.isVisible(straddling));
+		VR_CHECK(culler.getScreenCoverage(straddling) == 1.0f);
+
+		// Occluders crossing the near plane skip the triangles they can't project, and hide nothing
+		const glm::mat4 closeWall = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f))
+			* glm::rotate(glm::mat4(1.0f), glm::radians(80.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+		culler.begin(ViewProjection());
+		culler.addOccluder(wall, closeWall);
+		culler.rasterize();
+		VR_CHECK(culler.isVisible(AABB{ { -0.5f, -0.5f, -3.0f }, { 0.5f, 0.5f, -2.0f } }));
+	}
+
+	VR_TEST(OcclusionCuller, EmptyBuffer) {
+		JobSystem jobSystem;
+		OcclusionCuller culler(jobSystem);
+
+		culler.begin(ViewProjection());
+		culler.rasterize();
+
+		VR_CHECK(culler.getOccluderCount() == 0);
+		const std::vector<float>& depth = culler.getDepthBuffer();
+		VR_CHECK(std::all_of(depth.begin(), depth.end(), [](float d) { return d == 1.0f; }));
+
+		// Anything on screen is visible, boxes out of the screen are not
+		VR_CHECK(culler.isVisible(AABB{ { -0.5f, -0.5f, -3.0f }, { 0.5f, 0.5f, -2.0f } }));
+		VR_CHECK(culler.isVisible(AABB{ { -0.1f, -0.1f, -90.0f }, { 0.1f, 0.1f, -80.0f } }));
+		VR_CHECK(!culler.isVisible(AABB{ { 50.0f, -0.5f, -3.0f }, { 51.0f, 0.5f, -2.0f } }));
+	}
+
+}
@@ -0,0 +1,143 @@
+// VR Renderer - Transform Hierarchy Tests
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "renderer/TransformHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace vr {
+
+	// Non-uniform scales, arbitrary rotations and translations
+	static Transform RandomTransform(std::mt19937& rng) {
+		std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+
+		Transform transform;
+		transform.scale = glm::vec3(scale(rng), scale(rng), scale(rng));
+		transform.rotation = glm::normalize(glm::quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+		transform.translation = glm::vec3(position(rng), position(rng), position(rng));
+		return transform;
+	}
+
+	static bool NearlyEqual(const glm::mat4& a, const glm::mat4& b) {
+		for (uint32_t column = 0; column < 4; ++column) {
+			for (uint32_t row = 0; row < 4; ++row) {
+				const float tolerance = 1e-4f * std::max(1.0f, std::abs(b[column][row]));
+				if (std::abs(a[column][row] - b[column][row]) > tolerance)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Reference matrices of a node, concatenated up the chain of its parents
+	static void CheckNode(const TransformHierarchy& hierarchy, const std::vector<Transform>& transforms, uint32_t node) {
+		glm::mat4 world = transforms[node].getModelMatrix();
+		glm::mat4 normal = transforms[node].getNormalMatrix();
+		for (uint32_t parent = hierarchy.getParent(node); parent != TransformHierarchy::s_NO_PARENT; parent = hierarchy.getParent(parent)) {
+			world = transforms[parent].getModelMatrix() * world;
+			normal = transforms[parent].getNormalMatrix() * normal;
+		}
+
+		VR_CHECK(NearlyEqual(hierarchy.getWorldMatrix(node), world));
+		VR_CHECK(NearlyEqual(hierarchy.getNormalMatrix(node), normal));
+	}
+
+	VR_TEST(TransformHierarchy, MatchesTransformMatrices) {
+		std::mt19937 rng(7);
+
+		// Counts around the four lanes of a batch
+		for (uint32_t count : { 1u, 3u, 5u, 6u, 7u, 13u }) {
+			TransformHierarchy hierarchy;
+			hierarchy.resize(count);
+
+			std::vector<Transform> transforms(count);
+			for (uint32_t node = 0; node < count; ++node) {
+				transforms[node] = RandomTransform(rng);
+				hierarchy.setLocal(node, transforms[node]);
+			}
+
+			// Chains and siblings, children declared before their parents
+			for (uint32_t node = 0; node + 2 < count; node += 2)
+				hierarchy.setParent(node, node + 2);
+
+			hierarchy.update();
+			VR_CHECK(hierarchy.getUpdatedCount() == count);
+			for (uint32_t node = 0; node < count; ++node)
+				CheckNode(hierarchy, transforms, node);
+		}
+	}
+
+	VR_TEST(TransformHierarchy, PropagatesDirtyParents) {
+		std::mt19937 rng(11);
+		std::vector<Transform> transforms = { RandomTransform(rng), RandomTransform(rng), RandomTransform(rng), RandomTransform(rng) };
+
+		TransformHierarchy hierarchy;
+		hierarchy.resize(4);
+		for (uint32_t node = 0; node < 4; ++node)
+			hierarchy.setLocal(node, transforms[node]);
+		hierarchy.setParent(1, 0);
+		hierarchy.setParent(2, 1);
+		hierarchy.update();
+
+		// Only the grandparent moves, its clean descendants follow while the unrelated root is left as is
+		const uint64_t rootRevision = hierarchy.getRevision(3);
+		transforms[0] = RandomTransform(rng);
+		hierarchy.setLocal(0, transforms[0]);
+		hierarchy.update();
+
+		VR_CHECK(hierarchy.getUpdatedCount() == 3);
+		VR_CHECK(hierarchy.getRevision(3) == rootRevision);
+		for (uint32_t node = 0; node < 4; ++node)
+			CheckNode(hierarchy, transforms, node);
+
+		// Nothing changed, nothing is recomputed
+		hierarchy.update();
+		VR_CHECK(hierarchy.getUpdatedCount() == 0);
+	}
+
+	VR_TEST(TransformHierarchy, RefusesCycles) {
+		TransformHierarchy hierarchy;
+		hierarchy.resize(3);
+		hierarchy.setParent(1, 0);
+		hierarchy.setParent(2, 1);
+
+		hierarchy.setParent(0, 2);
+		hierarchy.setParent(0, 0);
+		VR_CHECK(hierarchy.getParent(0) == TransformHierarchy::s_NO_PARENT);
+
+		// Attaching higher up its own chain is no cycle
+		hierarchy.setParent(2, 0);
+		VR_CHECK(hierarchy.getParent(2) == 0);
+	}
+
+	VR_TEST(TransformHierarchy, DetachesChildrenOfRemovedNodes) {
+		std::mt19937 rng(13);
+		std::vector<Transform> transforms = { RandomTransform(rng), RandomTransform(rng), RandomTransform(rng) };
+
+		TransformHierarchy hierarchy;
+		hierarchy.resize(3);
+		for (uint32_t node = 0; node < 3; ++node)
+			hierarchy.setLocal(node, transforms[node]);
+		hierarchy.setParent(0, 2);
+		hierarchy.setParent(1, 0);
+		hierarchy.update();
+
+		// The first node becomes a root and is recomputed on its own, its child follows
+		hierarchy.resize(2);
+		VR_CHECK(hierarchy.getParent(0) == TransformHierarchy::s_NO_PARENT);
+		VR_CHECK(hierarchy.getParent(1) == 0);
+
+		transforms.resize(2);
+		hierarchy.update();
+		VR_CHECK(hierarchy.getUpdatedCount() == 2);
+		for (uint32_t node = 0; node < 2; ++node)
+			CheckNode(hierarchy, transforms, node);
+	}
+
+}
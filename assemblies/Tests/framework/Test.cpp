@@ -0,0 +1,88 @@
+// VR Renderer - Test Framework
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "core/Logger.h"
+
+#include <chrono>
+#include <cstring>
+#include <exception>
+
+namespace vr {
+	namespace test {
+
+		static uint32_t s_failures = 0;	// Failed checks of the running case
+		static const void* volatile s_sink = nullptr;
+
+		std::vector<Case>& getCases() {
+			static std::vector<Case> s_cases;
+			return s_cases;
+		}
+
+		Registrar::Registrar(const char* suite, const char* name, void (*function)(), bool benchmark) {
+			getCases().push_back(Case{ suite, name, function, benchmark });
+		}
+
+		void fail(const char* expression, const char* file, int32_t line) {
+			logger::error("{}:{}: check failed: {}", file, line, expression);
+			++s_failures;
+		}
+
+		double measure(const std::string& label, uint32_t iterations, const std::function<void()>& function) {
+			function();
+
+			const auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < iterations; ++i)
+				function();
+			const auto end = std::chrono::steady_clock::now();
+
+			const double time = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+			logger::info("{:<48} {:>12.1f} us", label, time);
+			return time;
+		}
+
+		void keep(const void* value) {
+			s_sink = value;
+		}
+
+	}
+}
+
+// Runs the tests, or the benchmarks with --bench. Any other argument filters the cases by "suite.name" substring.
+int main(int argc, char** argv) {
+	bool benchmarks = false;
+	const char* filter = nullptr;
+	for (int32_t i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--bench") == 0)
+			benchmarks = true;
+		else
+			filter = argv[i];
+	}
+
+	uint32_t passed = 0, failed = 0;
+	for (const vr::test::Case& testCase : vr::test::getCases()) {
+		const std::string name = std::string(testCase.suite) + "." + testCase.name;
+		if (testCase.benchmark != benchmarks) continue;
+		if (filter && name.find(filter) == std::string::npos) continue;
+
+		vr::logger::info("{}", name);
+		vr::test::s_failures = 0;
+		try {
+			testCase.function();
+		} catch (const std::exception& exception) {
+			vr::logger::error("Unexpected exception: {}", exception.what());
+			++vr::test::s_failures;
+		}
+
+		if (vr::test::s_failures == 0) {
+			++passed;
+		} else {
+			vr::logger::error("{} failed", name);
+			++failed;
+		}
+	}
+
+	vr::logger::info("{} passed, {} failed", passed, failed);
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// VR Renderer - Test Framework
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vr {
+	namespace test {
+
+		/// @brief Test or benchmark, registered before main by the VR_TEST and VR_BENCHMARK macros.
+		struct Case {
+			const char* suite;
+			const char* name;
+			void (*function)();
+			bool benchmark;
+		};
+
+		/// @brief Provides the registered cases, in registration order.
+		std::vector<Case>& getCases();
+
+		struct Registrar {
+			Registrar(const char* suite, const char* name, void (*function)(), bool benchmark);
+		};
+
+		/// @brief Records a failed check of the running test. The test goes on, it fails once it returns.
+		void fail(const char* expression, const char* file, int32_t line);
+
+		/// @brief Times a function, after a warm up call, and logs its mean time.
+		/// @param label Name of the measure, logged with the time.
+		/// @param iterations Number of timed calls.
+		/// @return Mean time of a call, in microseconds.
+		double measure(const std::string& label, uint32_t iterations, const std::function<void()>& function);
+
+		/// @brief Keeps the compiler from optimizing away a benchmarked computation.
+		void keep(const void* value);
+
+	}
+}
+
+#define VR_TEST_CASE(suite, name, benchmark)																	\
+	static void suite##_##name();																				\
+	static const vr::test::Registrar suite##_##name##_registrar(#suite, #name, suite##_##name, benchmark);	\
+	static void suite##_##name()
+
+/// @brief Defines a test, run by default.
+#define VR_TEST(suite, name) VR_TEST_CASE(suite, name, false)
+
+/// @brief Defines a benchmark, run with --bench.
+#define VR_BENCHMARK(suite, name) VR_TEST_CASE(suite, name, true)
+
+/// @brief Fails the running test if the expression is false.
+#define VR_CHECK(expression) do { if (!(expression)) vr::test::fail(#expression, __FILE__, __LINE__); } while (false)
+
+/// @brief Fails the running test and leaves it if the expression is false.
+#define VR_REQUIRE(expression) do { if (!(expression)) { vr::test::fail(#expression, __FILE__, __LINE__); return; } } while (false)
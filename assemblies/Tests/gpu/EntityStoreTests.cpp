@@ -0,0 +1,141 @@
+// VR Renderer - Entity Store Tests
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "GpuContext.h"
+#include "renderer/EntityStore.h"
+#include "renderer/RenderableStore.h"
+
+#include <cstring>
+
+namespace vr {
+
+	// Single triangle, enough for the draw calls of the renderable store
+	static std::shared_ptr<gpu::VertexArray> Triangle() {
+		const glm::vec3 corners[3] = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+
+		gpu::GeometryData geometry;
+		geometry.layout = gpu::VertexLayout{ { gpu::Attribute::Position, GL_FLOAT, 3 } };
+		geometry.vertex_data.resize(sizeof(corners));
+		std::memcpy(geometry.vertex_data.data(), corners, sizeof(corners));
+		geometry.indices = { 0, 1, 2 };
+		geometry.topology = GL_TRIANGLES;
+		return std::make_shared<gpu::VertexArray>(geometry);
+	}
+
+	// Mesh of a few primitives sharing a geometry, the first one alpha masked
+	static Mesh MakeMesh(uint32_t primitiveCount, bool isStatic, std::shared_ptr<gpu::VertexArray> geometry = nullptr) {
+		auto masked = std::make_shared<MaterialInstance>();
+		masked->renderFlags.alphaCutoff = 0.5f;
+		auto opaque = std::make_shared<MaterialInstance>();
+
+		Mesh mesh;
+		mesh.isStatic = isStatic;
+		for (uint32_t j = 0; j < primitiveCount; ++j) {
+			const glm::vec3 corner(static_cast<float>(j));
+			mesh.primitives.push_back(Primitive{ geometry, j == 0 ? masked : opaque, AABB{ corner, corner + 1.0f }, nullptr });
+		}
+		return mesh;
+	}
+
+	// Checks the ranges and the entity of every renderable agree
+	static void CheckRanges(const EntityStore::Layout& layout) {
+		VR_CHECK(layout.firstRenderables.size() == layout.getEntityCount() + 1);
+		VR_CHECK(layout.firstRenderables.back() == layout.getRenderableCount());
+		for (uint32_t e = 0; e < layout.getEntityCount(); ++e) {
+			for (uint32_t r = layout.firstRenderables[e]; r < layout.firstRenderables[e + 1]; ++r)
+				VR_CHECK(layout.entities[r] == e);
+		}
+	}
+
+	VR_TEST(EntityStore, PacksRenderablesInEntityOrder) {
+		VR_REQUIRE(test::initGpu());
+
+		EntityStore store;
+		VR_CHECK(store.add(MakeMesh(2, true)) == 0);
+		VR_CHECK(store.add(MakeMesh(3, false)) == 1);
+		VR_CHECK(store.add(MakeMesh(1, false)) == 2);
+
+		const std::shared_ptr<const EntityStore::Layout> layout = store.getLayout();
+		CheckRanges(*layout);
+		VR_CHECK(layout->getRenderableCount() == 6);
+		VR_CHECK(layout->flags[0] == (EntityStore::Static | EntityStore::AlphaMasked));
+		VR_CHECK(layout->flags[1] == EntityStore::Static);
+		VR_CHECK(layout->flags[2] == EntityStore::AlphaMasked);
+		VR_CHECK(layout->flags[3] == 0);
+		VR_CHECK(layout->bounds[4].min == glm::vec3(2.0f));
+
+		// Replacing primitives in the middle shifts the renderables of the following entities
+		store.setPrimitives(1, MakeMesh(1, false).primitives);
+		CheckRanges(*store.getLayout());
+		VR_CHECK(store.getLayout()->getRenderableCount() == 4);
+		VR_CHECK(store.getRenderableCount(1) == 1);
+		VR_CHECK(store.getFirstRenderable(2) == 3);
+
+		// Truncated entities can't stay parents
+		store.setParent(0, 2);
+		store.setParent(1, 0);
+		store.truncate(2);
+		CheckRanges(*store.getLayout());
+		VR_CHECK(store.getCount() == 2);
+		VR_CHECK(store.getParent(0) == EntityStore::s_NO_ENTITY);
+		VR_CHECK(store.getParent(1) == 0);
+	}
+
+	VR_TEST(EntityStore, EditsCopySharedLayout) {
+		VR_REQUIRE(test::initGpu());
+
+		EntityStore store;
+		store.add(MakeMesh(2, false));
+
+		// The held layout is left untouched, the edit goes to a copy with a new revision
+		const std::shared_ptr<const EntityStore::Layout> held = store.getLayout();
+		const auto material = std::make_shared<MaterialInstance>();
+		material->renderFlags.alphaCutoff = 0.5f;
+		store.setMaterial(1, material);
+		store.setStatic(0, true);
+
+		const EntityStore::Layout* edited = store.getLayout().get();
+		VR_CHECK(edited != held.get());
+		VR_CHECK(edited->revision != held->revision);
+		VR_CHECK(held->materials[1] != material.get());
+		VR_CHECK(held->flags[1] == 0);
+		VR_CHECK(edited->materials[1] == material.get());
+		VR_CHECK(edited->flags[1] == (EntityStore::Static | EntityStore::AlphaMasked));
+
+		// A layout held by no snapshot is edited in place
+		const uint64_t revision = edited->revision;
+		store.setStatic(0, false);
+		VR_CHECK(store.getLayout().get() == edited);
+		VR_CHECK(edited->revision != revision);
+		VR_CHECK(edited->flags[1] == EntityStore::AlphaMasked);
+	}
+
+	VR_TEST(EntityStore, MaterialEditsMoveRenderables) {
+		VR_REQUIRE(test::initGpu());
+
+		Scene scene;
+		scene.entities.add(MakeMesh(2, false, Triangle()));
+		SceneSnapshot snapshot;
+		snapshot.capture(scene);
+
+		RenderableStore renderables;
+		VR_CHECK(renderables.sync(snapshot));
+		VR_CHECK(!renderables.sync(snapshot));
+		VR_CHECK(renderables.locate(0).archetype == RenderableStore::AlphaMasked);
+		VR_CHECK(renderables.locate(1).archetype == 0);
+
+		// The draw order is rebuilt from the new material, the renderable becomes alpha masked
+		const auto material = std::make_shared<MaterialInstance>();
+		material->renderFlags.alphaCutoff = 0.5f;
+		scene.entities.setMaterial(1, material);
+		snapshot.capture(scene);
+		VR_CHECK(renderables.sync(snapshot));
+
+		const RenderableStore::Location& location = renderables.locate(1);
+		VR_CHECK(location.archetype == RenderableStore::AlphaMasked);
+		VR_CHECK(renderables.getArchetype(location.archetype).materials[location.index] == material.get());
+	}
+
+}
@@ -0,0 +1,79 @@
+// VR Renderer - GPU Test Context
+// Rodolphe VALICON
+// 2025
+
+#include "GpuContext.h"
+#include "core/Logger.h"
+
+#include <glad/glad.h>
+
+#ifdef _WIN32
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <string>
+
+namespace vr {
+	namespace test {
+
+#ifdef _WIN32
+		static bool CreateContext() {
+			if (!glfwInit()) return false;
+
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+			glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+			GLFWwindow* window = glfwCreateWindow(64, 64, "GpuTests", nullptr, nullptr);
+			if (!window) return false;
+
+			glfwMakeContextCurrent(window);
+			return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+		}
+#else
+		static bool CreateContext() {
+			// Surfaceless display, no window system is needed
+			auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+			EGLDisplay display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) : EGL_NO_DISPLAY;
+			if (display == EGL_NO_DISPLAY)
+				display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) return false;
+
+			const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+			EGLConfig config = nullptr;
+			EGLint configCount = 0;
+			eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+			const EGLint contextAttributes[] = {
+				EGL_CONTEXT_MAJOR_VERSION, 4,
+				EGL_CONTEXT_MINOR_VERSION, 5,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_NONE
+			};
+			if (!eglBindAPI(EGL_OPENGL_API)) return false;
+			EGLContext context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+			if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return false;
+
+			return gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+		}
+#endif
+
+		bool initGpu() {
+			static const bool s_initialized = [] {
+				if (!CreateContext()) {
+					logger::error("No OpenGL context could be created for the GPU tests");
+					return false;
+				}
+
+				logger::info("OpenGL {} on {}", reinterpret_cast<const char*>(glGetString(GL_VERSION)), reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+				return true;
+			}();
+			return s_initialized;
+		}
+
+	}
+}
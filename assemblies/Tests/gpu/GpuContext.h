@@ -0,0 +1,17 @@
+// VR Renderer - GPU Test Context
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+namespace vr {
+	namespace test {
+
+		/// @brief Creates the headless OpenGL 4.6 context of the GPU tests on the first call, and keeps it current.
+		/// Linux uses a surfaceless EGL display, which also runs on software implementations like llvmpipe,
+		/// other platforms use a hidden GLFW window. Cases drawing to the default framebuffer are not supported.
+		/// @return false if no context could be created, the calling case should fail.
+		bool initGpu();
+
+	}
+}
@@ -0,0 +1,236 @@
+// VR Renderer - GPU Culler Tests
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "GpuContext.h"
+#include "gpu/StateCache.h"
+#include "renderer/GpuCuller.h"
+#include "renderer/OcclusionCuller.h"
+#include "renderer/RenderTarget.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace vr {
+
+	static constexpr int32_t s_TARGET_WIDTH = 320;
+	static constexpr int32_t s_TARGET_HEIGHT = 180;
+
+	// Camera 5 units in front of the origin, looking down -Z, as in the CPU occlusion tests
+	static glm::mat4 ViewProjection() {
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		return projection * view;
+	}
+
+	// Unit cube, shared by every renderable
+	static std::shared_ptr<gpu::VertexArray> Cube() {
+		const glm::vec3 corners[8] = {
+			{ -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+			{ -0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { -0.5f, 0.5f, 0.5f },
+		};
+
+		gpu::GeometryData geometry;
+		geometry.layout = gpu::VertexLayout{ { gpu::Attribute::Position, GL_FLOAT, 3 } };
+		geometry.vertex_data.resize(sizeof(corners));
+		std::memcpy(geometry.vertex_data.data(), corners, sizeof(corners));
+		geometry.indices = { 0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5 };
+		geometry.topology = GL_TRIANGLES;
+		return std::make_shared<gpu::VertexArray>(geometry);
+	}
+
+	// Renderables of the scene, one entity of a single primitive per box, and the flattened bounds of the culling pass
+	struct CullScene {
+		Scene scene;
+		SceneSnapshot snapshot;
+		std::vector<AABB> boxes;
+		gpu::Buffer bounds;
+
+		CullScene(const std::vector<AABB>& sceneBoxes) : boxes(sceneBoxes) {
+			const std::shared_ptr<gpu::VertexArray> cube = Cube();
+			const std::shared_ptr<MaterialInstance> material = std::make_shared<MaterialInstance>();
+
+			std::vector<float> flattened;
+			for (const AABB& box : boxes) {
+				Mesh mesh;
+				mesh.primitives.push_back(Primitive{ cube, material, box, nullptr });
+				scene.entities.add(mesh);
+
+				flattened.insert(flattened.end(), { box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z });
+			}
+			snapshot.capture(scene);
+			bounds = gpu::Buffer(flattened.size() * sizeof(float), GL_STATIC_DRAW, reinterpret_cast<const uint8_t*>(flattened.data()));
+		}
+	};
+
+	static uint32_t ObjectIndex(const RenderableStore& store, uint32_t primitive) {
+		const RenderableStore::Location& location = store.locate(primitive);
+		return store.getArchetype(location.archetype).first + location.index;
+	}
+
+	// Square of side 4 in the XY plane, centered on the origin
+	static OccluderGeometry Wall() {
+		OccluderGeometry wall;
+		wall.positions = { { -2.0f, -2.0f, 0.0f }, { 2.0f, -2.0f, 0.0f }, { 2.0f, 2.0f, 0.0f }, { -2.0f, 2.0f, 0.0f } };
+		wall.indices = { 0, 1, 2, 0, 2, 3 };
+		return wall;
+	}
+
+	// Depth of the wall as a rasterizer writes it: the wall faces the camera, its depth is constant over the pixels it covers
+	static void DrawWallDepth(const RenderTarget& target, const glm::mat4& viewProjection) {
+		const glm::vec4 lower = viewProjection * glm::vec4(-2.0f, -2.0f, 0.0f, 1.0f);
+		const glm::vec4 upper = viewProjection * glm::vec4(2.0f, 2.0f, 0.0f, 1.0f);
+		const glm::vec2 size(target.getViewportWidth(), target.getViewportHeight());
+		const glm::vec2 screenMin = (glm::vec2(lower) / lower.w * 0.5f + 0.5f) * size;
+		const glm::vec2 screenMax = (glm::vec2(upper) / upper.w * 0.5f + 0.5f) * size;
+		const float depth = lower.z / lower.w * 0.5f + 0.5f;
+
+		// Pixels whose center is covered
+		const glm::ivec2 first(glm::ceil(screenMin - 0.5f));
+		const glm::ivec2 last(glm::floor(screenMax - 0.5f));
+
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		glClearNamedFramebufferfi(target.getFramebuffer(), GL_DEPTH_STENCIL, 0, 1.0f, 0);
+		state.enable(GL_SCISSOR_TEST);
+		glScissor(first.x, first.y, last.x - first.x + 1, last.y - first.y + 1);
+		glClearNamedFramebufferfi(target.getFramebuffer(), GL_DEPTH_STENCIL, 0, depth, 0);
+		state.disable(GL_SCISSOR_TEST);
+	}
+
+	// Objects of the commands drawing instances, checking each command draws the cube
+	static std::vector<uint32_t> DrawnObjects(const GpuCuller& culler, uint32_t instanceViews) {
+		std::vector<uint32_t> objects;
+		std::vector<GpuCuller::DrawCommand> commands;
+		for (uint32_t b = 0; b < culler.getBatches().size(); ++b) {
+			const uint32_t count = culler.readCommands(b, commands);
+			VR_CHECK(count <= commands.size());
+
+			uint32_t drawn = 0;
+			for (uint32_t c = 0; c < commands.size(); ++c) {
+				const GpuCuller::DrawCommand& command = commands[c];
+				if (culler.isCompacting() && c >= count) break;
+				if (command.instanceCount == 0) continue;
+
+				VR_CHECK(command.instanceCount == instanceViews);
+				VR_CHECK(command.elementCount == 36);
+				objects.push_back(command.baseInstance);
+				++drawn;
+			}
+			VR_CHECK(drawn == count);
+		}
+
+		std::sort(objects.begin(), objects.end());
+		return objects;
+	}
+
+	VR_TEST(GpuCuller, FrustumMatchesCpu) {
+		VR_REQUIRE(test::initGpu());
+
+		// Boxes scattered in and around the view, more than a work group of the culling pass
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+		std::uniform_real_distribution<float> size(0.1f, 3.0f);
+		std::vector<AABB> boxes(1000);
+		for (AABB& box : boxes) {
+			box.min = glm::vec3(position(rng), position(rng), position(rng) - 30.0f);
+			box.max = box.min + glm::vec3(size(rng), size(rng), size(rng));
+		}
+
+		CullScene scene(boxes);
+		RenderableStore store;
+		store.sync(scene.snapshot);
+
+		GpuCuller culler;
+		culler.sync(store);
+		VR_CHECK(culler.getStats().instances == boxes.size());
+
+		const Frustum frustum(ViewProjection());
+		std::vector<uint32_t> expected;
+		for (uint32_t p = 0; p < boxes.size(); ++p) {
+			if (frustum.intersects(boxes[p]))
+				expected.push_back(ObjectIndex(store, p));
+		}
+		std::sort(expected.begin(), expected.end());
+		VR_CHECK(!expected.empty() && expected.size() < boxes.size());
+
+		gpu::StateCache::getInstance().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, scene.bounds);
+		for (uint32_t instanceViews : { 1u, 2u }) {
+			culler.cull(frustum, false, instanceViews);
+			VR_CHECK(DrawnObjects(culler, instanceViews) == expected);
+		}
+	}
+
+	VR_TEST(GpuCuller, OcclusionMatchesCpu) {
+		VR_REQUIRE(test::initGpu());
+
+		const std::vector<AABB> boxes = {
+			{ { -2.0f, -2.0f, -0.05f }, { 2.0f, 2.0f, 0.05f } },	// The wall itself, in front of its own depth
+			{ { -0.5f, -0.5f, 1.0f }, { 0.5f, 0.5f, 2.0f } },		// In front of the wall
+			{ { -0.5f, -0.5f, -3.0f }, { 0.5f, 0.5f, -2.0f } },		// Behind the wall
+			{ { 0.8f, -1.0f, -6.0f }, { 1.2f, -0.6f, -5.0f } },		// Behind the wall, off its center
+			{ { 2.5f, -0.5f, -3.0f }, { 3.5f, 0.5f, -2.0f } },		// Behind the wall plane, sticking out of its edge
+			{ { -0.5f, -0.5f, 7.0f }, { 0.5f, 0.5f, 8.0f } },		// Behind the camera
+			{ { 50.0f, -0.5f, -3.0f }, { 51.0f, 0.5f, -2.0f } },	// Out of the sides
+			{ { -0.5f, -0.5f, -120.0f }, { 0.5f, 0.5f, -110.0f } },	// Past the far plane
+		};
+		const std::vector<uint32_t> visible = { 0, 1, 4 };
+		const std::vector<uint32_t> inFrustum = { 0, 1, 2, 3, 4 };
+
+		CullScene scene(boxes);
+		RenderableStore store;
+		store.sync(scene.snapshot);
+
+		// CPU reference, the wall rasterized by the software occlusion culler
+		const glm::mat4 viewProjection = ViewProjection();
+		const Frustum frustum(viewProjection);
+		JobSystem jobSystem;
+		OcclusionCuller occlusionCuller(jobSystem);
+		const OccluderGeometry wall = Wall();
+		occlusionCuller.begin(viewProjection);
+		occlusionCuller.addOccluder(wall, glm::mat4(1.0f));
+		occlusionCuller.rasterize();
+
+		std::vector<uint32_t> cpuVisible, cpuInFrustum;
+		for (uint32_t p = 0; p < boxes.size(); ++p) {
+			if (!frustum.intersects(boxes[p])) continue;
+
+			cpuInFrustum.push_back(p);
+			if (occlusionCuller.isVisible(boxes[p]))
+				cpuVisible.push_back(p);
+		}
+		VR_CHECK(cpuVisible == visible);
+		VR_CHECK(cpuInFrustum == inFrustum);
+
+		auto objects = [&](const std::vector<uint32_t>& primitives) {
+			std::vector<uint32_t> result;
+			for (uint32_t p : primitives)
+				result.push_back(ObjectIndex(store, p));
+			std::sort(result.begin(), result.end());
+			return result;
+		};
+
+		GpuCuller culler;
+		culler.sync(store);
+		gpu::StateCache::getInstance().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, scene.bounds);
+
+		// Without a depth pyramid yet, only the frustum culls
+		culler.cull(frustum, true);
+		VR_CHECK(DrawnObjects(culler, 1) == objects(inFrustum));
+
+		// Depth pyramid of the wall drawn by the previous frame
+		RenderTarget target(s_TARGET_WIDTH, s_TARGET_HEIGHT);
+		DrawWallDepth(target, viewProjection);
+		culler.buildDepthPyramid(target, viewProjection);
+
+		culler.cull(frustum, true);
+		VR_CHECK(DrawnObjects(culler, 1) == objects(visible));
+
+		culler.cull(frustum, false);
+		VR_CHECK(DrawnObjects(culler, 1) == objects(inFrustum));
+	}
+
+}
@@ -0,0 +1,49 @@
+// VR Renderer - Instancing Benchmarks
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "RendererFixture.h"
+#include "core/Logger.h"
+#include "utils/GLTFLoader.h"
+
+namespace vr {
+
+	// 10k copies of the emissive cube lit by the sun, moved every frame so that their shadows are redrawn each time
+	VR_BENCHMARK(Instancing, StressCubes) {
+		VR_REQUIRE(test::initRenderer());
+
+		test::RendererFixture fixture(640, 360);
+		Scene& scene = fixture.getScene();
+		scene.directionalLights.push_back(DirectionalLight{
+			.direction = { -0.1f, -1.0f, -0.5f },
+			.color = glm::vec3(1.0f),
+			.power = 10.0f,
+		});
+
+		const std::shared_ptr<Mesh> cube = utils::loadGLTFMesh("res/models/cube-emissive/Cube.gltf", 0);
+		test::addStressGrid(scene, *cube, 10000, 0.04f, 0.005f);
+		for (uint32_t e = 0; e < scene.entities.getCount(); ++e)
+			scene.entities.setStatic(e, false);
+
+		Camera& camera = fixture.getCamera();
+		camera.eyePos = glm::vec3(0.0f, 0.6f, 0.9f);
+		camera.forward = glm::normalize(glm::vec3(0.0f, 0.3f, 0.0f) - camera.eyePos);
+
+		Renderer::Settings& settings = fixture.getRenderer().getSettings();
+		settings.occlusionCulling = false;
+		for (bool instancing : { false, true }) {
+			settings.instancing = instancing;
+			const test::RendererFixture::FrameTimes times = fixture.measureFrames(10);
+			const Renderer::Stats& stats = fixture.getRenderer().getStats();
+			const ShadowScheduler::Stats& shadows = fixture.getRenderer().getShadowScheduler().getStats();
+
+			logger::info("Instancing {}: {} draws of {} instances, shadows {} draws of {} instances", instancing ? "on" : "off",
+				stats.drawCalls, stats.instances, shadows.draws, shadows.instances);
+			logger::info("{:<48} {:>12.1f} us", "Submit", times.submit);
+			logger::info("{:<48} {:>12.1f} us", "Frame CPU", times.frame);
+			logger::info("{:<48} {:>12.1f} us", "Frame GPU wait", times.gpu);
+		}
+	}
+
+}
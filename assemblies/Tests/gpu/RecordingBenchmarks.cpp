@@ -0,0 +1,122 @@
+// VR Renderer - Recording Benchmarks
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "RendererFixture.h"
+#include "core/Logger.h"
+#include "utils/GLTFLoader.h"
+
+#include <cmath>
+#include <filesystem>
+#include <format>
+
+namespace vr {
+
+	// Corners of the courtyard of Sponza as the application scales it, where the point lights are placed
+	static constexpr glm::vec3 s_LIGHT_POSITIONS[4] = { { -1.0f, 0.4f, -0.4f }, { -1.0f, 0.4f, 0.4f }, { 1.0f, 0.4f, -0.4f }, { 1.0f, 0.4f, 0.4f } };
+
+	static void AddPointLights(Scene& scene) {
+		for (const glm::vec3& position : s_LIGHT_POSITIONS)
+			scene.pointLights.push_back(PointLight{ .position = position, .color = glm::vec3(1.0f), .power = 0.05f, .radius = 0.0f });
+	}
+
+	// Sponza as the application loads it, either as is or merged by the static batcher
+	static std::shared_ptr<Mesh> LoadSponza(bool staticBatching) {
+		Transform transform;
+		transform.scale = glm::vec3(0.002f);
+
+		if (!staticBatching) {
+			auto sponza = utils::loadGLTFMesh("res/models/sponza/Sponza.gltf", 0);
+			sponza->transform = transform;
+			sponza->isStatic = true;
+			return sponza;
+		}
+
+		utils::StaticBatcher batcher;
+		utils::batchGLTFMesh("res/models/sponza/Sponza.gltf", 0, transform.getModelMatrix(), batcher);
+		return batcher.build();
+	}
+
+	// Renders the scene of the fixture with its passes recorded on the render thread, then on the workers.
+	// The point lights sway every frame so that their 24 shadow faces are recorded again each time.
+	static void MeasureRecording(test::RendererFixture& fixture, const std::string& scene) {
+		Renderer& renderer = fixture.getRenderer();
+		Renderer::Settings& settings = renderer.getSettings();
+		settings.shadows.instanceBudget = 100000;
+
+		std::vector<PointLight>& lights = fixture.getScene().pointLights;
+		for (bool parallel : { false, true }) {
+			settings.parallelRecording = parallel;
+
+			uint32_t frame = 0;
+			auto swayFrame = [&]() {
+				const float offset = 0.05f * std::sin(0.5f * static_cast<float>(++frame));
+				for (uint32_t l = 0; l < 4; ++l)
+					lights[l].position = s_LIGHT_POSITIONS[l] + glm::vec3(0.0f, offset, 0.0f);
+				return fixture.renderFrame();
+			};
+
+			for (uint32_t f = 0; f < 3; ++f)
+				swayFrame();
+
+			const uint32_t frames = 10;
+			test::RendererFixture::FrameTimes mean;
+			float recordTime = 0.0f;
+			for (uint32_t f = 0; f < frames; ++f) {
+				const test::RendererFixture::FrameTimes times = swayFrame();
+				mean.submit += times.submit / frames;
+				mean.frame += times.frame / frames;
+				mean.gpu += times.gpu / frames;
+				recordTime += renderer.getStats().recordTime / frames;
+			}
+
+			const Renderer::Stats& stats = renderer.getStats();
+			const ShadowScheduler::Stats& shadows = renderer.getShadowScheduler().getStats();
+			const std::string name = std::format("{}, {} recording", scene, parallel ? "parallel" : "serial");
+			logger::info("{}: {} passes, {} draws, shadows {} draws of {} instances", name, stats.recordedPasses, stats.drawCalls, shadows.draws, shadows.instances);
+			logger::info("{:<48} {:>12.1f} us", std::format("{}, record", name), recordTime);
+			logger::info("{:<48} {:>12.1f} us", std::format("{}, submit", name), mean.submit);
+			logger::info("{:<48} {:>12.1f} us", std::format("{}, frame CPU", name), mean.frame);
+			logger::info("{:<48} {:>12.1f} us", std::format("{}, frame GPU wait", name), mean.gpu);
+		}
+	}
+
+	// CPU frame time of Sponza lit by 4 shadowed point lights, as loaded and as batched
+	VR_BENCHMARK(Recording, SponzaPointShadows) {
+		VR_REQUIRE(test::initRenderer());
+		// The glTF loader reads a missing buffer as zeros, every primitive would collapse at the origin and be culled
+		VR_REQUIRE(std::filesystem::exists("res/models/sponza/Sponza.bin"));
+
+		for (bool staticBatching : { false, true }) {
+			test::RendererFixture fixture(320, 180);
+			Scene& scene = fixture.getScene();
+			scene.entities.add(*LoadSponza(staticBatching));
+			AddPointLights(scene);
+
+			Camera& camera = fixture.getCamera();
+			camera.eyePos = glm::vec3(-2.0f, 0.4f, 0.0f);
+			camera.forward = glm::vec3(1.0f, 0.0f, 0.0f);
+
+			MeasureRecording(fixture, staticBatching ? "Batched Sponza" : "Sponza");
+		}
+	}
+
+	// Same lights around a block of 10k static cubes, a scene of many small draws that ships with the repository
+	VR_BENCHMARK(Recording, CubesPointShadows) {
+		VR_REQUIRE(test::initRenderer());
+
+		test::RendererFixture fixture(320, 180);
+		Scene& scene = fixture.getScene();
+		const std::shared_ptr<Mesh> cube = utils::loadGLTFMesh("res/models/cube-emissive/Cube.gltf", 0);
+		test::addStressGrid(scene, *cube, 10000, 0.04f, 0.005f);
+		AddPointLights(scene);
+
+		Camera& camera = fixture.getCamera();
+		camera.eyePos = glm::vec3(-2.0f, 0.4f, 0.0f);
+		camera.forward = glm::vec3(1.0f, 0.0f, 0.0f);
+
+		MeasureRecording(fixture, "10k cubes");
+	}
+
+}
@@ -0,0 +1,86 @@
+// VR Renderer - Renderer Test Fixture
+// Rodolphe VALICON
+// 2025
+
+#include "RendererFixture.h"
+#include "GpuContext.h"
+#include "renderer/MaterialRegistry.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cmath>
+
+namespace vr {
+	namespace test {
+
+		bool initRenderer() {
+			static const bool s_initialized = [] {
+				if (!initGpu()) return false;
+
+				MaterialRegistry::loadMaterials();
+				Renderer::init(1920, 1080);
+				return true;
+			}();
+			return s_initialized;
+		}
+
+		RendererFixture::RendererFixture(int32_t width, int32_t height, int32_t samples) {
+			m_target = std::make_shared<RenderTarget>(width, height, samples);
+			m_renderer = std::make_unique<Renderer>(m_target);
+			m_camera.aspect = static_cast<float>(width) / static_cast<float>(height);
+		}
+
+		RendererFixture::FrameTimes RendererFixture::renderFrame() {
+			const auto captureStart = std::chrono::steady_clock::now();
+			m_snapshot.capture(m_scene);
+			m_snapshot.applyMaterialDeltas();
+
+			FrameTimes times;
+			const auto start = std::chrono::steady_clock::now();
+			times.capture = std::chrono::duration<float, std::micro>(start - captureStart).count();
+			if (m_renderer->beginFrame()) {
+				m_renderer->beginScene(m_camera);
+				m_renderer->submit(m_snapshot);
+				m_renderer->endScene();
+			}
+			const auto issued = std::chrono::steady_clock::now();
+			glFinish();
+			const auto end = std::chrono::steady_clock::now();
+
+			m_snapshot.release();
+			times.submit = m_renderer->getStats().submitTime;
+			times.frame = std::chrono::duration<float, std::micro>(issued - start).count();
+			times.gpu = std::chrono::duration<float, std::micro>(end - issued).count();
+			return times;
+		}
+
+		RendererFixture::FrameTimes RendererFixture::measureFrames(uint32_t frames, uint32_t warmUpFrames) {
+			for (uint32_t f = 0; f < warmUpFrames; ++f)
+				renderFrame();
+
+			FrameTimes mean;
+			for (uint32_t f = 0; f < frames; ++f) {
+				const FrameTimes times = renderFrame();
+				mean.capture += times.capture / frames;
+				mean.submit += times.submit / frames;
+				mean.frame += times.frame / frames;
+				mean.gpu += times.gpu / frames;
+			}
+			return mean;
+		}
+
+		void addStressGrid(Scene& scene, const Mesh& source, uint32_t count, float spacing, float scale) {
+			const int32_t side = static_cast<int32_t>(std::ceil(std::cbrt(static_cast<float>(count))));
+			Mesh cube = source;
+			cube.transform.scale = glm::vec3(scale);
+			cube.isStatic = true;
+			for (int32_t c = 0; c < static_cast<int32_t>(count); ++c) {
+				const uint32_t entity = scene.entities.add(cube);
+				scene.entities.getTransform(entity).translation = glm::vec3(c % side, c / side % side, c / (side * side)) * spacing
+					- glm::vec3(0.5f * spacing * side, -0.1f, 0.5f * spacing * side);
+			}
+		}
+
+	}
+}
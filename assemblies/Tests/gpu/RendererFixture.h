@@ -0,0 +1,58 @@
+// VR Renderer - Renderer Test Fixture
+// Rodolphe VALICON
+// 2025
+
+#pragma once
+
+#include "renderer/Camera.h"
+#include "renderer/Renderer.h"
+#include "renderer/Scene.h"
+#include "renderer/SceneSnapshot.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace vr {
+	namespace test {
+
+		/// @brief Loads the materials and the shared resources of the renderer on the first call, after initGpu.
+		/// @return false if no context could be created.
+		bool initRenderer();
+
+		/// @brief Renderer drawing a scene into an offscreen target, the way the application does without its window.
+		class RendererFixture {
+		public:
+			// CPU times of a frame, in microseconds
+			struct FrameTimes {
+				float capture = 0.0f;	// Scene snapshot, taken on the update thread by the application
+				float submit = 0.0f;	// Renderer::submit, as measured by the renderer
+				float frame = 0.0f;		// From the scene begin to its end, before waiting for the GPU
+				float gpu = 0.0f;		// Wait for the GPU once the frame is issued
+			};
+
+			RendererFixture(int32_t width, int32_t height, int32_t samples = 1);
+
+			/// @brief Captures the scene and renders a frame of it, then waits for the GPU.
+			FrameTimes renderFrame();
+
+			/// @brief Renders frames and averages their times, after a few warm up frames.
+			FrameTimes measureFrames(uint32_t frames, uint32_t warmUpFrames = 3);
+
+			Renderer& getRenderer() { return *m_renderer; }
+			Scene& getScene() { return m_scene; }
+			Camera& getCamera() { return m_camera; }
+
+		private:
+			std::shared_ptr<RenderTarget> m_target;
+			std::unique_ptr<Renderer> m_renderer;
+			Scene m_scene;
+			SceneSnapshot m_snapshot;
+			Camera m_camera;
+		};
+
+		/// @brief Appends a grid of copies of a mesh to a scene, like the stress cubes of the application.
+		/// @param source Mesh placed by each entity, its primitives are shared by the copies.
+		void addStressGrid(Scene& scene, const Mesh& source, uint32_t count, float spacing, float scale);
+
+	}
+}
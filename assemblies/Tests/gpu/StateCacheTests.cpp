@@ -0,0 +1,89 @@
+// VR Renderer - State Cache Tests
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "GpuContext.h"
+#include "gpu/StateCache.h"
+
+namespace vr {
+
+	// Texture bound to a unit, as the context sees it
+	static GLuint BoundTexture(GLuint unit) {
+		GLint texture = 0;
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+		glActiveTexture(GL_TEXTURE0);
+		return static_cast<GLuint>(texture);
+	}
+
+	// Calls of the cache since the last check
+	static bool Counted(gpu::StateCache& state, uint32_t issued, uint32_t skipped) {
+		const gpu::StateCache::Counters counters = state.takeCounters();
+		return counters.issued == issued && counters.skipped == skipped;
+	}
+
+	VR_TEST(StateCache, SkipsBoundTextures) {
+		VR_REQUIRE(test::initGpu());
+
+		GLuint textures[3];
+		glCreateTextures(GL_TEXTURE_2D, 3, textures);
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.invalidate();
+		state.takeCounters();
+
+		state.bindTextureUnit(0, textures[0]);
+		state.bindTextureUnit(0, textures[0]);
+		VR_CHECK(Counted(state, 1, 1));
+
+		// Unit 0 already holds its texture, only the span of units 1 to 2 is bound
+		state.bindTextures(0, 3, textures);
+		state.bindTextures(0, 3, textures);
+		state.bindTextureUnit(2, textures[2]);
+		VR_CHECK(Counted(state, 1, 2));
+		for (GLuint unit = 0; unit < 3; ++unit)
+			VR_CHECK(BoundTexture(unit) == textures[unit]);
+
+		// Unbinding through a null texture is issued
+		const GLuint none[3] = { 0, 0, 0 };
+		state.bindTextures(0, 3, none);
+		state.bindTextureUnit(1, 0);
+		VR_CHECK(Counted(state, 1, 1));
+		VR_CHECK(BoundTexture(1) == 0);
+
+		for (GLuint texture : textures)
+			state.forgetTexture(texture);
+		glDeleteTextures(3, textures);
+	}
+
+	VR_TEST(StateCache, TracksRangesPastLastUnit) {
+		VR_REQUIRE(test::initGpu());
+
+		GLint maxUnits = 0;
+		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+		VR_REQUIRE(maxUnits >= 34);
+
+		GLuint textures[2];
+		glCreateTextures(GL_TEXTURE_2D, 2, textures);
+		gpu::StateCache& state = gpu::StateCache::getInstance();
+		state.invalidate();
+		state.takeCounters();
+
+		// Units 30 to 33 straddle the tracked units, the tracked ones must still see the new textures
+		state.bindTextureUnit(30, textures[0]);
+		const GLuint range[4] = { textures[1], textures[1], textures[1], textures[1] };
+		state.bindTextures(30, 4, range);
+		VR_CHECK(Counted(state, 2, 0));
+
+		state.bindTextureUnit(30, textures[0]);
+		state.bindTextureUnit(31, textures[1]);
+		VR_CHECK(Counted(state, 1, 1));
+		VR_CHECK(BoundTexture(30) == textures[0]);
+		VR_CHECK(BoundTexture(31) == textures[1]);
+
+		for (GLuint texture : textures)
+			state.forgetTexture(texture);
+		glDeleteTextures(2, textures);
+	}
+
+}
@@ -0,0 +1,152 @@
+// VR Renderer - Static Batcher Tests
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "GpuContext.h"
+#include "utils/StaticBatcher.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <utility>
+
+namespace vr {
+
+	struct Vertex {
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec4 tangent;
+	};
+
+	struct Triangle {
+		glm::vec3 corners[3];
+	};
+
+	// Scattered triangles with their own vertices, flat normals and a tangent along their first edge
+	static gpu::GeometryData RandomTriangles(uint32_t count, std::mt19937& rng) {
+		std::uniform_real_distribution<float> position(-5.0f, 5.0f);
+		std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+
+		std::vector<Vertex> vertices;
+		while (vertices.size() < 3 * count) {
+			const glm::vec3 center(position(rng), position(rng), position(rng));
+			const glm::vec3 corners[3] = {
+				center + glm::vec3(offset(rng), offset(rng), offset(rng)),
+				center + glm::vec3(offset(rng), offset(rng), offset(rng)),
+				center + glm::vec3(offset(rng), offset(rng), offset(rng)),
+			};
+
+			const glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			if (glm::length(normal) < 1e-2f) continue;
+
+			for (const glm::vec3& corner : corners)
+				vertices.push_back(Vertex{ corner, glm::normalize(normal), glm::vec4(glm::normalize(corners[1] - corners[0]), 1.0f) });
+		}
+
+		gpu::GeometryData geometry;
+		geometry.layout = gpu::VertexLayout{ { gpu::Attribute::Position, GL_FLOAT, 3 }, { gpu::Attribute::Normal, GL_FLOAT, 3 }, { gpu::Attribute::Tangent, GL_FLOAT, 4 } };
+		geometry.vertex_data.resize(vertices.size() * sizeof(Vertex));
+		std::memcpy(geometry.vertex_data.data(), vertices.data(), geometry.vertex_data.size());
+		geometry.topology = GL_TRIANGLES;
+		for (uint32_t i = 0; i < vertices.size(); ++i)
+			geometry.indices.push_back(i);
+		return geometry;
+	}
+
+	static Vertex ReadVertex(const gpu::GeometryData& geometry, uint32_t index) {
+		Vertex vertex;
+		std::memcpy(&vertex, &geometry.vertex_data[index * sizeof(Vertex)], sizeof(Vertex));
+		return vertex;
+	}
+
+	// Triangles of a source once transformed, in the winding the batch must give them
+	static void AppendExpected(const gpu::GeometryData& geometry, const glm::mat4& transform, std::vector<Triangle>& triangles) {
+		const bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+		for (uint32_t i = 0; i < geometry.indices.size(); i += 3) {
+			Triangle triangle;
+			for (uint32_t k = 0; k < 3; ++k)
+				triangle.corners[k] = glm::vec3(transform * glm::vec4(ReadVertex(geometry, geometry.indices[i + k]).position, 1.0f));
+			if (mirrored)
+				std::swap(triangle.corners[1], triangle.corners[2]);
+			triangles.push_back(triangle);
+		}
+	}
+
+	// Same corners in the same cyclic order, wherever the triangle starts
+	static bool SameWinding(const Triangle& a, const Triangle& b) {
+		auto near = [](const glm::vec3& u, const glm::vec3& v) { return glm::all(glm::lessThan(glm::abs(u - v), glm::vec3(1e-3f))); };
+		for (uint32_t start = 0; start < 3; ++start) {
+			if (near(a.corners[0], b.corners[start]) && near(a.corners[1], b.corners[(start + 1) % 3]) && near(a.corners[2], b.corners[(start + 2) % 3]))
+				return true;
+		}
+		return false;
+	}
+
+	VR_TEST(StaticBatcher, KeepsTransformedTriangles) {
+		VR_REQUIRE(test::initGpu());
+
+		std::mt19937 rng(5);
+		const gpu::GeometryData source = RandomTriangles(1500, rng);
+		const auto material = std::make_shared<MaterialInstance>();
+
+		// A rotated and non-uniformly scaled copy on the right, a mirrored copy on the left
+		const glm::mat4 right = glm::translate(glm::mat4(1.0f), glm::vec3(100.0f, 0.0f, 0.0f)) *
+			glm::rotate(glm::mat4(1.0f), 0.7f, glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f))) * glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 0.5f));
+		const glm::mat4 left = glm::translate(glm::mat4(1.0f), glm::vec3(-100.0f, 0.0f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(-1.0f, 1.5f, 1.0f));
+
+		utils::StaticBatcher::Settings settings;
+		settings.maxChunkTriangles = 200;
+		settings.minChunkTriangles = 8;
+		utils::StaticBatcher batcher(settings);
+		batcher.add(source, material, right);
+		batcher.add(source, material, left);
+		const std::vector<utils::StaticBatcher::Chunk> chunks = batcher.buildChunks();
+
+		std::vector<Triangle> expected;
+		AppendExpected(source, right, expected);
+		AppendExpected(source, left, expected);
+
+		std::vector<Triangle> merged;
+		for (const utils::StaticBatcher::Chunk& chunk : chunks) {
+			VR_CHECK(chunk.material == material);
+			VR_CHECK(chunk.geometry.indices.size() / 3 <= settings.maxChunkTriangles);
+
+			for (uint32_t i = 0; i < chunk.geometry.indices.size(); i += 3) {
+				Vertex vertices[3];
+				for (uint32_t k = 0; k < 3; ++k)
+					vertices[k] = ReadVertex(chunk.geometry, chunk.geometry.indices[i + k]);
+
+				// Normals follow the winding, tangents stay in the plane and flip their sign on the mirrored copy
+				const glm::vec3 faceNormal = glm::normalize(glm::cross(vertices[1].position - vertices[0].position, vertices[2].position - vertices[0].position));
+				const float sign = vertices[0].position.x < 0.0f ? -1.0f : 1.0f;
+				for (const Vertex& vertex : vertices) {
+					VR_CHECK(glm::dot(vertex.normal, faceNormal) > 0.999f);
+					VR_CHECK(std::abs(glm::dot(glm::vec3(vertex.tangent), faceNormal)) < 1e-3f);
+					VR_CHECK(vertex.tangent.w == sign);
+				}
+
+				merged.push_back(Triangle{ { vertices[0].position, vertices[1].position, vertices[2].position } });
+			}
+		}
+
+		// Every source triangle is found once, with its winding
+		VR_REQUIRE(merged.size() == expected.size());
+		std::vector<bool> matched(merged.size(), false);
+		for (const Triangle& triangle : expected) {
+			bool found = false;
+			for (size_t m = 0; m < merged.size() && !found; ++m) {
+				if (!matched[m] && SameWinding(triangle, merged[m]))
+					matched[m] = found = true;
+			}
+			VR_CHECK(found);
+		}
+
+		VR_CHECK(batcher.getStats().sourcePrimitives == 2);
+		VR_CHECK(batcher.getStats().chunks == chunks.size());
+		VR_CHECK(chunks.size() >= 2 * 1500 / settings.maxChunkTriangles);
+	}
+
+}
@@ -0,0 +1,58 @@
+// VR Renderer - Submit Benchmarks
+// Rodolphe VALICON
+// 2025
+
+#include "Test.h"
+#include "RendererFixture.h"
+#include "core/Logger.h"
+#include "utils/GLTFLoader.h"
+
+#include <format>
+
+namespace vr {
+
+	// CPU cost of submitting the stress cubes. The camera faces away from them and nothing is lit, so that no draw
+	// reaches the rasterizer: what is measured is the bookkeeping of the renderables, their transforms and their culling.
+	VR_BENCHMARK(Submit, StressCubes) {
+		VR_REQUIRE(test::initRenderer());
+
+		const std::shared_ptr<Mesh> cube = utils::loadGLTFMesh("res/models/cube-emissive/Cube.gltf", 0);
+		for (uint32_t count : { 10000u, 30000u, 100000u }) {
+			test::RendererFixture fixture(64, 36);
+			Scene& scene = fixture.getScene();
+			test::addStressGrid(scene, *cube, count, 0.04f, 0.005f);
+
+			Camera& camera = fixture.getCamera();
+			camera.eyePos = glm::vec3(0.0f, 0.5f, 2.5f);
+			camera.forward = glm::vec3(0.0f, 0.0f, 1.0f);
+
+			// Static cubes, as in the application: after the first frames only the transforms are checked
+			const test::RendererFixture::FrameTimes times = fixture.measureFrames(10);
+			logger::info("{:<48} {:>12.1f} us", std::format("{} cubes, capture", count), times.capture);
+			logger::info("{:<48} {:>12.1f} us", std::format("{} cubes, submit", count), times.submit);
+			logger::info("{:<48} {:>12.1f} us", std::format("{} cubes, frame CPU", count), times.frame);
+
+			// Moving every cube, the transforms, bounds and objects are all updated
+			float offset = 0.0f;
+			auto moveFrame = [&]() {
+				offset += 0.001f;
+				for (uint32_t e = 0; e < scene.entities.getCount(); ++e)
+					scene.entities.getTransform(e).translation.x += offset;
+				return fixture.renderFrame();
+			};
+			moveFrame();
+
+			test::RendererFixture::FrameTimes moving;
+			for (uint32_t f = 0; f < 10; ++f) {
+				const test::RendererFixture::FrameTimes frame = moveFrame();
+				moving.capture += frame.capture / 10.0f;
+				moving.submit += frame.submit / 10.0f;
+				moving.frame += frame.frame / 10.0f;
+			}
+			logger::info("{:<48} {:>12.1f} us", std::format("{} moving cubes, capture", count), moving.capture);
+			logger::info("{:<48} {:>12.1f} us", std::format("{} moving cubes, submit", count), moving.submit);
+			logger::info("{:<48} {:>12.1f} us", std::format("{} moving cubes, frame CPU", count), moving.frame);
+		}
+	}
+
+}
@@ -0,0 +1,124 @@
+-- VR - Tests build file
+-- Rodolphe VALICON
+-- 2025
+
+-- CPU tests and benchmarks of the renderer, built and run without OpenGL.
+-- Runs the tests, or the benchmarks with --bench, an other argument filters the cases by name.
+project "Tests"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "On"
+
+    targetdir("%{build_dir}/bin/%{output_dir}/%{prj.name}")
+    objdir("%{build_dir}/bin-int/%{output_dir}/%{prj.name}")
+
+    files {
+        "framework/**.h",
+        "framework/**.cpp",
+        "cpu/**.h",
+        "cpu/**.cpp",
+
+        -- Tested renderer sources, none of them calls OpenGL
+        "../Renderer/src/core/JobSystem.cpp",
+        "../Renderer/src/renderer/BoundingVolumeHierarchy.cpp",
+        "../Renderer/src/renderer/Frustum.cpp",
+        "../Renderer/src/renderer/OcclusionCuller.cpp",
+        "../Renderer/src/renderer/TransformHierarchy.cpp",
+    }
+
+    includedirs {
+        "framework",
+        "../Renderer/src"
+    }
+
+    externalincludedirs {
+        "../Renderer/vendor/glm/include",
+    }
+    externalwarnings "Off"
+
+    filter "configurations:Debug"
+        runtime "Debug"
+        symbols "on"
+        optimize "off"
+
+    filter "configurations:Release"
+        runtime "Release"
+        symbols "on"
+        optimize "on"
+
+    filter "configurations:Dist"
+        runtime "Release"
+        symbols "off"
+        optimize "on"
+
+-- GPU tests and benchmarks of the renderer, run on a headless OpenGL context from the Renderer directory,
+-- which holds the shaders. Software implementations work, Mesa llvmpipe needs MESA_GL_VERSION_OVERRIDE=4.6
+-- and MESA_GLSL_VERSION_OVERRIDE=460.
+project "GpuTests"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "On"
+
+    targetdir("%{build_dir}/bin/%{output_dir}/%{prj.name}")
+    objdir("%{build_dir}/bin-int/%{output_dir}/%{prj.name}")
+    debugdir "../Renderer"
+
+    files {
+        "framework/**.h",
+        "framework/**.cpp",
+        "gpu/**.h",
+        "gpu/**.cpp",
+
+        -- The whole renderer, without the application
+        "../Renderer/src/**.h",
+        "../Renderer/src/**.cpp",
+        "../Renderer/vendor/glad/src/**.c",
+        "../Renderer/vendor/mikktspace/src/**.c",
+    }
+
+    removefiles {
+        "../Renderer/src/VR.cpp",
+        "../Renderer/src/core/EntryPoint.cpp",
+    }
+
+    includedirs {
+        "framework",
+        "gpu",
+        "../Renderer/src"
+    }
+
+    externalincludedirs {
+        "../Renderer/vendor/glfw/include",
+        "../Renderer/vendor/glad/include",
+        "../Renderer/vendor/glm/include",
+        "../Renderer/vendor/imgui",
+        "../Renderer/vendor/stb",
+        "../Renderer/vendor/json",
+        "../Renderer/vendor/mikktspace/include",
+    }
+    externalwarnings "Off"
+
+    links {
+        "GLFW",
+        "ImGUI",
+    }
+
+    filter "system:linux"
+        links { "EGL", "dl", "pthread" }
+
+    filter "configurations:Debug"
+        runtime "Debug"
+        symbols "on"
+        optimize "off"
+
+    filter "configurations:Release"
+        runtime "Release"
+        symbols "on"
+        optimize "on"
+
+    filter "configurations:Dist"
+        runtime "Release"
+        symbols "off"
+        optimize "on"
@@ -24,4 +24,7 @@ workspace "VR"
         include "assemblies/Renderer/vendor/glfw"
         include "assemblies/Renderer/vendor/imgui"
     group ""
-        include "assemblies/Renderer"
\ No newline at end of file
+        include "assemblies/Renderer"
+
+    group "Tests"
+        include "assemblies/Tests"
\ No newline at end of file